@@ -0,0 +1,124 @@
+#include "benchmarks.h"
+#include "Aes128CtrEngine.h"
+#include "Aes128CtrStream.h"
+
+#include <tc/crypto/Aes128CtrEncryptor.h>
+#include <tc/crypto/Aes128CtrEncryptedStream.h>
+#include <tc/io/MemoryStream.h>
+
+#include <cstring>
+#include <algorithm>
+
+namespace {
+
+// decrypt the whole stream in blocks of read_size, the way file extraction reads it
+void readWholeStream(tc::io::IStream& stream, byte_t* buffer, size_t read_size)
+{
+	stream.seek(0, tc::io::SeekOrigin::Begin);
+	for (int64_t remaining = stream.length(); remaining > 0;)
+	{
+		size_t read_len = stream.read(buffer, read_size);
+		if (read_len == 0)
+		{
+			throw tc::io::IOException("nstool::bench", "Failed to read from stream.");
+		}
+		remaining -= int64_t(read_len);
+	}
+}
+
+}
+
+void nstool::bench::benchmarkAesCtr()
+{
+	std::array<byte_t, Aes128CtrEngine::kKeySize> key;
+	std::array<byte_t, Aes128CtrEngine::kBlockSize> counter;
+	fillTestData(key.data(), key.size());
+	fillTestData(counter.data(), counter.size());
+
+	tc::ByteData input = tc::ByteData(kBenchmarkBufferSize);
+	fillTestData(input.data(), input.size());
+
+	const size_t iterations = kBenchmarkDataSize / input.size();
+
+	// reference: tc::crypto::Aes128CtrEncryptor
+	tc::ByteData reference = tc::ByteData(input.size());
+	{
+		tc::crypto::Aes128CtrEncryptor encryptor;
+		encryptor.initialize(key.data(), key.size(), counter.data(), counter.size());
+
+		Timer timer;
+		for (size_t i = 0; i < iterations; i++)
+		{
+			encryptor.decrypt(reference.data(), input.data(), input.size(), 0);
+		}
+		printThroughput("tc::crypto::Aes128CtrEncryptor", iterations * input.size(), timer.getElapsedSeconds());
+	}
+
+	// every implementation supported by this cpu
+	static const Aes128CtrEngine::Implementation kImplementations[] = { Aes128CtrEngine::Implementation_Generic, Aes128CtrEngine::Implementation_AesNi, Aes128CtrEngine::Implementation_ArmCe };
+	tc::ByteData output = tc::ByteData(input.size());
+	for (size_t impl = 0; impl < sizeof(kImplementations) / sizeof(kImplementations[0]); impl++)
+	{
+		if (Aes128CtrEngine::isImplementationSupported(kImplementations[impl]) == false)
+			continue;
+
+		Aes128CtrEngine engine(kImplementations[impl]);
+		engine.initialize(key.data(), key.size(), counter.data(), counter.size());
+
+		Timer timer;
+		for (size_t i = 0; i < iterations; i++)
+		{
+			engine.crypt(output.data(), input.data(), input.size(), 0);
+		}
+		double seconds = timer.getElapsedSeconds();
+
+		std::string label = "Aes128CtrEngine (" + Aes128CtrEngine::getImplementationName(kImplementations[impl]) + ")";
+		if (memcmp(output.data(), reference.data(), output.size()) != 0)
+		{
+			fmt::print("  {:<48s} output MISMATCH\n", label);
+			continue;
+		}
+		printThroughput(label, iterations * input.size(), seconds);
+	}
+
+	// stream level, reading 1MiB at a time like file extraction
+	static const size_t kReadSize = 0x100000;
+	tc::ByteData read_buffer = tc::ByteData(kReadSize);
+	std::shared_ptr<tc::io::IStream> encrypted_stream = std::make_shared<tc::io::MemoryStream>(tc::io::MemoryStream(input));
+	{
+		tc::crypto::Aes128CtrEncryptedStream stream(encrypted_stream, key, counter);
+
+		Timer timer;
+		for (size_t i = 0; i < iterations; i++)
+		{
+			readWholeStream(stream, read_buffer.data(), read_buffer.size());
+		}
+		printThroughput("tc::crypto::Aes128CtrEncryptedStream", iterations * input.size(), timer.getElapsedSeconds());
+	}
+	{
+		Aes128CtrStream stream(encrypted_stream, key, counter);
+
+		Timer timer;
+		for (size_t i = 0; i < iterations; i++)
+		{
+			readWholeStream(stream, read_buffer.data(), read_buffer.size());
+		}
+		printThroughput("nstool::Aes128CtrStream", iterations * input.size(), timer.getElapsedSeconds());
+	}
+
+	// chunk parallel decryption, with one thread per core (the reading thread is one of them)
+	size_t thread_count = std::max<size_t>(std::thread::hardware_concurrency(), 1);
+	std::vector<size_t> parallel_read_sizes = { kReadSize, kReadSize * 16 };
+	for (auto itr = parallel_read_sizes.begin(); itr != parallel_read_sizes.end(); itr++)
+	{
+		tc::ByteData parallel_read_buffer = tc::ByteData(*itr);
+		Aes128CtrStream stream(encrypted_stream, key, counter, std::make_shared<ThreadPool>(thread_count - 1));
+
+		Timer timer;
+		for (size_t i = 0; i < iterations; i++)
+		{
+			readWholeStream(stream, parallel_read_buffer.data(), parallel_read_buffer.size());
+		}
+		printThroughput(fmt::format("nstool::Aes128CtrStream ({:d} threads, {:d}MiB reads)", thread_count, *itr >> 20), iterations * input.size(), timer.getElapsedSeconds());
+	}
+}
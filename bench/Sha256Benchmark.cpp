@@ -0,0 +1,84 @@
+#include "benchmarks.h"
+#include "Sha256Engine.h"
+
+#include <tc/crypto/Sha2256Generator.h>
+
+#include <cstring>
+
+void nstool::bench::benchmarkSha256()
+{
+	tc::ByteData input = tc::ByteData(kBenchmarkBufferSize);
+	fillTestData(input.data(), input.size());
+
+	const size_t iterations = kBenchmarkDataSize / input.size();
+
+	// hash layer blocks as used by HierarchicalIntegrity partitions
+	static const size_t kHashBlockSize = 0x4000;
+	const size_t block_num = input.size() / kHashBlockSize;
+
+	// reference: tc::crypto::Sha2256Generator
+	std::array<byte_t, Sha256Engine::kHashSize> reference;
+	tc::ByteData reference_block_hashes = tc::ByteData(block_num * Sha256Engine::kHashSize);
+	{
+		tc::crypto::Sha2256Generator generator;
+
+		Timer timer;
+		for (size_t i = 0; i < iterations; i++)
+		{
+			generator.initialize();
+			generator.update(input.data(), input.size());
+			generator.getHash(reference.data());
+		}
+		printThroughput("tc::crypto::Sha2256Generator", iterations * input.size(), timer.getElapsedSeconds());
+
+		for (size_t i = 0; i < block_num; i++)
+		{
+			generator.initialize();
+			generator.update(input.data() + i * kHashBlockSize, kHashBlockSize);
+			generator.getHash(reference_block_hashes.data() + i * Sha256Engine::kHashSize);
+		}
+	}
+
+	// every implementation supported by this cpu, hashing one large message, then independent blocks
+	static const Sha256Engine::Implementation kImplementations[] = { Sha256Engine::Implementation_Generic, Sha256Engine::Implementation_ShaNi, Sha256Engine::Implementation_ArmCe, Sha256Engine::Implementation_Avx2 };
+	tc::ByteData block_hashes = tc::ByteData(block_num * Sha256Engine::kHashSize);
+	for (size_t impl = 0; impl < sizeof(kImplementations) / sizeof(kImplementations[0]); impl++)
+	{
+		if (Sha256Engine::isImplementationSupported(kImplementations[impl]) == false)
+			continue;
+
+		Sha256Engine engine(kImplementations[impl]);
+		std::string name = Sha256Engine::getImplementationName(kImplementations[impl]);
+
+		std::array<byte_t, Sha256Engine::kHashSize> hash;
+		Timer timer;
+		for (size_t i = 0; i < iterations; i++)
+		{
+			engine.generateHash(hash.data(), input.data(), input.size());
+		}
+		double seconds = timer.getElapsedSeconds();
+		if (hash != reference)
+		{
+			fmt::print("  {:<48s} output MISMATCH\n", "Sha256Engine (" + name + ")");
+		}
+		else
+		{
+			printThroughput("Sha256Engine (" + name + ")", iterations * input.size(), seconds);
+		}
+
+		timer = Timer();
+		for (size_t i = 0; i < iterations; i++)
+		{
+			engine.generateBlockHashes(block_hashes.data(), input.data(), input.size(), kHashBlockSize);
+		}
+		seconds = timer.getElapsedSeconds();
+		if (memcmp(block_hashes.data(), reference_block_hashes.data(), block_hashes.size()) != 0)
+		{
+			fmt::print("  {:<48s} output MISMATCH\n", "Sha256Engine (" + name + ", 16KiB blocks)");
+		}
+		else
+		{
+			printThroughput("Sha256Engine (" + name + ", 16KiB blocks)", iterations * input.size(), seconds);
+		}
+	}
+}
@@ -0,0 +1,36 @@
+#pragma once
+#include "types.h"
+
+#include <chrono>
+
+namespace nstool { namespace bench {
+
+// total amount of data each measurement processes
+static const size_t kBenchmarkDataSize = 0x40000000;
+
+// size of the buffer that is processed repeatedly until kBenchmarkDataSize is reached
+static const size_t kBenchmarkBufferSize = 0x4000000;
+
+class Timer
+{
+public:
+	Timer() : mStart(std::chrono::steady_clock::now()) {}
+
+	double getElapsedSeconds() const { return std::chrono::duration<double>(std::chrono::steady_clock::now() - mStart).count(); }
+private:
+	std::chrono::steady_clock::time_point mStart;
+};
+
+// print one result line, "<label>: <GB/s>"
+void printThroughput(const std::string& label, size_t bytes, double seconds);
+
+// fill data with deterministic pseudo random bytes
+void fillTestData(byte_t* data, size_t size);
+
+// AES-128-CTR: tc::crypto implementation vs nstool::Aes128CtrEngine
+void benchmarkAesCtr();
+
+// SHA-256: tc::crypto implementation vs nstool::Sha256Engine
+void benchmarkSha256();
+
+}}
@@ -0,0 +1,69 @@
+#include "benchmarks.h"
+
+#include <tc/os/UnicodeMain.h>
+
+#include <map>
+#include <functional>
+#include <cstring>
+
+void nstool::bench::printThroughput(const std::string& label, size_t bytes, double seconds)
+{
+	fmt::print("  {:<48s} {:8.2f} GB/s\n", label, (double(bytes) / 1e9) / seconds);
+}
+
+void nstool::bench::fillTestData(byte_t* data, size_t size)
+{
+	uint32_t state = 0x12345678;
+	for (size_t i = 0; i < size; i++)
+	{
+		// xorshift32
+		state ^= state << 13;
+		state ^= state >> 17;
+		state ^= state << 5;
+		data[i] = byte_t(state);
+	}
+}
+
+int umain(const std::vector<std::string>& args, const std::vector<std::string>& env)
+{
+	std::map<std::string, std::function<void()>> benchmarks = {
+		{ "aesctr", nstool::bench::benchmarkAesCtr },
+		{ "sha256", nstool::bench::benchmarkSha256 },
+	};
+
+	// run the benchmarks named on the command line, or all of them
+	std::vector<std::string> selected(args.begin() + 1, args.end());
+	if (selected.empty())
+	{
+		for (auto itr = benchmarks.begin(); itr != benchmarks.end(); itr++)
+			selected.push_back(itr->first);
+	}
+
+	try
+	{
+		for (auto itr = selected.begin(); itr != selected.end(); itr++)
+		{
+			auto benchmark = benchmarks.find(*itr);
+			if (benchmark == benchmarks.end())
+			{
+				fmt::print("Unknown benchmark \"{:s}\"\n", *itr);
+				return 1;
+			}
+
+			fmt::print("[{:s}]\n", benchmark->first);
+			benchmark->second();
+		}
+	}
+	catch (tc::Exception& e)
+	{
+		fmt::print("[{0}{1}ERROR] {2}\n", e.module(), (strlen(e.module()) != 0 ? " ": ""), e.error());
+		return 1;
+	}
+	catch (std::exception& e)
+	{
+		fmt::print("[ERROR] {}\n", e.what());
+		return 1;
+	}
+
+	return 0;
+}
@@ -0,0 +1,263 @@
+// nstool_client - sends a single request to a running "nstool --server <socket path>" and prints its output (or with --records, its records)
+// only uses the C++ standard library and POSIX sockets, so it starts faster than nstool itself
+#include <string>
+#include <vector>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <cerrno>
+#include <climits>
+#include <unistd.h>
+#include <sys/types.h>
+#include <sys/socket.h>
+#include <sys/un.h>
+
+namespace {
+
+void usage_text(const char* bin_name)
+{
+	fprintf(stderr, "Usage: %s [--records] <socket path> info <file>\n", bin_name);
+	fprintf(stderr, "       %s [--records] <socket path> list <file>\n", bin_name);
+	fprintf(stderr, "       %s [--records] <socket path> verify <file>\n", bin_name);
+	fprintf(stderr, "       %s [--records] <socket path> extract <file> <out path> [<virtual path>]\n", bin_name);
+	fprintf(stderr, "\n");
+	fprintf(stderr, "  --records   Print the tab separated records of the response (dir, file, warning, error), rather than the output.\n");
+	fprintf(stderr, "  Exits with 0 if the status is ok, 2 if it is warning (e.g. verify found a bad signature or hash) and 1 on error.\n");
+}
+
+// paths are resolved by the server, which may have a different working directory
+bool make_absolute_path(const std::string& path, std::string& absolute_path)
+{
+	if (path.empty() == false && path[0] == '/')
+	{
+		absolute_path = path;
+		return true;
+	}
+
+	char cwd[PATH_MAX];
+	if (getcwd(cwd, sizeof(cwd)) == nullptr)
+	{
+		return false;
+	}
+
+	absolute_path = std::string(cwd) + "/" + path;
+	return true;
+}
+
+bool write_all(int fd, const char* data, size_t size)
+{
+	for (size_t done = 0; done < size;)
+	{
+		ssize_t write_len = send(fd, data + done, size - done, 0);
+		if (write_len < 0 && errno == EINTR)
+			continue;
+		if (write_len <= 0)
+			return false;
+		done += size_t(write_len);
+	}
+
+	return true;
+}
+
+// read from fd until buffer holds at least size bytes, returns false if the connection closed first
+bool read_until_size(int fd, std::string& buffer, size_t size)
+{
+	char chunk[0x1000];
+	while (buffer.size() < size)
+	{
+		ssize_t read_len = recv(fd, chunk, sizeof(chunk), 0);
+		if (read_len < 0 && errno == EINTR)
+			continue;
+		if (read_len <= 0)
+			return false;
+		buffer.append(chunk, size_t(read_len));
+	}
+
+	return true;
+}
+
+// read a line (without the line break) from fd, with buffer holding bytes already received
+bool read_line(int fd, std::string& buffer, std::string& line)
+{
+	size_t line_end = std::string::npos;
+	while ((line_end = buffer.find('\n')) == std::string::npos)
+	{
+		if (read_until_size(fd, buffer, buffer.size() + 1) == false)
+			return false;
+	}
+
+	line = buffer.substr(0, line_end);
+	buffer.erase(0, line_end + 1);
+	return true;
+}
+
+}
+
+int main(int argc, char** argv)
+{
+	const char* bin_name = argv[0];
+
+	bool print_records = false;
+	if (argc > 1 && strcmp(argv[1], "--records") == 0)
+	{
+		print_records = true;
+		argv++;
+		argc--;
+	}
+
+	if (argc < 4)
+	{
+		usage_text(bin_name);
+		return 1;
+	}
+
+	std::string socket_path = argv[1];
+	std::string command = argv[2];
+
+	std::vector<std::string> fields;
+	fields.push_back(command);
+	if (command == "info" || command == "list" || command == "verify")
+	{
+		if (argc != 4)
+		{
+			usage_text(bin_name);
+			return 1;
+		}
+	}
+	else if (command == "extract")
+	{
+		if (argc != 5 && argc != 6)
+		{
+			usage_text(bin_name);
+			return 1;
+		}
+	}
+	else
+	{
+		usage_text(bin_name);
+		return 1;
+	}
+
+	// input path and extract path are local paths, the virtual path is a path inside the input
+	for (int i = 3; i < argc && i < 5; i++)
+	{
+		std::string absolute_path;
+		if (make_absolute_path(argv[i], absolute_path) == false)
+		{
+			fprintf(stderr, "[nstool_client ERROR] Failed to get the working directory.\n");
+			return 1;
+		}
+		fields.push_back(absolute_path);
+	}
+	if (argc == 6)
+	{
+		fields.push_back(argv[5]);
+	}
+
+	std::string request;
+	for (size_t i = 0; i < fields.size(); i++)
+	{
+		if (fields[i].find_first_of("\t\r\n") != std::string::npos)
+		{
+			fprintf(stderr, "[nstool_client ERROR] Paths cannot contain tabs or line breaks.\n");
+			return 1;
+		}
+		request += (i == 0 ? "" : "\t") + fields[i];
+	}
+	request += "\n";
+
+	// connect
+	struct sockaddr_un addr;
+	memset(&addr, 0, sizeof(addr));
+	addr.sun_family = AF_UNIX;
+	if (socket_path.size() >= sizeof(addr.sun_path))
+	{
+		fprintf(stderr, "[nstool_client ERROR] Socket path is too long.\n");
+		return 1;
+	}
+	memcpy(addr.sun_path, socket_path.c_str(), socket_path.size());
+
+	int fd = socket(AF_UNIX, SOCK_STREAM, 0);
+	if (fd < 0 || connect(fd, (const struct sockaddr*)&addr, sizeof(addr)) != 0)
+	{
+		fprintf(stderr, "[nstool_client ERROR] Failed to connect to \"%s\" (%s). Is \"nstool --server\" running?\n", socket_path.c_str(), strerror(errno));
+		return 1;
+	}
+
+	if (write_all(fd, request.data(), request.size()) == false)
+	{
+		fprintf(stderr, "[nstool_client ERROR] Failed to send request (%s).\n", strerror(errno));
+		close(fd);
+		return 1;
+	}
+
+	// response header: <status>\t<file type>\t<record count>\t<output size>\n
+	std::string buffer;
+	std::string header;
+	if (read_line(fd, buffer, header) == false)
+	{
+		fprintf(stderr, "[nstool_client ERROR] Connection closed before a response was received.\n");
+		close(fd);
+		return 1;
+	}
+
+	std::vector<std::string> header_fields;
+	for (size_t pos = 0; pos <= header.size();)
+	{
+		size_t field_end = header.find('\t', pos);
+		if (field_end == std::string::npos)
+			field_end = header.size();
+		header_fields.push_back(header.substr(pos, field_end - pos));
+		pos = field_end + 1;
+	}
+	if (header_fields.size() != 4)
+	{
+		fprintf(stderr, "[nstool_client ERROR] Malformed response.\n");
+		close(fd);
+		return 1;
+	}
+	std::string status = header_fields[0];
+	size_t record_num = size_t(strtoull(header_fields[2].c_str(), nullptr, 10));
+	size_t output_size = size_t(strtoull(header_fields[3].c_str(), nullptr, 10));
+
+	// records, one per line
+	std::vector<std::string> records;
+	for (size_t i = 0; i < record_num; i++)
+	{
+		std::string record;
+		if (read_line(fd, buffer, record) == false)
+		{
+			fprintf(stderr, "[nstool_client ERROR] Connection closed before the whole response was received.\n");
+			close(fd);
+			return 1;
+		}
+		records.push_back(record);
+	}
+
+	if (read_until_size(fd, buffer, output_size) == false)
+	{
+		fprintf(stderr, "[nstool_client ERROR] Connection closed before the whole response was received.\n");
+		close(fd);
+		return 1;
+	}
+	close(fd);
+
+	if (print_records)
+	{
+		for (size_t i = 0; i < records.size(); i++)
+		{
+			fprintf(stdout, "%s\n", records[i].c_str());
+		}
+	}
+	else
+	{
+		fwrite(buffer.data(), 1, output_size, stdout);
+	}
+	fflush(stdout);
+
+	if (status == "ok")
+		return 0;
+	if (status == "warning")
+		return 2;
+	return 1;
+}
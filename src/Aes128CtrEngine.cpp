@@ -0,0 +1,481 @@
+#include "Aes128CtrEngine.h"
+
+#include <tc/ArgumentOutOfRangeException.h>
+#include <tc/InvalidOperationException.h>
+#include <tc/NotSupportedException.h>
+
+#include <cstring>
+
+// select hardware kernels for this target
+#if defined(__x86_64__) || defined(__i386__) || defined(_M_X64) || defined(_M_IX86)
+	#define NSTOOL_AESCTR_HAS_AESNI
+	#if defined(_MSC_VER) && !defined(__clang__)
+		#include <intrin.h>
+		#define NSTOOL_AESNI_TARGET
+	#else
+		#include <cpuid.h>
+		#define NSTOOL_AESNI_TARGET __attribute__((target("aes,sse2")))
+	#endif
+	#include <emmintrin.h>
+	#include <wmmintrin.h>
+#elif defined(__aarch64__)
+	// clang only allows the crypto intrinsics when they are enabled for the whole translation unit, gcc allows them per function
+	#if defined(__ARM_FEATURE_CRYPTO) || defined(__ARM_FEATURE_AES)
+		#define NSTOOL_AESCTR_HAS_ARMCE
+		#define NSTOOL_ARMCE_TARGET
+	#elif defined(__GNUC__) && !defined(__clang__)
+		#define NSTOOL_AESCTR_HAS_ARMCE
+		#define NSTOOL_ARMCE_TARGET __attribute__((target("+crypto")))
+	#endif
+	#ifdef NSTOOL_AESCTR_HAS_ARMCE
+		#include <arm_neon.h>
+		#if defined(__linux__)
+			#include <sys/auxv.h>
+			#include <asm/hwcap.h>
+		#endif
+	#endif
+#endif
+
+namespace {
+
+const byte_t kAesSbox[256] = {
+	0x63, 0x7c, 0x77, 0x7b, 0xf2, 0x6b, 0x6f, 0xc5, 0x30, 0x01, 0x67, 0x2b, 0xfe, 0xd7, 0xab, 0x76,
+	0xca, 0x82, 0xc9, 0x7d, 0xfa, 0x59, 0x47, 0xf0, 0xad, 0xd4, 0xa2, 0xaf, 0x9c, 0xa4, 0x72, 0xc0,
+	0xb7, 0xfd, 0x93, 0x26, 0x36, 0x3f, 0xf7, 0xcc, 0x34, 0xa5, 0xe5, 0xf1, 0x71, 0xd8, 0x31, 0x15,
+	0x04, 0xc7, 0x23, 0xc3, 0x18, 0x96, 0x05, 0x9a, 0x07, 0x12, 0x80, 0xe2, 0xeb, 0x27, 0xb2, 0x75,
+	0x09, 0x83, 0x2c, 0x1a, 0x1b, 0x6e, 0x5a, 0xa0, 0x52, 0x3b, 0xd6, 0xb3, 0x29, 0xe3, 0x2f, 0x84,
+	0x53, 0xd1, 0x00, 0xed, 0x20, 0xfc, 0xb1, 0x5b, 0x6a, 0xcb, 0xbe, 0x39, 0x4a, 0x4c, 0x58, 0xcf,
+	0xd0, 0xef, 0xaa, 0xfb, 0x43, 0x4d, 0x33, 0x85, 0x45, 0xf9, 0x02, 0x7f, 0x50, 0x3c, 0x9f, 0xa8,
+	0x51, 0xa3, 0x40, 0x8f, 0x92, 0x9d, 0x38, 0xf5, 0xbc, 0xb6, 0xda, 0x21, 0x10, 0xff, 0xf3, 0xd2,
+	0xcd, 0x0c, 0x13, 0xec, 0x5f, 0x97, 0x44, 0x17, 0xc4, 0xa7, 0x7e, 0x3d, 0x64, 0x5d, 0x19, 0x73,
+	0x60, 0x81, 0x4f, 0xdc, 0x22, 0x2a, 0x90, 0x88, 0x46, 0xee, 0xb8, 0x14, 0xde, 0x5e, 0x0b, 0xdb,
+	0xe0, 0x32, 0x3a, 0x0a, 0x49, 0x06, 0x24, 0x5c, 0xc2, 0xd3, 0xac, 0x62, 0x91, 0x95, 0xe4, 0x79,
+	0xe7, 0xc8, 0x37, 0x6d, 0x8d, 0xd5, 0x4e, 0xa9, 0x6c, 0x56, 0xf4, 0xea, 0x65, 0x7a, 0xae, 0x08,
+	0xba, 0x78, 0x25, 0x2e, 0x1c, 0xa6, 0xb4, 0xc6, 0xe8, 0xdd, 0x74, 0x1f, 0x4b, 0xbd, 0x8b, 0x8a,
+	0x70, 0x3e, 0xb5, 0x66, 0x48, 0x03, 0xf6, 0x0e, 0x61, 0x35, 0x57, 0xb9, 0x86, 0xc1, 0x1d, 0x9e,
+	0xe1, 0xf8, 0x98, 0x11, 0x69, 0xd9, 0x8e, 0x94, 0x9b, 0x1e, 0x87, 0xe9, 0xce, 0x55, 0x28, 0xdf,
+	0x8c, 0xa1, 0x89, 0x0d, 0xbf, 0xe6, 0x42, 0x68, 0x41, 0x99, 0x2d, 0x0f, 0xb0, 0x54, 0xbb, 0x16
+};
+
+// AES-128 key expansion (FIPS-197 section 5.2), round key r is round_keys[16*r..16*r+15]
+void expandAes128Key(const byte_t* key, byte_t* round_keys)
+{
+	static const byte_t kRcon[10] = { 0x01, 0x02, 0x04, 0x08, 0x10, 0x20, 0x40, 0x80, 0x1b, 0x36 };
+
+	memcpy(round_keys, key, 16);
+	for (size_t i = 16; i < 176; i += 4)
+	{
+		byte_t temp[4] = { round_keys[i - 4], round_keys[i - 3], round_keys[i - 2], round_keys[i - 1] };
+		if (i % 16 == 0)
+		{
+			// RotWord, SubWord, Rcon
+			byte_t first = temp[0];
+			temp[0] = kAesSbox[temp[1]] ^ kRcon[(i / 16) - 1];
+			temp[1] = kAesSbox[temp[2]];
+			temp[2] = kAesSbox[temp[3]];
+			temp[3] = kAesSbox[first];
+		}
+		for (size_t j = 0; j < 4; j++)
+		{
+			round_keys[i + j] = round_keys[i + j - 16] ^ temp[j];
+		}
+	}
+}
+
+inline uint64_t readBe64(const byte_t* data)
+{
+	uint64_t value = 0;
+	for (size_t i = 0; i < 8; i++)
+	{
+		value = (value << 8) | data[i];
+	}
+	return value;
+}
+
+inline void writeBe64(byte_t* data, uint64_t value)
+{
+	for (size_t i = 0; i < 8; i++)
+	{
+		data[7 - i] = byte_t(value);
+		value >>= 8;
+	}
+}
+
+inline uint64_t byteSwap64(uint64_t value)
+{
+#if defined(_MSC_VER) && !defined(__clang__)
+	return _byteswap_uint64(value);
+#else
+	return __builtin_bswap64(value);
+#endif
+}
+
+// counter + n as a 128bit big endian integer
+inline void addCounter(uint64_t& hi, uint64_t& lo, uint64_t n)
+{
+	uint64_t old_lo = lo;
+	lo += n;
+	if (lo < old_lo)
+	{
+		hi++;
+	}
+}
+
+#ifdef NSTOOL_AESCTR_HAS_AESNI
+bool isAesNiSupported()
+{
+#if defined(_MSC_VER) && !defined(__clang__)
+	int cpu_info[4];
+	__cpuid(cpu_info, 1);
+	bool has_aes = (cpu_info[2] & (1 << 25)) != 0;
+	bool has_sse2 = (cpu_info[3] & (1 << 26)) != 0;
+#else
+	unsigned int eax, ebx, ecx, edx;
+	if (__get_cpuid(1, &eax, &ebx, &ecx, &edx) == 0)
+	{
+		return false;
+	}
+	bool has_aes = (ecx & (1 << 25)) != 0;
+	bool has_sse2 = (edx & (1 << 26)) != 0;
+#endif
+	return has_aes && has_sse2;
+}
+
+NSTOOL_AESNI_TARGET inline __m128i makeCounterBlockAesNi(uint64_t hi, uint64_t lo)
+{
+	// counter is big endian, so each half is byte swapped into the little endian lanes
+	return _mm_set_epi64x((long long)byteSwap64(lo), (long long)byteSwap64(hi));
+}
+
+NSTOOL_AESNI_TARGET void cryptBlocksAesNi(const byte_t* round_keys, byte_t* dst, const byte_t* src, size_t num_blocks, uint64_t ctr_hi, uint64_t ctr_lo)
+{
+	__m128i rk[11];
+	for (size_t r = 0; r < 11; r++)
+	{
+		rk[r] = _mm_loadu_si128((const __m128i*)(round_keys + r * 16));
+	}
+
+	// 8 blocks per iteration, each aesenc has several cycles of latency, so independent blocks keep the AES unit busy
+	// (the lanes are written out so they stay in registers without relying on the optimiser to unroll)
+	for (; num_blocks >= 8; num_blocks -= 8, src += 8 * 16, dst += 8 * 16)
+	{
+		__m128i b[8];
+		b[0] = makeCounterBlockAesNi(ctr_hi, ctr_lo); addCounter(ctr_hi, ctr_lo, 1);
+		b[1] = makeCounterBlockAesNi(ctr_hi, ctr_lo); addCounter(ctr_hi, ctr_lo, 1);
+		b[2] = makeCounterBlockAesNi(ctr_hi, ctr_lo); addCounter(ctr_hi, ctr_lo, 1);
+		b[3] = makeCounterBlockAesNi(ctr_hi, ctr_lo); addCounter(ctr_hi, ctr_lo, 1);
+		b[4] = makeCounterBlockAesNi(ctr_hi, ctr_lo); addCounter(ctr_hi, ctr_lo, 1);
+		b[5] = makeCounterBlockAesNi(ctr_hi, ctr_lo); addCounter(ctr_hi, ctr_lo, 1);
+		b[6] = makeCounterBlockAesNi(ctr_hi, ctr_lo); addCounter(ctr_hi, ctr_lo, 1);
+		b[7] = makeCounterBlockAesNi(ctr_hi, ctr_lo); addCounter(ctr_hi, ctr_lo, 1);
+
+		b[0] = _mm_xor_si128(b[0], rk[0]); b[1] = _mm_xor_si128(b[1], rk[0]); b[2] = _mm_xor_si128(b[2], rk[0]); b[3] = _mm_xor_si128(b[3], rk[0]);
+		b[4] = _mm_xor_si128(b[4], rk[0]); b[5] = _mm_xor_si128(b[5], rk[0]); b[6] = _mm_xor_si128(b[6], rk[0]); b[7] = _mm_xor_si128(b[7], rk[0]);
+		for (size_t r = 1; r < 10; r++)
+		{
+			__m128i k = rk[r];
+			b[0] = _mm_aesenc_si128(b[0], k); b[1] = _mm_aesenc_si128(b[1], k); b[2] = _mm_aesenc_si128(b[2], k); b[3] = _mm_aesenc_si128(b[3], k);
+			b[4] = _mm_aesenc_si128(b[4], k); b[5] = _mm_aesenc_si128(b[5], k); b[6] = _mm_aesenc_si128(b[6], k); b[7] = _mm_aesenc_si128(b[7], k);
+		}
+		b[0] = _mm_aesenclast_si128(b[0], rk[10]); b[1] = _mm_aesenclast_si128(b[1], rk[10]); b[2] = _mm_aesenclast_si128(b[2], rk[10]); b[3] = _mm_aesenclast_si128(b[3], rk[10]);
+		b[4] = _mm_aesenclast_si128(b[4], rk[10]); b[5] = _mm_aesenclast_si128(b[5], rk[10]); b[6] = _mm_aesenclast_si128(b[6], rk[10]); b[7] = _mm_aesenclast_si128(b[7], rk[10]);
+
+		_mm_storeu_si128((__m128i*)(dst + 0x00), _mm_xor_si128(b[0], _mm_loadu_si128((const __m128i*)(src + 0x00))));
+		_mm_storeu_si128((__m128i*)(dst + 0x10), _mm_xor_si128(b[1], _mm_loadu_si128((const __m128i*)(src + 0x10))));
+		_mm_storeu_si128((__m128i*)(dst + 0x20), _mm_xor_si128(b[2], _mm_loadu_si128((const __m128i*)(src + 0x20))));
+		_mm_storeu_si128((__m128i*)(dst + 0x30), _mm_xor_si128(b[3], _mm_loadu_si128((const __m128i*)(src + 0x30))));
+		_mm_storeu_si128((__m128i*)(dst + 0x40), _mm_xor_si128(b[4], _mm_loadu_si128((const __m128i*)(src + 0x40))));
+		_mm_storeu_si128((__m128i*)(dst + 0x50), _mm_xor_si128(b[5], _mm_loadu_si128((const __m128i*)(src + 0x50))));
+		_mm_storeu_si128((__m128i*)(dst + 0x60), _mm_xor_si128(b[6], _mm_loadu_si128((const __m128i*)(src + 0x60))));
+		_mm_storeu_si128((__m128i*)(dst + 0x70), _mm_xor_si128(b[7], _mm_loadu_si128((const __m128i*)(src + 0x70))));
+	}
+
+	for (; num_blocks > 0; num_blocks--, src += 16, dst += 16)
+	{
+		__m128i block = _mm_xor_si128(makeCounterBlockAesNi(ctr_hi, ctr_lo), rk[0]);
+		addCounter(ctr_hi, ctr_lo, 1);
+		for (size_t r = 1; r < 10; r++)
+		{
+			block = _mm_aesenc_si128(block, rk[r]);
+		}
+		block = _mm_aesenclast_si128(block, rk[10]);
+		_mm_storeu_si128((__m128i*)dst, _mm_xor_si128(block, _mm_loadu_si128((const __m128i*)src)));
+	}
+}
+#endif
+
+#ifdef NSTOOL_AESCTR_HAS_ARMCE
+bool isArmCeSupported()
+{
+#if defined(__APPLE__)
+	// every arm64 apple cpu has the crypto extensions
+	return true;
+#elif defined(__linux__)
+	return (getauxval(AT_HWCAP) & HWCAP_AES) != 0;
+#elif defined(__ARM_FEATURE_CRYPTO) || defined(__ARM_FEATURE_AES)
+	return true;
+#else
+	return false;
+#endif
+}
+
+NSTOOL_ARMCE_TARGET inline uint8x16_t makeCounterBlockArmCe(uint64_t hi, uint64_t lo)
+{
+	// counter is big endian, so each half is byte swapped into the little endian lanes
+	return vreinterpretq_u8_u64(vcombine_u64(vcreate_u64(byteSwap64(hi)), vcreate_u64(byteSwap64(lo))));
+}
+
+NSTOOL_ARMCE_TARGET inline uint8x16_t encryptBlockArmCe(uint8x16_t block, const uint8x16_t* rk)
+{
+	// aese does AddRoundKey+SubBytes+ShiftRows, aesmc does MixColumns
+	for (size_t r = 0; r < 9; r++)
+	{
+		block = vaesmcq_u8(vaeseq_u8(block, rk[r]));
+	}
+	block = vaeseq_u8(block, rk[9]);
+	return veorq_u8(block, rk[10]);
+}
+
+NSTOOL_ARMCE_TARGET void cryptBlocksArmCe(const byte_t* round_keys, byte_t* dst, const byte_t* src, size_t num_blocks, uint64_t ctr_hi, uint64_t ctr_lo)
+{
+	uint8x16_t rk[11];
+	for (size_t r = 0; r < 11; r++)
+	{
+		rk[r] = vld1q_u8(round_keys + r * 16);
+	}
+
+	// 8 blocks per iteration, so the aese/aesmc pairs of independent blocks can be fused and overlapped
+	// (the lanes are written out so they stay in registers without relying on the optimiser to unroll)
+	for (; num_blocks >= 8; num_blocks -= 8, src += 8 * 16, dst += 8 * 16)
+	{
+		uint8x16_t b[8];
+		b[0] = makeCounterBlockArmCe(ctr_hi, ctr_lo); addCounter(ctr_hi, ctr_lo, 1);
+		b[1] = makeCounterBlockArmCe(ctr_hi, ctr_lo); addCounter(ctr_hi, ctr_lo, 1);
+		b[2] = makeCounterBlockArmCe(ctr_hi, ctr_lo); addCounter(ctr_hi, ctr_lo, 1);
+		b[3] = makeCounterBlockArmCe(ctr_hi, ctr_lo); addCounter(ctr_hi, ctr_lo, 1);
+		b[4] = makeCounterBlockArmCe(ctr_hi, ctr_lo); addCounter(ctr_hi, ctr_lo, 1);
+		b[5] = makeCounterBlockArmCe(ctr_hi, ctr_lo); addCounter(ctr_hi, ctr_lo, 1);
+		b[6] = makeCounterBlockArmCe(ctr_hi, ctr_lo); addCounter(ctr_hi, ctr_lo, 1);
+		b[7] = makeCounterBlockArmCe(ctr_hi, ctr_lo); addCounter(ctr_hi, ctr_lo, 1);
+
+		for (size_t r = 0; r < 9; r++)
+		{
+			uint8x16_t k = rk[r];
+			b[0] = vaesmcq_u8(vaeseq_u8(b[0], k)); b[1] = vaesmcq_u8(vaeseq_u8(b[1], k)); b[2] = vaesmcq_u8(vaeseq_u8(b[2], k)); b[3] = vaesmcq_u8(vaeseq_u8(b[3], k));
+			b[4] = vaesmcq_u8(vaeseq_u8(b[4], k)); b[5] = vaesmcq_u8(vaeseq_u8(b[5], k)); b[6] = vaesmcq_u8(vaeseq_u8(b[6], k)); b[7] = vaesmcq_u8(vaeseq_u8(b[7], k));
+		}
+		b[0] = veorq_u8(vaeseq_u8(b[0], rk[9]), rk[10]); b[1] = veorq_u8(vaeseq_u8(b[1], rk[9]), rk[10]); b[2] = veorq_u8(vaeseq_u8(b[2], rk[9]), rk[10]); b[3] = veorq_u8(vaeseq_u8(b[3], rk[9]), rk[10]);
+		b[4] = veorq_u8(vaeseq_u8(b[4], rk[9]), rk[10]); b[5] = veorq_u8(vaeseq_u8(b[5], rk[9]), rk[10]); b[6] = veorq_u8(vaeseq_u8(b[6], rk[9]), rk[10]); b[7] = veorq_u8(vaeseq_u8(b[7], rk[9]), rk[10]);
+
+		vst1q_u8(dst + 0x00, veorq_u8(b[0], vld1q_u8(src + 0x00)));
+		vst1q_u8(dst + 0x10, veorq_u8(b[1], vld1q_u8(src + 0x10)));
+		vst1q_u8(dst + 0x20, veorq_u8(b[2], vld1q_u8(src + 0x20)));
+		vst1q_u8(dst + 0x30, veorq_u8(b[3], vld1q_u8(src + 0x30)));
+		vst1q_u8(dst + 0x40, veorq_u8(b[4], vld1q_u8(src + 0x40)));
+		vst1q_u8(dst + 0x50, veorq_u8(b[5], vld1q_u8(src + 0x50)));
+		vst1q_u8(dst + 0x60, veorq_u8(b[6], vld1q_u8(src + 0x60)));
+		vst1q_u8(dst + 0x70, veorq_u8(b[7], vld1q_u8(src + 0x70)));
+	}
+
+	for (; num_blocks > 0; num_blocks--, src += 16, dst += 16)
+	{
+		uint8x16_t block = encryptBlockArmCe(makeCounterBlockArmCe(ctr_hi, ctr_lo), rk);
+		addCounter(ctr_hi, ctr_lo, 1);
+		vst1q_u8(dst, veorq_u8(block, vld1q_u8(src)));
+	}
+}
+#endif
+
+}
+
+nstool::Aes128CtrEngine::Aes128CtrEngine() :
+	Aes128CtrEngine(getBestImplementation())
+{
+}
+
+nstool::Aes128CtrEngine::Aes128CtrEngine(Implementation implementation) :
+	mModuleName("nstool::Aes128CtrEngine"),
+	mImplementation(implementation),
+	mInitialized(false),
+	mRoundKeys(),
+	mCounterHi(0),
+	mCounterLo(0),
+	mGenericEncryptor()
+{
+	if (isImplementationSupported(mImplementation) == false)
+	{
+		throw tc::NotSupportedException(mModuleName, fmt::format("{:s} is not supported on this CPU.", getImplementationName(mImplementation)));
+	}
+}
+
+nstool::Aes128CtrEngine::Aes128CtrEngine(const Aes128CtrEngine& other) :
+	Aes128CtrEngine(other.mImplementation)
+{
+	*this = other;
+}
+
+nstool::Aes128CtrEngine& nstool::Aes128CtrEngine::operator=(const Aes128CtrEngine& other)
+{
+	if (this != &other)
+	{
+		mImplementation = other.mImplementation;
+		mInitialized = other.mInitialized;
+		mRoundKeys = other.mRoundKeys;
+		mCounterHi = other.mCounterHi;
+		mCounterLo = other.mCounterLo;
+		mGenericEncryptor.reset();
+		if (mInitialized && mImplementation == Implementation_Generic)
+		{
+			initializeGenericEncryptor();
+		}
+	}
+	return *this;
+}
+
+void nstool::Aes128CtrEngine::initialize(const byte_t* key, size_t key_size, const byte_t* counter, size_t counter_size)
+{
+	if (key == nullptr || key_size != kKeySize)
+	{
+		throw tc::ArgumentOutOfRangeException(mModuleName, "key_size was invalid.");
+	}
+	if (counter == nullptr || counter_size != kBlockSize)
+	{
+		throw tc::ArgumentOutOfRangeException(mModuleName, "counter_size was invalid.");
+	}
+
+	// the first round key is the key itself, so this also keeps the key for initializeGenericEncryptor()
+	expandAes128Key(key, mRoundKeys.data());
+	mCounterHi = readBe64(counter);
+	mCounterLo = readBe64(counter + 8);
+	mInitialized = true;
+
+	mGenericEncryptor.reset();
+	if (mImplementation == Implementation_Generic)
+	{
+		initializeGenericEncryptor();
+	}
+}
+
+void nstool::Aes128CtrEngine::crypt(byte_t* dst, const byte_t* src, size_t size, uint64_t block_number)
+{
+	if (mInitialized == false)
+	{
+		throw tc::InvalidOperationException(mModuleName, "Engine was not initialized.");
+	}
+
+	size_t num_blocks = size / kBlockSize;
+	size_t tail_size = size % kBlockSize;
+
+	uint64_t ctr_hi = mCounterHi;
+	uint64_t ctr_lo = mCounterLo;
+	addCounter(ctr_hi, ctr_lo, block_number);
+
+	switch (mImplementation)
+	{
+#ifdef NSTOOL_AESCTR_HAS_AESNI
+	case (Implementation_AesNi):
+		cryptBlocksAesNi(mRoundKeys.data(), dst, src, num_blocks, ctr_hi, ctr_lo);
+		break;
+#endif
+#ifdef NSTOOL_AESCTR_HAS_ARMCE
+	case (Implementation_ArmCe):
+		cryptBlocksArmCe(mRoundKeys.data(), dst, src, num_blocks, ctr_hi, ctr_lo);
+		break;
+#endif
+	default:
+		if (num_blocks > 0)
+		{
+			mGenericEncryptor->decrypt(dst, src, num_blocks * kBlockSize, block_number);
+		}
+		break;
+	}
+
+	// partial final block, crypt a padded copy
+	if (tail_size > 0)
+	{
+		std::array<byte_t, kBlockSize> tail;
+		memset(tail.data(), 0, tail.size());
+		memcpy(tail.data(), src + num_blocks * kBlockSize, tail_size);
+
+		uint64_t tail_block_number = block_number + uint64_t(num_blocks);
+		switch (mImplementation)
+		{
+#ifdef NSTOOL_AESCTR_HAS_AESNI
+		case (Implementation_AesNi):
+			addCounter(ctr_hi, ctr_lo, uint64_t(num_blocks));
+			cryptBlocksAesNi(mRoundKeys.data(), tail.data(), tail.data(), 1, ctr_hi, ctr_lo);
+			break;
+#endif
+#ifdef NSTOOL_AESCTR_HAS_ARMCE
+		case (Implementation_ArmCe):
+			addCounter(ctr_hi, ctr_lo, uint64_t(num_blocks));
+			cryptBlocksArmCe(mRoundKeys.data(), tail.data(), tail.data(), 1, ctr_hi, ctr_lo);
+			break;
+#endif
+		default:
+			mGenericEncryptor->decrypt(tail.data(), tail.data(), tail.size(), tail_block_number);
+			break;
+		}
+
+		memcpy(dst + num_blocks * kBlockSize, tail.data(), tail_size);
+	}
+}
+
+nstool::Aes128CtrEngine::Implementation nstool::Aes128CtrEngine::getImplementation() const
+{
+	return mImplementation;
+}
+
+nstool::Aes128CtrEngine::Implementation nstool::Aes128CtrEngine::getBestImplementation()
+{
+	static const Implementation kBestImplementation = isImplementationSupported(Implementation_AesNi) ? Implementation_AesNi : (isImplementationSupported(Implementation_ArmCe) ? Implementation_ArmCe : Implementation_Generic);
+
+	return kBestImplementation;
+}
+
+bool nstool::Aes128CtrEngine::isImplementationSupported(Implementation implementation)
+{
+	switch (implementation)
+	{
+	case (Implementation_Generic):
+		return true;
+#ifdef NSTOOL_AESCTR_HAS_AESNI
+	case (Implementation_AesNi):
+		return isAesNiSupported();
+#endif
+#ifdef NSTOOL_AESCTR_HAS_ARMCE
+	case (Implementation_ArmCe):
+		return isArmCeSupported();
+#endif
+	default:
+		return false;
+	}
+}
+
+std::string nstool::Aes128CtrEngine::getImplementationName(Implementation implementation)
+{
+	switch (implementation)
+	{
+	case (Implementation_AesNi):
+		return "AES-NI";
+	case (Implementation_ArmCe):
+		return "ARMv8-CE";
+	default:
+		return "Generic";
+	}
+}
+
+void nstool::Aes128CtrEngine::expandKey(const byte_t* key, byte_t* round_keys)
+{
+	expandAes128Key(key, round_keys);
+}
+
+void nstool::Aes128CtrEngine::initializeGenericEncryptor()
+{
+	byte_t counter[kBlockSize];
+	writeBe64(counter, mCounterHi);
+	writeBe64(counter + 8, mCounterLo);
+
+	mGenericEncryptor = std::make_shared<tc::crypto::Aes128CtrEncryptor>();
+	mGenericEncryptor->initialize(mRoundKeys.data(), kKeySize, counter, sizeof(counter));
+}
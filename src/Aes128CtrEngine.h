@@ -0,0 +1,68 @@
+#pragma once
+#include "types.h"
+
+#include <array>
+#include <tc/crypto/Aes128CtrEncryptor.h>
+
+namespace nstool {
+
+// AES-128-CTR keystream generator with hardware kernels (AES-NI on x86/x86_64, ARMv8 Crypto Extensions on arm64) selected at runtime.
+// The hardware kernels encrypt 8 counter blocks at a time, so the AES rounds of independent blocks overlap in the CPU pipeline.
+// When no hardware support is available tc::crypto::Aes128CtrEncryptor is used.
+// The counter is a 128bit big endian integer, block n of the keystream is AES(initial counter + n), matching tc::crypto::Aes128CtrEncryptor.
+class Aes128CtrEngine
+{
+public:
+	static const size_t kKeySize = 16;
+	static const size_t kBlockSize = 16;
+
+	enum Implementation
+	{
+		Implementation_Generic,
+		Implementation_AesNi,
+		Implementation_ArmCe
+	};
+
+	Aes128CtrEngine();
+
+	// use implementation instead of the best one available (used to compare implementations), throws tc::NotSupportedException if it is not supported
+	Aes128CtrEngine(Implementation implementation);
+
+	// copies get their own generic encryptor state, so a copy can be used from another thread
+	Aes128CtrEngine(const Aes128CtrEngine& other);
+	Aes128CtrEngine& operator=(const Aes128CtrEngine& other);
+
+	void initialize(const byte_t* key, size_t key_size, const byte_t* counter, size_t counter_size);
+
+	// dst = src ^ keystream, where the keystream starts at block block_number, size does not have to be a multiple of kBlockSize, dst may equal src
+	void crypt(byte_t* dst, const byte_t* src, size_t size, uint64_t block_number);
+
+	Implementation getImplementation() const;
+
+	// fastest implementation supported by this CPU (detected once)
+	static Implementation getBestImplementation();
+	static bool isImplementationSupported(Implementation implementation);
+	static std::string getImplementationName(Implementation implementation);
+
+	// AES-128 key expansion, round_keys receives the 11 round keys (kRoundKeySize bytes, standard FIPS-197 byte order)
+	static const size_t kRoundKeySize = kBlockSize * 11;
+	static void expandKey(const byte_t* key, byte_t* round_keys);
+private:
+	std::string mModuleName;
+
+	Implementation mImplementation;
+	bool mInitialized;
+
+	// expanded key for the hardware kernels (standard FIPS-197 byte order)
+	std::array<byte_t, kRoundKeySize> mRoundKeys;
+
+	// initial counter as two big endian halves
+	uint64_t mCounterHi;
+	uint64_t mCounterLo;
+
+	// Implementation_Generic
+	std::shared_ptr<tc::crypto::Aes128CtrEncryptor> mGenericEncryptor;
+	void initializeGenericEncryptor();
+};
+
+}
@@ -0,0 +1,194 @@
+#include "Aes128CtrStream.h"
+#include "util.h"
+
+#include <tc/io/StreamUtil.h>
+#include <tc/io/IOUtil.h>
+#include <tc/ObjectDisposedException.h>
+#include <tc/NotSupportedException.h>
+#include <tc/ArgumentNullException.h>
+
+#include <cstring>
+#include <algorithm>
+
+nstool::Aes128CtrStream::Aes128CtrStream() :
+	mModuleName("nstool::Aes128CtrStream"),
+	mBaseStream(),
+	mEngine(),
+	mPosition(0),
+	mThreadPool()
+{
+}
+
+nstool::Aes128CtrStream::Aes128CtrStream(const std::shared_ptr<tc::io::IStream>& stream, const key_t& key, const counter_t& counter) :
+	Aes128CtrStream()
+{
+	if (stream == nullptr)
+	{
+		throw tc::ArgumentNullException(mModuleName, "stream is null.");
+	}
+	if (stream->canRead() == false)
+	{
+		throw tc::InvalidOperationException(mModuleName, "stream does not support reading.");
+	}
+	if (stream->canSeek() == false)
+	{
+		throw tc::InvalidOperationException(mModuleName, "stream does not support seeking.");
+	}
+
+	mBaseStream = stream;
+	mEngine.initialize(key.data(), key.size(), counter.data(), counter.size());
+}
+
+nstool::Aes128CtrStream::Aes128CtrStream(const std::shared_ptr<tc::io::IStream>& stream, const key_t& key, const counter_t& counter, const std::shared_ptr<ThreadPool>& thread_pool) :
+	Aes128CtrStream(stream, key, counter)
+{
+	mThreadPool = thread_pool;
+}
+
+bool nstool::Aes128CtrStream::canRead() const
+{
+	return mBaseStream != nullptr;
+}
+
+bool nstool::Aes128CtrStream::canWrite() const
+{
+	return false;
+}
+
+bool nstool::Aes128CtrStream::canSeek() const
+{
+	return mBaseStream != nullptr;
+}
+
+int64_t nstool::Aes128CtrStream::length()
+{
+	if (mBaseStream == nullptr)
+	{
+		throw tc::ObjectDisposedException(mModuleName+"::length()", "Failed to get stream length (stream is disposed)");
+	}
+
+	return mBaseStream->length();
+}
+
+int64_t nstool::Aes128CtrStream::position()
+{
+	if (mBaseStream == nullptr)
+	{
+		throw tc::ObjectDisposedException(mModuleName+"::position()", "Failed to get stream position (stream is disposed)");
+	}
+
+	return mPosition;
+}
+
+size_t nstool::Aes128CtrStream::read(byte_t* ptr, size_t count)
+{
+	if (mBaseStream == nullptr)
+	{
+		throw tc::ObjectDisposedException(mModuleName+"::read()", "Failed to read from stream (stream is disposed)");
+	}
+	if (ptr == nullptr)
+	{
+		throw tc::ArgumentNullException(mModuleName+"::read()", "ptr was null.");
+	}
+
+	size_t read_len = tc::io::IOUtil::getReadableCount(mBaseStream->length(), mPosition, count);
+	if (read_len == 0)
+	{
+		return 0;
+	}
+
+	static const int64_t kBlockSize = int64_t(Aes128CtrEngine::kBlockSize);
+
+	size_t done = 0;
+
+	// first block is partially read, decrypt it in a temporary block
+	size_t head_offset = size_t(mPosition % kBlockSize);
+	if (head_offset != 0)
+	{
+		int64_t block_offset = mPosition - int64_t(head_offset);
+		size_t block_len = std::min<size_t>(size_t(kBlockSize), tc::io::IOUtil::getReadableCount(mBaseStream->length(), block_offset, Aes128CtrEngine::kBlockSize));
+
+		std::array<byte_t, Aes128CtrEngine::kBlockSize> block;
+		readStreamExact(mBaseStream, block_offset, block.data(), block_len, mModuleName+"::read()");
+		mEngine.crypt(block.data(), block.data(), block_len, uint64_t(block_offset / kBlockSize));
+
+		done = std::min<size_t>(read_len, block_len - head_offset);
+		memcpy(ptr, block.data() + head_offset, done);
+	}
+
+	// the remaining data starts on a block boundary, so it is read and decrypted in place (the engine handles a partial final block)
+	if (done < read_len)
+	{
+		int64_t offset = mPosition + int64_t(done);
+		readStreamExact(mBaseStream, offset, ptr + done, read_len - done, mModuleName+"::read()");
+		decryptAligned(offset, ptr + done, read_len - done);
+	}
+
+	mPosition += int64_t(read_len);
+
+	return read_len;
+}
+
+size_t nstool::Aes128CtrStream::write(const byte_t* ptr, size_t count)
+{
+	throw tc::NotSupportedException(mModuleName+"::write()", "write() is not supported for Aes128CtrStream");
+}
+
+int64_t nstool::Aes128CtrStream::seek(int64_t offset, tc::io::SeekOrigin origin)
+{
+	if (mBaseStream == nullptr)
+	{
+		throw tc::ObjectDisposedException(mModuleName+"::seek()", "Failed to set stream position (stream is disposed)");
+	}
+
+	mPosition = tc::io::StreamUtil::getSeekResult(offset, origin, mPosition, mBaseStream->length());
+
+	return mPosition;
+}
+
+void nstool::Aes128CtrStream::setLength(int64_t length)
+{
+	throw tc::NotSupportedException(mModuleName+"::setLength()", "setLength() is not supported for Aes128CtrStream");
+}
+
+void nstool::Aes128CtrStream::flush()
+{
+	if (mBaseStream == nullptr)
+	{
+		throw tc::ObjectDisposedException(mModuleName+"::flush()", "Failed to flush stream (stream is disposed)");
+	}
+
+	mBaseStream->flush();
+}
+
+void nstool::Aes128CtrStream::dispose()
+{
+	// the base stream is not disposed, it is often shared (e.g. with the raw partition reader)
+	mBaseStream.reset();
+	mThreadPool.reset();
+	mPosition = 0;
+}
+
+void nstool::Aes128CtrStream::decryptAligned(int64_t offset, byte_t* ptr, size_t count)
+{
+	uint64_t block_number = uint64_t(offset) / Aes128CtrEngine::kBlockSize;
+
+	if (mThreadPool == nullptr || count < kParallelChunkSize * 2)
+	{
+		mEngine.crypt(ptr, ptr, count, block_number);
+		return;
+	}
+
+	// chunks are a multiple of the block size, so each starts at a known counter and can be decrypted independently
+	// every chunk uses its own copy of the engine, as the generic implementation keeps encryptor state
+	const Aes128CtrEngine& engine = mEngine;
+	const size_t max_chunk_size = kParallelChunkSize;
+	size_t chunk_num = (count + max_chunk_size - 1) / max_chunk_size;
+	mThreadPool->parallelFor(chunk_num, [&engine, ptr, count, block_number, max_chunk_size](size_t chunk_index) {
+		size_t chunk_offset = chunk_index * max_chunk_size;
+		size_t chunk_size = std::min<size_t>(max_chunk_size, count - chunk_offset);
+
+		Aes128CtrEngine chunk_engine = engine;
+		chunk_engine.crypt(ptr + chunk_offset, ptr + chunk_offset, chunk_size, block_number + chunk_offset / Aes128CtrEngine::kBlockSize);
+	});
+}
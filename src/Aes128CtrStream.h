@@ -0,0 +1,47 @@
+#pragma once
+#include "types.h"
+#include "Aes128CtrEngine.h"
+#include "ThreadPool.h"
+
+namespace nstool {
+
+// Read-only IStream that decrypts an AES-128-CTR encrypted stream with Aes128CtrEngine, a replacement for tc::crypto::Aes128CtrEncryptedStream when only reading.
+// Byte 0 of the stream is at the start of the block for the initial counter. Block aligned regions are decrypted in place in the caller's buffer.
+// When a ThreadPool is supplied, large reads are split into counter aligned chunks which are decrypted in parallel.
+class Aes128CtrStream : public tc::io::IStream
+{
+public:
+	using key_t = std::array<byte_t, Aes128CtrEngine::kKeySize>;
+	using counter_t = std::array<byte_t, Aes128CtrEngine::kBlockSize>;
+
+	Aes128CtrStream();
+	Aes128CtrStream(const std::shared_ptr<tc::io::IStream>& stream, const key_t& key, const counter_t& counter);
+	Aes128CtrStream(const std::shared_ptr<tc::io::IStream>& stream, const key_t& key, const counter_t& counter, const std::shared_ptr<ThreadPool>& thread_pool);
+
+	bool canRead() const;
+	bool canWrite() const;
+	bool canSeek() const;
+	int64_t length();
+	int64_t position();
+	size_t read(byte_t* ptr, size_t count);
+	size_t write(const byte_t* ptr, size_t count);
+	int64_t seek(int64_t offset, tc::io::SeekOrigin origin);
+	void setLength(int64_t length);
+	void flush();
+	void dispose();
+private:
+	// size of the chunks a read is split into for parallel decryption, reads smaller than two chunks are decrypted on the calling thread
+	static const size_t kParallelChunkSize = 0x40000;
+
+	std::string mModuleName;
+
+	std::shared_ptr<tc::io::IStream> mBaseStream;
+	Aes128CtrEngine mEngine;
+	int64_t mPosition;
+	std::shared_ptr<ThreadPool> mThreadPool;
+
+	// decrypt count bytes in place, ptr holds the data at block aligned stream offset
+	void decryptAligned(int64_t offset, byte_t* ptr, size_t count);
+};
+
+}
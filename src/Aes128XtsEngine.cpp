@@ -0,0 +1,489 @@
+#include "Aes128XtsEngine.h"
+
+#include <tc/ArgumentOutOfRangeException.h>
+#include <tc/InvalidOperationException.h>
+#include <tc/NotSupportedException.h>
+
+#include <cstring>
+#include <algorithm>
+
+// select hardware kernels for this target (CPU support is detected by Aes128CtrEngine)
+#if defined(__x86_64__) || defined(__i386__) || defined(_M_X64) || defined(_M_IX86)
+	#define NSTOOL_AESXTS_HAS_AESNI
+	#if defined(_MSC_VER) && !defined(__clang__)
+		#include <intrin.h>
+		#define NSTOOL_AESNI_TARGET
+	#else
+		#define NSTOOL_AESNI_TARGET __attribute__((target("aes,sse2")))
+	#endif
+	#include <emmintrin.h>
+	#include <wmmintrin.h>
+#elif defined(__aarch64__)
+	// clang only allows the crypto intrinsics when they are enabled for the whole translation unit, gcc allows them per function
+	#if defined(__ARM_FEATURE_CRYPTO) || defined(__ARM_FEATURE_AES)
+		#define NSTOOL_AESXTS_HAS_ARMCE
+		#define NSTOOL_ARMCE_TARGET
+	#elif defined(__GNUC__) && !defined(__clang__)
+		#define NSTOOL_AESXTS_HAS_ARMCE
+		#define NSTOOL_ARMCE_TARGET __attribute__((target("+crypto")))
+	#endif
+	#ifdef NSTOOL_AESXTS_HAS_ARMCE
+		#include <arm_neon.h>
+	#endif
+#endif
+
+namespace {
+
+// number of sectors whose tweaks are encrypted together
+static const size_t kTweakBatchSize = 8;
+
+inline byte_t gfMul2(byte_t value)
+{
+	return byte_t((value << 1) ^ ((value & 0x80) ? 0x1b : 0x00));
+}
+
+inline byte_t gfMul(byte_t value, byte_t factor)
+{
+	byte_t result = 0;
+	for (; factor != 0; factor >>= 1, value = gfMul2(value))
+	{
+		if (factor & 1)
+		{
+			result ^= value;
+		}
+	}
+	return result;
+}
+
+// InvMixColumns of one round key
+void invMixColumns(const byte_t* src, byte_t* dst)
+{
+	for (size_t c = 0; c < 16; c += 4)
+	{
+		const byte_t* a = src + c;
+		dst[c + 0] = gfMul(a[0], 14) ^ gfMul(a[1], 11) ^ gfMul(a[2], 13) ^ gfMul(a[3], 9);
+		dst[c + 1] = gfMul(a[0], 9) ^ gfMul(a[1], 14) ^ gfMul(a[2], 11) ^ gfMul(a[3], 13);
+		dst[c + 2] = gfMul(a[0], 13) ^ gfMul(a[1], 9) ^ gfMul(a[2], 14) ^ gfMul(a[3], 11);
+		dst[c + 3] = gfMul(a[0], 11) ^ gfMul(a[1], 13) ^ gfMul(a[2], 9) ^ gfMul(a[3], 14);
+	}
+}
+
+// round keys for the equivalent inverse cipher (FIPS-197 section 5.3.5), which both aesdec (AES-NI) and aesd/aesimc (ARMv8) use
+void makeDecryptRoundKeys(const byte_t* round_keys, byte_t* dec_round_keys)
+{
+	memcpy(dec_round_keys, round_keys + 10 * 16, 16);
+	for (size_t r = 1; r < 10; r++)
+	{
+		invMixColumns(round_keys + (10 - r) * 16, dec_round_keys + r * 16);
+	}
+	memcpy(dec_round_keys + 10 * 16, round_keys, 16);
+}
+
+inline uint64_t byteSwap64(uint64_t value)
+{
+#if defined(_MSC_VER) && !defined(__clang__)
+	return _byteswap_uint64(value);
+#else
+	return __builtin_bswap64(value);
+#endif
+}
+
+#ifdef NSTOOL_AESXTS_HAS_AESNI
+NSTOOL_AESNI_TARGET inline __m128i makeTweakBlockAesNi(uint64_t sector_number)
+{
+	// 128bit big endian sector number, the high half is zero
+	return _mm_set_epi64x((long long)byteSwap64(sector_number), 0);
+}
+
+NSTOOL_AESNI_TARGET inline __m128i mulAlphaAesNi(__m128i tweak)
+{
+	// shift the 128bit little endian tweak left by one, the carry out of each dword goes into the next, the carry out of the top is reduced into the bottom (x^128 = x^7 + x^2 + x + 1)
+	const __m128i kCarryMask = _mm_set_epi32(0x87, 1, 1, 1);
+	__m128i carry = _mm_shuffle_epi32(_mm_and_si128(_mm_srai_epi32(tweak, 31), kCarryMask), 0x93);
+	return _mm_xor_si128(_mm_slli_epi32(tweak, 1), carry);
+}
+
+NSTOOL_AESNI_TARGET inline __m128i decryptBlockAesNi(__m128i block, const __m128i* dk)
+{
+	block = _mm_xor_si128(block, dk[0]);
+	for (size_t r = 1; r < 10; r++)
+	{
+		block = _mm_aesdec_si128(block, dk[r]);
+	}
+	return _mm_aesdeclast_si128(block, dk[10]);
+}
+
+NSTOOL_AESNI_TARGET void decryptSectorsAesNi(const byte_t* dec_round_keys, const byte_t* tweak_round_keys, byte_t* dst, const byte_t* src, size_t sector_num, size_t sector_size, uint64_t sector_number, uint64_t sector_step)
+{
+	__m128i dk[11], tk[11];
+	for (size_t r = 0; r < 11; r++)
+	{
+		dk[r] = _mm_loadu_si128((const __m128i*)(dec_round_keys + r * 16));
+		tk[r] = _mm_loadu_si128((const __m128i*)(tweak_round_keys + r * 16));
+	}
+
+	for (; sector_num > 0;)
+	{
+		// initial tweaks of the next 8 sectors, encrypted together (lanes past the last sector are unused)
+		// sector_step is 1 for consecutive sectors, 0 when every sector has the same sector number
+		__m128i t[kTweakBatchSize];
+		for (size_t i = 0; i < kTweakBatchSize; i++)
+		{
+			t[i] = _mm_xor_si128(makeTweakBlockAesNi(sector_number + i * sector_step), tk[0]);
+		}
+		for (size_t r = 1; r < 10; r++)
+		{
+			__m128i k = tk[r];
+			t[0] = _mm_aesenc_si128(t[0], k); t[1] = _mm_aesenc_si128(t[1], k); t[2] = _mm_aesenc_si128(t[2], k); t[3] = _mm_aesenc_si128(t[3], k);
+			t[4] = _mm_aesenc_si128(t[4], k); t[5] = _mm_aesenc_si128(t[5], k); t[6] = _mm_aesenc_si128(t[6], k); t[7] = _mm_aesenc_si128(t[7], k);
+		}
+		t[0] = _mm_aesenclast_si128(t[0], tk[10]); t[1] = _mm_aesenclast_si128(t[1], tk[10]); t[2] = _mm_aesenclast_si128(t[2], tk[10]); t[3] = _mm_aesenclast_si128(t[3], tk[10]);
+		t[4] = _mm_aesenclast_si128(t[4], tk[10]); t[5] = _mm_aesenclast_si128(t[5], tk[10]); t[6] = _mm_aesenclast_si128(t[6], tk[10]); t[7] = _mm_aesenclast_si128(t[7], tk[10]);
+
+		size_t batch_num = std::min<size_t>(sector_num, kTweakBatchSize);
+		for (size_t i = 0; i < batch_num; i++, sector_num--, sector_number += sector_step)
+		{
+			__m128i tweak = t[i];
+			size_t num_blocks = sector_size / 16;
+
+			// 8 blocks per iteration, the tweaks are derived serially but the aesdec of the blocks overlap
+			// (the lanes are written out so they stay in registers without relying on the optimiser to unroll)
+			for (; num_blocks >= 8; num_blocks -= 8, src += 8 * 16, dst += 8 * 16)
+			{
+				__m128i w[8], b[8];
+				w[0] = tweak; w[1] = mulAlphaAesNi(w[0]); w[2] = mulAlphaAesNi(w[1]); w[3] = mulAlphaAesNi(w[2]);
+				w[4] = mulAlphaAesNi(w[3]); w[5] = mulAlphaAesNi(w[4]); w[6] = mulAlphaAesNi(w[5]); w[7] = mulAlphaAesNi(w[6]);
+				tweak = mulAlphaAesNi(w[7]);
+
+				b[0] = _mm_xor_si128(_mm_loadu_si128((const __m128i*)(src + 0x00)), _mm_xor_si128(w[0], dk[0]));
+				b[1] = _mm_xor_si128(_mm_loadu_si128((const __m128i*)(src + 0x10)), _mm_xor_si128(w[1], dk[0]));
+				b[2] = _mm_xor_si128(_mm_loadu_si128((const __m128i*)(src + 0x20)), _mm_xor_si128(w[2], dk[0]));
+				b[3] = _mm_xor_si128(_mm_loadu_si128((const __m128i*)(src + 0x30)), _mm_xor_si128(w[3], dk[0]));
+				b[4] = _mm_xor_si128(_mm_loadu_si128((const __m128i*)(src + 0x40)), _mm_xor_si128(w[4], dk[0]));
+				b[5] = _mm_xor_si128(_mm_loadu_si128((const __m128i*)(src + 0x50)), _mm_xor_si128(w[5], dk[0]));
+				b[6] = _mm_xor_si128(_mm_loadu_si128((const __m128i*)(src + 0x60)), _mm_xor_si128(w[6], dk[0]));
+				b[7] = _mm_xor_si128(_mm_loadu_si128((const __m128i*)(src + 0x70)), _mm_xor_si128(w[7], dk[0]));
+				for (size_t r = 1; r < 10; r++)
+				{
+					__m128i k = dk[r];
+					b[0] = _mm_aesdec_si128(b[0], k); b[1] = _mm_aesdec_si128(b[1], k); b[2] = _mm_aesdec_si128(b[2], k); b[3] = _mm_aesdec_si128(b[3], k);
+					b[4] = _mm_aesdec_si128(b[4], k); b[5] = _mm_aesdec_si128(b[5], k); b[6] = _mm_aesdec_si128(b[6], k); b[7] = _mm_aesdec_si128(b[7], k);
+				}
+				b[0] = _mm_aesdeclast_si128(b[0], dk[10]); b[1] = _mm_aesdeclast_si128(b[1], dk[10]); b[2] = _mm_aesdeclast_si128(b[2], dk[10]); b[3] = _mm_aesdeclast_si128(b[3], dk[10]);
+				b[4] = _mm_aesdeclast_si128(b[4], dk[10]); b[5] = _mm_aesdeclast_si128(b[5], dk[10]); b[6] = _mm_aesdeclast_si128(b[6], dk[10]); b[7] = _mm_aesdeclast_si128(b[7], dk[10]);
+
+				_mm_storeu_si128((__m128i*)(dst + 0x00), _mm_xor_si128(b[0], w[0]));
+				_mm_storeu_si128((__m128i*)(dst + 0x10), _mm_xor_si128(b[1], w[1]));
+				_mm_storeu_si128((__m128i*)(dst + 0x20), _mm_xor_si128(b[2], w[2]));
+				_mm_storeu_si128((__m128i*)(dst + 0x30), _mm_xor_si128(b[3], w[3]));
+				_mm_storeu_si128((__m128i*)(dst + 0x40), _mm_xor_si128(b[4], w[4]));
+				_mm_storeu_si128((__m128i*)(dst + 0x50), _mm_xor_si128(b[5], w[5]));
+				_mm_storeu_si128((__m128i*)(dst + 0x60), _mm_xor_si128(b[6], w[6]));
+				_mm_storeu_si128((__m128i*)(dst + 0x70), _mm_xor_si128(b[7], w[7]));
+			}
+
+			for (; num_blocks > 0; num_blocks--, src += 16, dst += 16)
+			{
+				__m128i block = decryptBlockAesNi(_mm_xor_si128(_mm_loadu_si128((const __m128i*)src), tweak), dk);
+				_mm_storeu_si128((__m128i*)dst, _mm_xor_si128(block, tweak));
+				tweak = mulAlphaAesNi(tweak);
+			}
+		}
+	}
+}
+#endif
+
+#ifdef NSTOOL_AESXTS_HAS_ARMCE
+NSTOOL_ARMCE_TARGET inline uint8x16_t makeTweakBlockArmCe(uint64_t sector_number)
+{
+	// 128bit big endian sector number, the high half is zero
+	return vreinterpretq_u8_u64(vcombine_u64(vcreate_u64(0), vcreate_u64(byteSwap64(sector_number))));
+}
+
+NSTOOL_ARMCE_TARGET inline uint8x16_t mulAlphaArmCe(uint8x16_t tweak)
+{
+	// shift the 128bit little endian tweak left by one, the carry out of each word goes into the next, the carry out of the top is reduced into the bottom (x^128 = x^7 + x^2 + x + 1)
+	static const int32_t kCarryMask[4] = { 1, 1, 1, 0x87 };
+	int32x4_t value = vreinterpretq_s32_u8(tweak);
+	int32x4_t carry = vandq_s32(vshrq_n_s32(value, 31), vld1q_s32(kCarryMask));
+	carry = vextq_s32(carry, carry, 3);
+	return vreinterpretq_u8_s32(veorq_s32(vshlq_n_s32(value, 1), carry));
+}
+
+NSTOOL_ARMCE_TARGET inline uint8x16_t decryptBlockArmCe(uint8x16_t block, const uint8x16_t* dk)
+{
+	// aesd does AddRoundKey+InvShiftRows+InvSubBytes, aesimc does InvMixColumns
+	for (size_t r = 0; r < 9; r++)
+	{
+		block = vaesimcq_u8(vaesdq_u8(block, dk[r]));
+	}
+	block = vaesdq_u8(block, dk[9]);
+	return veorq_u8(block, dk[10]);
+}
+
+NSTOOL_ARMCE_TARGET void decryptSectorsArmCe(const byte_t* dec_round_keys, const byte_t* tweak_round_keys, byte_t* dst, const byte_t* src, size_t sector_num, size_t sector_size, uint64_t sector_number, uint64_t sector_step)
+{
+	uint8x16_t dk[11], tk[11];
+	for (size_t r = 0; r < 11; r++)
+	{
+		dk[r] = vld1q_u8(dec_round_keys + r * 16);
+		tk[r] = vld1q_u8(tweak_round_keys + r * 16);
+	}
+
+	for (; sector_num > 0;)
+	{
+		// initial tweaks of the next 8 sectors, encrypted together (lanes past the last sector are unused)
+		// sector_step is 1 for consecutive sectors, 0 when every sector has the same sector number
+		uint8x16_t t[kTweakBatchSize];
+		for (size_t i = 0; i < kTweakBatchSize; i++)
+		{
+			t[i] = makeTweakBlockArmCe(sector_number + i * sector_step);
+		}
+		for (size_t r = 0; r < 9; r++)
+		{
+			uint8x16_t k = tk[r];
+			t[0] = vaesmcq_u8(vaeseq_u8(t[0], k)); t[1] = vaesmcq_u8(vaeseq_u8(t[1], k)); t[2] = vaesmcq_u8(vaeseq_u8(t[2], k)); t[3] = vaesmcq_u8(vaeseq_u8(t[3], k));
+			t[4] = vaesmcq_u8(vaeseq_u8(t[4], k)); t[5] = vaesmcq_u8(vaeseq_u8(t[5], k)); t[6] = vaesmcq_u8(vaeseq_u8(t[6], k)); t[7] = vaesmcq_u8(vaeseq_u8(t[7], k));
+		}
+		t[0] = veorq_u8(vaeseq_u8(t[0], tk[9]), tk[10]); t[1] = veorq_u8(vaeseq_u8(t[1], tk[9]), tk[10]); t[2] = veorq_u8(vaeseq_u8(t[2], tk[9]), tk[10]); t[3] = veorq_u8(vaeseq_u8(t[3], tk[9]), tk[10]);
+		t[4] = veorq_u8(vaeseq_u8(t[4], tk[9]), tk[10]); t[5] = veorq_u8(vaeseq_u8(t[5], tk[9]), tk[10]); t[6] = veorq_u8(vaeseq_u8(t[6], tk[9]), tk[10]); t[7] = veorq_u8(vaeseq_u8(t[7], tk[9]), tk[10]);
+
+		size_t batch_num = std::min<size_t>(sector_num, kTweakBatchSize);
+		for (size_t i = 0; i < batch_num; i++, sector_num--, sector_number += sector_step)
+		{
+			uint8x16_t tweak = t[i];
+			size_t num_blocks = sector_size / 16;
+
+			// 8 blocks per iteration, the tweaks are derived serially but the aesd/aesimc pairs of the blocks overlap
+			// (the lanes are written out so they stay in registers without relying on the optimiser to unroll)
+			for (; num_blocks >= 8; num_blocks -= 8, src += 8 * 16, dst += 8 * 16)
+			{
+				uint8x16_t w[8], b[8];
+				w[0] = tweak; w[1] = mulAlphaArmCe(w[0]); w[2] = mulAlphaArmCe(w[1]); w[3] = mulAlphaArmCe(w[2]);
+				w[4] = mulAlphaArmCe(w[3]); w[5] = mulAlphaArmCe(w[4]); w[6] = mulAlphaArmCe(w[5]); w[7] = mulAlphaArmCe(w[6]);
+				tweak = mulAlphaArmCe(w[7]);
+
+				b[0] = veorq_u8(vld1q_u8(src + 0x00), w[0]); b[1] = veorq_u8(vld1q_u8(src + 0x10), w[1]); b[2] = veorq_u8(vld1q_u8(src + 0x20), w[2]); b[3] = veorq_u8(vld1q_u8(src + 0x30), w[3]);
+				b[4] = veorq_u8(vld1q_u8(src + 0x40), w[4]); b[5] = veorq_u8(vld1q_u8(src + 0x50), w[5]); b[6] = veorq_u8(vld1q_u8(src + 0x60), w[6]); b[7] = veorq_u8(vld1q_u8(src + 0x70), w[7]);
+				for (size_t r = 0; r < 9; r++)
+				{
+					uint8x16_t k = dk[r];
+					b[0] = vaesimcq_u8(vaesdq_u8(b[0], k)); b[1] = vaesimcq_u8(vaesdq_u8(b[1], k)); b[2] = vaesimcq_u8(vaesdq_u8(b[2], k)); b[3] = vaesimcq_u8(vaesdq_u8(b[3], k));
+					b[4] = vaesimcq_u8(vaesdq_u8(b[4], k)); b[5] = vaesimcq_u8(vaesdq_u8(b[5], k)); b[6] = vaesimcq_u8(vaesdq_u8(b[6], k)); b[7] = vaesimcq_u8(vaesdq_u8(b[7], k));
+				}
+				b[0] = veorq_u8(vaesdq_u8(b[0], dk[9]), dk[10]); b[1] = veorq_u8(vaesdq_u8(b[1], dk[9]), dk[10]); b[2] = veorq_u8(vaesdq_u8(b[2], dk[9]), dk[10]); b[3] = veorq_u8(vaesdq_u8(b[3], dk[9]), dk[10]);
+				b[4] = veorq_u8(vaesdq_u8(b[4], dk[9]), dk[10]); b[5] = veorq_u8(vaesdq_u8(b[5], dk[9]), dk[10]); b[6] = veorq_u8(vaesdq_u8(b[6], dk[9]), dk[10]); b[7] = veorq_u8(vaesdq_u8(b[7], dk[9]), dk[10]);
+
+				vst1q_u8(dst + 0x00, veorq_u8(b[0], w[0]));
+				vst1q_u8(dst + 0x10, veorq_u8(b[1], w[1]));
+				vst1q_u8(dst + 0x20, veorq_u8(b[2], w[2]));
+				vst1q_u8(dst + 0x30, veorq_u8(b[3], w[3]));
+				vst1q_u8(dst + 0x40, veorq_u8(b[4], w[4]));
+				vst1q_u8(dst + 0x50, veorq_u8(b[5], w[5]));
+				vst1q_u8(dst + 0x60, veorq_u8(b[6], w[6]));
+				vst1q_u8(dst + 0x70, veorq_u8(b[7], w[7]));
+			}
+
+			for (; num_blocks > 0; num_blocks--, src += 16, dst += 16)
+			{
+				uint8x16_t block = decryptBlockArmCe(veorq_u8(vld1q_u8(src), tweak), dk);
+				vst1q_u8(dst, veorq_u8(block, tweak));
+				tweak = mulAlphaArmCe(tweak);
+			}
+		}
+	}
+}
+#endif
+
+}
+
+nstool::Aes128XtsEngine::Aes128XtsEngine() :
+	Aes128XtsEngine(getBestImplementation())
+{
+}
+
+nstool::Aes128XtsEngine::Aes128XtsEngine(Implementation implementation) :
+	mModuleName("nstool::Aes128XtsEngine"),
+	mImplementation(implementation),
+	mInitialized(false),
+	mSectorSize(0),
+	mDecryptRoundKeys(),
+	mTweakRoundKeys(),
+	mKey1(),
+	mKey2(),
+	mGenericEncryptor()
+{
+	if (isImplementationSupported(mImplementation) == false)
+	{
+		throw tc::NotSupportedException(mModuleName, fmt::format("{:s} is not supported on this CPU.", getImplementationName(mImplementation)));
+	}
+}
+
+nstool::Aes128XtsEngine::Aes128XtsEngine(const Aes128XtsEngine& other) :
+	Aes128XtsEngine(other.mImplementation)
+{
+	*this = other;
+}
+
+nstool::Aes128XtsEngine& nstool::Aes128XtsEngine::operator=(const Aes128XtsEngine& other)
+{
+	if (this != &other)
+	{
+		mImplementation = other.mImplementation;
+		mInitialized = other.mInitialized;
+		mSectorSize = other.mSectorSize;
+		mDecryptRoundKeys = other.mDecryptRoundKeys;
+		mTweakRoundKeys = other.mTweakRoundKeys;
+		mKey1 = other.mKey1;
+		mKey2 = other.mKey2;
+		mGenericEncryptor.reset();
+		if (mInitialized && mImplementation == Implementation_Generic)
+		{
+			initializeGenericEncryptor();
+		}
+	}
+	return *this;
+}
+
+void nstool::Aes128XtsEngine::initialize(const byte_t* key1, size_t key1_size, const byte_t* key2, size_t key2_size, size_t sector_size)
+{
+	if (key1 == nullptr || key1_size != kKeySize)
+	{
+		throw tc::ArgumentOutOfRangeException(mModuleName, "key1_size was invalid.");
+	}
+	if (key2 == nullptr || key2_size != kKeySize)
+	{
+		throw tc::ArgumentOutOfRangeException(mModuleName, "key2_size was invalid.");
+	}
+	if (sector_size == 0 || sector_size % kBlockSize != 0)
+	{
+		throw tc::ArgumentOutOfRangeException(mModuleName, "sector_size was invalid.");
+	}
+
+	memcpy(mKey1.data(), key1, mKey1.size());
+	memcpy(mKey2.data(), key2, mKey2.size());
+	mSectorSize = sector_size;
+
+	std::array<byte_t, Aes128CtrEngine::kRoundKeySize> round_keys;
+	Aes128CtrEngine::expandKey(key1, round_keys.data());
+	makeDecryptRoundKeys(round_keys.data(), mDecryptRoundKeys.data());
+	Aes128CtrEngine::expandKey(key2, mTweakRoundKeys.data());
+	mInitialized = true;
+
+	mGenericEncryptor.reset();
+	if (mImplementation == Implementation_Generic)
+	{
+		initializeGenericEncryptor();
+	}
+}
+
+void nstool::Aes128XtsEngine::decrypt(byte_t* dst, const byte_t* src, size_t size, uint64_t sector_number)
+{
+	decryptSectors(dst, src, size, sector_number, 1);
+}
+
+void nstool::Aes128XtsEngine::decryptSameSector(byte_t* dst, const byte_t* src, size_t size, uint64_t sector_number)
+{
+	decryptSectors(dst, src, size, sector_number, 0);
+}
+
+void nstool::Aes128XtsEngine::decryptSectors(byte_t* dst, const byte_t* src, size_t size, uint64_t sector_number, uint64_t sector_step)
+{
+	if (mInitialized == false)
+	{
+		throw tc::InvalidOperationException(mModuleName, "Engine was not initialized.");
+	}
+	if (size % mSectorSize != 0)
+	{
+		throw tc::ArgumentOutOfRangeException(mModuleName, "size was not a multiple of the sector size.");
+	}
+
+	size_t sector_num = size / mSectorSize;
+	if (sector_num == 0)
+	{
+		return;
+	}
+
+	switch (mImplementation)
+	{
+#ifdef NSTOOL_AESXTS_HAS_AESNI
+	case (Implementation_AesNi):
+		decryptSectorsAesNi(mDecryptRoundKeys.data(), mTweakRoundKeys.data(), dst, src, sector_num, mSectorSize, sector_number, sector_step);
+		break;
+#endif
+#ifdef NSTOOL_AESXTS_HAS_ARMCE
+	case (Implementation_ArmCe):
+		decryptSectorsArmCe(mDecryptRoundKeys.data(), mTweakRoundKeys.data(), dst, src, sector_num, mSectorSize, sector_number, sector_step);
+		break;
+#endif
+	default:
+		if (sector_step == 1)
+		{
+			mGenericEncryptor->decrypt(dst, src, size, sector_number);
+		}
+		else
+		{
+			for (size_t i = 0; i < sector_num; i++)
+			{
+				mGenericEncryptor->decrypt(dst + i * mSectorSize, src + i * mSectorSize, mSectorSize, sector_number + i * sector_step);
+			}
+		}
+		break;
+	}
+}
+
+size_t nstool::Aes128XtsEngine::getSectorSize() const
+{
+	return mSectorSize;
+}
+
+nstool::Aes128XtsEngine::Implementation nstool::Aes128XtsEngine::getImplementation() const
+{
+	return mImplementation;
+}
+
+nstool::Aes128XtsEngine::Implementation nstool::Aes128XtsEngine::getBestImplementation()
+{
+	static const Implementation kBestImplementation = isImplementationSupported(Implementation_AesNi) ? Implementation_AesNi : (isImplementationSupported(Implementation_ArmCe) ? Implementation_ArmCe : Implementation_Generic);
+
+	return kBestImplementation;
+}
+
+bool nstool::Aes128XtsEngine::isImplementationSupported(Implementation implementation)
+{
+	switch (implementation)
+	{
+	case (Implementation_Generic):
+		return true;
+#ifdef NSTOOL_AESXTS_HAS_AESNI
+	case (Implementation_AesNi):
+		return Aes128CtrEngine::isImplementationSupported(Aes128CtrEngine::Implementation_AesNi);
+#endif
+#ifdef NSTOOL_AESXTS_HAS_ARMCE
+	case (Implementation_ArmCe):
+		return Aes128CtrEngine::isImplementationSupported(Aes128CtrEngine::Implementation_ArmCe);
+#endif
+	default:
+		return false;
+	}
+}
+
+std::string nstool::Aes128XtsEngine::getImplementationName(Implementation implementation)
+{
+	switch (implementation)
+	{
+	case (Implementation_AesNi):
+		return "AES-NI";
+	case (Implementation_ArmCe):
+		return "ARMv8-CE";
+	default:
+		return "Generic";
+	}
+}
+
+void nstool::Aes128XtsEngine::initializeGenericEncryptor()
+{
+	// the last argument selects the big endian (Nintendo) sector number tweak, as used for the NCA header
+	mGenericEncryptor = std::make_shared<tc::crypto::Aes128XtsEncryptor>();
+	mGenericEncryptor->initialize(mKey1.data(), mKey1.size(), mKey2.data(), mKey2.size(), mSectorSize, false);
+}
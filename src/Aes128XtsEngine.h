@@ -0,0 +1,76 @@
+#pragma once
+#include "types.h"
+#include "Aes128CtrEngine.h"
+
+#include <array>
+#include <tc/crypto/Aes128XtsEncryptor.h>
+
+namespace nstool {
+
+// AES-128-XTS sector decryption with hardware kernels (AES-NI on x86/x86_64, ARMv8 Crypto Extensions on arm64) selected at runtime.
+// This is the Nintendo variant of XTS, the tweak of a sector is the sector number as a 128bit big endian integer (standard XTS uses little endian).
+// The hardware kernels encrypt the tweaks of up to 8 sectors at once, then decrypt 8 blocks at a time with the tweak of each block derived from the previous one (multiplication by x in GF(2^128)).
+// When no hardware support is available tc::crypto::Aes128XtsEncryptor is used.
+class Aes128XtsEngine
+{
+public:
+	static const size_t kKeySize = 16;
+	static const size_t kBlockSize = 16;
+
+	enum Implementation
+	{
+		Implementation_Generic,
+		Implementation_AesNi,
+		Implementation_ArmCe
+	};
+
+	Aes128XtsEngine();
+
+	// use implementation instead of the best one available (used to compare implementations), throws tc::NotSupportedException if it is not supported
+	Aes128XtsEngine(Implementation implementation);
+
+	// copies get their own generic encryptor state, so a copy can be used from another thread
+	Aes128XtsEngine(const Aes128XtsEngine& other);
+	Aes128XtsEngine& operator=(const Aes128XtsEngine& other);
+
+	// key1 decrypts the data, key2 encrypts the tweaks, sector_size must be a non-zero multiple of kBlockSize
+	void initialize(const byte_t* key1, size_t key1_size, const byte_t* key2, size_t key2_size, size_t sector_size);
+
+	// decrypt whole sectors, size must be a multiple of the sector size, the data starts at sector sector_number, dst may equal src
+	void decrypt(byte_t* dst, const byte_t* src, size_t size, uint64_t sector_number);
+
+	// decrypt whole sectors which were all encrypted as sector sector_number (e.g. the same header sector of many NCAs), size must be a multiple of the sector size, dst may equal src
+	void decryptSameSector(byte_t* dst, const byte_t* src, size_t size, uint64_t sector_number);
+
+	size_t getSectorSize() const;
+
+	Implementation getImplementation() const;
+
+	// fastest implementation supported by this CPU (detected once)
+	static Implementation getBestImplementation();
+	static bool isImplementationSupported(Implementation implementation);
+	static std::string getImplementationName(Implementation implementation);
+private:
+	std::string mModuleName;
+
+	Implementation mImplementation;
+	bool mInitialized;
+	size_t mSectorSize;
+
+	// expanded keys for the hardware kernels, mDecryptRoundKeys are in the order they are used by the inverse cipher
+	std::array<byte_t, Aes128CtrEngine::kRoundKeySize> mDecryptRoundKeys;
+	std::array<byte_t, Aes128CtrEngine::kRoundKeySize> mTweakRoundKeys;
+
+	// keys are kept for initializeGenericEncryptor()
+	std::array<byte_t, kKeySize> mKey1;
+	std::array<byte_t, kKeySize> mKey2;
+
+	// Implementation_Generic
+	std::shared_ptr<tc::crypto::Aes128XtsEncryptor> mGenericEncryptor;
+	void initializeGenericEncryptor();
+
+	// sector i of the data is sector sector_number + i * sector_step
+	void decryptSectors(byte_t* dst, const byte_t* src, size_t size, uint64_t sector_number, uint64_t sector_step);
+};
+
+}
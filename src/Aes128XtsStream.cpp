@@ -0,0 +1,215 @@
+#include "Aes128XtsStream.h"
+#include "util.h"
+
+#include <tc/io/StreamUtil.h>
+#include <tc/io/IOUtil.h>
+#include <tc/ObjectDisposedException.h>
+#include <tc/NotSupportedException.h>
+#include <tc/ArgumentNullException.h>
+#include <tc/ArgumentOutOfRangeException.h>
+
+#include <cstring>
+#include <algorithm>
+
+nstool::Aes128XtsStream::Aes128XtsStream() :
+	mModuleName("nstool::Aes128XtsStream"),
+	mBaseStream(),
+	mEngine(),
+	mSectorSize(0),
+	mPosition(0),
+	mThreadPool()
+{
+}
+
+nstool::Aes128XtsStream::Aes128XtsStream(const std::shared_ptr<tc::io::IStream>& stream, const key_t& key1, const key_t& key2, size_t sector_size) :
+	Aes128XtsStream()
+{
+	if (stream == nullptr)
+	{
+		throw tc::ArgumentNullException(mModuleName, "stream is null.");
+	}
+	if (stream->canRead() == false)
+	{
+		throw tc::InvalidOperationException(mModuleName, "stream does not support reading.");
+	}
+	if (stream->canSeek() == false)
+	{
+		throw tc::InvalidOperationException(mModuleName, "stream does not support seeking.");
+	}
+
+	// throws if sector_size is not a multiple of the AES block size
+	mEngine.initialize(key1.data(), key1.size(), key2.data(), key2.size(), sector_size);
+
+	// XTS without ciphertext stealing, every sector is whole
+	if (stream->length() % int64_t(sector_size) != 0)
+	{
+		throw tc::ArgumentOutOfRangeException(mModuleName, "stream length was not a multiple of the sector size.");
+	}
+
+	mBaseStream = stream;
+	mSectorSize = sector_size;
+}
+
+nstool::Aes128XtsStream::Aes128XtsStream(const std::shared_ptr<tc::io::IStream>& stream, const key_t& key1, const key_t& key2, size_t sector_size, const std::shared_ptr<ThreadPool>& thread_pool) :
+	Aes128XtsStream(stream, key1, key2, sector_size)
+{
+	mThreadPool = thread_pool;
+}
+
+bool nstool::Aes128XtsStream::canRead() const
+{
+	return mBaseStream != nullptr;
+}
+
+bool nstool::Aes128XtsStream::canWrite() const
+{
+	return false;
+}
+
+bool nstool::Aes128XtsStream::canSeek() const
+{
+	return mBaseStream != nullptr;
+}
+
+int64_t nstool::Aes128XtsStream::length()
+{
+	if (mBaseStream == nullptr)
+	{
+		throw tc::ObjectDisposedException(mModuleName+"::length()", "Failed to get stream length (stream is disposed)");
+	}
+
+	return mBaseStream->length();
+}
+
+int64_t nstool::Aes128XtsStream::position()
+{
+	if (mBaseStream == nullptr)
+	{
+		throw tc::ObjectDisposedException(mModuleName+"::position()", "Failed to get stream position (stream is disposed)");
+	}
+
+	return mPosition;
+}
+
+size_t nstool::Aes128XtsStream::read(byte_t* ptr, size_t count)
+{
+	if (mBaseStream == nullptr)
+	{
+		throw tc::ObjectDisposedException(mModuleName+"::read()", "Failed to read from stream (stream is disposed)");
+	}
+	if (ptr == nullptr)
+	{
+		throw tc::ArgumentNullException(mModuleName+"::read()", "ptr was null.");
+	}
+
+	size_t read_len = tc::io::IOUtil::getReadableCount(mBaseStream->length(), mPosition, count);
+	if (read_len == 0)
+	{
+		return 0;
+	}
+
+	const int64_t sector_size = int64_t(mSectorSize);
+
+	size_t done = 0;
+
+	// first sector is partially read
+	size_t head_offset = size_t(mPosition % sector_size);
+	if (head_offset != 0)
+	{
+		done = std::min<size_t>(read_len, mSectorSize - head_offset);
+		readPartialSector(mPosition - int64_t(head_offset), head_offset, ptr, done);
+	}
+
+	// whole sectors are read and decrypted in place
+	size_t body_len = ((read_len - done) / mSectorSize) * mSectorSize;
+	if (body_len > 0)
+	{
+		int64_t offset = mPosition + int64_t(done);
+		readStreamExact(mBaseStream, offset, ptr + done, body_len, mModuleName+"::read()");
+		decryptAligned(offset, ptr + done, body_len);
+		done += body_len;
+	}
+
+	// last sector is partially read
+	if (done < read_len)
+	{
+		readPartialSector(mPosition + int64_t(done), 0, ptr + done, read_len - done);
+	}
+
+	mPosition += int64_t(read_len);
+
+	return read_len;
+}
+
+size_t nstool::Aes128XtsStream::write(const byte_t* ptr, size_t count)
+{
+	throw tc::NotSupportedException(mModuleName+"::write()", "write() is not supported for Aes128XtsStream");
+}
+
+int64_t nstool::Aes128XtsStream::seek(int64_t offset, tc::io::SeekOrigin origin)
+{
+	if (mBaseStream == nullptr)
+	{
+		throw tc::ObjectDisposedException(mModuleName+"::seek()", "Failed to set stream position (stream is disposed)");
+	}
+
+	mPosition = tc::io::StreamUtil::getSeekResult(offset, origin, mPosition, mBaseStream->length());
+
+	return mPosition;
+}
+
+void nstool::Aes128XtsStream::setLength(int64_t length)
+{
+	throw tc::NotSupportedException(mModuleName+"::setLength()", "setLength() is not supported for Aes128XtsStream");
+}
+
+void nstool::Aes128XtsStream::flush()
+{
+	if (mBaseStream == nullptr)
+	{
+		throw tc::ObjectDisposedException(mModuleName+"::flush()", "Failed to flush stream (stream is disposed)");
+	}
+
+	mBaseStream->flush();
+}
+
+void nstool::Aes128XtsStream::dispose()
+{
+	// the base stream is not disposed, it is often shared (e.g. with the raw partition reader)
+	mBaseStream.reset();
+	mThreadPool.reset();
+	mPosition = 0;
+}
+
+void nstool::Aes128XtsStream::readPartialSector(int64_t offset, size_t sector_offset, byte_t* ptr, size_t count)
+{
+	tc::ByteData sector = tc::ByteData(mSectorSize, false);
+	readStreamExact(mBaseStream, offset, sector.data(), sector.size(), mModuleName+"::read()");
+	mEngine.decrypt(sector.data(), sector.data(), sector.size(), uint64_t(offset) / mSectorSize);
+	memcpy(ptr, sector.data() + sector_offset, count);
+}
+
+void nstool::Aes128XtsStream::decryptAligned(int64_t offset, byte_t* ptr, size_t count)
+{
+	uint64_t sector_number = uint64_t(offset) / mSectorSize;
+
+	if (mThreadPool == nullptr || count < kParallelChunkSize * 2)
+	{
+		mEngine.decrypt(ptr, ptr, count, sector_number);
+		return;
+	}
+
+	// chunks are a multiple of the sector size, so each starts at a known sector and can be decrypted independently
+	// every chunk uses its own copy of the engine, as the generic implementation keeps encryptor state
+	const Aes128XtsEngine& engine = mEngine;
+	const size_t sector_size = mSectorSize;
+	const size_t max_chunk_size = std::max<size_t>(size_t(kParallelChunkSize) - size_t(kParallelChunkSize) % sector_size, sector_size);
+	size_t chunk_num = (count + max_chunk_size - 1) / max_chunk_size;
+	mThreadPool->parallelFor(chunk_num, [&engine, ptr, count, sector_number, sector_size, max_chunk_size](size_t chunk_index) {
+		size_t chunk_offset = chunk_index * max_chunk_size;
+		size_t chunk_size = std::min<size_t>(max_chunk_size, count - chunk_offset);
+
+		Aes128XtsEngine chunk_engine = engine;
+		chunk_engine.decrypt(ptr + chunk_offset, ptr + chunk_offset, chunk_size, sector_number + chunk_offset / sector_size);
+	});
+}
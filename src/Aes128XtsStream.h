@@ -0,0 +1,54 @@
+#pragma once
+#include "types.h"
+#include "Aes128XtsEngine.h"
+#include "ThreadPool.h"
+
+namespace nstool {
+
+// Read-only IStream that decrypts an AES-128-XTS encrypted stream with Aes128XtsEngine, sector 0 is at byte 0 of the stream.
+// Reads are expanded to whole sectors, sectors wholly inside the read are decrypted in place in the caller's buffer, partial sectors at either end are decrypted in a temporary sector.
+// When a ThreadPool is supplied, large reads are split into sector aligned chunks which are decrypted in parallel.
+class Aes128XtsStream : public tc::io::IStream
+{
+public:
+	using key_t = std::array<byte_t, Aes128XtsEngine::kKeySize>;
+
+	// sector (data unit) size of NCA partitions
+	static const size_t kDefaultSectorSize = 0x200;
+
+	Aes128XtsStream();
+	// the stream length must be a multiple of sector_size
+	Aes128XtsStream(const std::shared_ptr<tc::io::IStream>& stream, const key_t& key1, const key_t& key2, size_t sector_size);
+	Aes128XtsStream(const std::shared_ptr<tc::io::IStream>& stream, const key_t& key1, const key_t& key2, size_t sector_size, const std::shared_ptr<ThreadPool>& thread_pool);
+
+	bool canRead() const;
+	bool canWrite() const;
+	bool canSeek() const;
+	int64_t length();
+	int64_t position();
+	size_t read(byte_t* ptr, size_t count);
+	size_t write(const byte_t* ptr, size_t count);
+	int64_t seek(int64_t offset, tc::io::SeekOrigin origin);
+	void setLength(int64_t length);
+	void flush();
+	void dispose();
+private:
+	// size of the chunks a read is split into for parallel decryption, reads smaller than two chunks are decrypted on the calling thread
+	static const size_t kParallelChunkSize = 0x40000;
+
+	std::string mModuleName;
+
+	std::shared_ptr<tc::io::IStream> mBaseStream;
+	Aes128XtsEngine mEngine;
+	size_t mSectorSize;
+	int64_t mPosition;
+	std::shared_ptr<ThreadPool> mThreadPool;
+
+	// decrypt the sector at sector aligned offset into a temporary sector and copy count bytes from sector_offset of it to ptr
+	void readPartialSector(int64_t offset, size_t sector_offset, byte_t* ptr, size_t count);
+
+	// decrypt whole sectors in place, ptr holds the data at sector aligned stream offset
+	void decryptAligned(int64_t offset, byte_t* ptr, size_t count);
+};
+
+}
@@ -1,12 +1,15 @@
 #include "AssetProcess.h"
+#include "OutputCapture.h"
 
 #include "util.h"
 
 nstool::AssetProcess::AssetProcess() :
 	mModuleName("nstool::AssetProcess"),
 	mFile(),
+	mFileFactory(),
 	mCliOutputMode(true, false, false, false),
-	mVerify(false)
+	mVerify(false),
+	mExtractOptions()
 {
 }    
 
@@ -23,6 +26,11 @@ void nstool::AssetProcess::setInputFile(const std::shared_ptr<tc::io::IStream>&
 	mFile = file;
 }
 
+void nstool::AssetProcess::setInputFileFactory(const StreamFactory& file_factory)
+{
+	mFileFactory = file_factory;
+}
+
 void nstool::AssetProcess::setCliOutputMode(CliOutputMode type)
 {
 	mCliOutputMode = type;
@@ -53,6 +61,12 @@ void nstool::AssetProcess::setRomfsExtractJobs(const std::vector<nstool::Extract
 	mRomfs.setExtractJobs(extract_jobs);
 }
 
+void nstool::AssetProcess::setRomfsExtractOptions(const nstool::ExtractOptions& extract_options)
+{
+	mExtractOptions = extract_options;
+	mRomfs.setExtractOptions(extract_options);
+}
+
 void nstool::AssetProcess::importHeader()
 {
 	if (mFile == nullptr)
@@ -85,8 +99,8 @@ void nstool::AssetProcess::processSections()
 		if ((mHdr.getIconInfo().size + mHdr.getIconInfo().offset) > file_size) 
 			throw tc::Exception(mModuleName, "ASET geometry for icon beyond file size");
 
-		fmt::print("Saving {:s}...", mIconExtractPath.get().to_string());
-		writeSubStreamToFile(mFile, mHdr.getIconInfo().offset, mHdr.getIconInfo().size, mIconExtractPath.get());
+		nstool::print("Saving {:s}...", mIconExtractPath.get().to_string());
+		writeSubStreamToFile(mFile, mHdr.getIconInfo().offset, mHdr.getIconInfo().size, mIconExtractPath.get(), getIoBlockSize(1, mExtractOptions.max_io_size));
 	}
 
 	if (mHdr.getNacpInfo().size > 0)
@@ -96,8 +110,8 @@ void nstool::AssetProcess::processSections()
 
 		if (mNacpExtractPath.isSet())
 		{
-			fmt::print("Saving {:s}...", mNacpExtractPath.get().to_string());
-			writeSubStreamToFile(mFile, mHdr.getNacpInfo().offset, mHdr.getNacpInfo().size, mNacpExtractPath.get());
+			nstool::print("Saving {:s}...", mNacpExtractPath.get().to_string());
+			writeSubStreamToFile(mFile, mHdr.getNacpInfo().offset, mHdr.getNacpInfo().size, mNacpExtractPath.get(), getIoBlockSize(1, mExtractOptions.max_io_size));
 		}
 		
 		mNacp.setInputFile(std::make_shared<tc::io::SubStream>(mFile, mHdr.getNacpInfo().offset, mHdr.getNacpInfo().size));
@@ -113,6 +127,15 @@ void nstool::AssetProcess::processSections()
 			throw tc::Exception(mModuleName, "ASET geometry for romfs beyond file size");
 
 		mRomfs.setInputFile(std::make_shared<tc::io::SubStream>(mFile, mHdr.getRomfsInfo().offset, mHdr.getRomfsInfo().size));
+		if (mFileFactory != nullptr)
+		{
+			StreamFactory file_factory = mFileFactory;
+			int64_t romfs_offset = mHdr.getRomfsInfo().offset;
+			int64_t romfs_size = mHdr.getRomfsInfo().size;
+			mRomfs.setInputFileFactory([file_factory, romfs_offset, romfs_size]() -> std::shared_ptr<tc::io::IStream> {
+				return std::make_shared<tc::io::SubStream>(tc::io::SubStream(file_factory(), romfs_offset, romfs_size));
+			});
+		}
 		mRomfs.setCliOutputMode(mCliOutputMode);
 		mRomfs.setVerifyMode(mVerify);
 
@@ -124,16 +147,16 @@ void nstool::AssetProcess::displayHeader()
 {
 	if (mCliOutputMode.show_layout)
 	{
-		fmt::print("[ASET Header]\n");
-		fmt::print("  Icon:\n");
-		fmt::print("    Offset:       0x{:x}\n", mHdr.getIconInfo().offset);
-		fmt::print("    Size:         0x{:x}\n", mHdr.getIconInfo().size);
-		fmt::print("  NACP:\n");
-		fmt::print("    Offset:       0x{:x}\n", mHdr.getNacpInfo().offset);
-		fmt::print("    Size:         0x{:x}\n", mHdr.getNacpInfo().size);
-		fmt::print("  RomFs:\n");
-		fmt::print("    Offset:       0x{:x}\n", mHdr.getRomfsInfo().offset);
-		fmt::print("    Size:         0x{:x}\n", mHdr.getRomfsInfo().size);
+		nstool::print("[ASET Header]\n");
+		nstool::print("  Icon:\n");
+		nstool::print("    Offset:       0x{:x}\n", mHdr.getIconInfo().offset);
+		nstool::print("    Size:         0x{:x}\n", mHdr.getIconInfo().size);
+		nstool::print("  NACP:\n");
+		nstool::print("    Offset:       0x{:x}\n", mHdr.getNacpInfo().offset);
+		nstool::print("    Size:         0x{:x}\n", mHdr.getNacpInfo().size);
+		nstool::print("  RomFs:\n");
+		nstool::print("    Offset:       0x{:x}\n", mHdr.getRomfsInfo().offset);
+		nstool::print("    Size:         0x{:x}\n", mHdr.getRomfsInfo().size);
 	}	
 }
 		
@@ -15,6 +15,7 @@ public:
 	void process();
 
 	void setInputFile(const std::shared_ptr<tc::io::IStream>& file);
+	void setInputFileFactory(const StreamFactory& file_factory);
 	void setCliOutputMode(CliOutputMode type);
 	void setVerifyMode(bool verify);
 
@@ -23,15 +24,18 @@ public:
 	
 	void setRomfsShowFsTree(bool show_fs_tree);
 	void setRomfsExtractJobs(const std::vector<nstool::ExtractJob>& extract_jobs);
+	void setRomfsExtractOptions(const nstool::ExtractOptions& extract_options);
 private:
 	std::string mModuleName;
 
 	std::shared_ptr<tc::io::IStream> mFile;
+	StreamFactory mFileFactory;
 	CliOutputMode mCliOutputMode;
 	bool mVerify;
 
 	tc::Optional<tc::io::Path> mIconExtractPath;
 	tc::Optional<tc::io::Path> mNacpExtractPath;
+	nstool::ExtractOptions mExtractOptions; // also used for the icon and NACP extract
 
 	pie::hac::AssetHeader mHdr;
 	NacpProcess mNacp;
@@ -0,0 +1,131 @@
+#include "BaseNcaSession.h"
+#include "NcaProcess.h"
+#include "Aes128CtrStream.h"
+
+#include <pietendo/hac/ContentArchiveUtil.h>
+
+nstool::BaseNcaSession::BaseNcaSession(const tc::io::Path& nca_path, const KeyBag& keycfg) :
+	mModuleName("nstool::BaseNcaSession"),
+	mPath(nca_path),
+	mKeyCfg(keycfg),
+	mOpenMutex(),
+	mOpened(false),
+	mOpenError(),
+	mProgramId(0),
+	mRomFsOffset(0),
+	mRomFsSize(0),
+	mRomFsEncrypted(false),
+	mRomFsKey(),
+	mRomFsCounter(),
+	mRomFsSparseInfo()
+{
+}
+
+const tc::io::Path& nstool::BaseNcaSession::getPath() const
+{
+	return mPath;
+}
+
+uint64_t nstool::BaseNcaSession::getProgramId()
+{
+	open();
+
+	return mProgramId;
+}
+
+std::shared_ptr<tc::io::IStream> nstool::BaseNcaSession::createRomFsReader(const std::shared_ptr<ThreadPool>& thread_pool)
+{
+	open();
+
+	std::shared_ptr<tc::io::IStream> base_stream = std::make_shared<tc::io::FileStream>(tc::io::FileStream(mPath, tc::io::FileMode::Open, tc::io::FileAccess::Read));
+
+	if (mRomFsSparseInfo.generation.unwrap() != 0)
+	{
+		if (mRomFsEncrypted == false)
+		{
+			return std::make_shared<nstool::SparseStream>(nstool::SparseStream(base_stream, mRomFsOffset, mRomFsSize, mRomFsSparseInfo));
+		}
+		return std::make_shared<nstool::SparseStream>(nstool::SparseStream(base_stream, mRomFsOffset, mRomFsSize, mRomFsSparseInfo, mRomFsKey, mRomFsCounter));
+	}
+
+	std::shared_ptr<tc::io::IStream> raw_reader = std::make_shared<tc::io::SubStream>(tc::io::SubStream(base_stream, mRomFsOffset, mRomFsSize));
+	if (mRomFsEncrypted == false)
+	{
+		return raw_reader;
+	}
+
+	pie::hac::detail::aes_iv_t partition_counter = mRomFsCounter;
+	tc::crypto::IncrementCounterAes128Ctr(partition_counter.data(), mRomFsOffset >> 4);
+	return std::make_shared<nstool::Aes128CtrStream>(nstool::Aes128CtrStream(raw_reader, mRomFsKey, partition_counter, thread_pool));
+}
+
+void nstool::BaseNcaSession::open()
+{
+	std::lock_guard<std::mutex> lock(mOpenMutex);
+
+	if (mOpened)
+	{
+		if (mOpenError.empty() == false)
+		{
+			throw tc::Exception(mModuleName, mOpenError);
+		}
+		return;
+	}
+	mOpened = true;
+
+	try {
+		std::shared_ptr<tc::io::IStream> base_stream = std::make_shared<tc::io::FileStream>(tc::io::FileStream(mPath, tc::io::FileMode::Open, tc::io::FileAccess::Read));
+
+		// only the header is processed, the partitions are not opened
+		NcaProcess obj;
+		obj.setCliOutputMode(CliOutputMode(false, false, false, false));
+		obj.setKeyCfg(mKeyCfg);
+		obj.setInputFile(base_stream);
+		obj.importHeader();
+		obj.generateNcaBodyEncryptionKeys();
+		obj.generatePartitionConfiguration();
+
+		mProgramId = obj.mHdr.getProgramId();
+
+		bool found_romfs = false;
+		for (size_t i = 0; i < obj.mHdr.getPartitionEntryList().size() && found_romfs == false; i++)
+		{
+			const NcaProcess::sPartitionInfo& info = obj.mPartitions[obj.mHdr.getPartitionEntryList()[i].header_index];
+			if (info.format_type != pie::hac::nca::FormatType_RomFs)
+			{
+				continue;
+			}
+
+			if (info.enc_type == pie::hac::nca::EncryptionType_None)
+			{
+				mRomFsEncrypted = false;
+			}
+			else if (info.enc_type == pie::hac::nca::EncryptionType_AesCtr)
+			{
+				if (obj.mContentKey.aes_ctr.isNull())
+					throw tc::Exception("AES-CTR Key was not determined");
+
+				mRomFsEncrypted = true;
+				mRomFsKey = obj.mContentKey.aes_ctr.get();
+				mRomFsCounter = info.aes_ctr;
+			}
+			else
+			{
+				throw tc::Exception(fmt::format("EncryptionType({:s}): UNSUPPORTED", pie::hac::ContentArchiveUtil::getEncryptionTypeAsString(info.enc_type)));
+			}
+
+			mRomFsOffset = info.offset;
+			mRomFsSize = info.size;
+			mRomFsSparseInfo = info.sparse_info;
+			found_romfs = true;
+		}
+		if (found_romfs == false)
+		{
+			throw tc::Exception("Cannot determine RomFs from base nca.");
+		}
+	}
+	catch (const tc::Exception& e) {
+		mOpenError = fmt::format("Failed to open base NCA \"{:s}\" ({:s})", mPath.to_string(), e.error());
+		throw tc::Exception(mModuleName, mOpenError);
+	}
+}
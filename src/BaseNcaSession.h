@@ -0,0 +1,50 @@
+#pragma once
+#include "types.h"
+#include "KeyBag.h"
+#include "ThreadPool.h"
+#include "SparseStream.h"
+
+#include <mutex>
+
+namespace nstool {
+
+// The base NCA of patch (BKTR) NCAs, opened once and shared by every patch NCA (and thread) that needs it.
+// Only the header is processed (when first used) to locate and decrypt the base RomFs, the other partitions are never opened.
+class BaseNcaSession
+{
+public:
+	BaseNcaSession(const tc::io::Path& nca_path, const KeyBag& keycfg);
+
+	const tc::io::Path& getPath() const;
+
+	// program id of the base NCA
+	uint64_t getProgramId();
+
+	// create a decrypted stream of the base RomFs partition, each stream has its own file handle so streams can be used on different threads
+	std::shared_ptr<tc::io::IStream> createRomFsReader(const std::shared_ptr<ThreadPool>& thread_pool);
+private:
+	BaseNcaSession(const BaseNcaSession&) = delete;
+	BaseNcaSession& operator=(const BaseNcaSession&) = delete;
+
+	std::string mModuleName;
+
+	tc::io::Path mPath;
+	KeyBag mKeyCfg;
+
+	// base NCA is opened by the first user, later users get the same result (including the error if it could not be opened)
+	std::mutex mOpenMutex;
+	bool mOpened;
+	std::string mOpenError;
+
+	uint64_t mProgramId;
+	int64_t mRomFsOffset;
+	int64_t mRomFsSize;
+	bool mRomFsEncrypted;
+	KeyBag::aes128_key_t mRomFsKey;
+	pie::hac::detail::aes_iv_t mRomFsCounter; // for NCA offset 0
+	SparseStream::sSparseInfo mRomFsSparseInfo;
+
+	void open();
+};
+
+}
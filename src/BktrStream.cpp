@@ -0,0 +1,337 @@
+#include "BktrStream.h"
+#include "util.h"
+
+#include <tc/io/StreamUtil.h>
+#include <tc/io/IOUtil.h>
+#include <tc/ObjectDisposedException.h>
+#include <tc/NotSupportedException.h>
+#include <tc/ArgumentNullException.h>
+#include <tc/ArgumentOutOfRangeException.h>
+
+#include <cstring>
+#include <algorithm>
+
+nstool::BktrStream::BktrStream() :
+	mModuleName("nstool::BktrStream"),
+	mPatchStream(),
+	mBaseStream(),
+	mKey(),
+	mCounter(),
+	mRelocations(),
+	mRelocationEnd(0),
+	mRelocationCursor(0),
+	mSubsections(),
+	mSubsectionEnd(0),
+	mSubsectionCursor(0),
+	mEngine(),
+	mEngineInitialized(false),
+	mEngineGeneration(0),
+	mPosition(0)
+{
+}
+
+nstool::BktrStream::BktrStream(const std::shared_ptr<tc::io::IStream>& stream, const key_t& key, const counter_t& counter, const sPatchInfo& patch_info, const std::shared_ptr<tc::io::IStream>& base_stream) :
+	BktrStream()
+{
+	if (stream == nullptr)
+	{
+		throw tc::ArgumentNullException(mModuleName, "stream is null.");
+	}
+	if (base_stream == nullptr)
+	{
+		throw tc::ArgumentNullException(mModuleName, "base_stream is null.");
+	}
+	if (stream->canRead() == false || stream->canSeek() == false || base_stream->canRead() == false || base_stream->canSeek() == false)
+	{
+		throw tc::InvalidOperationException(mModuleName, "stream and base_stream must support reading and seeking.");
+	}
+
+	mPatchStream = stream;
+	mBaseStream = base_stream;
+	mKey = key;
+	mCounter = counter;
+
+	// relocation table
+	tc::ByteData entries;
+	readBucketTree(patch_info.indirect_offset.unwrap(), patch_info.indirect_size.unwrap(), patch_info.indirect_header, kRelocationEntrySize, entries, mRelocationEnd);
+	for (size_t i = 0; i < entries.size() / kRelocationEntrySize; i++)
+	{
+		const byte_t* raw = entries.data() + i * kRelocationEntrySize;
+		sRelocationEntry entry;
+		entry.offset = ((const tc::bn::le64<int64_t>*)(raw + 0x0))->unwrap();
+		entry.physical_offset = ((const tc::bn::le64<int64_t>*)(raw + 0x8))->unwrap();
+		entry.is_patch = ((const tc::bn::le32<uint32_t>*)(raw + 0x10))->unwrap() != 0;
+
+		if ((mRelocations.empty() && entry.offset != 0) || (mRelocations.empty() == false && entry.offset <= mRelocations.back().offset) || entry.offset >= mRelocationEnd || entry.physical_offset < 0)
+		{
+			throw tc::ArgumentOutOfRangeException(mModuleName, "Relocation table was corrupt.");
+		}
+
+		// an entry that continues the previous one in the same storage is merged into it, so reads over both are one read
+		if (mRelocations.empty() == false && mRelocations.back().is_patch == entry.is_patch && entry.physical_offset - mRelocations.back().physical_offset == entry.offset - mRelocations.back().offset)
+		{
+			continue;
+		}
+		mRelocations.push_back(entry);
+	}
+	if (mRelocations.empty())
+	{
+		throw tc::ArgumentOutOfRangeException(mModuleName, "Relocation table was empty.");
+	}
+
+	// subsection table
+	readBucketTree(patch_info.aes_ctr_ex_offset.unwrap(), patch_info.aes_ctr_ex_size.unwrap(), patch_info.aes_ctr_ex_header, kSubsectionEntrySize, entries, mSubsectionEnd);
+	for (size_t i = 0; i < entries.size() / kSubsectionEntrySize; i++)
+	{
+		const byte_t* raw = entries.data() + i * kSubsectionEntrySize;
+		sSubsectionEntry entry;
+		entry.offset = ((const tc::bn::le64<int64_t>*)(raw + 0x0))->unwrap();
+		entry.is_encrypted = raw[0x8] == 0;
+		entry.generation = ((const tc::bn::le32<uint32_t>*)(raw + 0xC))->unwrap();
+
+		if ((mSubsections.empty() && entry.offset != 0) || (mSubsections.empty() == false && entry.offset <= mSubsections.back().offset) || entry.offset >= mSubsectionEnd)
+		{
+			throw tc::ArgumentOutOfRangeException(mModuleName, "Subsection table was corrupt.");
+		}
+
+		if (mSubsections.empty() == false && mSubsections.back().generation == entry.generation && mSubsections.back().is_encrypted == entry.is_encrypted)
+		{
+			continue;
+		}
+		mSubsections.push_back(entry);
+	}
+	if (mSubsections.empty())
+	{
+		throw tc::ArgumentOutOfRangeException(mModuleName, "Subsection table was empty.");
+	}
+}
+
+bool nstool::BktrStream::canRead() const
+{
+	return mPatchStream != nullptr;
+}
+
+bool nstool::BktrStream::canWrite() const
+{
+	return false;
+}
+
+bool nstool::BktrStream::canSeek() const
+{
+	return mPatchStream != nullptr;
+}
+
+int64_t nstool::BktrStream::length()
+{
+	if (mPatchStream == nullptr)
+	{
+		throw tc::ObjectDisposedException(mModuleName+"::length()", "Failed to get stream length (stream is disposed)");
+	}
+
+	return mRelocationEnd;
+}
+
+int64_t nstool::BktrStream::position()
+{
+	if (mPatchStream == nullptr)
+	{
+		throw tc::ObjectDisposedException(mModuleName+"::position()", "Failed to get stream position (stream is disposed)");
+	}
+
+	return mPosition;
+}
+
+size_t nstool::BktrStream::read(byte_t* ptr, size_t count)
+{
+	if (mPatchStream == nullptr)
+	{
+		throw tc::ObjectDisposedException(mModuleName+"::read()", "Failed to read from stream (stream is disposed)");
+	}
+	if (ptr == nullptr)
+	{
+		throw tc::ArgumentNullException(mModuleName+"::read()", "ptr was null.");
+	}
+
+	size_t read_len = tc::io::IOUtil::getReadableCount(mRelocationEnd, mPosition, count);
+
+	for (size_t done = 0; done < read_len;)
+	{
+		int64_t offset = mPosition + int64_t(done);
+		size_t index = findEntry(mRelocations, offset, mRelocationCursor);
+		const sRelocationEntry& entry = mRelocations[index];
+
+		int64_t entry_end = (index + 1 < mRelocations.size()) ? mRelocations[index + 1].offset : mRelocationEnd;
+		size_t run_len = std::min<size_t>(read_len - done, size_t(entry_end - offset));
+		int64_t physical_offset = entry.physical_offset + (offset - entry.offset);
+
+		if (entry.is_patch)
+		{
+			readPatch(physical_offset, ptr + done, run_len);
+		}
+		else
+		{
+			readStreamExact(mBaseStream, physical_offset, ptr + done, run_len, mModuleName+"::read()");
+		}
+
+		done += run_len;
+	}
+
+	mPosition += int64_t(read_len);
+
+	return read_len;
+}
+
+size_t nstool::BktrStream::write(const byte_t* ptr, size_t count)
+{
+	throw tc::NotSupportedException(mModuleName+"::write()", "write() is not supported for BktrStream");
+}
+
+int64_t nstool::BktrStream::seek(int64_t offset, tc::io::SeekOrigin origin)
+{
+	if (mPatchStream == nullptr)
+	{
+		throw tc::ObjectDisposedException(mModuleName+"::seek()", "Failed to set stream position (stream is disposed)");
+	}
+
+	mPosition = tc::io::StreamUtil::getSeekResult(offset, origin, mPosition, mRelocationEnd);
+
+	return mPosition;
+}
+
+void nstool::BktrStream::setLength(int64_t length)
+{
+	throw tc::NotSupportedException(mModuleName+"::setLength()", "setLength() is not supported for BktrStream");
+}
+
+void nstool::BktrStream::flush()
+{
+	if (mPatchStream == nullptr)
+	{
+		throw tc::ObjectDisposedException(mModuleName+"::flush()", "Failed to flush stream (stream is disposed)");
+	}
+
+	mPatchStream->flush();
+	mBaseStream->flush();
+}
+
+void nstool::BktrStream::dispose()
+{
+	// the base streams are not disposed, they are shared (e.g. with the raw partition reader)
+	mPatchStream.reset();
+	mBaseStream.reset();
+	mRelocations.clear();
+	mSubsections.clear();
+	mRelocationCursor = 0;
+	mSubsectionCursor = 0;
+	mPosition = 0;
+}
+
+void nstool::BktrStream::readBucketTree(int64_t offset, int64_t size, const BucketTree::sHeader& header, size_t entry_size, tc::ByteData& entries, int64_t& end_offset)
+{
+	size_t table_size = BucketTree::getTableSize(header, entry_size);
+	if (offset < 0 || size < int64_t(table_size))
+	{
+		throw tc::ArgumentOutOfRangeException(mModuleName, "Bucket tree was too small for its entry count.");
+	}
+	if (offset % int64_t(Aes128CtrEngine::kBlockSize) != 0)
+	{
+		throw tc::ArgumentOutOfRangeException(mModuleName, "Bucket tree was not block aligned.");
+	}
+
+	// the tables are encrypted with the partition counter
+	tc::ByteData table = tc::ByteData(table_size);
+	readStreamExact(mPatchStream, offset, table.data(), table.size(), mModuleName+"::read()");
+	Aes128CtrEngine table_engine;
+	table_engine.initialize(mKey.data(), mKey.size(), mCounter.data(), mCounter.size());
+	table_engine.crypt(table.data(), table.data(), table.size(), uint64_t(offset) / Aes128CtrEngine::kBlockSize);
+
+	BucketTree::readEntries(table.data(), header, entry_size, entries, end_offset);
+}
+
+void nstool::BktrStream::readPatch(int64_t offset, byte_t* ptr, size_t count)
+{
+	const int64_t block_size = int64_t(Aes128CtrEngine::kBlockSize);
+
+	for (size_t done = 0; done < count;)
+	{
+		int64_t piece_offset = offset + int64_t(done);
+		if (piece_offset >= mSubsectionEnd)
+		{
+			throw tc::ArgumentOutOfRangeException(mModuleName+"::read()", "Relocation entry was outside of the subsection table.");
+		}
+
+		size_t index = findEntry(mSubsections, piece_offset, mSubsectionCursor);
+		const sSubsectionEntry& entry = mSubsections[index];
+		int64_t entry_end = (index + 1 < mSubsections.size()) ? mSubsections[index + 1].offset : mSubsectionEnd;
+		size_t piece_len = std::min<size_t>(count - done, size_t(entry_end - piece_offset));
+
+		if (entry.is_encrypted == false)
+		{
+			readStreamExact(mPatchStream, piece_offset, ptr + done, piece_len, mModuleName+"::read()");
+			done += piece_len;
+			continue;
+		}
+
+		// an unaligned start is decrypted from a copy of its block, the rest is decrypted in place
+		size_t block_offset = size_t(piece_offset % block_size);
+		if (block_offset != 0)
+		{
+			std::array<byte_t, Aes128CtrEngine::kBlockSize> block;
+			int64_t block_start = piece_offset - int64_t(block_offset);
+			size_t block_len = size_t(std::min<int64_t>(block_size, mPatchStream->length() - block_start));
+			readStreamExact(mPatchStream, block_start, block.data(), block_len, mModuleName+"::read()");
+			decryptPatch(block_start, block.data(), block_len, entry.generation);
+
+			size_t copy_len = std::min<size_t>(piece_len, block_len - block_offset);
+			memcpy(ptr + done, block.data() + block_offset, copy_len);
+			done += copy_len;
+			piece_len -= copy_len;
+			piece_offset += int64_t(copy_len);
+		}
+
+		if (piece_len > 0)
+		{
+			readStreamExact(mPatchStream, piece_offset, ptr + done, piece_len, mModuleName+"::read()");
+			decryptPatch(piece_offset, ptr + done, piece_len, entry.generation);
+			done += piece_len;
+		}
+	}
+}
+
+void nstool::BktrStream::decryptPatch(int64_t offset, byte_t* ptr, size_t count, uint32_t generation)
+{
+	// the subsection generation replaces bytes 4-7 (big endian) of the partition counter
+	if (mEngineInitialized == false || mEngineGeneration != generation)
+	{
+		counter_t counter = mCounter;
+		counter[4] = byte_t(generation >> 24);
+		counter[5] = byte_t(generation >> 16);
+		counter[6] = byte_t(generation >> 8);
+		counter[7] = byte_t(generation);
+
+		mEngine.initialize(mKey.data(), mKey.size(), counter.data(), counter.size());
+		mEngineInitialized = true;
+		mEngineGeneration = generation;
+	}
+
+	mEngine.crypt(ptr, ptr, count, uint64_t(offset) / Aes128CtrEngine::kBlockSize);
+}
+
+template <class T>
+size_t nstool::BktrStream::findEntry(const std::vector<T>& entries, int64_t offset, size_t& cursor)
+{
+	// sequential reads stay in the last entry or move on to the next one
+	for (size_t i = cursor; i < entries.size() && i <= cursor + 1; i++)
+	{
+		if (entries[i].offset <= offset && (i + 1 == entries.size() || offset < entries[i + 1].offset))
+		{
+			cursor = i;
+			return cursor;
+		}
+	}
+
+	// otherwise the last entry starting at or before offset
+	auto itr = std::upper_bound(entries.begin(), entries.end(), offset, [](int64_t value, const T& entry) { return value < entry.offset; });
+	cursor = size_t(itr - entries.begin()) - 1;
+	return cursor;
+}
@@ -0,0 +1,104 @@
+#pragma once
+#include "types.h"
+#include "Aes128CtrEngine.h"
+#include "BucketTree.h"
+
+namespace nstool {
+
+// Read-only IStream over a patch (BKTR) RomFs partition, a replacement for pie::hac::BKTREncryptedStream.
+// The relocation (IndirectStorage) and subsection (AesCtrEx) bucket trees are loaded once into flat tables sorted by offset, where adjacent entries that continue each other are merged.
+// Reads find their entry with a cursor (sequential reads) or a binary search, and each run of a read within one entry is read from the base or patch storage at once.
+class BktrStream : public tc::io::IStream
+{
+public:
+	using key_t = std::array<byte_t, Aes128CtrEngine::kKeySize>;
+	using counter_t = std::array<byte_t, Aes128CtrEngine::kBlockSize>;
+
+#pragma pack(push,1)
+	// patch_info of the NCA FS header
+	struct sPatchInfo
+	{
+		tc::bn::le64<int64_t> indirect_offset;
+		tc::bn::le64<int64_t> indirect_size;
+		BucketTree::sHeader indirect_header;
+		tc::bn::le64<int64_t> aes_ctr_ex_offset;
+		tc::bn::le64<int64_t> aes_ctr_ex_size;
+		BucketTree::sHeader aes_ctr_ex_header;
+	};
+#pragma pack(pop)
+	static_assert(sizeof(sPatchInfo) == 0x40, "sPatchInfo size.");
+
+	BktrStream();
+
+	// stream is the raw patch partition, counter is the partition's AES-CTR counter for the start of the partition (the bucket trees are encrypted with it)
+	// base_stream is the decrypted base RomFs partition
+	BktrStream(const std::shared_ptr<tc::io::IStream>& stream, const key_t& key, const counter_t& counter, const sPatchInfo& patch_info, const std::shared_ptr<tc::io::IStream>& base_stream);
+
+	bool canRead() const;
+	bool canWrite() const;
+	bool canSeek() const;
+	int64_t length();
+	int64_t position();
+	size_t read(byte_t* ptr, size_t count);
+	size_t write(const byte_t* ptr, size_t count);
+	int64_t seek(int64_t offset, tc::io::SeekOrigin origin);
+	void setLength(int64_t length);
+	void flush();
+	void dispose();
+private:
+	std::string mModuleName;
+
+	static const size_t kRelocationEntrySize = 0x14;
+	static const size_t kSubsectionEntrySize = 0x10;
+
+	// maps [offset, next entry offset) of the patched partition to the base or patch partition
+	struct sRelocationEntry
+	{
+		int64_t offset;
+		int64_t physical_offset;
+		bool is_patch;
+	};
+
+	// AES-CTR counter generation for [offset, next entry offset) of the patch partition
+	struct sSubsectionEntry
+	{
+		int64_t offset;
+		uint32_t generation;
+		bool is_encrypted;
+	};
+
+	std::shared_ptr<tc::io::IStream> mPatchStream;
+	std::shared_ptr<tc::io::IStream> mBaseStream;
+	key_t mKey;
+	counter_t mCounter;
+
+	std::vector<sRelocationEntry> mRelocations;
+	int64_t mRelocationEnd;
+	size_t mRelocationCursor;
+
+	std::vector<sSubsectionEntry> mSubsections;
+	int64_t mSubsectionEnd;
+	size_t mSubsectionCursor;
+
+	// engine for the last subsection generation used
+	Aes128CtrEngine mEngine;
+	bool mEngineInitialized;
+	uint32_t mEngineGeneration;
+
+	int64_t mPosition;
+
+	// read a bucket tree's entries (entry_size bytes each, in order) and the end offset of the last entry
+	void readBucketTree(int64_t offset, int64_t size, const BucketTree::sHeader& header, size_t entry_size, tc::ByteData& entries, int64_t& end_offset);
+
+	// read count bytes of the patch partition at offset, decrypted with the subsections' counters
+	void readPatch(int64_t offset, byte_t* ptr, size_t count);
+
+	// decrypt count bytes in place, ptr holds the data at block aligned patch partition offset
+	void decryptPatch(int64_t offset, byte_t* ptr, size_t count, uint32_t generation);
+
+	// index of the entry containing offset (entries are sorted by offset, the first starts at 0), cursor is the entry found last
+	template <class T>
+	static size_t findEntry(const std::vector<T>& entries, int64_t offset, size_t& cursor);
+};
+
+}
@@ -0,0 +1,64 @@
+#include "BucketTree.h"
+
+#include <tc/NotSupportedException.h>
+#include <tc/ArgumentOutOfRangeException.h>
+
+#include <cstring>
+
+size_t nstool::BucketTree::getTableSize(const sHeader& header, size_t entry_size)
+{
+	if (header.magic.unwrap() != kMagic)
+	{
+		throw tc::ArgumentOutOfRangeException("nstool::BucketTree", "Bucket tree header had invalid magic.");
+	}
+	if (header.entry_count.unwrap() <= 0)
+	{
+		return 0;
+	}
+
+	size_t entry_count = size_t(header.entry_count.unwrap());
+	size_t entries_per_set = (kNodeSize - kNodeHeaderSize) / entry_size;
+	size_t entry_set_count = (entry_count + entries_per_set - 1) / entries_per_set;
+	if (entry_set_count > (kNodeSize - kNodeHeaderSize) / sizeof(int64_t))
+	{
+		throw tc::NotSupportedException("nstool::BucketTree", "Bucket trees with more than one node level are not supported.");
+	}
+
+	return kNodeSize * (1 + entry_set_count);
+}
+
+void nstool::BucketTree::readEntries(const byte_t* table, const sHeader& header, size_t entry_size, tc::ByteData& entries, int64_t& end_offset)
+{
+	size_t table_size = getTableSize(header, entry_size);
+	if (table_size == 0)
+	{
+		entries = tc::ByteData();
+		end_offset = 0;
+		return;
+	}
+
+	size_t entry_count = size_t(header.entry_count.unwrap());
+	size_t entries_per_set = (kNodeSize - kNodeHeaderSize) / entry_size;
+	size_t entry_set_count = table_size / kNodeSize - 1;
+
+	end_offset = ((const tc::bn::le64<int64_t>*)(table + 0x8))->unwrap();
+
+	entries = tc::ByteData(entry_count * entry_size);
+	size_t entries_read = 0;
+	for (size_t i = 0; i < entry_set_count; i++)
+	{
+		const byte_t* entry_set = table + kNodeSize * (1 + i);
+		size_t set_entry_count = size_t(((const tc::bn::le32<int32_t>*)(entry_set + 0x4))->unwrap());
+		if (set_entry_count > entries_per_set || entries_read + set_entry_count > entry_count)
+		{
+			throw tc::ArgumentOutOfRangeException("nstool::BucketTree", "Bucket tree entry set was corrupt.");
+		}
+
+		memcpy(entries.data() + entries_read * entry_size, entry_set + kNodeHeaderSize, set_entry_count * entry_size);
+		entries_read += set_entry_count;
+	}
+	if (entries_read != entry_count)
+	{
+		throw tc::ArgumentOutOfRangeException("nstool::BucketTree", "Bucket tree entry count did not match its header.");
+	}
+}
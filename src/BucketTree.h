@@ -0,0 +1,33 @@
+#pragma once
+#include "types.h"
+
+namespace nstool {
+
+// Table format (BKTR) of the relocation/subsection tables of NCA patch partitions, and the tables of NCA sparse partitions.
+// The first node holds the start offsets of the entry sets, the entry sets follow it (one node each). Only trees with this single node level are supported.
+class BucketTree
+{
+public:
+	static const uint32_t kMagic = 0x52544B42; // "BKTR"
+	static const size_t kNodeSize = 0x4000;
+	static const size_t kNodeHeaderSize = 0x10;
+
+#pragma pack(push,1)
+	struct sHeader
+	{
+		tc::bn::le32<uint32_t> magic;
+		tc::bn::le32<uint32_t> version;
+		tc::bn::le32<int32_t> entry_count;
+		tc::bn::le32<uint32_t> reserved;
+	};
+#pragma pack(pop)
+	static_assert(sizeof(sHeader) == 0x10, "BucketTree::sHeader size.");
+
+	// size of the table for header's entry count (0 if it has no entries), throws if the header is invalid or the tree needs more than one node level
+	static size_t getTableSize(const sHeader& header, size_t entry_size);
+
+	// copy the entries (entry_size bytes each, in order) from a decrypted table of getTableSize() bytes, end_offset is the end of the last entry
+	static void readEntries(const byte_t* table, const sHeader& header, size_t entry_size, tc::ByteData& entries, int64_t& end_offset);
+};
+
+}
@@ -1,4 +1,5 @@
 #include "CnmtProcess.h"
+#include "OutputCapture.h"
 
 #include <pietendo/hac/ContentMetaUtil.h>
 
@@ -68,11 +69,11 @@ void nstool::CnmtProcess::importCnmt()
 void nstool::CnmtProcess::displayCnmt()
 {
 	const pie::hac::sContentMetaHeader* cnmt_hdr = (const pie::hac::sContentMetaHeader*)mCnmt.getBytes().data();
-	fmt::print("[ContentMeta]\n");
-	fmt::print("  TitleId:               0x{:016x}\n", mCnmt.getTitleId());
-	fmt::print("  Version:               {:s} (v{:d})\n", pie::hac::ContentMetaUtil::getVersionAsString(mCnmt.getTitleVersion()), mCnmt.getTitleVersion());
-	fmt::print("  Type:                  {:s} ({:d})\n", pie::hac::ContentMetaUtil::getContentMetaTypeAsString(mCnmt.getContentMetaType()), (uint32_t)mCnmt.getContentMetaType());
-	fmt::print("  Attributes:            0x{:x}", *((byte_t*)&cnmt_hdr->attributes));
+	nstool::print("[ContentMeta]\n");
+	nstool::print("  TitleId:               0x{:016x}\n", mCnmt.getTitleId());
+	nstool::print("  Version:               {:s} (v{:d})\n", pie::hac::ContentMetaUtil::getVersionAsString(mCnmt.getTitleVersion()), mCnmt.getTitleVersion());
+	nstool::print("  Type:                  {:s} ({:d})\n", pie::hac::ContentMetaUtil::getContentMetaTypeAsString(mCnmt.getContentMetaType()), (uint32_t)mCnmt.getContentMetaType());
+	nstool::print("  Attributes:            0x{:x}", *((byte_t*)&cnmt_hdr->attributes));
 	if (mCnmt.getAttribute().size())
 	{
 		std::vector<std::string> attribute_list;
@@ -82,63 +83,63 @@ void nstool::CnmtProcess::displayCnmt()
 			attribute_list.push_back(pie::hac::ContentMetaUtil::getContentMetaAttributeFlagAsString(pie::hac::cnmt::ContentMetaAttributeFlag(*itr)));
 		}
 
-		fmt::print(" [");
+		nstool::print(" [");
 		for (auto itr = attribute_list.begin(); itr != attribute_list.end(); itr++)
 		{
-			fmt::print("{:s}",*itr);
+			nstool::print("{:s}",*itr);
 			if ((itr + 1) != attribute_list.end())
 			{
-				fmt::print(", ");
+				nstool::print(", ");
 			}
 		}
-		fmt::print("]");
+		nstool::print("]");
 	}
-	fmt::print("\n");
+	nstool::print("\n");
 
-	fmt::print("  StorageId:             {:s} ({:d})\n", pie::hac::ContentMetaUtil::getStorageIdAsString(mCnmt.getStorageId()), (uint32_t)mCnmt.getStorageId());
-	fmt::print("  ContentInstallType:    {:s} ({:d})\n", pie::hac::ContentMetaUtil::getContentInstallTypeAsString(mCnmt.getContentInstallType()),(uint32_t)mCnmt.getContentInstallType());
-	fmt::print("  RequiredDownloadSystemVersion: {:s} (v{:d})\n", pie::hac::ContentMetaUtil::getVersionAsString(mCnmt.getRequiredDownloadSystemVersion()), mCnmt.getRequiredDownloadSystemVersion());
+	nstool::print("  StorageId:             {:s} ({:d})\n", pie::hac::ContentMetaUtil::getStorageIdAsString(mCnmt.getStorageId()), (uint32_t)mCnmt.getStorageId());
+	nstool::print("  ContentInstallType:    {:s} ({:d})\n", pie::hac::ContentMetaUtil::getContentInstallTypeAsString(mCnmt.getContentInstallType()),(uint32_t)mCnmt.getContentInstallType());
+	nstool::print("  RequiredDownloadSystemVersion: {:s} (v{:d})\n", pie::hac::ContentMetaUtil::getVersionAsString(mCnmt.getRequiredDownloadSystemVersion()), mCnmt.getRequiredDownloadSystemVersion());
 	switch(mCnmt.getContentMetaType())
 	{
 		case (pie::hac::cnmt::ContentMetaType_Application):
-			fmt::print("  ApplicationExtendedHeader:\n");
-			fmt::print("    RequiredApplicationVersion: {:s} (v{:d})\n", pie::hac::ContentMetaUtil::getVersionAsString(mCnmt.getApplicationMetaExtendedHeader().getRequiredApplicationVersion()), mCnmt.getApplicationMetaExtendedHeader().getRequiredApplicationVersion());
-			fmt::print("    RequiredSystemVersion:      {:s} (v{:d})\n", pie::hac::ContentMetaUtil::getVersionAsString(mCnmt.getApplicationMetaExtendedHeader().getRequiredSystemVersion()), mCnmt.getApplicationMetaExtendedHeader().getRequiredSystemVersion());
-			fmt::print("    PatchId:                    0x{:016x}\n", mCnmt.getApplicationMetaExtendedHeader().getPatchId());
+			nstool::print("  ApplicationExtendedHeader:\n");
+			nstool::print("    RequiredApplicationVersion: {:s} (v{:d})\n", pie::hac::ContentMetaUtil::getVersionAsString(mCnmt.getApplicationMetaExtendedHeader().getRequiredApplicationVersion()), mCnmt.getApplicationMetaExtendedHeader().getRequiredApplicationVersion());
+			nstool::print("    RequiredSystemVersion:      {:s} (v{:d})\n", pie::hac::ContentMetaUtil::getVersionAsString(mCnmt.getApplicationMetaExtendedHeader().getRequiredSystemVersion()), mCnmt.getApplicationMetaExtendedHeader().getRequiredSystemVersion());
+			nstool::print("    PatchId:                    0x{:016x}\n", mCnmt.getApplicationMetaExtendedHeader().getPatchId());
 			break;
 		case (pie::hac::cnmt::ContentMetaType_Patch):
-			fmt::print("  PatchMetaExtendedHeader:\n");
-			fmt::print("    RequiredSystemVersion: {:s} (v{:d})\n", pie::hac::ContentMetaUtil::getVersionAsString(mCnmt.getPatchMetaExtendedHeader().getRequiredSystemVersion()), mCnmt.getPatchMetaExtendedHeader().getRequiredSystemVersion());
-			fmt::print("    ApplicationId:         0x{:016x}\n", mCnmt.getPatchMetaExtendedHeader().getApplicationId());
+			nstool::print("  PatchMetaExtendedHeader:\n");
+			nstool::print("    RequiredSystemVersion: {:s} (v{:d})\n", pie::hac::ContentMetaUtil::getVersionAsString(mCnmt.getPatchMetaExtendedHeader().getRequiredSystemVersion()), mCnmt.getPatchMetaExtendedHeader().getRequiredSystemVersion());
+			nstool::print("    ApplicationId:         0x{:016x}\n", mCnmt.getPatchMetaExtendedHeader().getApplicationId());
 			break;
 		case (pie::hac::cnmt::ContentMetaType_AddOnContent):
-			fmt::print("  AddOnContentMetaExtendedHeader:\n");
-			fmt::print("    RequiredApplicationVersion: {:s} (v{:d})\n", pie::hac::ContentMetaUtil::getVersionAsString(mCnmt.getAddOnContentMetaExtendedHeader().getRequiredApplicationVersion()), mCnmt.getAddOnContentMetaExtendedHeader().getRequiredApplicationVersion());
-			fmt::print("    ApplicationId:         0x{:016x}\n", mCnmt.getAddOnContentMetaExtendedHeader().getApplicationId());
+			nstool::print("  AddOnContentMetaExtendedHeader:\n");
+			nstool::print("    RequiredApplicationVersion: {:s} (v{:d})\n", pie::hac::ContentMetaUtil::getVersionAsString(mCnmt.getAddOnContentMetaExtendedHeader().getRequiredApplicationVersion()), mCnmt.getAddOnContentMetaExtendedHeader().getRequiredApplicationVersion());
+			nstool::print("    ApplicationId:         0x{:016x}\n", mCnmt.getAddOnContentMetaExtendedHeader().getApplicationId());
 			break;
 		case (pie::hac::cnmt::ContentMetaType_Delta):
-			fmt::print("  DeltaMetaExtendedHeader:\n");
-			fmt::print("    ApplicationId:         0x{:016x}\n", mCnmt.getDeltaMetaExtendedHeader().getApplicationId());
+			nstool::print("  DeltaMetaExtendedHeader:\n");
+			nstool::print("    ApplicationId:         0x{:016x}\n", mCnmt.getDeltaMetaExtendedHeader().getApplicationId());
 			break;
 		default:
 			break;
 	}
 	if (mCnmt.getContentInfo().size() > 0)
 	{
-		fmt::print("  ContentInfo:\n");
+		nstool::print("  ContentInfo:\n");
 		for (size_t i = 0; i < mCnmt.getContentInfo().size(); i++)
 		{
 			const pie::hac::ContentInfo& info = mCnmt.getContentInfo()[i];
-			fmt::print("    {:d}\n", i);
-			fmt::print("      Type:         {:s} ({:d})\n", pie::hac::ContentMetaUtil::getContentTypeAsString(info.getContentType()), (uint32_t)info.getContentType());
-			fmt::print("      Id:           {:s}\n", tc::cli::FormatUtil::formatBytesAsString(info.getContentId().data(), info.getContentId().size(), false, ""));
-			fmt::print("      Size:         0x{:x}\n", info.getContentSize());
-			fmt::print("      Hash:         {:s}\n", tc::cli::FormatUtil::formatBytesAsString(info.getContentHash().data(), info.getContentHash().size(), false, ""));
+			nstool::print("    {:d}\n", i);
+			nstool::print("      Type:         {:s} ({:d})\n", pie::hac::ContentMetaUtil::getContentTypeAsString(info.getContentType()), (uint32_t)info.getContentType());
+			nstool::print("      Id:           {:s}\n", tc::cli::FormatUtil::formatBytesAsString(info.getContentId().data(), info.getContentId().size(), false, ""));
+			nstool::print("      Size:         0x{:x}\n", info.getContentSize());
+			nstool::print("      Hash:         {:s}\n", tc::cli::FormatUtil::formatBytesAsString(info.getContentHash().data(), info.getContentHash().size(), false, ""));
 		}
 	}
 	if (mCnmt.getContentMetaInfo().size() > 0)
 	{
-		fmt::print("  ContentMetaInfo:\n");
+		nstool::print("  ContentMetaInfo:\n");
 		displayContentMetaInfoList(mCnmt.getContentMetaInfo(), "    ");
 	}
 
@@ -146,47 +147,47 @@ void nstool::CnmtProcess::displayCnmt()
 	if (mCnmt.getContentMetaType() == pie::hac::cnmt::ContentMetaType_Patch && mCnmt.getPatchMetaExtendedHeader().getExtendedDataSize() != 0)
 	{
 		// this is stubbed as the raw output is for development purposes
-		//fmt::print("  PatchMetaExtendedData:\n");
+		//nstool::print("  PatchMetaExtendedData:\n");
 		//tc::cli::FormatUtil::formatBytesAsHxdHexString(mCnmt.getPatchMetaExtendedData().data(), mCnmt.getPatchMetaExtendedData().size());
 	}
 	else if (mCnmt.getContentMetaType() == pie::hac::cnmt::ContentMetaType_Delta && mCnmt.getDeltaMetaExtendedHeader().getExtendedDataSize() != 0)
 	{
 		// this is stubbed as the raw output is for development purposes
-		//fmt::print("  DeltaMetaExtendedData:\n");
+		//nstool::print("  DeltaMetaExtendedData:\n");
 		//tc::cli::FormatUtil::formatBytesAsHxdHexString(mCnmt.getDeltaMetaExtendedData().data(), mCnmt.getDeltaMetaExtendedData().size());
 	}
 	else if (mCnmt.getContentMetaType() == pie::hac::cnmt::ContentMetaType_SystemUpdate && mCnmt.getSystemUpdateMetaExtendedHeader().getExtendedDataSize() != 0)
 	{
-		fmt::print("  SystemUpdateMetaExtendedData:\n");
-		fmt::print("    FormatVersion:         {:d}\n", mCnmt.getSystemUpdateMetaExtendedData().getFormatVersion());
-		fmt::print("    FirmwareVariation:\n");
+		nstool::print("  SystemUpdateMetaExtendedData:\n");
+		nstool::print("    FormatVersion:         {:d}\n", mCnmt.getSystemUpdateMetaExtendedData().getFormatVersion());
+		nstool::print("    FirmwareVariation:\n");
 		auto variation_info = mCnmt.getSystemUpdateMetaExtendedData().getFirmwareVariationInfo();
 		for (size_t i = 0; i < mCnmt.getSystemUpdateMetaExtendedData().getFirmwareVariationInfo().size(); i++)
 		{
-			fmt::print("      {:d}\n", i);
-			fmt::print("        FirmwareVariationId:  0x{:x}\n", variation_info[i].variation_id);
+			nstool::print("      {:d}\n", i);
+			nstool::print("        FirmwareVariationId:  0x{:x}\n", variation_info[i].variation_id);
 			if (mCnmt.getSystemUpdateMetaExtendedData().getFormatVersion() == 2)
 			{
-				fmt::print("        ReferToBase:          {}\n", variation_info[i].meta.empty());
+				nstool::print("        ReferToBase:          {}\n", variation_info[i].meta.empty());
 				if (variation_info[i].meta.empty() == false)
 				{
-					fmt::print("        ContentMeta:\n");
+					nstool::print("        ContentMeta:\n");
 					displayContentMetaInfoList(variation_info[i].meta, "          ");
 				}
 			}
 		}
 	}
 
-	fmt::print("  Digest:   {:s}\n", tc::cli::FormatUtil::formatBytesAsString(mCnmt.getDigest().data(), mCnmt.getDigest().size(), false, ""));
+	nstool::print("  Digest:   {:s}\n", tc::cli::FormatUtil::formatBytesAsString(mCnmt.getDigest().data(), mCnmt.getDigest().size(), false, ""));
 }
 
 void nstool::CnmtProcess::displayContentMetaInfo(const pie::hac::ContentMetaInfo& content_meta_info, const std::string& prefix)
 {
 	const pie::hac::sContentMetaInfo* content_meta_info_raw = (const pie::hac::sContentMetaInfo*)content_meta_info.getBytes().data();
-	fmt::print("{:s}Id:           0x{:016x}\n", prefix, content_meta_info.getTitleId());
-	fmt::print("{:s}Version:      {:s} (v{:d})\n", prefix, pie::hac::ContentMetaUtil::getVersionAsString(content_meta_info.getTitleVersion()), content_meta_info.getTitleVersion());
-	fmt::print("{:s}Type:         {:s} ({:d})\n", prefix, pie::hac::ContentMetaUtil::getContentMetaTypeAsString(content_meta_info.getContentMetaType()), (uint32_t)content_meta_info.getContentMetaType());
-	fmt::print("{:s}Attributes:   0x{:x}", prefix, *((byte_t*)&content_meta_info_raw->attributes) );
+	nstool::print("{:s}Id:           0x{:016x}\n", prefix, content_meta_info.getTitleId());
+	nstool::print("{:s}Version:      {:s} (v{:d})\n", prefix, pie::hac::ContentMetaUtil::getVersionAsString(content_meta_info.getTitleVersion()), content_meta_info.getTitleVersion());
+	nstool::print("{:s}Type:         {:s} ({:d})\n", prefix, pie::hac::ContentMetaUtil::getContentMetaTypeAsString(content_meta_info.getContentMetaType()), (uint32_t)content_meta_info.getContentMetaType());
+	nstool::print("{:s}Attributes:   0x{:x}", prefix, *((byte_t*)&content_meta_info_raw->attributes) );
 	if (content_meta_info.getAttribute().size())
 	{
 		std::vector<std::string> attribute_list;
@@ -196,18 +197,18 @@ void nstool::CnmtProcess::displayContentMetaInfo(const pie::hac::ContentMetaInfo
 			attribute_list.push_back(pie::hac::ContentMetaUtil::getContentMetaAttributeFlagAsString(pie::hac::cnmt::ContentMetaAttributeFlag(*itr)));
 		}
 
-		fmt::print(" [");
+		nstool::print(" [");
 		for (auto itr = attribute_list.begin(); itr != attribute_list.end(); itr++)
 		{
-			fmt::print("{:s}",*itr);
+			nstool::print("{:s}",*itr);
 			if ((itr + 1) != attribute_list.end())
 			{
-				fmt::print(", ");
+				nstool::print(", ");
 			}
 		}
-		fmt::print("]");
+		nstool::print("]");
 	}
-	fmt::print("\n");
+	nstool::print("\n");
 }
 
 void nstool::CnmtProcess::displayContentMetaInfoList(const std::vector<pie::hac::ContentMetaInfo>& content_meta_info_list, const std::string& prefix)
@@ -215,7 +216,7 @@ void nstool::CnmtProcess::displayContentMetaInfoList(const std::vector<pie::hac:
 	for (size_t i = 0; i < content_meta_info_list.size(); i++)
 	{
 		const pie::hac::ContentMetaInfo& info = mCnmt.getContentMetaInfo()[i];
-		fmt::print("{:s}{:d}\n", i);
+		nstool::print("{:s}{:d}\n", i);
 		displayContentMetaInfo(info, prefix + "  ");
 	}
 }
\ No newline at end of file
@@ -0,0 +1,375 @@
+#include "CompressedStream.h"
+#include "util.h"
+
+#include <tc/io/StreamUtil.h>
+#include <tc/io/IOUtil.h>
+#include <tc/ObjectDisposedException.h>
+#include <tc/NotSupportedException.h>
+#include <tc/ArgumentNullException.h>
+#include <tc/ArgumentOutOfRangeException.h>
+
+#include <lz4.h>
+
+#include <cstring>
+#include <algorithm>
+
+nstool::CompressedStream::CompressedStream() :
+	mModuleName("nstool::CompressedStream"),
+	mBaseStream(),
+	mThreadPool(),
+	mLength(0),
+	mEntries(),
+	mCursor(0),
+	mBlockCache(),
+	mPosition(0)
+{
+}
+
+nstool::CompressedStream::CompressedStream(const std::shared_ptr<tc::io::IStream>& stream, const sCompressionInfo& compression_info) :
+	CompressedStream()
+{
+	if (stream == nullptr)
+	{
+		throw tc::ArgumentNullException(mModuleName, "stream is null.");
+	}
+	if (stream->canRead() == false || stream->canSeek() == false)
+	{
+		throw tc::InvalidOperationException(mModuleName, "stream must support reading and seeking.");
+	}
+
+	mBaseStream = stream;
+
+	loadTable(compression_info);
+}
+
+nstool::CompressedStream::CompressedStream(const std::shared_ptr<tc::io::IStream>& stream, const sCompressionInfo& compression_info, const std::shared_ptr<ThreadPool>& thread_pool) :
+	CompressedStream(stream, compression_info)
+{
+	mThreadPool = thread_pool;
+}
+
+bool nstool::CompressedStream::canRead() const
+{
+	return mBaseStream != nullptr;
+}
+
+bool nstool::CompressedStream::canWrite() const
+{
+	return false;
+}
+
+bool nstool::CompressedStream::canSeek() const
+{
+	return mBaseStream != nullptr;
+}
+
+int64_t nstool::CompressedStream::length()
+{
+	if (mBaseStream == nullptr)
+	{
+		throw tc::ObjectDisposedException(mModuleName+"::length()", "Failed to get stream length (stream is disposed)");
+	}
+
+	return mLength;
+}
+
+int64_t nstool::CompressedStream::position()
+{
+	if (mBaseStream == nullptr)
+	{
+		throw tc::ObjectDisposedException(mModuleName+"::position()", "Failed to get stream position (stream is disposed)");
+	}
+
+	return mPosition;
+}
+
+size_t nstool::CompressedStream::read(byte_t* ptr, size_t count)
+{
+	if (mBaseStream == nullptr)
+	{
+		throw tc::ObjectDisposedException(mModuleName+"::read()", "Failed to read from stream (stream is disposed)");
+	}
+	if (ptr == nullptr)
+	{
+		throw tc::ArgumentNullException(mModuleName+"::read()", "ptr was null.");
+	}
+
+	size_t read_len = tc::io::IOUtil::getReadableCount(mLength, mPosition, count);
+	int64_t read_end = mPosition + int64_t(read_len);
+
+	for (size_t done = 0; done < read_len;)
+	{
+		int64_t offset = mPosition + int64_t(done);
+		size_t index = findEntry(offset);
+		const sEntry& entry = mEntries[index];
+
+		int64_t entry_end = getEntryEnd(index);
+		size_t run_len = std::min<size_t>(read_len - done, size_t(entry_end - offset));
+
+		if (entry.compression_type == CompressionType_Zeros)
+		{
+			memset(ptr + done, 0, run_len);
+		}
+		else if (entry.compression_type == CompressionType_None)
+		{
+			readStreamExact(mBaseStream, entry.physical_offset + (offset - entry.offset), ptr + done, run_len, mModuleName+"::read()");
+		}
+		else if (offset == entry.offset && entry_end <= read_end)
+		{
+			// this and the following compressed blocks that are wholly inside the read are decompressed straight to ptr
+			size_t block_num = 1;
+			while (index + block_num < mEntries.size() && mEntries[index + block_num].compression_type == CompressionType_Lz4 && getEntryEnd(index + block_num) <= read_end)
+			{
+				run_len += size_t(getEntryEnd(index + block_num) - mEntries[index + block_num].offset);
+				block_num++;
+			}
+
+			decompressEntries(index, block_num, ptr + done);
+		}
+		else
+		{
+			const tc::ByteData& block = getCachedBlock(index);
+			memcpy(ptr + done, block.data() + (offset - entry.offset), run_len);
+		}
+
+		done += run_len;
+	}
+
+	mPosition += int64_t(read_len);
+
+	return read_len;
+}
+
+size_t nstool::CompressedStream::write(const byte_t* ptr, size_t count)
+{
+	throw tc::NotSupportedException(mModuleName+"::write()", "write() is not supported for CompressedStream");
+}
+
+int64_t nstool::CompressedStream::seek(int64_t offset, tc::io::SeekOrigin origin)
+{
+	if (mBaseStream == nullptr)
+	{
+		throw tc::ObjectDisposedException(mModuleName+"::seek()", "Failed to set stream position (stream is disposed)");
+	}
+
+	mPosition = tc::io::StreamUtil::getSeekResult(offset, origin, mPosition, mLength);
+
+	return mPosition;
+}
+
+void nstool::CompressedStream::setLength(int64_t length)
+{
+	throw tc::NotSupportedException(mModuleName+"::setLength()", "setLength() is not supported for CompressedStream");
+}
+
+void nstool::CompressedStream::flush()
+{
+	if (mBaseStream == nullptr)
+	{
+		throw tc::ObjectDisposedException(mModuleName+"::flush()", "Failed to flush stream (stream is disposed)");
+	}
+
+	mBaseStream->flush();
+}
+
+void nstool::CompressedStream::dispose()
+{
+	// the base stream is not disposed, it is the partition's (shared) hash layer stream
+	mBaseStream.reset();
+	mThreadPool.reset();
+	mEntries.clear();
+	mBlockCache.clear();
+	mCursor = 0;
+	mPosition = 0;
+}
+
+void nstool::CompressedStream::loadTable(const sCompressionInfo& compression_info)
+{
+	int64_t table_offset = compression_info.table_offset.unwrap();
+	size_t table_size = BucketTree::getTableSize(compression_info.table_header, kEntrySize);
+	if (table_offset < 0 || compression_info.table_size.unwrap() < int64_t(table_size) || table_offset + int64_t(table_size) > mBaseStream->length())
+	{
+		throw tc::ArgumentOutOfRangeException(mModuleName, "Compression table was outside of the partition.");
+	}
+
+	mEntries.clear();
+	mLength = 0;
+	if (table_size == 0)
+	{
+		return;
+	}
+
+	tc::ByteData table = tc::ByteData(table_size);
+	readStreamExact(mBaseStream, table_offset, table.data(), table.size(), mModuleName+"::read()");
+
+	tc::ByteData entries;
+	int64_t end_offset = 0;
+	BucketTree::readEntries(table.data(), compression_info.table_header, kEntrySize, entries, end_offset);
+
+	std::vector<sEntry> table_entries;
+	for (size_t i = 0; i < entries.size() / kEntrySize; i++)
+	{
+		const byte_t* raw = entries.data() + i * kEntrySize;
+		sEntry entry;
+		entry.offset = ((const tc::bn::le64<int64_t>*)(raw + 0x0))->unwrap();
+		entry.physical_offset = ((const tc::bn::le64<int64_t>*)(raw + 0x8))->unwrap();
+		entry.compression_type = raw[0x10];
+		entry.physical_size = size_t(((const tc::bn::le32<uint32_t>*)(raw + 0x14))->unwrap());
+
+		if ((table_entries.empty() && entry.offset != 0) || (table_entries.empty() == false && entry.offset <= table_entries.back().offset) || entry.offset >= end_offset)
+		{
+			throw tc::ArgumentOutOfRangeException(mModuleName, "Compression table was corrupt.");
+		}
+		if (entry.compression_type != CompressionType_None && entry.compression_type != CompressionType_Zeros && entry.compression_type != CompressionType_Lz4)
+		{
+			throw tc::NotSupportedException(mModuleName, fmt::format("CompressionType({:d}): UNSUPPORTED", entry.compression_type));
+		}
+
+		table_entries.push_back(entry);
+	}
+
+	int64_t base_length = mBaseStream->length();
+	for (size_t i = 0; i < table_entries.size(); i++)
+	{
+		sEntry& entry = table_entries[i];
+		int64_t size = ((i + 1 < table_entries.size()) ? table_entries[i + 1].offset : end_offset) - entry.offset;
+
+		// stored size of the block in the base stream
+		int64_t physical_size = 0;
+		if (entry.compression_type == CompressionType_None)
+		{
+			physical_size = size;
+		}
+		else if (entry.compression_type == CompressionType_Lz4)
+		{
+			if (size > int64_t(kMaxBlockSize) || entry.physical_size == 0 || entry.physical_size > size_t(LZ4_COMPRESSBOUND(kMaxBlockSize)))
+			{
+				throw tc::ArgumentOutOfRangeException(mModuleName, "Compression table entry was invalid.");
+			}
+			physical_size = int64_t(entry.physical_size);
+		}
+		if (physical_size != 0 && (entry.physical_offset < 0 || entry.physical_offset + physical_size > base_length))
+		{
+			throw tc::ArgumentOutOfRangeException(mModuleName, "Compression table entry was outside of the partition.");
+		}
+
+		// adjacent zero blocks, and adjacent uncompressed blocks stored one after the other, are read as one
+		if (mEntries.empty() == false)
+		{
+			const sEntry& prev = mEntries.back();
+			bool is_contiguous_none = prev.compression_type == CompressionType_None && entry.compression_type == CompressionType_None && prev.physical_offset + (entry.offset - prev.offset) == entry.physical_offset;
+			bool is_contiguous_zeros = prev.compression_type == CompressionType_Zeros && entry.compression_type == CompressionType_Zeros;
+			if (is_contiguous_none || is_contiguous_zeros)
+			{
+				continue;
+			}
+		}
+		mEntries.push_back(entry);
+	}
+
+	mLength = end_offset;
+}
+
+int64_t nstool::CompressedStream::getEntryEnd(size_t index) const
+{
+	return (index + 1 < mEntries.size()) ? mEntries[index + 1].offset : mLength;
+}
+
+const tc::ByteData& nstool::CompressedStream::getCachedBlock(size_t index)
+{
+	for (auto itr = mBlockCache.begin(); itr != mBlockCache.end(); itr++)
+	{
+		if (itr->index == index)
+		{
+			mBlockCache.splice(mBlockCache.begin(), mBlockCache, itr);
+			return mBlockCache.front().data;
+		}
+	}
+
+	sCachedBlock block;
+	block.index = index;
+	block.data = tc::ByteData(size_t(getEntryEnd(index) - mEntries[index].offset), false);
+	decompressEntries(index, 1, block.data.data());
+
+	mBlockCache.push_front(block);
+	if (mBlockCache.size() > kBlockCacheNum)
+	{
+		mBlockCache.pop_back();
+	}
+
+	return mBlockCache.front().data;
+}
+
+void nstool::CompressedStream::decompressEntries(size_t first_index, size_t count, byte_t* ptr)
+{
+	// offsets of each block's compressed data in the read buffer and of its decompressed data at ptr
+	std::vector<size_t> src_offsets(count);
+	std::vector<size_t> dst_offsets(count);
+	size_t src_size = 0;
+	for (size_t i = 0; i < count; i++)
+	{
+		src_offsets[i] = src_size;
+		dst_offsets[i] = size_t(mEntries[first_index + i].offset - mEntries[first_index].offset);
+		src_size += mEntries[first_index + i].physical_size;
+	}
+
+	// compressed blocks stored one after the other are read at once
+	tc::ByteData src = tc::ByteData(src_size, false);
+	for (size_t i = 0; i < count;)
+	{
+		size_t run_num = 1;
+		while (i + run_num < count && mEntries[first_index + i + run_num].physical_offset == mEntries[first_index + i + run_num - 1].physical_offset + int64_t(mEntries[first_index + i + run_num - 1].physical_size))
+		{
+			run_num++;
+		}
+
+		size_t run_end = (i + run_num < count) ? src_offsets[i + run_num] : src_size;
+		readStreamExact(mBaseStream, mEntries[first_index + i].physical_offset, src.data() + src_offsets[i], run_end - src_offsets[i], mModuleName+"::read()");
+		i += run_num;
+	}
+
+	if (mThreadPool == nullptr || count < 2)
+	{
+		for (size_t i = 0; i < count; i++)
+		{
+			decompressBlock(first_index + i, src.data() + src_offsets[i], ptr + dst_offsets[i]);
+		}
+		return;
+	}
+
+	// the blocks are independent, so each is decompressed on its own thread
+	const byte_t* src_data = src.data();
+	mThreadPool->parallelFor(count, [this, first_index, src_data, ptr, &src_offsets, &dst_offsets](size_t i) {
+		decompressBlock(first_index + i, src_data + src_offsets[i], ptr + dst_offsets[i]);
+	});
+}
+
+void nstool::CompressedStream::decompressBlock(size_t index, const byte_t* src, byte_t* dst) const
+{
+	const sEntry& entry = mEntries[index];
+	size_t dst_size = size_t(getEntryEnd(index) - entry.offset);
+
+	// block sizes are limited by loadTable(), so they fit the LZ4 api
+	int decomp_size = LZ4_decompress_safe((const char*)src, (char*)dst, int(entry.physical_size), int(dst_size));
+	if (decomp_size < 0 || size_t(decomp_size) != dst_size)
+	{
+		throw tc::Exception(mModuleName, fmt::format("Compressed block at 0x{:x} failed to decompress.", entry.offset));
+	}
+}
+
+size_t nstool::CompressedStream::findEntry(int64_t offset)
+{
+	// sequential reads stay in the last entry or move on to the next one
+	for (size_t i = mCursor; i < mEntries.size() && i <= mCursor + 1; i++)
+	{
+		if (mEntries[i].offset <= offset && (i + 1 == mEntries.size() || offset < mEntries[i + 1].offset))
+		{
+			mCursor = i;
+			return mCursor;
+		}
+	}
+
+	auto itr = std::upper_bound(mEntries.begin(), mEntries.end(), offset, [](int64_t value, const sEntry& entry) { return value < entry.offset; });
+	mCursor = size_t(itr - mEntries.begin()) - 1;
+	return mCursor;
+}
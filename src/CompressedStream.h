@@ -0,0 +1,107 @@
+#pragma once
+#include "types.h"
+#include "BucketTree.h"
+#include "ThreadPool.h"
+
+#include <list>
+
+namespace nstool {
+
+// Read-only IStream over the compression layer of an NCA partition, which sits on top of the hash layer (the compression table and data are in the hash verified data).
+// The table is loaded once into a flat list of blocks sorted by offset, each block is stored uncompressed, LZ4 compressed or not stored (zeros).
+// Compressed blocks wholly inside a read are decompressed straight into the caller's buffer, in parallel when a ThreadPool is supplied.
+// Blocks only partially read are decompressed into a small cache of recent blocks, as the FS layer reads its metadata in many small reads.
+class CompressedStream : public tc::io::IStream
+{
+public:
+#pragma pack(push,1)
+	// compression_info of the NCA FS header
+	struct sCompressionInfo
+	{
+		tc::bn::le64<int64_t> table_offset; // relative to the start of the hash verified data
+		tc::bn::le64<int64_t> table_size;
+		BucketTree::sHeader table_header;
+		std::array<byte_t, 8> reserved;
+	};
+#pragma pack(pop)
+	static_assert(sizeof(sCompressionInfo) == 0x28, "sCompressionInfo size.");
+
+	CompressedStream();
+	CompressedStream(const std::shared_ptr<tc::io::IStream>& stream, const sCompressionInfo& compression_info);
+	CompressedStream(const std::shared_ptr<tc::io::IStream>& stream, const sCompressionInfo& compression_info, const std::shared_ptr<ThreadPool>& thread_pool);
+
+	bool canRead() const;
+	bool canWrite() const;
+	bool canSeek() const;
+	int64_t length();
+	int64_t position();
+	size_t read(byte_t* ptr, size_t count);
+	size_t write(const byte_t* ptr, size_t count);
+	int64_t seek(int64_t offset, tc::io::SeekOrigin origin);
+	void setLength(int64_t length);
+	void flush();
+	void dispose();
+private:
+	std::string mModuleName;
+
+	static const size_t kEntrySize = 0x18;
+
+	// largest decompressed size of one compressed block
+	static const size_t kMaxBlockSize = 0x1000000;
+
+	// number of decompressed blocks kept for partial reads
+	static const size_t kBlockCacheNum = 8;
+
+	enum CompressionType
+	{
+		CompressionType_None = 0,
+		CompressionType_Zeros = 1,
+		CompressionType_Lz4 = 3
+	};
+
+	// maps [offset, next entry offset) of the stream to a block of the base stream
+	struct sEntry
+	{
+		int64_t offset;
+		int64_t physical_offset;
+		size_t physical_size;
+		byte_t compression_type;
+	};
+
+	struct sCachedBlock
+	{
+		size_t index;
+		tc::ByteData data;
+	};
+
+	std::shared_ptr<tc::io::IStream> mBaseStream;
+	std::shared_ptr<ThreadPool> mThreadPool;
+	int64_t mLength;
+
+	std::vector<sEntry> mEntries;
+	size_t mCursor;
+
+	// most recently used first
+	std::list<sCachedBlock> mBlockCache;
+
+	int64_t mPosition;
+
+	void loadTable(const sCompressionInfo& compression_info);
+
+	// end offset of the entry at index
+	int64_t getEntryEnd(size_t index) const;
+
+	// decompressed data of the compressed entry at index, from the cache if present
+	const tc::ByteData& getCachedBlock(size_t index);
+
+	// decompress the compressed entries [first_index, first_index + count) to ptr, which holds their whole decompressed size
+	void decompressEntries(size_t first_index, size_t count, byte_t* ptr);
+
+	// decompress the compressed data src of the entry at index to dst, which holds its whole decompressed size
+	void decompressBlock(size_t index, const byte_t* src, byte_t* dst) const;
+
+	// index of the entry containing offset
+	size_t findEntry(int64_t offset);
+};
+
+}
@@ -0,0 +1,265 @@
+#include "ContentHasher.h"
+
+#include <cstring>
+#include <algorithm>
+
+namespace {
+
+// crc32 lookup tables for slicing-by-8, table[0] is the classic byte at a time table
+struct Crc32Tables
+{
+	uint32_t table[8][256];
+
+	Crc32Tables()
+	{
+		static const uint32_t kPolynomial = 0xEDB88320;
+
+		for (uint32_t i = 0; i < 256; i++)
+		{
+			uint32_t crc = i;
+			for (size_t bit = 0; bit < 8; bit++)
+			{
+				crc = (crc & 1) ? ((crc >> 1) ^ kPolynomial) : (crc >> 1);
+			}
+			table[0][i] = crc;
+		}
+
+		for (uint32_t i = 0; i < 256; i++)
+		{
+			for (size_t slice = 1; slice < 8; slice++)
+			{
+				table[slice][i] = (table[slice - 1][i] >> 8) ^ table[0][table[slice - 1][i] & 0xff];
+			}
+		}
+	}
+};
+
+const Crc32Tables& getCrc32Tables()
+{
+	static const Crc32Tables kTables;
+	return kTables;
+}
+
+inline uint32_t readLe32(const byte_t* data)
+{
+	return uint32_t(data[0]) | (uint32_t(data[1]) << 8) | (uint32_t(data[2]) << 16) | (uint32_t(data[3]) << 24);
+}
+
+inline uint64_t readLe64(const byte_t* data)
+{
+	return uint64_t(readLe32(data)) | (uint64_t(readLe32(data + 4)) << 32);
+}
+
+inline uint64_t rotl64(uint64_t x, int r)
+{
+	return (x << r) | (x >> (64 - r));
+}
+
+const uint64_t kXxPrime1 = 11400714785074694791ULL;
+const uint64_t kXxPrime2 = 14029467366897019727ULL;
+const uint64_t kXxPrime3 = 1609587929392839161ULL;
+const uint64_t kXxPrime4 = 9650029242287828579ULL;
+const uint64_t kXxPrime5 = 2870177450012600261ULL;
+
+inline uint64_t xxHashRound(uint64_t acc, uint64_t input)
+{
+	acc += input * kXxPrime2;
+	acc = rotl64(acc, 31);
+	acc *= kXxPrime1;
+	return acc;
+}
+
+inline uint64_t xxHashMergeRound(uint64_t acc, uint64_t val)
+{
+	acc ^= xxHashRound(0, val);
+	acc = acc * kXxPrime1 + kXxPrime4;
+	return acc;
+}
+
+}
+
+nstool::ContentHasher::ContentHasher(uint32_t hash_types) :
+	mHashTypes(hash_types),
+	mSha256Gen(),
+	mSha256(),
+	mCrc32(0xFFFFFFFF),
+	mXxHashAcc(),
+	mXxHashStripe(),
+	mXxHashStripeLen(0),
+	mXxHashTotalLen(0),
+	mXxHash64(0)
+{
+	if (mHashTypes & HashType_Sha256)
+	{
+		mSha256Gen.initialize();
+	}
+
+	mXxHashAcc[0] = kXxPrime1 + kXxPrime2;
+	mXxHashAcc[1] = kXxPrime2;
+	mXxHashAcc[2] = 0;
+	mXxHashAcc[3] = 0 - kXxPrime1;
+}
+
+uint32_t nstool::ContentHasher::getHashTypes() const
+{
+	return mHashTypes;
+}
+
+void nstool::ContentHasher::update(const byte_t* data, size_t len)
+{
+	if (mHashTypes & HashType_Sha256)
+	{
+		mSha256Gen.update(data, len);
+	}
+	if (mHashTypes & HashType_Crc32)
+	{
+		updateCrc32(data, len);
+	}
+	if (mHashTypes & HashType_XxHash64)
+	{
+		updateXxHash64(data, len);
+	}
+}
+
+void nstool::ContentHasher::finalize()
+{
+	if (mHashTypes & HashType_Sha256)
+	{
+		mSha256Gen.getHash(mSha256.data());
+	}
+	if (mHashTypes & HashType_Crc32)
+	{
+		mCrc32 ^= 0xFFFFFFFF;
+	}
+	if (mHashTypes & HashType_XxHash64)
+	{
+		finalizeXxHash64();
+	}
+}
+
+const nstool::ContentHasher::sha256_hash_t& nstool::ContentHasher::getSha256() const
+{
+	return mSha256;
+}
+
+uint32_t nstool::ContentHasher::getCrc32() const
+{
+	return mCrc32;
+}
+
+uint64_t nstool::ContentHasher::getXxHash64() const
+{
+	return mXxHash64;
+}
+
+void nstool::ContentHasher::updateCrc32(const byte_t* data, size_t len)
+{
+	const Crc32Tables& tables = getCrc32Tables();
+
+	uint32_t crc = mCrc32;
+
+	// 8 bytes per step
+	for (; len >= 8; data += 8, len -= 8)
+	{
+		uint32_t lo = readLe32(data) ^ crc;
+		uint32_t hi = readLe32(data + 4);
+		crc = tables.table[7][lo & 0xff] ^ tables.table[6][(lo >> 8) & 0xff] ^ tables.table[5][(lo >> 16) & 0xff] ^ tables.table[4][lo >> 24] ^
+		      tables.table[3][hi & 0xff] ^ tables.table[2][(hi >> 8) & 0xff] ^ tables.table[1][(hi >> 16) & 0xff] ^ tables.table[0][hi >> 24];
+	}
+
+	for (; len > 0; data++, len--)
+	{
+		crc = (crc >> 8) ^ tables.table[0][(crc ^ *data) & 0xff];
+	}
+
+	mCrc32 = crc;
+}
+
+void nstool::ContentHasher::updateXxHash64(const byte_t* data, size_t len)
+{
+	mXxHashTotalLen += len;
+
+	// complete a stripe left over from the previous update
+	if (mXxHashStripeLen > 0)
+	{
+		size_t copy_len = std::min<size_t>(mXxHashStripe.size() - mXxHashStripeLen, len);
+		memcpy(mXxHashStripe.data() + mXxHashStripeLen, data, copy_len);
+		mXxHashStripeLen += copy_len;
+		data += copy_len;
+		len -= copy_len;
+
+		if (mXxHashStripeLen < mXxHashStripe.size())
+		{
+			return;
+		}
+
+		for (size_t i = 0; i < mXxHashAcc.size(); i++)
+		{
+			mXxHashAcc[i] = xxHashRound(mXxHashAcc[i], readLe64(mXxHashStripe.data() + i * 8));
+		}
+		mXxHashStripeLen = 0;
+	}
+
+	for (; len >= mXxHashStripe.size(); data += mXxHashStripe.size(), len -= mXxHashStripe.size())
+	{
+		mXxHashAcc[0] = xxHashRound(mXxHashAcc[0], readLe64(data));
+		mXxHashAcc[1] = xxHashRound(mXxHashAcc[1], readLe64(data + 8));
+		mXxHashAcc[2] = xxHashRound(mXxHashAcc[2], readLe64(data + 16));
+		mXxHashAcc[3] = xxHashRound(mXxHashAcc[3], readLe64(data + 24));
+	}
+
+	if (len > 0)
+	{
+		memcpy(mXxHashStripe.data(), data, len);
+		mXxHashStripeLen = len;
+	}
+}
+
+void nstool::ContentHasher::finalizeXxHash64()
+{
+	uint64_t hash;
+	if (mXxHashTotalLen >= mXxHashStripe.size())
+	{
+		hash = rotl64(mXxHashAcc[0], 1) + rotl64(mXxHashAcc[1], 7) + rotl64(mXxHashAcc[2], 12) + rotl64(mXxHashAcc[3], 18);
+		for (size_t i = 0; i < mXxHashAcc.size(); i++)
+		{
+			hash = xxHashMergeRound(hash, mXxHashAcc[i]);
+		}
+	}
+	else
+	{
+		hash = kXxPrime5;
+	}
+
+	hash += mXxHashTotalLen;
+
+	// remaining bytes of the last partial stripe
+	const byte_t* data = mXxHashStripe.data();
+	size_t len = mXxHashStripeLen;
+	for (; len >= 8; data += 8, len -= 8)
+	{
+		hash ^= xxHashRound(0, readLe64(data));
+		hash = rotl64(hash, 27) * kXxPrime1 + kXxPrime4;
+	}
+	if (len >= 4)
+	{
+		hash ^= uint64_t(readLe32(data)) * kXxPrime1;
+		hash = rotl64(hash, 23) * kXxPrime2 + kXxPrime3;
+		data += 4;
+		len -= 4;
+	}
+	for (; len > 0; data++, len--)
+	{
+		hash ^= uint64_t(*data) * kXxPrime5;
+		hash = rotl64(hash, 11) * kXxPrime1;
+	}
+
+	// avalanche
+	hash ^= hash >> 33;
+	hash *= kXxPrime2;
+	hash ^= hash >> 29;
+	hash *= kXxPrime3;
+	hash ^= hash >> 32;
+
+	mXxHash64 = hash;
+}
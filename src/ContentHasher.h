@@ -0,0 +1,56 @@
+#pragma once
+#include "types.h"
+
+#include <array>
+#include "Sha256Engine.h"
+
+namespace nstool {
+
+// Calculates a selection of hashes (SHA-256, CRC32, xxHash64) over data supplied in pieces, so file content can be hashed while it is extracted.
+class ContentHasher
+{
+public:
+	enum HashType
+	{
+		HashType_Sha256 = 1 << 0,
+		HashType_Crc32 = 1 << 1,
+		HashType_XxHash64 = 1 << 2
+	};
+
+	using sha256_hash_t = std::array<byte_t, Sha256Engine::kHashSize>;
+
+	// hash_types is a combination of HashType flags
+	ContentHasher(uint32_t hash_types);
+
+	uint32_t getHashTypes() const;
+
+	void update(const byte_t* data, size_t len);
+
+	// complete the hashes, the get*() methods are valid after this, and update() may not be called again
+	void finalize();
+
+	const sha256_hash_t& getSha256() const;
+	uint32_t getCrc32() const;
+	uint64_t getXxHash64() const;
+private:
+	uint32_t mHashTypes;
+
+	// sha256
+	Sha256Engine mSha256Gen;
+	sha256_hash_t mSha256;
+
+	// crc32 (IEEE 802.3 polynomial, as used by zip/gzip)
+	uint32_t mCrc32;
+	void updateCrc32(const byte_t* data, size_t len);
+
+	// xxHash64 (seed 0), input is consumed in 32 byte stripes so a partial stripe is held until more data arrives
+	std::array<uint64_t, 4> mXxHashAcc;
+	std::array<byte_t, 32> mXxHashStripe;
+	size_t mXxHashStripeLen;
+	uint64_t mXxHashTotalLen;
+	uint64_t mXxHash64;
+	void updateXxHash64(const byte_t* data, size_t len);
+	void finalizeXxHash64();
+};
+
+}
@@ -1,4 +1,5 @@
 #include "EsCertProcess.h"
+#include "OutputCapture.h"
 #include "PkiValidator.h"
 #include "util.h"
 
@@ -85,7 +86,7 @@ void nstool::EsCertProcess::validateCerts()
 	}
 	catch (const tc::Exception& e)
 	{
-		fmt::print("[WARNING] {}\n", e.error());
+		nstool::print("[WARNING] {}\n", e.error());
 		return;
 	}
 }
@@ -100,73 +101,73 @@ void nstool::EsCertProcess::displayCerts()
 
 void nstool::EsCertProcess::displayCert(const pie::hac::es::SignedData<pie::hac::es::CertificateBody>& cert)
 {
-	fmt::print("[ES Certificate]\n");
+	nstool::print("[ES Certificate]\n");
 
-	fmt::print("  SignType       {:s}", getSignTypeStr(cert.getSignature().getSignType()));
+	nstool::print("  SignType       {:s}", getSignTypeStr(cert.getSignature().getSignType()));
 	if (mCliOutputMode.show_extended_info)
-		fmt::print(" (0x{:x}) ({:s})", (uint32_t)cert.getSignature().getSignType(), getEndiannessStr(cert.getSignature().isLittleEndian()));
-	fmt::print("\n");
+		nstool::print(" (0x{:x}) ({:s})", (uint32_t)cert.getSignature().getSignType(), getEndiannessStr(cert.getSignature().isLittleEndian()));
+	nstool::print("\n");
 
-	fmt::print("  Issuer:        {:s}\n", cert.getBody().getIssuer());
-	fmt::print("  Subject:       {:s}\n", cert.getBody().getSubject());
-	fmt::print("  PublicKeyType: {:s}", getPublicKeyTypeStr(cert.getBody().getPublicKeyType()));
+	nstool::print("  Issuer:        {:s}\n", cert.getBody().getIssuer());
+	nstool::print("  Subject:       {:s}\n", cert.getBody().getSubject());
+	nstool::print("  PublicKeyType: {:s}", getPublicKeyTypeStr(cert.getBody().getPublicKeyType()));
 	if (mCliOutputMode.show_extended_info)
-		fmt::print(" ({:d})", (uint32_t)cert.getBody().getPublicKeyType());
-	fmt::print("\n");
-	fmt::print("  CertID:        0x{:x}\n", cert.getBody().getCertId());
+		nstool::print(" ({:d})", (uint32_t)cert.getBody().getPublicKeyType());
+	nstool::print("\n");
+	nstool::print("  CertID:        0x{:x}\n", cert.getBody().getCertId());
 	
 	if (cert.getBody().getPublicKeyType() == pie::hac::es::cert::RSA4096)
 	{
-		fmt::print("  PublicKey:\n");
+		nstool::print("  PublicKey:\n");
 		if (mCliOutputMode.show_extended_info)
 		{
-			fmt::print("    Modulus:\n");
-			fmt::print("      {:s}", tc::cli::FormatUtil::formatBytesAsStringWithLineLimit(cert.getBody().getRsa4096PublicKey().n.data(), cert.getBody().getRsa4096PublicKey().n.size(), true, "", 0x10, 6, false));
-			fmt::print("    Public Exponent:\n");
-			fmt::print("      {:s}", tc::cli::FormatUtil::formatBytesAsStringWithLineLimit(cert.getBody().getRsa4096PublicKey().e.data(), cert.getBody().getRsa4096PublicKey().e.size(), true, "", 0x10, 6, false));
+			nstool::print("    Modulus:\n");
+			nstool::print("      {:s}", tc::cli::FormatUtil::formatBytesAsStringWithLineLimit(cert.getBody().getRsa4096PublicKey().n.data(), cert.getBody().getRsa4096PublicKey().n.size(), true, "", 0x10, 6, false));
+			nstool::print("    Public Exponent:\n");
+			nstool::print("      {:s}", tc::cli::FormatUtil::formatBytesAsStringWithLineLimit(cert.getBody().getRsa4096PublicKey().e.data(), cert.getBody().getRsa4096PublicKey().e.size(), true, "", 0x10, 6, false));
 		}
 		else
 		{
-			fmt::print("    Modulus:\n");
-			fmt::print("      {:s}\n", getTruncatedBytesString(cert.getBody().getRsa4096PublicKey().n.data(), cert.getBody().getRsa4096PublicKey().n.size()));
-			fmt::print("    Public Exponent:\n");
-			fmt::print("      {:s}\n", getTruncatedBytesString(cert.getBody().getRsa4096PublicKey().e.data(), cert.getBody().getRsa4096PublicKey().e.size()));
+			nstool::print("    Modulus:\n");
+			nstool::print("      {:s}\n", getTruncatedBytesString(cert.getBody().getRsa4096PublicKey().n.data(), cert.getBody().getRsa4096PublicKey().n.size()));
+			nstool::print("    Public Exponent:\n");
+			nstool::print("      {:s}\n", getTruncatedBytesString(cert.getBody().getRsa4096PublicKey().e.data(), cert.getBody().getRsa4096PublicKey().e.size()));
 		}
 	}
 	else if (cert.getBody().getPublicKeyType() == pie::hac::es::cert::RSA2048)
 	{
-		fmt::print("  PublicKey:\n");
+		nstool::print("  PublicKey:\n");
 		if (mCliOutputMode.show_extended_info)
 		{
-			fmt::print("    Modulus:\n");
-			fmt::print("      {:s}", tc::cli::FormatUtil::formatBytesAsStringWithLineLimit(cert.getBody().getRsa2048PublicKey().n.data(), cert.getBody().getRsa2048PublicKey().n.size(), true, "", 0x10, 6, false));
-			fmt::print("    Public Exponent:\n");
-			fmt::print("      {:s}", tc::cli::FormatUtil::formatBytesAsStringWithLineLimit(cert.getBody().getRsa2048PublicKey().e.data(), cert.getBody().getRsa2048PublicKey().e.size(), true, "", 0x10, 6, false));
+			nstool::print("    Modulus:\n");
+			nstool::print("      {:s}", tc::cli::FormatUtil::formatBytesAsStringWithLineLimit(cert.getBody().getRsa2048PublicKey().n.data(), cert.getBody().getRsa2048PublicKey().n.size(), true, "", 0x10, 6, false));
+			nstool::print("    Public Exponent:\n");
+			nstool::print("      {:s}", tc::cli::FormatUtil::formatBytesAsStringWithLineLimit(cert.getBody().getRsa2048PublicKey().e.data(), cert.getBody().getRsa2048PublicKey().e.size(), true, "", 0x10, 6, false));
 		}
 		else
 		{
-			fmt::print("    Modulus:\n");
-			fmt::print("      {:s}\n", getTruncatedBytesString(cert.getBody().getRsa2048PublicKey().n.data(), cert.getBody().getRsa2048PublicKey().n.size()));
-			fmt::print("    Public Exponent:\n");
-			fmt::print("      {:s}\n", getTruncatedBytesString(cert.getBody().getRsa2048PublicKey().e.data(), cert.getBody().getRsa2048PublicKey().e.size()));
+			nstool::print("    Modulus:\n");
+			nstool::print("      {:s}\n", getTruncatedBytesString(cert.getBody().getRsa2048PublicKey().n.data(), cert.getBody().getRsa2048PublicKey().n.size()));
+			nstool::print("    Public Exponent:\n");
+			nstool::print("      {:s}\n", getTruncatedBytesString(cert.getBody().getRsa2048PublicKey().e.data(), cert.getBody().getRsa2048PublicKey().e.size()));
 		}
 	}
 	else if (cert.getBody().getPublicKeyType() == pie::hac::es::cert::ECDSA240)
 	{
-		fmt::print("  PublicKey:\n");
+		nstool::print("  PublicKey:\n");
 		if (mCliOutputMode.show_extended_info)
 		{
-			fmt::print("    Modulus:\n");
-			fmt::print("      {:s}", tc::cli::FormatUtil::formatBytesAsStringWithLineLimit(cert.getBody().getEcdsa240PublicKey().r.data(), cert.getBody().getEcdsa240PublicKey().r.size(), true, "", 0x10, 6, false));
-			fmt::print("    Public Exponent:\n");
-			fmt::print("      {:s}", tc::cli::FormatUtil::formatBytesAsStringWithLineLimit(cert.getBody().getEcdsa240PublicKey().s.data(), cert.getBody().getEcdsa240PublicKey().s.size(), true, "", 0x10, 6, false));
+			nstool::print("    Modulus:\n");
+			nstool::print("      {:s}", tc::cli::FormatUtil::formatBytesAsStringWithLineLimit(cert.getBody().getEcdsa240PublicKey().r.data(), cert.getBody().getEcdsa240PublicKey().r.size(), true, "", 0x10, 6, false));
+			nstool::print("    Public Exponent:\n");
+			nstool::print("      {:s}", tc::cli::FormatUtil::formatBytesAsStringWithLineLimit(cert.getBody().getEcdsa240PublicKey().s.data(), cert.getBody().getEcdsa240PublicKey().s.size(), true, "", 0x10, 6, false));
 		}
 		else
 		{
-			fmt::print("    Modulus:\n");
-			fmt::print("      {:s}\n", getTruncatedBytesString(cert.getBody().getEcdsa240PublicKey().r.data(), cert.getBody().getEcdsa240PublicKey().r.size()));
-			fmt::print("    Public Exponent:\n");
-			fmt::print("      {:s}\n", getTruncatedBytesString(cert.getBody().getEcdsa240PublicKey().s.data(), cert.getBody().getEcdsa240PublicKey().s.size()));
+			nstool::print("    Modulus:\n");
+			nstool::print("      {:s}\n", getTruncatedBytesString(cert.getBody().getEcdsa240PublicKey().r.data(), cert.getBody().getEcdsa240PublicKey().r.size()));
+			nstool::print("    Public Exponent:\n");
+			nstool::print("      {:s}\n", getTruncatedBytesString(cert.getBody().getEcdsa240PublicKey().s.data(), cert.getBody().getEcdsa240PublicKey().s.size()));
 		}
 	}
 }
@@ -1,4 +1,5 @@
 #include "EsTikProcess.h"
+#include "OutputCapture.h"
 #include "PkiValidator.h"
 
 #include <pietendo/hac/es/SignUtils.h>
@@ -98,7 +99,7 @@ void nstool::EsTikProcess::verifyTicket()
 	}
 	catch (const tc::Exception& e)
 	{
-		fmt::print("[WARNING] Ticket signature could not be validated ({:s})\n", e.error());
+		nstool::print("[WARNING] Ticket signature could not be validated ({:s})\n", e.error());
 	}
 }
 
@@ -106,60 +107,60 @@ void nstool::EsTikProcess::displayTicket()
 {
 	const pie::hac::es::TicketBody_V2& body = mTik.getBody();	
 
-	fmt::print("[ES Ticket]\n");
-	fmt::print("  SignType:         {:s}", getSignTypeStr(mTik.getSignature().getSignType()));
+	nstool::print("[ES Ticket]\n");
+	nstool::print("  SignType:         {:s}", getSignTypeStr(mTik.getSignature().getSignType()));
 	if (mCliOutputMode.show_extended_info)
-		fmt::print(" (0x{:x})", (uint32_t)mTik.getSignature().getSignType());
-	fmt::print("\n");
+		nstool::print(" (0x{:x})", (uint32_t)mTik.getSignature().getSignType());
+	nstool::print("\n");
 
-	fmt::print("  Issuer:           {:s}\n", body.getIssuer());
-	fmt::print("  Title Key:\n");
-	fmt::print("    EncMode:        {:s}\n", getTitleKeyPersonalisationStr(body.getTitleKeyEncType()));
-	fmt::print("    KeyGeneration:  {:d}\n", (uint32_t)body.getCommonKeyId());
+	nstool::print("  Issuer:           {:s}\n", body.getIssuer());
+	nstool::print("  Title Key:\n");
+	nstool::print("    EncMode:        {:s}\n", getTitleKeyPersonalisationStr(body.getTitleKeyEncType()));
+	nstool::print("    KeyGeneration:  {:d}\n", (uint32_t)body.getCommonKeyId());
 	if (body.getTitleKeyEncType() == pie::hac::es::ticket::RSA2048)
 	{
-		fmt::print("    Data:\n");
-		fmt::print("      {:s}", tc::cli::FormatUtil::formatBytesAsStringWithLineLimit(body.getEncTitleKey(), 0x100, true, "", 0x10, 6, false));
+		nstool::print("    Data:\n");
+		nstool::print("      {:s}", tc::cli::FormatUtil::formatBytesAsStringWithLineLimit(body.getEncTitleKey(), 0x100, true, "", 0x10, 6, false));
 	}
 	else if (body.getTitleKeyEncType() == pie::hac::es::ticket::AES128_CBC)
 	{
-		fmt::print("    Data:\n");
-		fmt::print("      {:s}\n", tc::cli::FormatUtil::formatBytesAsString(body.getEncTitleKey(), 0x10, true, ""));
+		nstool::print("    Data:\n");
+		nstool::print("      {:s}\n", tc::cli::FormatUtil::formatBytesAsString(body.getEncTitleKey(), 0x10, true, ""));
 	}
 	else
 	{
-		fmt::print("    Data:           <cannot display>\n");
+		nstool::print("    Data:           <cannot display>\n");
 	}
-	fmt::print("  Version:          {:s} (v{:d})\n", getTitleVersionStr(body.getTicketVersion()), body.getTicketVersion());
-	fmt::print("  License Type:     {:s}\n", getLicenseTypeStr(body.getLicenseType())); 
+	nstool::print("  Version:          {:s} (v{:d})\n", getTitleVersionStr(body.getTicketVersion()), body.getTicketVersion());
+	nstool::print("  License Type:     {:s}\n", getLicenseTypeStr(body.getLicenseType())); 
 	if (body.getPropertyFlags().size() > 0 || mCliOutputMode.show_extended_info)
 	{
 		pie::hac::es::sTicketBody_v2* raw_body = (pie::hac::es::sTicketBody_v2*)body.getBytes().data();
-		fmt::print("  PropertyMask:     0x{:04x}\n", ((tc::bn::le16<uint16_t>*)&raw_body->property_mask)->unwrap());
+		nstool::print("  PropertyMask:     0x{:04x}\n", ((tc::bn::le16<uint16_t>*)&raw_body->property_mask)->unwrap());
 		for (size_t i = 0; i < body.getPropertyFlags().size(); i++)
 		{
-			fmt::print("    {:s}\n", getPropertyFlagStr(body.getPropertyFlags()[i]));
+			nstool::print("    {:s}\n", getPropertyFlagStr(body.getPropertyFlags()[i]));
 		}
 	}
 	if (mCliOutputMode.show_extended_info)
 	{
-		fmt::print("  Reserved Region:\n");
-		fmt::print("    {:s}\n", tc::cli::FormatUtil::formatBytesAsString(body.getReservedRegion(), 8, true, ""));
+		nstool::print("  Reserved Region:\n");
+		nstool::print("    {:s}\n", tc::cli::FormatUtil::formatBytesAsString(body.getReservedRegion(), 8, true, ""));
 	}
 	
 	if (body.getTicketId() != 0 || mCliOutputMode.show_extended_info)
-		fmt::print("  TicketId:         0x{:016x}\n", body.getTicketId());
+		nstool::print("  TicketId:         0x{:016x}\n", body.getTicketId());
 	
 	if (body.getDeviceId() != 0 || mCliOutputMode.show_extended_info)
-		fmt::print("  DeviceId:         0x{:016x}\n", body.getDeviceId());
+		nstool::print("  DeviceId:         0x{:016x}\n", body.getDeviceId());
 	
-	fmt::print("  RightsId:         \n");
-	fmt::print("    {:s}\n", tc::cli::FormatUtil::formatBytesAsString(body.getRightsId(), 16, true, ""));
+	nstool::print("  RightsId:         \n");
+	nstool::print("    {:s}\n", tc::cli::FormatUtil::formatBytesAsString(body.getRightsId(), 16, true, ""));
 
-	fmt::print("  SectionTotalSize:       0x{:x}\n", body.getSectionTotalSize());
-	fmt::print("  SectionHeaderOffset:    0x{:x}\n", body.getSectionHeaderOffset());
-	fmt::print("  SectionNum:             0x{:x}\n", body.getSectionNum());
-	fmt::print("  SectionEntrySize:       0x{:x}\n", body.getSectionEntrySize());
+	nstool::print("  SectionTotalSize:       0x{:x}\n", body.getSectionTotalSize());
+	nstool::print("  SectionHeaderOffset:    0x{:x}\n", body.getSectionHeaderOffset());
+	nstool::print("  SectionNum:             0x{:x}\n", body.getSectionNum());
+	nstool::print("  SectionEntrySize:       0x{:x}\n", body.getSectionEntrySize());
 }
 
 std::string nstool::EsTikProcess::getSignTypeStr(uint32_t type) const
@@ -0,0 +1,177 @@
+#include "ExtractManifest.h"
+#include "util.h"
+
+#include <tc/io/FileStream.h>
+#include <tc/io/FileNotFoundException.h>
+
+#include <cstring>
+#include <sstream>
+#include <algorithm>
+
+const std::string nstool::ExtractManifest::kFileName = ".nstool_manifest";
+
+std::string nstool::ExtractManifest::getInputIdentity(const tc::io::Path& input_path, const std::shared_ptr<tc::io::IStream>& input_stream)
+{
+	int64_t input_size = input_stream->length();
+
+	tc::ByteData header = tc::ByteData(size_t(std::min<int64_t>(input_size, int64_t(kInputHeaderSize))));
+	readStreamExact(input_stream, 0, header.data(), header.size(), "nstool::ExtractManifest");
+
+	ContentHasher hasher(ContentHasher::HashType_Sha256);
+	hasher.update(header.data(), header.size());
+	hasher.finalize();
+
+	// same layout as an entry line, so the path is last and may hold any character but a line break
+	return fmt::format("{:s}\t{:d}\t{:s}", tc::cli::FormatUtil::formatBytesAsString(hasher.getSha256().data(), hasher.getSha256().size(), false, ""), input_size, input_path.to_string());
+}
+
+nstool::ExtractManifest::ExtractManifest() :
+	mModuleName("nstool::ExtractManifest"),
+	mMutex(),
+	mEntries(),
+	mFile()
+{
+}
+
+nstool::ExtractManifest::~ExtractManifest()
+{
+	try {
+		close();
+	}
+	catch (...) {
+		// the manifest is only an optimisation for later runs, a failure to finish it is not worth reporting from a destructor
+	}
+}
+
+void nstool::ExtractManifest::open(const tc::io::Path& manifest_path, const std::string& input_identity)
+{
+	std::lock_guard<std::mutex> lock(mMutex);
+
+	mEntries.clear();
+	mFile.reset();
+
+	// load existing entries
+	try {
+		tc::io::FileStream in_file = tc::io::FileStream(manifest_path, tc::io::FileMode::Open, tc::io::FileAccess::Read);
+
+		tc::ByteData text = tc::ByteData(tc::io::IOUtil::castInt64ToSize(in_file.length()));
+		in_file.seek(0, tc::io::SeekOrigin::Begin);
+		in_file.read(text.data(), text.size());
+		in_file.dispose();
+
+		parseManifest(std::string((const char*)text.data(), text.size()), input_identity);
+	}
+	catch (tc::io::FileNotFoundException&) {
+		// first extraction to this directory
+	}
+
+	// rewrite the manifest, this drops superseded and incomplete lines left by earlier runs
+	mFile = std::make_shared<tc::io::FileStream>(tc::io::FileStream(manifest_path, tc::io::FileMode::Create, tc::io::FileAccess::Write));
+	std::string identity_line = fmt::format("input\t{:s}\n", input_identity);
+	mFile->write((const byte_t*)identity_line.c_str(), identity_line.size());
+	for (auto itr = mEntries.begin(); itr != mEntries.end(); itr++)
+	{
+		writeEntry(itr->first, itr->second);
+	}
+	mFile->flush();
+}
+
+void nstool::ExtractManifest::close()
+{
+	std::lock_guard<std::mutex> lock(mMutex);
+
+	if (mFile != nullptr)
+	{
+		mFile->flush();
+		mFile->dispose();
+		mFile.reset();
+	}
+	mEntries.clear();
+}
+
+bool nstool::ExtractManifest::isOpen() const
+{
+	std::lock_guard<std::mutex> lock(mMutex);
+
+	return mFile != nullptr;
+}
+
+bool nstool::ExtractManifest::getEntry(const std::string& v_path, sEntry& entry) const
+{
+	std::lock_guard<std::mutex> lock(mMutex);
+
+	auto itr = mEntries.find(v_path);
+	if (itr == mEntries.end())
+	{
+		return false;
+	}
+
+	entry = itr->second;
+	return true;
+}
+
+void nstool::ExtractManifest::addEntry(const std::string& v_path, const sEntry& entry)
+{
+	std::lock_guard<std::mutex> lock(mMutex);
+
+	if (mFile == nullptr)
+	{
+		throw tc::InvalidOperationException(mModuleName, "Manifest is not open.");
+	}
+
+	mEntries[v_path] = entry;
+
+	// flush every entry, so it survives the extraction being interrupted
+	writeEntry(v_path, entry);
+	mFile->flush();
+}
+
+void nstool::ExtractManifest::parseManifest(const std::string& text, const std::string& input_identity)
+{
+	// the first line is "input\t<input identity>", the entries of a manifest made for another input (or an older manifest without this line) don't describe this extraction
+	std::istringstream in_stream(text);
+	std::string line;
+	if (std::getline(in_stream, line).fail() || line != "input\t" + input_identity)
+	{
+		return;
+	}
+
+	// one entry per line: "<sha256 hex>\t<size>\t<virtual path>", lines that do not parse (e.g. a line cut short by an interrupted write) are ignored
+	while (std::getline(in_stream, line))
+	{
+		size_t hash_end = line.find('\t');
+		if (hash_end == std::string::npos)
+			continue;
+
+		size_t size_end = line.find('\t', hash_end + 1);
+		if (size_end == std::string::npos || size_end + 1 >= line.size())
+			continue;
+
+		sEntry entry;
+
+		tc::ByteData hash;
+		try {
+			hash = tc::cli::FormatUtil::hexStringToBytes(line.substr(0, hash_end));
+		}
+		catch (tc::Exception&) {
+			continue;
+		}
+		if (hash.size() != entry.sha256.size())
+			continue;
+		memcpy(entry.sha256.data(), hash.data(), entry.sha256.size());
+
+		std::string size_str = line.substr(hash_end + 1, size_end - (hash_end + 1));
+		if (size_str.empty() || size_str.size() > 18 || size_str.find_first_not_of("0123456789") != std::string::npos)
+			continue;
+		entry.size = std::stoll(size_str);
+
+		mEntries[line.substr(size_end + 1)] = entry;
+	}
+}
+
+void nstool::ExtractManifest::writeEntry(const std::string& v_path, const sEntry& entry)
+{
+	std::string line = fmt::format("{:s}\t{:d}\t{:s}\n", tc::cli::FormatUtil::formatBytesAsString(entry.sha256.data(), entry.sha256.size(), false, ""), entry.size, v_path);
+
+	mFile->write((const byte_t*)line.c_str(), line.size());
+}
@@ -0,0 +1,57 @@
+#pragma once
+#include "types.h"
+#include "ContentHasher.h"
+
+#include <array>
+#include <mutex>
+
+namespace nstool {
+
+// Record of the files written by a directory extraction (virtual path, size, SHA-256 of the content), stored as a text file in the extract directory.
+// When an extraction is repeated with the same manifest, files whose output still matches their entry do not need to be extracted again.
+// The manifest starts with the identity of the input it was made for, a manifest made for another input is discarded.
+// Entries are appended as each file is completed, so an interrupted extraction keeps the entries for the files it finished.
+class ExtractManifest
+{
+public:
+	static const std::string kFileName;
+
+	using sha256_hash_t = ContentHasher::sha256_hash_t;
+
+	struct sEntry
+	{
+		int64_t size;
+		sha256_hash_t sha256;
+	};
+
+	// identity of an input file for open(): its path, size and the SHA-256 of its first kInputHeaderSize bytes
+	static const size_t kInputHeaderSize = 0x4000;
+	static std::string getInputIdentity(const tc::io::Path& input_path, const std::shared_ptr<tc::io::IStream>& input_stream);
+
+	ExtractManifest();
+	~ExtractManifest();
+
+	// load entries from manifest_path (if it exists and was made for input_identity), then rewrite it with those entries so new entries can be appended
+	void open(const tc::io::Path& manifest_path, const std::string& input_identity);
+	void close();
+	bool isOpen() const;
+
+	bool getEntry(const std::string& v_path, sEntry& entry) const;
+
+	// record a completed file, may be called from several threads
+	void addEntry(const std::string& v_path, const sEntry& entry);
+private:
+	std::string mModuleName;
+
+	mutable std::mutex mMutex;
+	std::map<std::string, sEntry> mEntries;
+	std::shared_ptr<tc::io::IStream> mFile;
+
+	void parseManifest(const std::string& text, const std::string& input_identity);
+	void writeEntry(const std::string& v_path, const sEntry& entry);
+
+	ExtractManifest(const ExtractManifest&) = delete;
+	ExtractManifest& operator=(const ExtractManifest&) = delete;
+};
+
+}
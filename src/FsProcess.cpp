@@ -1,20 +1,38 @@
 #include "FsProcess.h"
+#include "OutputCapture.h"
 #include "util.h"
+#include "HashManifest.h"
 
 #include <memory>
+#include <algorithm>
+#include <limits>
+#include <thread>
+#include <mutex>
+#include <atomic>
+#include <condition_variable>
+#include <cstring>
 #include <tc/io/FileNotFoundException.h>
 #include <tc/io/DirectoryNotFoundException.h>
 
 nstool::FsProcess::FsProcess() :
 	mModuleLabel("nstool::FsProcess"),
 	mInputFs(),
+	mInputFsFactory(),
 	mFsFormatName(),
 	mShowFsInfo(false),
 	mProperties(),
 	mShowFsTree(false),
 	mFsRootLabel(),
 	mExtractJobs(),
-	mDataCache(0x10000)
+	mExtractOptions(),
+	mIoAlignment(1),
+	mDataCache(),
+	mCopyPipeline(),
+	mFileOffsets(),
+	mRawInputPath(),
+	mCopyQueue(),
+	mManifest(),
+	mExtractWorkers()
 {
 
 }
@@ -28,10 +46,10 @@ void nstool::FsProcess::process()
 
 	if (mShowFsInfo)
 	{
-		fmt::print("[{:s}]\n", mFsFormatName.isSet() ? mFsFormatName.get() : "FileSystem/Info");
+		nstool::print("[{:s}]\n", mFsFormatName.isSet() ? mFsFormatName.get() : "FileSystem/Info");
 		for (auto itr = mProperties.begin(); itr != mProperties.end(); itr++)
 		{
-			fmt::print("  {:s}\n", *itr);
+			nstool::print("  {:s}\n", *itr);
 		}
 	}
 
@@ -51,6 +69,11 @@ void nstool::FsProcess::setInputFileSystem(const std::shared_ptr<tc::io::IFileSy
 	mInputFs = input_fs;
 }
 
+void nstool::FsProcess::setInputFileSystemFactory(const FileSystemFactory& input_fs_factory)
+{
+	mInputFsFactory = input_fs_factory;
+}
+
 void nstool::FsProcess::setFsFormatName(const std::string& fs_format_name)
 {
 	mFsFormatName = fs_format_name;
@@ -81,15 +104,43 @@ void nstool::FsProcess::setExtractJobs(const std::vector<nstool::ExtractJob>& ex
 	mExtractJobs = extract_jobs;
 }
 
+void nstool::FsProcess::setExtractOptions(const nstool::ExtractOptions& extract_options)
+{
+	mExtractOptions = extract_options;
+}
+
+void nstool::FsProcess::setIoAlignment(size_t io_alignment)
+{
+	mIoAlignment = io_alignment;
+}
+
+void nstool::FsProcess::setFileOffsets(const nstool::FileOffsetMap& file_offsets)
+{
+	mFileOffsets = file_offsets;
+}
+
+void nstool::FsProcess::setRawInputFile(const tc::io::Path& input_path)
+{
+	mRawInputPath = input_path;
+}
+
 void nstool::FsProcess::printFs()
 {
-	fmt::print("[{:s}/Tree]\n", (mFsFormatName.isSet() ? mFsFormatName.get() : "FileSystem"));
+	nstool::print("[{:s}/Tree]\n", (mFsFormatName.isSet() ? mFsFormatName.get() : "FileSystem"));
 	visitDir(tc::io::Path("/"), tc::io::Path("/"), false, true);
 }
 
 void nstool::FsProcess::extractFs()
 {
-	fmt::print("[{:s}/Extract]\n", (mFsFormatName.isSet() ? mFsFormatName.get() : "FileSystem"));
+	nstool::print("[{:s}/Extract]\n", (mFsFormatName.isSet() ? mFsFormatName.get() : "FileSystem"));
+
+	// reads are a multiple of the source block size (hash block/cipher block), so no block is split between two reads except at file boundaries
+	mDataCache = tc::ByteData(getIoBlockSize(mIoAlignment, mExtractOptions.max_io_size));
+	mCopyPipeline = std::make_shared<nstool::StreamCopyPipeline>(mModuleLabel);
+
+	// worker state is created lazily by flushCopyQueue() and reused for every extract job
+	mExtractWorkers.clear();
+	mExtractWorkers.resize(mExtractOptions.thread_count > 1 ? mExtractOptions.thread_count : 1);
 
 	for (auto itr = mExtractJobs.begin(); itr != mExtractJobs.end(); itr++)
 	{
@@ -97,8 +148,11 @@ void nstool::FsProcess::extractFs()
 		if (itr->virtual_path == tc::io::Path("/"))
 		{
 			visitDir(tc::io::Path("/"), itr->extract_path, true, false);
+			openManifest(itr->extract_path);
+			flushCopyQueue();
+			closeManifest();
 
-			//fmt::print("Root Dir Virtual Path: \"{:s}\"\n", itr->virtual_path.to_string());
+			//nstool::print("Root Dir Virtual Path: \"{:s}\"\n", itr->virtual_path.to_string());
 
 			// root directory extract successful, continue to next job
 			continue;
@@ -109,7 +163,7 @@ void nstool::FsProcess::extractFs()
 			std::shared_ptr<tc::io::IStream> file_stream;
 			mInputFs->openFile(itr->virtual_path, tc::io::FileMode::Open, tc::io::FileAccess::Read, file_stream);
 
-			//fmt::print("Valid File Path: \"{:s}\"\n", itr->virtual_path.to_string());
+			//nstool::print("Valid File Path: \"{:s}\"\n", itr->virtual_path.to_string());
 
 			// the output path for this file will depend on the user specified extract path
 			std::shared_ptr<tc::io::IFileSystem> local_fs = std::make_shared<tc::io::LocalFileSystem>(tc::io::LocalFileSystem());
@@ -124,9 +178,9 @@ void nstool::FsProcess::extractFs()
 
 				tc::io::Path file_extract_path = itr->extract_path + itr->virtual_path.back();
 
-				fmt::print("Saving {:s}...\n", file_extract_path.to_string());
+				nstool::print("Saving {:s}...\n", file_extract_path.to_string());
 
-				writeStreamToFile(file_stream, itr->extract_path + itr->virtual_path.back(), mDataCache);
+				writeFileToLocalPath(file_stream, itr->virtual_path, file_extract_path);
 
 				continue;
 
@@ -150,9 +204,9 @@ void nstool::FsProcess::extractFs()
 				tc::io::sDirectoryListing dir_listing;
 				local_fs->getDirectoryListing(parent_dir_path, dir_listing);
 
-				fmt::print("Saving {:s} as {:s}...\n", itr->virtual_path.to_string(), itr->extract_path.to_string());
+				nstool::print("Saving {:s} as {:s}...\n", itr->virtual_path.to_string(), itr->extract_path.to_string());
 
-				writeStreamToFile(file_stream, itr->extract_path, mDataCache);
+				writeFileToLocalPath(file_stream, itr->virtual_path, itr->extract_path);
 
 				continue;
 			} catch (tc::io::DirectoryNotFoundException&) {
@@ -161,7 +215,7 @@ void nstool::FsProcess::extractFs()
 
 
 			// extract path could not be determined, inform the user and skip this job
-			fmt::print("[WARNING] Extract path was invalid, and was skipped: {:s}\n", itr->extract_path.to_string());
+			nstool::print("[WARNING] Extract path was invalid, and was skipped: {:s}\n", itr->extract_path.to_string());
 			continue;
 		} catch (tc::io::FileNotFoundException&) {
 			// acceptable exception, just means file didn't exist
@@ -173,8 +227,11 @@ void nstool::FsProcess::extractFs()
 			mInputFs->getDirectoryListing(itr->virtual_path, dir_listing);
 
 			visitDir(itr->virtual_path, itr->extract_path, true, false);
+			openManifest(itr->extract_path);
+			flushCopyQueue();
+			closeManifest();
 
-			//fmt::print("Valid Directory Path: \"{:s}\"\n", itr->virtual_path.to_string());
+			//nstool::print("Valid Directory Path: \"{:s}\"\n", itr->virtual_path.to_string());
 
 			// directory extract successful, continue to next job
 			continue;
@@ -183,9 +240,352 @@ void nstool::FsProcess::extractFs()
 			// acceptable exception, just means directory didn't exist
 		}
 
-		fmt::print("[WARNING] Failed to extract virtual path: \"{:s}\"\n", itr->virtual_path.to_string());
+		nstool::print("[WARNING] Failed to extract virtual path: \"{:s}\"\n", itr->virtual_path.to_string());
 	}
-	
+
+	// release worker input filesystems and copy threads
+	mExtractWorkers.clear();
+	mCopyPipeline.reset();
+}
+
+void nstool::FsProcess::writeFileToLocalPath(const std::shared_ptr<tc::io::IStream>& file_stream, const tc::io::Path& v_path, const tc::io::Path& out_path)
+{
+	std::shared_ptr<tc::io::IStream> out_stream = openOutputFileStream(out_path, file_stream->length());
+
+	if (mExtractOptions.hash_manifest == nullptr)
+	{
+		mCopyPipeline->copy(file_stream, out_stream, mDataCache, mExtractOptions.sparse_output, StreamDataObserver(), getSourceName(v_path));
+		return;
+	}
+
+	ContentHasher hasher(mExtractOptions.hash_manifest->getHashTypes());
+	mCopyPipeline->copy(file_stream, out_stream, mDataCache, mExtractOptions.sparse_output, [&hasher](const byte_t* data, size_t len) { hasher.update(data, len); }, getSourceName(v_path));
+	hasher.finalize();
+
+	mExtractOptions.hash_manifest->addEntry(out_path, file_stream->length(), hasher);
+}
+
+void nstool::FsProcess::openManifest(const tc::io::Path& extract_path)
+{
+	if (mExtractOptions.resume == false)
+	{
+		return;
+	}
+
+	// a file in the input with the manifest's name would be overwritten by (or overwrite) the manifest, so this extract goes without one
+	tc::io::Path manifest_path = extract_path + nstool::ExtractManifest::kFileName;
+	for (auto itr = mCopyQueue.begin(); itr != mCopyQueue.end(); itr++)
+	{
+		if (itr->out_path.to_string() == manifest_path.to_string())
+		{
+			nstool::print("[WARNING] \"{:s}\" is extracted to the path of the resume manifest, so every file in \"{:s}\" will be extracted.\n", itr->v_path.to_string(), extract_path.to_string());
+			return;
+		}
+	}
+
+	mManifest = std::make_shared<nstool::ExtractManifest>();
+	mManifest->open(manifest_path, mExtractOptions.input_identity);
+}
+
+void nstool::FsProcess::closeManifest()
+{
+	if (mManifest != nullptr)
+	{
+		mManifest->close();
+		mManifest.reset();
+	}
+}
+
+void nstool::FsProcess::flushCopyQueue()
+{
+	// copy files in the order their data appears in the input file, files with no known offset keep their listing order after those
+	std::stable_sort(mCopyQueue.begin(), mCopyQueue.end(), [](const sFileCopyJob& a, const sFileCopyJob& b) { return a.data_offset < b.data_offset; });
+
+	size_t thread_count = std::min<size_t>(mExtractWorkers.size(), mCopyQueue.size());
+
+	// without a way to open independent input filesystems, files can only be copied serially
+	if (thread_count <= 1 || mInputFsFactory == nullptr)
+	{
+		for (auto itr = mCopyQueue.begin(); itr != mCopyQueue.end(); itr++)
+		{
+			if (isOutputUnchanged(*mInputFs, *itr, mDataCache))
+			{
+				nstool::print("Skipping {:s} (unchanged)...\n", itr->out_path.to_string());
+				continue;
+			}
+
+			nstool::print("Saving {:s}...\n", itr->out_path.to_string());
+			copyFile(*mInputFs, *itr, mDataCache, *mCopyPipeline);
+		}
+		mCopyQueue.clear();
+		return;
+	}
+
+	// job state is reported back to this thread, which prints progress and errors in queue order so output matches serial extraction
+	enum JobState { JobState_Pending, JobState_Done, JobState_Skipped, JobState_Failed };
+	std::vector<JobState> job_state(mCopyQueue.size(), JobState_Pending);
+	std::vector<std::pair<std::string, std::string>> job_error(mCopyQueue.size());
+	std::mutex state_mutex;
+	std::condition_variable state_changed;
+	std::atomic<size_t> next_job(0);
+	std::atomic<bool> stop_requested(false);
+
+	auto worker_func = [&](size_t worker_index)
+	{
+		sExtractWorker& worker = mExtractWorkers[worker_index];
+		for (size_t job_index = next_job++; job_index < mCopyQueue.size() && stop_requested == false; job_index = next_job++)
+		{
+			JobState result = JobState_Done;
+			try {
+				if (worker.input_fs == nullptr)
+				{
+					worker.input_fs = mInputFsFactory();
+				}
+				if (worker.cache.size() != mDataCache.size())
+				{
+					worker.cache = tc::ByteData(mDataCache.size());
+				}
+				if (worker.copy_pipeline == nullptr)
+				{
+					worker.copy_pipeline = std::make_shared<nstool::StreamCopyPipeline>(mModuleLabel);
+				}
+				if (isOutputUnchanged(*worker.input_fs, mCopyQueue[job_index], worker.cache))
+				{
+					result = JobState_Skipped;
+				}
+				else
+				{
+					copyFile(*worker.input_fs, mCopyQueue[job_index], worker.cache, *worker.copy_pipeline);
+				}
+			}
+			catch (tc::Exception& e) {
+				result = JobState_Failed;
+				job_error[job_index] = std::pair<std::string, std::string>(e.module(), e.error());
+			}
+			catch (std::exception& e) {
+				result = JobState_Failed;
+				job_error[job_index] = std::pair<std::string, std::string>(mModuleLabel, e.what());
+			}
+
+			{
+				std::lock_guard<std::mutex> lock(state_mutex);
+				job_state[job_index] = result;
+			}
+			state_changed.notify_all();
+		}
+	};
+
+	std::vector<std::thread> workers;
+	for (size_t i = 0; i < thread_count; i++)
+	{
+		workers.push_back(std::thread(worker_func, i));
+	}
+
+	// report jobs in order, stopping at the first failure like serial extraction would
+	size_t failed_job = mCopyQueue.size();
+	{
+		std::unique_lock<std::mutex> lock(state_mutex);
+		for (size_t i = 0; i < mCopyQueue.size(); i++)
+		{
+			state_changed.wait(lock, [&]() { return job_state[i] != JobState_Pending; });
+
+			if (job_state[i] == JobState_Skipped)
+			{
+				nstool::print("Skipping {:s} (unchanged)...\n", mCopyQueue[i].out_path.to_string());
+				continue;
+			}
+
+			nstool::print("Saving {:s}...\n", mCopyQueue[i].out_path.to_string());
+
+			if (job_state[i] == JobState_Failed)
+			{
+				failed_job = i;
+				stop_requested = true;
+				break;
+			}
+		}
+	}
+
+	for (auto itr = workers.begin(); itr != workers.end(); itr++)
+	{
+		itr->join();
+	}
+	mCopyQueue.clear();
+
+	if (failed_job < job_error.size())
+	{
+		throw tc::Exception(job_error[failed_job].first, job_error[failed_job].second);
+	}
+}
+
+void nstool::FsProcess::copyFile(tc::io::IFileSystem& input_fs, const sFileCopyJob& job, tc::ByteData& cache, nstool::StreamCopyPipeline& copy_pipeline)
+{
+	std::shared_ptr<tc::io::IStream> in_stream;
+	std::shared_ptr<tc::io::IStream> out_stream;
+
+	input_fs.openFile(job.v_path, tc::io::FileMode::Open, tc::io::FileAccess::Read, in_stream);
+
+	int64_t file_size = in_stream->length();
+	uint32_t hash_types = getOutputHashTypes();
+
+	// plain byte copy from the input file, let the OS do it (sparse output needs to inspect the data, so it always takes the buffered path)
+	if (mRawInputPath.isSet() && job.data_offset != std::numeric_limits<int64_t>::max() && mExtractOptions.sparse_output == false && isRawInputRegion(in_stream, job.data_offset))
+	{
+		if (copyFileRegionToFile(mRawInputPath.get(), job.data_offset, file_size, job.out_path))
+		{
+			// the data never passed through this process, so hash the output (which is still in the page cache)
+			if (hash_types != 0)
+			{
+				ContentHasher hasher(hash_types);
+				hashLocalFile(job.out_path, cache, hasher);
+				recordOutputHashes(job, file_size, hasher);
+			}
+			return;
+		}
+	}
+
+	out_stream = openOutputFileStream(job.out_path, file_size);
+
+	if (hash_types == 0)
+	{
+		copy_pipeline.copy(in_stream, out_stream, cache, mExtractOptions.sparse_output, StreamDataObserver(), getSourceName(job.v_path));
+		return;
+	}
+
+	ContentHasher hasher(hash_types);
+	copy_pipeline.copy(in_stream, out_stream, cache, mExtractOptions.sparse_output, [&hasher](const byte_t* data, size_t len) { hasher.update(data, len); }, getSourceName(job.v_path));
+	hasher.finalize();
+
+	// only recorded once the file is complete, so a file cut short by an interruption is extracted again
+	recordOutputHashes(job, file_size, hasher);
+}
+
+std::string nstool::FsProcess::getSourceName(const tc::io::Path& v_path) const
+{
+	return fmt::format("{:s}file \"{:s}\"", (mFsFormatName.isSet() ? (mFsFormatName.get() + " ") : ""), v_path.to_string());
+}
+
+bool nstool::FsProcess::isRawInputRegion(const std::shared_ptr<tc::io::IStream>& in_stream, int64_t offset)
+{
+	const int64_t file_size = in_stream->length();
+
+	try {
+		std::shared_ptr<tc::io::IStream> raw_file = std::make_shared<tc::io::FileStream>(tc::io::FileStream(mRawInputPath.get(), tc::io::FileMode::Open, tc::io::FileAccess::Read));
+		if (offset < 0 || offset > raw_file->length() || file_size > raw_file->length() - offset)
+		{
+			return false;
+		}
+
+		// samples at the start, middle and end of the file
+		tc::ByteData file_sample = tc::ByteData(kRawInputSampleSize);
+		tc::ByteData raw_sample = tc::ByteData(kRawInputSampleSize);
+		size_t sample_size = size_t(std::min<int64_t>(file_size, int64_t(kRawInputSampleSize)));
+		int64_t sample_offsets[] = { 0, (file_size - int64_t(sample_size)) / 2, file_size - int64_t(sample_size) };
+		for (size_t i = 0; i < sizeof(sample_offsets) / sizeof(sample_offsets[0]); i++)
+		{
+			readStreamExact(in_stream, sample_offsets[i], file_sample.data(), sample_size, mModuleLabel);
+			readStreamExact(raw_file, offset + sample_offsets[i], raw_sample.data(), sample_size, mModuleLabel);
+			if (memcmp(file_sample.data(), raw_sample.data(), sample_size) != 0)
+			{
+				return false;
+			}
+		}
+	}
+	catch (tc::io::IOException&) {
+		return false;
+	}
+
+	return true;
+}
+
+bool nstool::FsProcess::isOutputUnchanged(tc::io::IFileSystem& input_fs, const sFileCopyJob& job, tc::ByteData& cache)
+{
+	nstool::ExtractManifest::sEntry manifest_entry;
+	if (mManifest == nullptr || mManifest->getEntry(job.v_path.to_string(), manifest_entry) == false)
+	{
+		return false;
+	}
+
+	// the source file must still have the recorded size
+	std::shared_ptr<tc::io::IStream> in_stream;
+	input_fs.openFile(job.v_path, tc::io::FileMode::Open, tc::io::FileAccess::Read, in_stream);
+	if (in_stream->length() != manifest_entry.size)
+	{
+		return false;
+	}
+
+	// and the output file must still have the recorded content, the other output hashes are calculated in the same pass
+	ContentHasher hasher(getOutputHashTypes());
+	try {
+		hashLocalFile(job.out_path, cache, hasher);
+	}
+	catch (tc::io::FileNotFoundException&) {
+		return false;
+	}
+	catch (tc::io::DirectoryNotFoundException&) {
+		return false;
+	}
+
+	if (hasher.getSha256() != manifest_entry.sha256)
+	{
+		return false;
+	}
+
+	if (mExtractOptions.hash_manifest != nullptr)
+	{
+		mExtractOptions.hash_manifest->addEntry(job.out_path, manifest_entry.size, hasher);
+	}
+
+	return true;
+}
+
+uint32_t nstool::FsProcess::getOutputHashTypes() const
+{
+	uint32_t hash_types = 0;
+	if (mManifest != nullptr)
+	{
+		hash_types |= ContentHasher::HashType_Sha256;
+	}
+	if (mExtractOptions.hash_manifest != nullptr)
+	{
+		hash_types |= mExtractOptions.hash_manifest->getHashTypes();
+	}
+	return hash_types;
+}
+
+void nstool::FsProcess::recordOutputHashes(const sFileCopyJob& job, int64_t size, const ContentHasher& hasher)
+{
+	if (mManifest != nullptr)
+	{
+		nstool::ExtractManifest::sEntry manifest_entry;
+		manifest_entry.size = size;
+		manifest_entry.sha256 = hasher.getSha256();
+		mManifest->addEntry(job.v_path.to_string(), manifest_entry);
+	}
+
+	if (mExtractOptions.hash_manifest != nullptr)
+	{
+		mExtractOptions.hash_manifest->addEntry(job.out_path, size, hasher);
+	}
+}
+
+void nstool::FsProcess::hashLocalFile(const tc::io::Path& path, tc::ByteData& cache, ContentHasher& hasher)
+{
+	tc::io::FileStream file = tc::io::FileStream(path, tc::io::FileMode::Open, tc::io::FileAccess::Read);
+
+	file.seek(0, tc::io::SeekOrigin::Begin);
+	for (int64_t remaining_data = file.length(); remaining_data > 0;)
+	{
+		size_t read_len = file.read(cache.data(), cache.size());
+		if (read_len == 0)
+		{
+			throw tc::io::IOException(mModuleLabel, "Failed to read from local file.");
+		}
+
+		hasher.update(cache.data(), read_len);
+		remaining_data -= int64_t(read_len);
+	}
+	hasher.finalize();
 }
 
 void nstool::FsProcess::visitDir(const tc::io::Path& v_path, const tc::io::Path& l_path, bool extract_fs, bool print_fs)
@@ -199,9 +599,10 @@ void nstool::FsProcess::visitDir(const tc::io::Path& v_path, const tc::io::Path&
 	if (print_fs)
 	{
 		for (size_t i = 0; i < v_path.size(); i++)
-			fmt::print(" ");
+			nstool::print(" ");
 
-		fmt::print("{:s}/\n", ((v_path.size() == 1) ? (mFsRootLabel.isSet() ? (mFsRootLabel.get() + ":")  : "Root:") : v_path.back()));
+		nstool::print("{:s}/\n", ((v_path.size() == 1) ? (mFsRootLabel.isSet() ? (mFsRootLabel.get() + ":")  : "Root:") : v_path.back()));
+		OutputCapture::addRecord({"dir", v_path.to_string()});
 	}
 	if (extract_fs)
 	{
@@ -210,43 +611,21 @@ void nstool::FsProcess::visitDir(const tc::io::Path& v_path, const tc::io::Path&
 	}
 
 	// iterate thru child files
-	size_t cache_read_len;
-	tc::io::Path out_path;
-	std::shared_ptr<tc::io::IStream> in_stream;
-	std::shared_ptr<tc::io::IStream> out_stream;
 	for (auto itr = info.file_list.begin(); itr != info.file_list.end(); itr++)
 	{
 		if (print_fs)
 		{
 			for (size_t i = 0; i < v_path.size(); i++)
-				fmt::print(" ");
-			fmt::print(" {:s}\n", *itr);
+				nstool::print(" ");
+			nstool::print(" {:s}\n", *itr);
+			OutputCapture::addRecord({"file", (v_path + *itr).to_string()});
 		}
 		if (extract_fs)
 		{
-			// build out path
-			out_path = l_path + *itr;
-
-			fmt::print("Saving {:s}...\n", out_path.to_string());
-
-			// begin export
-			mInputFs->openFile(v_path + *itr, tc::io::FileMode::Open, tc::io::FileAccess::Read, in_stream);
-			local_fs.openFile(out_path, tc::io::FileMode::OpenOrCreate, tc::io::FileAccess::Write, out_stream);
-
-			in_stream->seek(0, tc::io::SeekOrigin::Begin);
-			out_stream->seek(0, tc::io::SeekOrigin::Begin);
-			for (int64_t remaining_data = in_stream->length(); remaining_data > 0;)
-			{
-				cache_read_len = in_stream->read(mDataCache.data(), mDataCache.size());
-				if (cache_read_len == 0)
-				{
-					throw tc::io::IOException(mModuleLabel, fmt::format("Failed to read from {:s}file.", (mFsFormatName.isSet() ? (mFsFormatName.get() + " ") : "")));
-				}
-
-				out_stream->write(mDataCache.data(), cache_read_len);
-
-				remaining_data -= int64_t(cache_read_len);
-			}
+			// queue export, the caller processes the queue once the walk is complete
+			tc::io::Path file_v_path = v_path + *itr;
+			auto offset_itr = mFileOffsets.find(file_v_path.to_string());
+			mCopyQueue.push_back({file_v_path, l_path + *itr, (offset_itr != mFileOffsets.end()) ? offset_itr->second : std::numeric_limits<int64_t>::max()});
 		}
 	}
 
@@ -3,6 +3,9 @@
 #include <tc/io.h>
 
 #include "types.h"
+#include "ExtractManifest.h"
+#include "ContentHasher.h"
+#include "StreamCopyPipeline.h"
 
 namespace nstool
 {
@@ -10,21 +13,29 @@ namespace nstool
 class FsProcess
 {
 public:
+	using FileSystemFactory = std::function<std::shared_ptr<tc::io::IFileSystem>()>;
+
 	FsProcess();
 
 	void process();
 
 	void setInputFileSystem(const std::shared_ptr<tc::io::IFileSystem>& input_fs);
+	void setInputFileSystemFactory(const FileSystemFactory& input_fs_factory);
 	void setFsFormatName(const std::string& fs_format_name);
 	void setFsProperties(const std::vector<std::string>& properties);
 	void setShowFsInfo(bool show_fs_info);
 	void setShowFsTree(bool show_fs_tree);
 	void setFsRootLabel(const std::string& root_label);
 	void setExtractJobs(const std::vector<nstool::ExtractJob>& extract_jobs);
+	void setExtractOptions(const nstool::ExtractOptions& extract_options);
+	void setIoAlignment(size_t io_alignment);
+	void setFileOffsets(const nstool::FileOffsetMap& file_offsets);
+	void setRawInputFile(const tc::io::Path& input_path);
 private:
 	std::string mModuleLabel;
 
 	std::shared_ptr<tc::io::IFileSystem> mInputFs;
+	FileSystemFactory mInputFsFactory;
 
 	// fs info
 	tc::Optional<std::string> mFsFormatName;
@@ -37,12 +48,63 @@ private:
 
 	// extract jobs
 	std::vector<nstool::ExtractJob> mExtractJobs;
+	nstool::ExtractOptions mExtractOptions;
 
-	// cache for file extract
+	// cache for file extract, sized by extractFs() from mIoAlignment and mExtractOptions.max_io_size
+	size_t mIoAlignment;
 	tc::ByteData mDataCache;
+
+	// copies files extracted on this thread, kept for the whole extract so its writer thread is reused
+	std::shared_ptr<nstool::StreamCopyPipeline> mCopyPipeline;
+
+	// location of file data in the input file, when known, so files can be extracted in a single forward pass over the input file
+	nstool::FileOffsetMap mFileOffsets;
+
+	// set when the data at mFileOffsets in this local file is stored as is (no encryption/hash layer), so files can be copied by the OS directly
+	tc::Optional<tc::io::Path> mRawInputPath;
+
+	// file copies found while walking the filesystem, processed in order by flushCopyQueue()
+	struct sFileCopyJob
+	{
+		tc::io::Path v_path;
+		tc::io::Path out_path;
+		int64_t data_offset;
+	};
+	std::vector<sFileCopyJob> mCopyQueue;
+
+	// manifest of the current directory extract job when mExtractOptions.resume is set, otherwise null
+	std::shared_ptr<nstool::ExtractManifest> mManifest;
+
+	// per thread state for parallel extraction, each worker reads from its own input filesystem so no stream is shared between threads
+	struct sExtractWorker
+	{
+		std::shared_ptr<tc::io::IFileSystem> input_fs;
+		tc::ByteData cache;
+		std::shared_ptr<nstool::StreamCopyPipeline> copy_pipeline;
+	};
+	std::vector<sExtractWorker> mExtractWorkers;
 	
 	void printFs();
 	void extractFs();
+	void writeFileToLocalPath(const std::shared_ptr<tc::io::IStream>& file_stream, const tc::io::Path& v_path, const tc::io::Path& out_path);
+	void openManifest(const tc::io::Path& extract_path);
+	void closeManifest();
+	void flushCopyQueue();
+	void copyFile(tc::io::IFileSystem& input_fs, const sFileCopyJob& job, tc::ByteData& cache, nstool::StreamCopyPipeline& copy_pipeline);
+
+	// mFileOffsets are ordering hints parsed separately from the filesystem, so before the region of mRawInputPath at offset is copied as the file opened as in_stream,
+	// check the region lies within the input file and holds the same data (kRawInputSampleSize samples at the start, middle and end of the file)
+	static const size_t kRawInputSampleSize = 0x1000;
+	bool isRawInputRegion(const std::shared_ptr<tc::io::IStream>& in_stream, int64_t offset);
+
+	// describes the file at v_path in the error thrown when it cannot be read
+	std::string getSourceName(const tc::io::Path& v_path) const;
+	bool isOutputUnchanged(tc::io::IFileSystem& input_fs, const sFileCopyJob& job, tc::ByteData& cache);
+
+	// hashes of extracted files are needed by the resume manifest (sha256) and the hash manifest (mExtractOptions.hash_manifest)
+	uint32_t getOutputHashTypes() const;
+	void recordOutputHashes(const sFileCopyJob& job, int64_t size, const ContentHasher& hasher);
+	void hashLocalFile(const tc::io::Path& path, tc::ByteData& cache, ContentHasher& hasher);
 
 	void visitDir(const tc::io::Path& v_path, const tc::io::Path& l_path, bool extract_fs, bool print_fs);
 };
@@ -1,4 +1,7 @@
 #include "GameCardProcess.h"
+#include "OutputCapture.h"
+#include "util.h"
+#include "Sha256Engine.h"
 
 #include <tc/crypto.h>
 #include <tc/io/IOUtil.h>
@@ -14,6 +17,8 @@
 nstool::GameCardProcess::GameCardProcess() :
 	mModuleName("nstool::GameCardProcess"),
 	mFile(),
+	mFileFactory(),
+	mFilePath(),
 	mCliOutputMode(true, false, false, false),
 	mVerify(false),
 	mIsTrueSdkXci(false),
@@ -46,6 +51,16 @@ void nstool::GameCardProcess::setInputFile(const std::shared_ptr<tc::io::IStream
 	mFile = file;
 }
 
+void nstool::GameCardProcess::setInputFileFactory(const StreamFactory& file_factory)
+{
+	mFileFactory = file_factory;
+}
+
+void nstool::GameCardProcess::setInputFilePath(const tc::io::Path& file_path)
+{
+	mFilePath = file_path;
+}
+
 void nstool::GameCardProcess::setKeyCfg(const KeyBag& keycfg)
 {
 	mKeyCfg = keycfg;
@@ -71,6 +86,11 @@ void nstool::GameCardProcess::setExtractJobs(const std::vector<nstool::ExtractJo
 	mFsProcess.setExtractJobs(extract_jobs);
 }
 
+void nstool::GameCardProcess::setExtractOptions(const nstool::ExtractOptions& extract_options)
+{
+	mFsProcess.setExtractOptions(extract_options);
+}
+
 void nstool::GameCardProcess::importHeader()
 {
 	if (mFile == nullptr)
@@ -114,7 +134,7 @@ void nstool::GameCardProcess::importHeader()
 	pie::hac::sGcHeader_Rsa2048Signed* hdr_ptr = (pie::hac::sGcHeader_Rsa2048Signed*)(scratch.data() + mGcHeaderOffset);
 
 	// generate hash of raw header
-	tc::crypto::GenerateSha2256Hash(mHdrHash.data(), (byte_t*)&hdr_ptr->header, sizeof(pie::hac::sGcHeader));
+	nstool::Sha256Engine::GenerateHash(mHdrHash.data(), (byte_t*)&hdr_ptr->header, sizeof(pie::hac::sGcHeader));
 	
 	// save the signature
 	memcpy(mHdrSignature.data(), hdr_ptr->signature.data(), mHdrSignature.size());
@@ -135,85 +155,85 @@ void nstool::GameCardProcess::displayHeader()
 {
 	const pie::hac::sGcHeader* raw_hdr = (const pie::hac::sGcHeader*)mHdr.getBytes().data();
 
-	fmt::print("[GameCard/Header]\n");
-	fmt::print("  CardHeaderVersion:      {:d}\n", mHdr.getCardHeaderVersion());
-	fmt::print("  RomSize:                {:s}", pie::hac::GameCardUtil::getRomSizeAsString((pie::hac::gc::RomSize)mHdr.getRomSizeType()));
+	nstool::print("[GameCard/Header]\n");
+	nstool::print("  CardHeaderVersion:      {:d}\n", mHdr.getCardHeaderVersion());
+	nstool::print("  RomSize:                {:s}", pie::hac::GameCardUtil::getRomSizeAsString((pie::hac::gc::RomSize)mHdr.getRomSizeType()));
 	if (mCliOutputMode.show_extended_info)
-		fmt::print(" (0x{:x})", mHdr.getRomSizeType());
-	fmt::print("\n");
-	fmt::print("  PackageId:              0x{:016x}\n", mHdr.getPackageId());
-	fmt::print("  Flags:                  0x{:02x}\n", *((byte_t*)&raw_hdr->flags));
+		nstool::print(" (0x{:x})", mHdr.getRomSizeType());
+	nstool::print("\n");
+	nstool::print("  PackageId:              0x{:016x}\n", mHdr.getPackageId());
+	nstool::print("  Flags:                  0x{:02x}\n", *((byte_t*)&raw_hdr->flags));
 	for (auto itr = mHdr.getFlags().begin(); itr != mHdr.getFlags().end(); itr++)
 	{
-		fmt::print("    {:s}\n", pie::hac::GameCardUtil::getHeaderFlagsAsString((pie::hac::gc::HeaderFlags)*itr));
+		nstool::print("    {:s}\n", pie::hac::GameCardUtil::getHeaderFlagsAsString((pie::hac::gc::HeaderFlags)*itr));
 	}
 	
 	
 	if (mCliOutputMode.show_extended_info)
 	{
-		fmt::print("  KekIndex:               {:s} ({:d})\n", pie::hac::GameCardUtil::getKekIndexAsString((pie::hac::gc::KekIndex)mHdr.getKekIndex()), mHdr.getKekIndex());
-		fmt::print("  TitleKeyDecIndex:       {:d}\n", mHdr.getTitleKeyDecIndex());
-		fmt::print("  InitialData:\n");
-		fmt::print("    Hash:\n");
-		fmt::print("      {:s}", tc::cli::FormatUtil::formatBytesAsStringWithLineLimit(mHdr.getInitialDataHash().data(), mHdr.getInitialDataHash().size(), true, "", 0x10, 6, false));
+		nstool::print("  KekIndex:               {:s} ({:d})\n", pie::hac::GameCardUtil::getKekIndexAsString((pie::hac::gc::KekIndex)mHdr.getKekIndex()), mHdr.getKekIndex());
+		nstool::print("  TitleKeyDecIndex:       {:d}\n", mHdr.getTitleKeyDecIndex());
+		nstool::print("  InitialData:\n");
+		nstool::print("    Hash:\n");
+		nstool::print("      {:s}", tc::cli::FormatUtil::formatBytesAsStringWithLineLimit(mHdr.getInitialDataHash().data(), mHdr.getInitialDataHash().size(), true, "", 0x10, 6, false));
 	}
 	if (mCliOutputMode.show_extended_info)
 	{
-		fmt::print("  Extended Header AesCbc IV:\n");
-		fmt::print("    {:s}\n", tc::cli::FormatUtil::formatBytesAsString(mHdr.getAesCbcIv().data(), mHdr.getAesCbcIv().size(), true, ""));
+		nstool::print("  Extended Header AesCbc IV:\n");
+		nstool::print("    {:s}\n", tc::cli::FormatUtil::formatBytesAsString(mHdr.getAesCbcIv().data(), mHdr.getAesCbcIv().size(), true, ""));
 	}
-	fmt::print("  SelSec:                 0x{:x}\n", mHdr.getSelSec());
-	fmt::print("  SelT1Key:               0x{:x}\n", mHdr.getSelT1Key());
-	fmt::print("  SelKey:                 0x{:x}\n", mHdr.getSelKey());
+	nstool::print("  SelSec:                 0x{:x}\n", mHdr.getSelSec());
+	nstool::print("  SelT1Key:               0x{:x}\n", mHdr.getSelT1Key());
+	nstool::print("  SelKey:                 0x{:x}\n", mHdr.getSelKey());
 	if (mCliOutputMode.show_layout)
 	{
-		fmt::print("  RomAreaStartPage:       0x{:x}", mHdr.getRomAreaStartPage());
+		nstool::print("  RomAreaStartPage:       0x{:x}", mHdr.getRomAreaStartPage());
 		if (mHdr.getRomAreaStartPage() != (uint32_t)(-1))
-			fmt::print(" (0x{:x})", pie::hac::GameCardUtil::blockToAddr(mHdr.getRomAreaStartPage()));
-		fmt::print("\n");
+			nstool::print(" (0x{:x})", pie::hac::GameCardUtil::blockToAddr(mHdr.getRomAreaStartPage()));
+		nstool::print("\n");
 
-		fmt::print("  BackupAreaStartPage:    0x{:x}", mHdr.getBackupAreaStartPage());
+		nstool::print("  BackupAreaStartPage:    0x{:x}", mHdr.getBackupAreaStartPage());
 		if (mHdr.getBackupAreaStartPage() != (uint32_t)(-1))
-			fmt::print(" (0x{:x})", pie::hac::GameCardUtil::blockToAddr(mHdr.getBackupAreaStartPage()));
-		fmt::print("\n");
+			nstool::print(" (0x{:x})", pie::hac::GameCardUtil::blockToAddr(mHdr.getBackupAreaStartPage()));
+		nstool::print("\n");
 
-		fmt::print("  ValidDataEndPage:       0x{:x}", mHdr.getValidDataEndPage());
+		nstool::print("  ValidDataEndPage:       0x{:x}", mHdr.getValidDataEndPage());
 		if (mHdr.getValidDataEndPage() != (uint32_t)(-1))
-			fmt::print(" (0x{:x})", pie::hac::GameCardUtil::blockToAddr(mHdr.getValidDataEndPage()));
-		fmt::print("\n");
+			nstool::print(" (0x{:x})", pie::hac::GameCardUtil::blockToAddr(mHdr.getValidDataEndPage()));
+		nstool::print("\n");
 
-		fmt::print("  LimArea:                0x{:x}", mHdr.getLimAreaPage());
+		nstool::print("  LimArea:                0x{:x}", mHdr.getLimAreaPage());
 		if (mHdr.getLimAreaPage() != (uint32_t)(-1))
-			fmt::print(" (0x{:x})", pie::hac::GameCardUtil::blockToAddr(mHdr.getLimAreaPage()));
-		fmt::print("\n");
+			nstool::print(" (0x{:x})", pie::hac::GameCardUtil::blockToAddr(mHdr.getLimAreaPage()));
+		nstool::print("\n");
 
-		fmt::print("  PartitionFs Header:\n");
-		fmt::print("    Offset:               0x{:x}\n", mHdr.getPartitionFsAddress());
-		fmt::print("    Size:                 0x{:x}\n", mHdr.getPartitionFsSize());
+		nstool::print("  PartitionFs Header:\n");
+		nstool::print("    Offset:               0x{:x}\n", mHdr.getPartitionFsAddress());
+		nstool::print("    Size:                 0x{:x}\n", mHdr.getPartitionFsSize());
 		if (mCliOutputMode.show_extended_info)
 		{
-			fmt::print("    Hash:\n");
-			fmt::print("      {:s}", tc::cli::FormatUtil::formatBytesAsStringWithLineLimit(mHdr.getPartitionFsHash().data(), mHdr.getPartitionFsHash().size(), true, "", 0x10, 6, false));
+			nstool::print("    Hash:\n");
+			nstool::print("      {:s}", tc::cli::FormatUtil::formatBytesAsStringWithLineLimit(mHdr.getPartitionFsHash().data(), mHdr.getPartitionFsHash().size(), true, "", 0x10, 6, false));
 		}
 	}
 
 	
 	if (mProccessExtendedHeader)
 	{
-		fmt::print("[GameCard/ExtendedHeader]\n");
-		fmt::print("  FwVersion:              v{:d} ({:s})\n", mHdr.getFwVersion(), pie::hac::GameCardUtil::getCardFwVersionDescriptionAsString((pie::hac::gc::FwVersion)mHdr.getFwVersion()));
-		fmt::print("  AccCtrl1:               0x{:x}\n", mHdr.getAccCtrl1());
-		fmt::print("    CardClockRate:        {:s}\n", pie::hac::GameCardUtil::getCardClockRateAsString((pie::hac::gc::CardClockRate)mHdr.getAccCtrl1()));
-		fmt::print("  Wait1TimeRead:          0x{:x}\n", mHdr.getWait1TimeRead());
-		fmt::print("  Wait2TimeRead:          0x{:x}\n", mHdr.getWait2TimeRead());
-		fmt::print("  Wait1TimeWrite:         0x{:x}\n", mHdr.getWait1TimeWrite());
-		fmt::print("  Wait2TimeWrite:         0x{:x}\n", mHdr.getWait2TimeWrite());
-		fmt::print("  SdkAddon Version:       {:s} (v{:d})\n", pie::hac::ContentArchiveUtil::getSdkAddonVersionAsString(mHdr.getFwMode()), mHdr.getFwMode());
-		fmt::print("  CompatibilityType:      {:s} ({:d})\n", pie::hac::GameCardUtil::getCompatibilityTypeAsString((pie::hac::gc::CompatibilityType)mHdr.getCompatibilityType()), mHdr.getCompatibilityType());
-		fmt::print("  Update Partition Info:\n");
-		fmt::print("    CUP Version:          {:s} (v{:d})\n", pie::hac::ContentMetaUtil::getVersionAsString(mHdr.getUppVersion()), mHdr.getUppVersion());
-		fmt::print("    CUP TitleId:          0x{:016x}\n", mHdr.getUppId());
-		fmt::print("    CUP Digest:           {:s}\n", tc::cli::FormatUtil::formatBytesAsString(mHdr.getUppHash().data(), mHdr.getUppHash().size(), true, ""));
+		nstool::print("[GameCard/ExtendedHeader]\n");
+		nstool::print("  FwVersion:              v{:d} ({:s})\n", mHdr.getFwVersion(), pie::hac::GameCardUtil::getCardFwVersionDescriptionAsString((pie::hac::gc::FwVersion)mHdr.getFwVersion()));
+		nstool::print("  AccCtrl1:               0x{:x}\n", mHdr.getAccCtrl1());
+		nstool::print("    CardClockRate:        {:s}\n", pie::hac::GameCardUtil::getCardClockRateAsString((pie::hac::gc::CardClockRate)mHdr.getAccCtrl1()));
+		nstool::print("  Wait1TimeRead:          0x{:x}\n", mHdr.getWait1TimeRead());
+		nstool::print("  Wait2TimeRead:          0x{:x}\n", mHdr.getWait2TimeRead());
+		nstool::print("  Wait1TimeWrite:         0x{:x}\n", mHdr.getWait1TimeWrite());
+		nstool::print("  Wait2TimeWrite:         0x{:x}\n", mHdr.getWait2TimeWrite());
+		nstool::print("  SdkAddon Version:       {:s} (v{:d})\n", pie::hac::ContentArchiveUtil::getSdkAddonVersionAsString(mHdr.getFwMode()), mHdr.getFwMode());
+		nstool::print("  CompatibilityType:      {:s} ({:d})\n", pie::hac::GameCardUtil::getCompatibilityTypeAsString((pie::hac::gc::CompatibilityType)mHdr.getCompatibilityType()), mHdr.getCompatibilityType());
+		nstool::print("  Update Partition Info:\n");
+		nstool::print("    CUP Version:          {:s} (v{:d})\n", pie::hac::ContentMetaUtil::getVersionAsString(mHdr.getUppVersion()), mHdr.getUppVersion());
+		nstool::print("    CUP TitleId:          0x{:016x}\n", mHdr.getUppId());
+		nstool::print("    CUP Digest:           {:s}\n", tc::cli::FormatUtil::formatBytesAsString(mHdr.getUppHash().data(), mHdr.getUppHash().size(), true, ""));
 	}
 }
 
@@ -225,7 +245,7 @@ bool nstool::GameCardProcess::validateRegionOfFile(int64_t offset, int64_t len,
 	mFile->read(scratch.data(), scratch.size());
 
 	// update hash
-	tc::crypto::Sha2256Generator sha256_gen;
+	nstool::Sha256Engine sha256_gen;
 	sha256_gen.initialize();
 	sha256_gen.update(scratch.data(), scratch.size());
 	if (use_salt)
@@ -249,12 +269,12 @@ void nstool::GameCardProcess::validateXciSignature()
 	{
 		if (tc::crypto::VerifyRsa2048Pkcs1Sha2256(mHdrSignature.data(), mHdrHash.data(), mKeyCfg.xci_header_sign_key.get()) == false)
 		{
-			fmt::print("[WARNING] GameCard Header Signature: FAIL\n");
+			nstool::print("[WARNING] GameCard Header Signature: FAIL\n");
 		}
 	}
 	else 
 	{
-		fmt::print("[WARNING] GameCard Header Signature: FAIL (Failed to load rsa public key.)\n");
+		nstool::print("[WARNING] GameCard Header Signature: FAIL (Failed to load rsa public key.)\n");
 	}
 }
 
@@ -262,7 +282,7 @@ void nstool::GameCardProcess::processRootPfs()
 {
 	if (mVerify && validateRegionOfFile(mHdr.getPartitionFsAddress(), mHdr.getPartitionFsSize(), mHdr.getPartitionFsHash().data(), mHdr.getCompatibilityType() != pie::hac::gc::CompatibilityType_Global, mHdr.getCompatibilityType()) == false)
 	{
-		fmt::print("[WARNING] GameCard Root HFS0: FAIL (bad hash)\n");
+		nstool::print("[WARNING] GameCard Root HFS0: FAIL (bad hash)\n");
 	}
 
 	std::shared_ptr<tc::io::IStream> gc_fs_raw = std::make_shared<tc::io::SubStream>(tc::io::SubStream(mFile, mHdr.getPartitionFsAddress(), pie::hac::GameCardUtil::blockToAddr(mHdr.getValidDataEndPage()+1) - mHdr.getPartitionFsAddress()));
@@ -271,6 +291,37 @@ void nstool::GameCardProcess::processRootPfs()
 	mFileSystem = std::make_shared<tc::io::VirtualFileSystem>(tc::io::VirtualFileSystem(gc_vfs_snapshot) );
 
 	mFsProcess.setInputFileSystem(mFileSystem);
+
+	// file offsets for each nested HFS0 partition, offsets in root_offsets are relative to gc_fs_raw
+	FileOffsetMap root_offsets, file_offsets;
+	getPartitionFsFileOffsets(gc_fs_raw, tc::io::Path("/"), 0, root_offsets);
+	for (auto itr = root_offsets.begin(); itr != root_offsets.end(); itr++)
+	{
+		if (itr->second < 0 || itr->second >= gc_fs_raw->length())
+			continue;
+
+		std::shared_ptr<tc::io::IStream> partition_raw = std::make_shared<tc::io::SubStream>(tc::io::SubStream(gc_fs_raw, itr->second, gc_fs_raw->length() - itr->second));
+		getPartitionFsFileOffsets(partition_raw, tc::io::Path(itr->first), mHdr.getPartitionFsAddress() + itr->second, file_offsets);
+	}
+	mFsProcess.setFileOffsets(file_offsets);
+
+	// file data is stored as is in the input file (file_offsets are absolute), unless verification requires it to be read back
+	if (mFilePath.isSet() && mVerify == false)
+	{
+		mFsProcess.setRawInputFile(mFilePath.get());
+	}
+	if (mFileFactory != nullptr)
+	{
+		// HFS0 validation warnings were already shown for mFileSystem, so these copies are created without validation
+		StreamFactory file_factory = mFileFactory;
+		int64_t fs_offset = mHdr.getPartitionFsAddress();
+		int64_t fs_region_size = pie::hac::GameCardUtil::blockToAddr(mHdr.getValidDataEndPage()+1) - mHdr.getPartitionFsAddress();
+		int64_t fs_header_size = mHdr.getPartitionFsSize();
+		mFsProcess.setInputFileSystemFactory([file_factory, fs_offset, fs_region_size, fs_header_size]() -> std::shared_ptr<tc::io::IFileSystem> {
+			std::shared_ptr<tc::io::IStream> fs_raw = std::make_shared<tc::io::SubStream>(tc::io::SubStream(file_factory(), fs_offset, fs_region_size));
+			return std::make_shared<tc::io::VirtualFileSystem>(tc::io::VirtualFileSystem(pie::hac::GameCardFsSnapshotGenerator(fs_raw, fs_header_size, pie::hac::GameCardFsSnapshotGenerator::ValidationMode_None)));
+		});
+	}
 	mFsProcess.setFsFormatName("PartitionFs");
 	mFsProcess.setFsProperties({
 		fmt::format("Type:      Nested HFS0"),
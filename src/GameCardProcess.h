@@ -16,6 +16,8 @@ public:
 
 	// generic
 	void setInputFile(const std::shared_ptr<tc::io::IStream>& file);
+	void setInputFileFactory(const StreamFactory& file_factory);
+	void setInputFilePath(const tc::io::Path& file_path);
 	void setKeyCfg(const KeyBag& keycfg);
 	void setCliOutputMode(CliOutputMode type);
 	void setVerifyMode(bool verify);
@@ -23,12 +25,15 @@ public:
 	// fs specific
 	void setShowFsTree(bool show_fs_tree);
 	void setExtractJobs(const std::vector<nstool::ExtractJob> extract_jobs);
+	void setExtractOptions(const nstool::ExtractOptions& extract_options);
 private:
 	const std::string kXciMountPointName = "gamecard";
 
 	std::string mModuleName;
 
 	std::shared_ptr<tc::io::IStream> mFile;
+	StreamFactory mFileFactory;
+	tc::Optional<tc::io::Path> mFilePath;
 	KeyBag mKeyCfg;
 	CliOutputMode mCliOutputMode;
 	bool mVerify;
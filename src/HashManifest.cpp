@@ -0,0 +1,65 @@
+#include "HashManifest.h"
+
+#include <tc/io/FileStream.h>
+
+nstool::HashManifest::HashManifest(const tc::io::Path& manifest_path, uint32_t hash_types) :
+	mModuleName("nstool::HashManifest"),
+	mHashTypes(hash_types),
+	mMutex(),
+	mFile()
+{
+	if (mHashTypes == 0)
+	{
+		throw tc::ArgumentException(mModuleName, "No hash types were selected.");
+	}
+
+	mFile = std::make_shared<tc::io::FileStream>(tc::io::FileStream(manifest_path, tc::io::FileMode::Create, tc::io::FileAccess::Write));
+
+	std::string header = "#";
+	if (mHashTypes & ContentHasher::HashType_Sha256)
+		header += "sha256\t";
+	if (mHashTypes & ContentHasher::HashType_Crc32)
+		header += "crc32\t";
+	if (mHashTypes & ContentHasher::HashType_XxHash64)
+		header += "xxh64\t";
+	header += "size\tpath\n";
+
+	writeLine(header);
+}
+
+nstool::HashManifest::~HashManifest()
+{
+	try {
+		mFile->flush();
+		mFile->dispose();
+	}
+	catch (...) {
+		// entries are flushed as they are added, so nothing is lost here
+	}
+}
+
+uint32_t nstool::HashManifest::getHashTypes() const
+{
+	return mHashTypes;
+}
+
+void nstool::HashManifest::addEntry(const tc::io::Path& out_path, int64_t size, const ContentHasher& hasher)
+{
+	std::string line;
+	if (mHashTypes & ContentHasher::HashType_Sha256)
+		line += tc::cli::FormatUtil::formatBytesAsString(hasher.getSha256().data(), hasher.getSha256().size(), false, "") + "\t";
+	if (mHashTypes & ContentHasher::HashType_Crc32)
+		line += fmt::format("{:08x}\t", hasher.getCrc32());
+	if (mHashTypes & ContentHasher::HashType_XxHash64)
+		line += fmt::format("{:016x}\t", hasher.getXxHash64());
+	line += fmt::format("{:d}\t{:s}\n", size, out_path.to_string());
+
+	std::lock_guard<std::mutex> lock(mMutex);
+	writeLine(line);
+}
+
+void nstool::HashManifest::writeLine(const std::string& line)
+{
+	mFile->write((const byte_t*)line.c_str(), line.size());
+	mFile->flush();
+}
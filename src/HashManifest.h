@@ -0,0 +1,36 @@
+#pragma once
+#include "types.h"
+#include "ContentHasher.h"
+
+#include <mutex>
+
+namespace nstool {
+
+// Text file listing the hashes of every extracted file, one tab separated line per file ("<hashes...>\t<size>\t<output path>") after a "#" header line naming the columns.
+// The hashes are calculated while files are extracted (see ContentHasher), so no data is read a second time to produce it.
+class HashManifest
+{
+public:
+	// hash_types is a combination of ContentHasher::HashType flags
+	HashManifest(const tc::io::Path& manifest_path, uint32_t hash_types);
+	~HashManifest();
+
+	uint32_t getHashTypes() const;
+
+	// record a file, may be called from several threads, hasher must have been finalized
+	void addEntry(const tc::io::Path& out_path, int64_t size, const ContentHasher& hasher);
+private:
+	std::string mModuleName;
+
+	uint32_t mHashTypes;
+
+	std::mutex mMutex;
+	std::shared_ptr<tc::io::IStream> mFile;
+
+	void writeLine(const std::string& line);
+
+	HashManifest(const HashManifest&) = delete;
+	HashManifest& operator=(const HashManifest&) = delete;
+};
+
+}
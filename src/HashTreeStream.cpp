@@ -0,0 +1,360 @@
+#include "HashTreeStream.h"
+#include "util.h"
+
+#include <tc/io/StreamUtil.h>
+#include <tc/io/IOUtil.h>
+#include <tc/ObjectDisposedException.h>
+#include <tc/NotSupportedException.h>
+#include <tc/ArgumentNullException.h>
+#include <tc/ArgumentOutOfRangeException.h>
+
+#include <cstring>
+#include <algorithm>
+
+nstool::HashTreeStream::HashTreeStream() :
+	mModuleName("nstool::HashTreeStream"),
+	mBaseStream(),
+	mHashEngine(),
+	mPadPartialBlock(false),
+	mBlockCache(),
+	mTreeId(0),
+	mSparseStream(),
+	mDataLayer(),
+	mDataLayerIndex(0),
+	mDataLayerHashes(),
+	mPosition(0),
+	mBlockBuffer(),
+	mBlockHashes(),
+	mBufferedFirstBlock(0),
+	mBufferedBlockNum(0)
+{
+}
+
+nstool::HashTreeStream::HashTreeStream(const std::shared_ptr<tc::io::IStream>& stream, const std::vector<sLayer>& layers, const std::vector<sha256_hash_t>& master_hashes, bool pad_partial_block) :
+	HashTreeStream(stream, layers, master_hashes, pad_partial_block, nullptr, 0)
+{
+}
+
+nstool::HashTreeStream::HashTreeStream(const std::shared_ptr<tc::io::IStream>& stream, const std::vector<sLayer>& layers, const std::vector<sha256_hash_t>& master_hashes, bool pad_partial_block, const std::shared_ptr<VerifiedBlockCache>& block_cache, uint64_t tree_id) :
+	HashTreeStream()
+{
+	if (stream == nullptr)
+	{
+		throw tc::ArgumentNullException(mModuleName, "stream is null.");
+	}
+	if (stream->canRead() == false)
+	{
+		throw tc::InvalidOperationException(mModuleName, "stream does not support reading.");
+	}
+	if (stream->canSeek() == false)
+	{
+		throw tc::InvalidOperationException(mModuleName, "stream does not support seeking.");
+	}
+	if (layers.empty())
+	{
+		throw tc::ArgumentOutOfRangeException(mModuleName, "No hash tree layers were specified.");
+	}
+	for (auto itr = layers.begin(); itr != layers.end(); itr++)
+	{
+		if (itr->offset < 0 || itr->size < 0 || itr->block_size == 0)
+		{
+			throw tc::ArgumentOutOfRangeException(mModuleName, "Hash tree layer geometry was invalid.");
+		}
+	}
+
+	mBaseStream = stream;
+	mPadPartialBlock = pad_partial_block;
+	mBlockCache = block_cache;
+	mTreeId = tree_id;
+	mSparseStream = std::dynamic_pointer_cast<SparseStream>(stream);
+
+	// the hashes for the first layer are the master hashes
+	tc::ByteData hashes = tc::ByteData(master_hashes.size() * Sha256Engine::kHashSize);
+	for (size_t i = 0; i < master_hashes.size(); i++)
+	{
+		memcpy(hashes.data() + i * Sha256Engine::kHashSize, master_hashes[i].data(), Sha256Engine::kHashSize);
+	}
+
+	// read and verify each hash layer, its contents are the hashes for the next layer
+	for (size_t i = 0; i + 1 < layers.size(); i++)
+	{
+		const sLayer& layer = layers[i];
+		size_t block_num = tc::io::IOUtil::castInt64ToSize((layer.size + int64_t(layer.block_size) - 1) / int64_t(layer.block_size));
+		if (hashes.size() < block_num * Sha256Engine::kHashSize)
+		{
+			throw tc::ArgumentOutOfRangeException(mModuleName, fmt::format("Hash layer {:d} has more blocks than there are hashes for it.", i));
+		}
+
+		tc::ByteData layer_data = tc::ByteData(block_num * layer.block_size);
+		memset(layer_data.data(), 0, layer_data.size());
+		bool is_cacheable = mBlockCache != nullptr && layer.size <= int64_t(mBlockCache->getCapacity() / kMaxCachedLayerDivisor);
+		if (is_cacheable == false || loadCachedLayer(uint32_t(i), layer, block_num, layer_data.data()) == false)
+		{
+			readStreamExact(mBaseStream, layer.offset, layer_data.data(), tc::io::IOUtil::castInt64ToSize(layer.size), mModuleName+"::read()");
+
+			if (verifyBlocks(layer, 0, block_num, layer_data.data(), hashes.data()) == false)
+			{
+				throw tc::Exception(mModuleName, fmt::format("Hash layer {:d} failed hash validation.", i));
+			}
+
+			if (is_cacheable)
+			{
+				cacheBlocks(uint32_t(i), layer, 0, block_num, layer_data.data());
+			}
+		}
+
+		hashes = layer_data;
+	}
+
+	mDataLayer = layers.back();
+	mDataLayerIndex = uint32_t(layers.size() - 1);
+	size_t data_block_num = tc::io::IOUtil::castInt64ToSize((mDataLayer.size + int64_t(mDataLayer.block_size) - 1) / int64_t(mDataLayer.block_size));
+	if (hashes.size() < data_block_num * Sha256Engine::kHashSize)
+	{
+		throw tc::ArgumentOutOfRangeException(mModuleName, "Data layer has more blocks than there are hashes for it.");
+	}
+	mDataLayerHashes = hashes;
+
+	// reads are verified in runs of whole blocks
+	size_t buffer_block_num = std::max<size_t>(kMaxReadSize / mDataLayer.block_size, 1);
+	mBlockBuffer = tc::ByteData(buffer_block_num * mDataLayer.block_size);
+	mBlockHashes = tc::ByteData(buffer_block_num * Sha256Engine::kHashSize);
+}
+
+bool nstool::HashTreeStream::canRead() const
+{
+	return mBaseStream != nullptr;
+}
+
+bool nstool::HashTreeStream::canWrite() const
+{
+	return false;
+}
+
+bool nstool::HashTreeStream::canSeek() const
+{
+	return mBaseStream != nullptr;
+}
+
+int64_t nstool::HashTreeStream::length()
+{
+	if (mBaseStream == nullptr)
+	{
+		throw tc::ObjectDisposedException(mModuleName+"::length()", "Failed to get stream length (stream is disposed)");
+	}
+
+	return mDataLayer.size;
+}
+
+int64_t nstool::HashTreeStream::position()
+{
+	if (mBaseStream == nullptr)
+	{
+		throw tc::ObjectDisposedException(mModuleName+"::position()", "Failed to get stream position (stream is disposed)");
+	}
+
+	return mPosition;
+}
+
+size_t nstool::HashTreeStream::read(byte_t* ptr, size_t count)
+{
+	if (mBaseStream == nullptr)
+	{
+		throw tc::ObjectDisposedException(mModuleName+"::read()", "Failed to read from stream (stream is disposed)");
+	}
+	if (ptr == nullptr)
+	{
+		throw tc::ArgumentNullException(mModuleName+"::read()", "ptr was null.");
+	}
+
+	size_t read_len = tc::io::IOUtil::getReadableCount(mDataLayer.size, mPosition, count);
+	const int64_t block_size = int64_t(mDataLayer.block_size);
+	const size_t max_block_num = mBlockBuffer.size() / mDataLayer.block_size;
+
+	for (size_t done = 0; done < read_len;)
+	{
+		int64_t offset = mPosition + int64_t(done);
+		size_t block_index = size_t(offset / block_size);
+
+		// blocks wholly in an absent region of a sparse base stream are zeros, and a run of blocks read stops before the next absent region
+		int64_t present_end = mDataLayer.offset + mDataLayer.size;
+		if (mSparseStream != nullptr)
+		{
+			int64_t block_start = mDataLayer.offset + int64_t(block_index) * block_size;
+			int64_t block_end = std::min<int64_t>(block_start + block_size, mDataLayer.offset + mDataLayer.size);
+			int64_t region_end = 0;
+			if (mSparseStream->getRegion(block_start, region_end))
+			{
+				if (region_end >= block_end)
+				{
+					size_t copy_len = std::min<size_t>(read_len - done, size_t(block_end - mDataLayer.offset - offset));
+					memset(ptr + done, 0, copy_len);
+					done += copy_len;
+					continue;
+				}
+			}
+			else
+			{
+				present_end = std::min<int64_t>(present_end, region_end);
+			}
+		}
+
+		// read and verify the blocks from here to the end of the read, unless the buffered blocks or the block cache already have this data
+		if (mBufferedBlockNum == 0 || block_index < mBufferedFirstBlock || block_index >= mBufferedFirstBlock + mBufferedBlockNum)
+		{
+			std::shared_ptr<const tc::ByteData> cached_block = mBlockCache != nullptr ? mBlockCache->getBlock(mTreeId, mDataLayerIndex, block_index) : nullptr;
+			if (cached_block != nullptr)
+			{
+				size_t block_offset = size_t(offset - int64_t(block_index) * block_size);
+				size_t copy_len = std::min<size_t>(read_len - done, cached_block->size() - block_offset);
+				memcpy(ptr + done, cached_block->data() + block_offset, copy_len);
+				done += copy_len;
+				continue;
+			}
+
+			int64_t read_end = mPosition + int64_t(read_len);
+			size_t block_num = std::min<size_t>(size_t((read_end - int64_t(block_index) * block_size + block_size - 1) / block_size), max_block_num);
+			block_num = std::min<size_t>(block_num, size_t((present_end - mDataLayer.offset - int64_t(block_index) * block_size + block_size - 1) / block_size));
+			int64_t block_offset = int64_t(block_index) * block_size;
+			size_t data_size = std::min<size_t>(block_num * mDataLayer.block_size, size_t(mDataLayer.size - block_offset));
+
+			mBufferedBlockNum = 0;
+			memset(mBlockBuffer.data() + data_size, 0, block_num * mDataLayer.block_size - data_size);
+			readStreamExact(mBaseStream, mDataLayer.offset + block_offset, mBlockBuffer.data(), data_size, mModuleName+"::read()");
+
+			if (verifyBlocks(mDataLayer, block_index, block_num, mBlockBuffer.data(), mDataLayerHashes.data()) == false)
+			{
+				throw tc::Exception(mModuleName, fmt::format("Data at offset 0x{:x} failed hash validation.", block_offset));
+			}
+
+			mBufferedFirstBlock = block_index;
+			mBufferedBlockNum = block_num;
+
+			// small reads (e.g. filesystem tables) are the ones repeated, from larger reads only the edge blocks are cached as they may be shared with neighbouring files
+			if (block_num <= 2)
+			{
+				cacheBlocks(mDataLayerIndex, mDataLayer, block_index, block_num, mBlockBuffer.data());
+			}
+			else
+			{
+				cacheBlocks(mDataLayerIndex, mDataLayer, block_index, 1, mBlockBuffer.data());
+				cacheBlocks(mDataLayerIndex, mDataLayer, block_index + block_num - 1, 1, mBlockBuffer.data() + (block_num - 1) * mDataLayer.block_size);
+			}
+		}
+
+		size_t buffer_offset = size_t(offset - int64_t(mBufferedFirstBlock) * block_size);
+		size_t copy_len = std::min<size_t>(read_len - done, mBufferedBlockNum * mDataLayer.block_size - buffer_offset);
+		memcpy(ptr + done, mBlockBuffer.data() + buffer_offset, copy_len);
+		done += copy_len;
+	}
+
+	mPosition += int64_t(read_len);
+
+	return read_len;
+}
+
+size_t nstool::HashTreeStream::write(const byte_t* ptr, size_t count)
+{
+	throw tc::NotSupportedException(mModuleName+"::write()", "write() is not supported for HashTreeStream");
+}
+
+int64_t nstool::HashTreeStream::seek(int64_t offset, tc::io::SeekOrigin origin)
+{
+	if (mBaseStream == nullptr)
+	{
+		throw tc::ObjectDisposedException(mModuleName+"::seek()", "Failed to set stream position (stream is disposed)");
+	}
+
+	mPosition = tc::io::StreamUtil::getSeekResult(offset, origin, mPosition, mDataLayer.size);
+
+	return mPosition;
+}
+
+void nstool::HashTreeStream::setLength(int64_t length)
+{
+	throw tc::NotSupportedException(mModuleName+"::setLength()", "setLength() is not supported for HashTreeStream");
+}
+
+void nstool::HashTreeStream::flush()
+{
+	if (mBaseStream == nullptr)
+	{
+		throw tc::ObjectDisposedException(mModuleName+"::flush()", "Failed to flush stream (stream is disposed)");
+	}
+
+	mBaseStream->flush();
+}
+
+void nstool::HashTreeStream::dispose()
+{
+	// the base stream is not disposed, it is often shared (e.g. with the raw partition reader)
+	mBaseStream.reset();
+	mBlockCache.reset();
+	mSparseStream.reset();
+	mDataLayerHashes = tc::ByteData();
+	mBlockBuffer = tc::ByteData();
+	mBlockHashes = tc::ByteData();
+	mBufferedBlockNum = 0;
+	mPosition = 0;
+}
+
+bool nstool::HashTreeStream::loadCachedLayer(uint32_t layer_index, const sLayer& layer, size_t block_num, byte_t* data)
+{
+	if (mBlockCache == nullptr)
+	{
+		return false;
+	}
+
+	for (size_t i = 0; i < block_num; i++)
+	{
+		std::shared_ptr<const tc::ByteData> cached_block = mBlockCache->getBlock(mTreeId, layer_index, i);
+		if (cached_block == nullptr)
+		{
+			return false;
+		}
+		memcpy(data + i * layer.block_size, cached_block->data(), cached_block->size());
+	}
+
+	return true;
+}
+
+void nstool::HashTreeStream::cacheBlocks(uint32_t layer_index, const sLayer& layer, size_t first_block, size_t block_num, const byte_t* data)
+{
+	if (mBlockCache == nullptr)
+	{
+		return;
+	}
+
+	for (size_t i = 0; i < block_num; i++)
+	{
+		if (mBlockCache->hasBlock(mTreeId, layer_index, first_block + i))
+		{
+			continue;
+		}
+
+		int64_t block_offset = int64_t(first_block + i) * int64_t(layer.block_size);
+		size_t block_size = std::min<size_t>(layer.block_size, size_t(layer.size - block_offset));
+
+		std::shared_ptr<tc::ByteData> block = std::make_shared<tc::ByteData>(block_size);
+		memcpy(block->data(), data + i * layer.block_size, block_size);
+		mBlockCache->addBlock(mTreeId, layer_index, first_block + i, block);
+	}
+}
+
+bool nstool::HashTreeStream::verifyBlocks(const sLayer& layer, size_t first_block, size_t block_num, const byte_t* data, const byte_t* expected_hashes)
+{
+	// without padding the final block of the layer is only hashed up to the end of the layer
+	size_t hashed_size = block_num * layer.block_size;
+	if (mPadPartialBlock == false)
+	{
+		hashed_size = std::min<size_t>(hashed_size, size_t(layer.size - int64_t(first_block) * int64_t(layer.block_size)));
+	}
+
+	if (mBlockHashes.size() < block_num * Sha256Engine::kHashSize)
+	{
+		mBlockHashes = tc::ByteData(block_num * Sha256Engine::kHashSize);
+	}
+	mHashEngine.generateBlockHashes(mBlockHashes.data(), data, hashed_size, layer.block_size);
+
+	return memcmp(mBlockHashes.data(), expected_hashes + first_block * Sha256Engine::kHashSize, block_num * Sha256Engine::kHashSize) == 0;
+}
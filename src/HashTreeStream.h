@@ -0,0 +1,85 @@
+#pragma once
+#include "types.h"
+#include "Sha256Engine.h"
+#include "VerifiedBlockCache.h"
+#include "SparseStream.h"
+
+namespace nstool {
+
+// Read-only IStream over the data layer of a SHA-256 hash tree (HierarchicalSha256, HierarchicalIntegrity), every data block read is verified against the hash layer above it.
+// The hash layers are read and verified when the stream is created, blocks are hashed with Sha256Engine (several blocks of a read at once).
+// An optional VerifiedBlockCache holds verified blocks, so streams over the same tree (or repeated reads of the same blocks) skip reading and hashing them again.
+// When the base stream is a SparseStream, data blocks in its absent regions are read as zeros without being read or verified.
+class HashTreeStream : public tc::io::IStream
+{
+public:
+	using sha256_hash_t = std::array<byte_t, Sha256Engine::kHashSize>;
+
+	struct sLayer
+	{
+		int64_t offset;
+		int64_t size;
+		size_t block_size;
+	};
+
+	HashTreeStream();
+
+	// layers[0] is verified against master_hashes, layers[i] against the hashes stored in layers[i-1], the last layer is the data read through this stream
+	// when pad_partial_block is true a layer's final block is hashed zero padded to the full block size (HierarchicalIntegrity), otherwise only the bytes present are hashed (HierarchicalSha256)
+	HashTreeStream(const std::shared_ptr<tc::io::IStream>& stream, const std::vector<sLayer>& layers, const std::vector<sha256_hash_t>& master_hashes, bool pad_partial_block);
+
+	// as above, verified blocks are kept in block_cache (may be null) under tree_id, which must identify this hash tree among the trees sharing the cache
+	HashTreeStream(const std::shared_ptr<tc::io::IStream>& stream, const std::vector<sLayer>& layers, const std::vector<sha256_hash_t>& master_hashes, bool pad_partial_block, const std::shared_ptr<VerifiedBlockCache>& block_cache, uint64_t tree_id);
+
+	bool canRead() const;
+	bool canWrite() const;
+	bool canSeek() const;
+	int64_t length();
+	int64_t position();
+	size_t read(byte_t* ptr, size_t count);
+	size_t write(const byte_t* ptr, size_t count);
+	int64_t seek(int64_t offset, tc::io::SeekOrigin origin);
+	void setLength(int64_t length);
+	void flush();
+	void dispose();
+protected:
+	std::string mModuleName;
+private:
+	// upper bound for the data blocks read and verified at once
+	static const size_t kMaxReadSize = 0x100000;
+
+	// hash layers larger than this fraction of the block cache capacity are not cached, so one large tree doesn't evict the blocks of every other tree
+	static const size_t kMaxCachedLayerDivisor = 8;
+
+	std::shared_ptr<tc::io::IStream> mBaseStream;
+	Sha256Engine mHashEngine;
+	bool mPadPartialBlock;
+
+	std::shared_ptr<VerifiedBlockCache> mBlockCache;
+	uint64_t mTreeId;
+
+	// base stream if it is sparse
+	std::shared_ptr<SparseStream> mSparseStream;
+
+	sLayer mDataLayer;
+	uint32_t mDataLayerIndex;
+	tc::ByteData mDataLayerHashes;
+	int64_t mPosition;
+
+	// whole data blocks from the last read (verified), so small reads within them are not hashed again
+	tc::ByteData mBlockBuffer;
+	tc::ByteData mBlockHashes;
+	size_t mBufferedFirstBlock;
+	size_t mBufferedBlockNum;
+
+	// load hash layer layer_index from the block cache, returns false if any of its blocks are not cached
+	bool loadCachedLayer(uint32_t layer_index, const sLayer& layer, size_t block_num, byte_t* data);
+
+	// add block_num blocks of layer_index held in data to the block cache (blocks already cached are skipped), the final block of the layer is cached without padding
+	void cacheBlocks(uint32_t layer_index, const sLayer& layer, size_t first_block, size_t block_num, const byte_t* data);
+
+	// verify block_num blocks of layer held in data (block_num * layer.block_size bytes, zero filled past the end of the layer) against expected_hashes
+	bool verifyBlocks(const sLayer& layer, size_t first_block, size_t block_num, const byte_t* data, const byte_t* expected_hashes);
+};
+
+}
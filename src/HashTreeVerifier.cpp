@@ -0,0 +1,265 @@
+#include "HashTreeVerifier.h"
+#include "util.h"
+#include "Sha256Engine.h"
+
+#include <tc/io/IOUtil.h>
+#include <tc/ArgumentNullException.h>
+#include <tc/ArgumentOutOfRangeException.h>
+
+#include <cstring>
+#include <algorithm>
+#include <thread>
+#include <mutex>
+#include <condition_variable>
+
+nstool::HashTreeVerifier::HashTreeVerifier() :
+	mModuleName("nstool::HashTreeVerifier"),
+	mBaseStream(),
+	mLayers(),
+	mMasterHashes(),
+	mPadPartialBlock(false),
+	mThreadPool()
+{
+}
+
+nstool::HashTreeVerifier::HashTreeVerifier(const std::shared_ptr<tc::io::IStream>& stream, const std::vector<HashTreeStream::sLayer>& layers, const std::vector<HashTreeStream::sha256_hash_t>& master_hashes, bool pad_partial_block, const std::shared_ptr<ThreadPool>& thread_pool) :
+	HashTreeVerifier()
+{
+	if (stream == nullptr)
+	{
+		throw tc::ArgumentNullException(mModuleName, "stream is null.");
+	}
+	for (auto itr = layers.begin(); itr != layers.end(); itr++)
+	{
+		if (itr->offset < 0 || itr->size < 0 || itr->block_size == 0)
+		{
+			throw tc::ArgumentOutOfRangeException(mModuleName, "Hash tree layer geometry was invalid.");
+		}
+	}
+
+	mBaseStream = stream;
+	mLayers = layers;
+	mMasterHashes = master_hashes;
+	mPadPartialBlock = pad_partial_block;
+	mThreadPool = thread_pool;
+}
+
+std::vector<nstool::HashTreeVerifier::sBlockRange> nstool::HashTreeVerifier::verify()
+{
+	std::vector<sBlockRange> failures;
+
+	// the hashes for the first layer are the master hashes
+	tc::ByteData hashes = tc::ByteData(mMasterHashes.size() * Sha256Engine::kHashSize);
+	for (size_t i = 0; i < mMasterHashes.size(); i++)
+	{
+		memcpy(hashes.data() + i * Sha256Engine::kHashSize, mMasterHashes[i].data(), Sha256Engine::kHashSize);
+	}
+
+	// chunk n+1 is read while chunk n is hashed, on one hasher thread kept for every chunk of every layer
+	sChunk hashed_chunk;
+	bool is_chunk_submitted = false;
+	bool is_chunk_pending = false;
+	bool stop_hasher = false;
+	std::exception_ptr hasher_error;
+	std::mutex hasher_mutex;
+	std::condition_variable hasher_changed;
+	std::thread hasher([this, &hashed_chunk, &is_chunk_pending, &stop_hasher, &hasher_error, &hasher_mutex, &hasher_changed]() {
+		std::unique_lock<std::mutex> lock(hasher_mutex);
+		for (;;)
+		{
+			hasher_changed.wait(lock, [&is_chunk_pending, &stop_hasher]() { return is_chunk_pending || stop_hasher; });
+			if (is_chunk_pending == false)
+			{
+				return;
+			}
+
+			lock.unlock();
+			try {
+				hashChunk(hashed_chunk);
+			}
+			catch (...) {
+				hasher_error = std::current_exception();
+			}
+			lock.lock();
+
+			is_chunk_pending = false;
+			hasher_changed.notify_all();
+		}
+	});
+	auto stopHasher = [&]() {
+		{
+			std::lock_guard<std::mutex> lock(hasher_mutex);
+			stop_hasher = true;
+		}
+		hasher_changed.notify_all();
+		hasher.join();
+	};
+
+	try {
+		for (size_t layer_index = 0; layer_index < mLayers.size(); layer_index++)
+		{
+			const HashTreeStream::sLayer& layer = mLayers[layer_index];
+			size_t block_num = tc::io::IOUtil::castInt64ToSize((layer.size + int64_t(layer.block_size) - 1) / int64_t(layer.block_size));
+			size_t chunk_block_num = std::max<size_t>(kChunkSize / layer.block_size, 1);
+
+			// hash layers are kept whole, as they hold the hashes for the next layer, the data layer is read through two chunk buffers
+			bool is_hash_layer = layer_index + 1 < mLayers.size();
+			tc::ByteData layer_data;
+			tc::ByteData chunk_buffer[2];
+			if (is_hash_layer)
+			{
+				layer_data = tc::ByteData(block_num * layer.block_size);
+			}
+			else
+			{
+				chunk_buffer[0] = tc::ByteData(std::min<size_t>(chunk_block_num, block_num) * layer.block_size);
+				chunk_buffer[1] = tc::ByteData(chunk_buffer[0].size());
+			}
+
+			// wait for the chunk being hashed, then collect its failures
+			auto finishHashing = [&]() {
+				if (is_chunk_submitted)
+				{
+					std::unique_lock<std::mutex> lock(hasher_mutex);
+					hasher_changed.wait(lock, [&is_chunk_pending]() { return is_chunk_pending == false; });
+					is_chunk_submitted = false;
+					if (hasher_error != nullptr)
+					{
+						std::rethrow_exception(hasher_error);
+					}
+					collectFailures(layer_index, hashed_chunk, failures);
+				}
+			};
+
+			try {
+				for (size_t first_block = 0, chunk_index = 0; first_block < block_num; chunk_index++)
+				{
+					size_t chunk_blocks = std::min<size_t>(chunk_block_num, block_num - first_block);
+					int64_t layer_offset = int64_t(first_block) * int64_t(layer.block_size);
+					size_t data_size = std::min<size_t>(chunk_blocks * layer.block_size, tc::io::IOUtil::castInt64ToSize(layer.size - layer_offset));
+
+					// the buffer for this chunk was last used two chunks ago, which has finished hashing
+					byte_t* data = is_hash_layer ? layer_data.data() + first_block * layer.block_size : chunk_buffer[chunk_index % 2].data();
+					memset(data + data_size, 0, chunk_blocks * layer.block_size - data_size);
+					readStreamExact(mBaseStream, layer.offset + layer_offset, data, data_size, mModuleName);
+
+					finishHashing();
+
+					{
+						std::lock_guard<std::mutex> lock(hasher_mutex);
+						hashed_chunk.layer = &layer;
+						hashed_chunk.first_block = first_block;
+						hashed_chunk.block_num = chunk_blocks;
+						hashed_chunk.data = data;
+						hashed_chunk.expected_hashes = hashes.data();
+						hashed_chunk.expected_hash_num = hashes.size() / Sha256Engine::kHashSize;
+						is_chunk_pending = true;
+						is_chunk_submitted = true;
+					}
+					hasher_changed.notify_all();
+
+					first_block += chunk_blocks;
+				}
+
+				finishHashing();
+			}
+			catch (...) {
+				// the chunk being hashed uses this layer's buffers
+				std::unique_lock<std::mutex> lock(hasher_mutex);
+				hasher_changed.wait(lock, [&is_chunk_pending]() { return is_chunk_pending == false; });
+				throw;
+			}
+
+			if (is_hash_layer)
+			{
+				hashes = layer_data;
+			}
+		}
+	}
+	catch (...) {
+		stopHasher();
+		throw;
+	}
+
+	stopHasher();
+
+	return failures;
+}
+
+size_t nstool::HashTreeVerifier::getBlockCount() const
+{
+	size_t block_count = 0;
+	for (auto itr = mLayers.begin(); itr != mLayers.end(); itr++)
+	{
+		block_count += tc::io::IOUtil::castInt64ToSize((itr->size + int64_t(itr->block_size) - 1) / int64_t(itr->block_size));
+	}
+	return block_count;
+}
+
+void nstool::HashTreeVerifier::hashChunk(sChunk& chunk)
+{
+	const size_t block_size = chunk.layer->block_size;
+	const size_t task_block_num = std::max<size_t>(kTaskSize / block_size, 1);
+	const size_t task_num = (chunk.block_num + task_block_num - 1) / task_block_num;
+	const bool pad_partial_block = mPadPartialBlock;
+
+	chunk.block_failed.assign(chunk.block_num, 0);
+
+	std::function<void(size_t)> hashTask = [&chunk, block_size, task_block_num, pad_partial_block](size_t task_index) {
+		size_t first = task_index * task_block_num;
+		size_t block_num = std::min<size_t>(task_block_num, chunk.block_num - first);
+
+		// without padding the final block of the layer is only hashed up to the end of the layer
+		size_t hashed_size = block_num * block_size;
+		if (pad_partial_block == false)
+		{
+			hashed_size = std::min<size_t>(hashed_size, size_t(chunk.layer->size - int64_t(chunk.first_block + first) * int64_t(block_size)));
+		}
+
+		std::vector<byte_t> block_hashes(block_num * Sha256Engine::kHashSize);
+		Sha256Engine engine;
+		engine.generateBlockHashes(block_hashes.data(), chunk.data + first * block_size, hashed_size, block_size);
+
+		for (size_t i = 0; i < block_num; i++)
+		{
+			size_t block_index = chunk.first_block + first + i;
+			bool failed = block_index >= chunk.expected_hash_num || memcmp(block_hashes.data() + i * Sha256Engine::kHashSize, chunk.expected_hashes + block_index * Sha256Engine::kHashSize, Sha256Engine::kHashSize) != 0;
+			chunk.block_failed[first + i] = failed ? 1 : 0;
+		}
+	};
+
+	if (mThreadPool != nullptr)
+	{
+		mThreadPool->parallelFor(task_num, hashTask);
+	}
+	else
+	{
+		for (size_t i = 0; i < task_num; i++)
+		{
+			hashTask(i);
+		}
+	}
+}
+
+void nstool::HashTreeVerifier::collectFailures(size_t layer_index, const sChunk& chunk, std::vector<sBlockRange>& failures)
+{
+	for (size_t i = 0; i < chunk.block_num; i++)
+	{
+		if (chunk.block_failed[i] == 0)
+			continue;
+
+		size_t block_index = chunk.first_block + i;
+		if (failures.empty() == false && failures.back().layer_index == layer_index && failures.back().first_block + failures.back().block_num == block_index)
+		{
+			failures.back().block_num++;
+		}
+		else
+		{
+			sBlockRange range;
+			range.layer_index = layer_index;
+			range.first_block = block_index;
+			range.block_num = 1;
+			failures.push_back(range);
+		}
+	}
+}
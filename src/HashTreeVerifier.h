@@ -0,0 +1,65 @@
+#pragma once
+#include "types.h"
+#include "HashTreeStream.h"
+#include "ThreadPool.h"
+
+namespace nstool {
+
+// Verifies every block of every layer of a SHA-256 hash tree, where HashTreeStream only verifies the blocks that are read.
+// Each layer is read sequentially in large chunks, and while the next chunk is read the blocks of the previous one are hashed by a hasher thread (in parallel on a ThreadPool if one is given).
+class HashTreeVerifier
+{
+public:
+	// run of consecutive blocks in one layer that failed hash validation
+	struct sBlockRange
+	{
+		size_t layer_index;
+		size_t first_block;
+		size_t block_num;
+	};
+
+	HashTreeVerifier();
+
+	// layers/master_hashes/pad_partial_block are as for HashTreeStream, thread_pool may be null to hash on the calling thread
+	HashTreeVerifier(const std::shared_ptr<tc::io::IStream>& stream, const std::vector<HashTreeStream::sLayer>& layers, const std::vector<HashTreeStream::sha256_hash_t>& master_hashes, bool pad_partial_block, const std::shared_ptr<ThreadPool>& thread_pool);
+
+	// returns the blocks that failed hash validation (empty if every block is valid)
+	// a block failing in a hash layer does not stop the layers below it being checked against the (possibly bad) hashes it holds
+	std::vector<sBlockRange> verify();
+
+	// total number of blocks in the tree
+	size_t getBlockCount() const;
+private:
+	std::string mModuleName;
+
+	// size of the chunks a layer is read in, rounded down to whole blocks
+	static const size_t kChunkSize = 0x800000;
+
+	// number of bytes hashed by one ThreadPool task, rounded down to whole blocks
+	static const size_t kTaskSize = 0x40000;
+
+	std::shared_ptr<tc::io::IStream> mBaseStream;
+	std::vector<HashTreeStream::sLayer> mLayers;
+	std::vector<HashTreeStream::sha256_hash_t> mMasterHashes;
+	bool mPadPartialBlock;
+	std::shared_ptr<ThreadPool> mThreadPool;
+
+	struct sChunk
+	{
+		const HashTreeStream::sLayer* layer;
+		size_t first_block;
+		size_t block_num;
+		const byte_t* data; // block_num whole blocks, zero filled past the end of the layer
+		const byte_t* expected_hashes; // expected hashes for the whole layer
+		size_t expected_hash_num;
+		std::vector<byte_t> block_failed;
+	};
+
+	// hash every block of chunk, setting chunk.block_failed
+	void hashChunk(sChunk& chunk);
+
+	// append the failed blocks of chunk to failures, extending the last range where they continue it
+	static void collectFailures(size_t layer_index, const sChunk& chunk, std::vector<sBlockRange>& failures);
+};
+
+}
@@ -0,0 +1,44 @@
+#include "HierarchicalIntegrityStream.h"
+
+#include <tc/io/IOUtil.h>
+
+#include <cstring>
+
+nstool::HierarchicalIntegrityStream::HierarchicalIntegrityStream(const std::shared_ptr<tc::io::IStream>& stream, const pie::hac::HierarchicalIntegrityHeader& hdr) :
+	HashTreeStream(stream, getLayers(hdr), getMasterHashes(hdr), true)
+{
+	mModuleName = "nstool::HierarchicalIntegrityStream";
+}
+
+nstool::HierarchicalIntegrityStream::HierarchicalIntegrityStream(const std::shared_ptr<tc::io::IStream>& stream, const pie::hac::HierarchicalIntegrityHeader& hdr, const std::shared_ptr<VerifiedBlockCache>& block_cache, uint64_t tree_id) :
+	HashTreeStream(stream, getLayers(hdr), getMasterHashes(hdr), true, block_cache, tree_id)
+{
+	mModuleName = "nstool::HierarchicalIntegrityStream";
+}
+
+std::vector<nstool::HashTreeStream::sLayer> nstool::HierarchicalIntegrityStream::getLayers(const pie::hac::HierarchicalIntegrityHeader& hdr)
+{
+	std::vector<sLayer> layers;
+	for (size_t i = 0; i < hdr.getLayerInfo().size(); i++)
+	{
+		sLayer layer;
+		layer.offset = hdr.getLayerInfo()[i].offset;
+		layer.size = hdr.getLayerInfo()[i].size;
+		layer.block_size = tc::io::IOUtil::castInt64ToSize(hdr.getLayerInfo()[i].block_size);
+
+		layers.push_back(layer);
+	}
+	return layers;
+}
+
+std::vector<nstool::HashTreeStream::sha256_hash_t> nstool::HierarchicalIntegrityStream::getMasterHashes(const pie::hac::HierarchicalIntegrityHeader& hdr)
+{
+	std::vector<sha256_hash_t> master_hashes;
+	for (size_t i = 0; i < hdr.getMasterHashList().size(); i++)
+	{
+		sha256_hash_t hash;
+		memcpy(hash.data(), hdr.getMasterHashList()[i].data(), hash.size());
+		master_hashes.push_back(hash);
+	}
+	return master_hashes;
+}
@@ -0,0 +1,23 @@
+#pragma once
+#include "HashTreeStream.h"
+
+#include <pietendo/hac/HierarchicalIntegrityHeader.h>
+
+namespace nstool {
+
+// HashTreeStream for a HierarchicalIntegrity (IVFC) hash tree (NCA RomFs partitions), a replacement for pie::hac::HierarchicalIntegrityStream.
+// The first layer's blocks are verified against the master hash list, partial final blocks are hashed zero padded.
+class HierarchicalIntegrityStream : public HashTreeStream
+{
+public:
+	HierarchicalIntegrityStream(const std::shared_ptr<tc::io::IStream>& stream, const pie::hac::HierarchicalIntegrityHeader& hdr);
+
+	// verified blocks are kept in block_cache (may be null) under tree_id, see HashTreeStream
+	HierarchicalIntegrityStream(const std::shared_ptr<tc::io::IStream>& stream, const pie::hac::HierarchicalIntegrityHeader& hdr, const std::shared_ptr<VerifiedBlockCache>& block_cache, uint64_t tree_id);
+
+	// hash tree geometry for HashTreeStream/HashTreeVerifier
+	static std::vector<sLayer> getLayers(const pie::hac::HierarchicalIntegrityHeader& hdr);
+	static std::vector<sha256_hash_t> getMasterHashes(const pie::hac::HierarchicalIntegrityHeader& hdr);
+};
+
+}
@@ -0,0 +1,34 @@
+#include "HierarchicalSha256Stream.h"
+
+#include <tc/io/IOUtil.h>
+
+#include <algorithm>
+
+nstool::HierarchicalSha256Stream::HierarchicalSha256Stream(const std::shared_ptr<tc::io::IStream>& stream, const pie::hac::HierarchicalSha256Header& hdr) :
+	HashTreeStream(stream, getLayers(hdr), std::vector<sha256_hash_t>(1, hdr.getMasterHash()), false)
+{
+	mModuleName = "nstool::HierarchicalSha256Stream";
+}
+
+nstool::HierarchicalSha256Stream::HierarchicalSha256Stream(const std::shared_ptr<tc::io::IStream>& stream, const pie::hac::HierarchicalSha256Header& hdr, const std::shared_ptr<VerifiedBlockCache>& block_cache, uint64_t tree_id) :
+	HashTreeStream(stream, getLayers(hdr), std::vector<sha256_hash_t>(1, hdr.getMasterHash()), false, block_cache, tree_id)
+{
+	mModuleName = "nstool::HierarchicalSha256Stream";
+}
+
+std::vector<nstool::HashTreeStream::sLayer> nstool::HierarchicalSha256Stream::getLayers(const pie::hac::HierarchicalSha256Header& hdr)
+{
+	std::vector<sLayer> layers;
+	for (size_t i = 0; i < hdr.getLayerInfo().size(); i++)
+	{
+		sLayer layer;
+		layer.offset = hdr.getLayerInfo()[i].offset;
+		layer.size = hdr.getLayerInfo()[i].size;
+
+		// the master hash covers the whole first layer
+		layer.block_size = (i == 0) ? std::max<size_t>(tc::io::IOUtil::castInt64ToSize(layer.size), 1) : tc::io::IOUtil::castInt64ToSize(hdr.getHashBlockSize());
+
+		layers.push_back(layer);
+	}
+	return layers;
+}
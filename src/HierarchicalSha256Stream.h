@@ -0,0 +1,22 @@
+#pragma once
+#include "HashTreeStream.h"
+
+#include <pietendo/hac/HierarchicalSha256Header.h>
+
+namespace nstool {
+
+// HashTreeStream for a HierarchicalSha256 hash tree (NCA PartitionFs partitions), a replacement for pie::hac::HierarchicalSha256Stream.
+// The first layer (the hash table) is one block verified against the master hash, the final data block is hashed without padding.
+class HierarchicalSha256Stream : public HashTreeStream
+{
+public:
+	HierarchicalSha256Stream(const std::shared_ptr<tc::io::IStream>& stream, const pie::hac::HierarchicalSha256Header& hdr);
+
+	// verified blocks are kept in block_cache (may be null) under tree_id, see HashTreeStream
+	HierarchicalSha256Stream(const std::shared_ptr<tc::io::IStream>& stream, const pie::hac::HierarchicalSha256Header& hdr, const std::shared_ptr<VerifiedBlockCache>& block_cache, uint64_t tree_id);
+
+	// hash tree geometry for HashTreeStream/HashTreeVerifier
+	static std::vector<sLayer> getLayers(const pie::hac::HierarchicalSha256Header& hdr);
+};
+
+}
@@ -1,4 +1,5 @@
 #include "IniProcess.h"
+#include "OutputCapture.h"
 
 #include "util.h"
 #include "KipProcess.h"
@@ -8,7 +9,8 @@ nstool::IniProcess::IniProcess() :
 	mFile(),
 	mCliOutputMode(true, false, false, false),
 	mVerify(false),
-	mKipExtractPath()
+	mKipExtractPath(),
+	mKipExtractOptions()
 {
 }
 
@@ -47,6 +49,11 @@ void nstool::IniProcess::setKipExtractPath(const tc::io::Path& path)
 	mKipExtractPath = path;
 }
 
+void nstool::IniProcess::setKipExtractOptions(const nstool::ExtractOptions& extract_options)
+{
+	mKipExtractOptions = extract_options;
+}
+
 void nstool::IniProcess::importHeader()
 {
 	if (mFile == nullptr)
@@ -96,9 +103,9 @@ void nstool::IniProcess::importKipList()
 
 void nstool::IniProcess::displayHeader()
 {
-	fmt::print("[INI Header]\n");
-	fmt::print("  Size:         0x{:x}\n", mHdr.getSize());
-	fmt::print("  KIP Num:      {:d}\n", mHdr.getKipNum());
+	nstool::print("[INI Header]\n");
+	nstool::print("  Size:         0x{:x}\n", mHdr.getSize());
+	nstool::print("  KIP Num:      {:d}\n", mHdr.getKipNum());
 }
 
 void nstool::IniProcess::displayKipList()
@@ -118,7 +125,7 @@ void nstool::IniProcess::displayKipList()
 void nstool::IniProcess::extractKipList()
 {
 	// allocate cache memory
-	tc::ByteData cache = tc::ByteData(kCacheSize);
+	tc::ByteData cache = tc::ByteData(getIoBlockSize(1, mKipExtractOptions.max_io_size));
 
 	// make extract dir
 	tc::io::LocalFileSystem local_fs;
@@ -134,9 +141,9 @@ void nstool::IniProcess::extractKipList()
 		out_path += fmt::format("{:s}.kip", itr->hdr.getName());
 
 		if (mCliOutputMode.show_basic_info)
-			fmt::print("Saving {:s}...\n", out_path.to_string());
+			nstool::print("Saving {:s}...\n", out_path.to_string());
 
-		writeStreamToFile(itr->stream, out_path, cache);
+		writeStreamToFile(itr->stream, out_path, cache, mKipExtractOptions.sparse_output);
 	}
 }
 
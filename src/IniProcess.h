@@ -18,9 +18,8 @@ public:
 	void setVerifyMode(bool verify);
 
 	void setKipExtractPath(const tc::io::Path& path);
+	void setKipExtractOptions(const nstool::ExtractOptions& extract_options);
 private:
-	const size_t kCacheSize = 0x10000;
-
 	std::string mModuleName;
 
 	std::shared_ptr<tc::io::IStream> mFile;
@@ -28,6 +27,7 @@ private:
 	bool mVerify;
 	
 	tc::Optional<tc::io::Path> mKipExtractPath;
+	nstool::ExtractOptions mKipExtractOptions;
 
 	pie::hac::IniHeader mHdr;
 	struct InnerKipInfo
@@ -1,4 +1,5 @@
 #include "KipProcess.h"
+#include "OutputCapture.h"
 
 #include <pietendo/hac/KernelCapabilityUtil.h>
 
@@ -151,84 +152,84 @@ size_t nstool::KipProcess::decompressData(const byte_t* src, size_t src_len, byt
 
 void nstool::KipProcess::displayHeader()
 {
-	fmt::print("[KIP Header]\n");
-	fmt::print("  Meta:\n");
-	fmt::print("    Name:                {:s}\n", mHdr.getName());
-	fmt::print("    TitleId:             0x{:016x}\n", mHdr.getTitleId());
-	fmt::print("    Version:             v{:d}\n", mHdr.getVersion());
-	fmt::print("    Is64BitInstruction:  {}\n", mHdr.getIs64BitInstructionFlag());
-	fmt::print("    Is64BitAddressSpace: {}\n", mHdr.getIs64BitAddressSpaceFlag());
-	fmt::print("    UseSecureMemory:     {}\n", mHdr.getUseSecureMemoryFlag());
-	fmt::print("  Program Sections:\n");
-	fmt::print("     .text:\n");
+	nstool::print("[KIP Header]\n");
+	nstool::print("  Meta:\n");
+	nstool::print("    Name:                {:s}\n", mHdr.getName());
+	nstool::print("    TitleId:             0x{:016x}\n", mHdr.getTitleId());
+	nstool::print("    Version:             v{:d}\n", mHdr.getVersion());
+	nstool::print("    Is64BitInstruction:  {}\n", mHdr.getIs64BitInstructionFlag());
+	nstool::print("    Is64BitAddressSpace: {}\n", mHdr.getIs64BitAddressSpaceFlag());
+	nstool::print("    UseSecureMemory:     {}\n", mHdr.getUseSecureMemoryFlag());
+	nstool::print("  Program Sections:\n");
+	nstool::print("     .text:\n");
 	if (mCliOutputMode.show_layout)
 	{
-		fmt::print("      FileOffset:     0x{:x}\n", mHdr.getTextSegmentInfo().file_layout.offset);
-		fmt::print("      FileSize:       0x{:x}{:s}\n", mHdr.getTextSegmentInfo().file_layout.size, (mHdr.getTextSegmentInfo().is_compressed? " (COMPRESSED)" : ""));
+		nstool::print("      FileOffset:     0x{:x}\n", mHdr.getTextSegmentInfo().file_layout.offset);
+		nstool::print("      FileSize:       0x{:x}{:s}\n", mHdr.getTextSegmentInfo().file_layout.size, (mHdr.getTextSegmentInfo().is_compressed? " (COMPRESSED)" : ""));
 	}
-	fmt::print("      MemoryOffset:   0x{:x}\n", mHdr.getTextSegmentInfo().memory_layout.offset);
-	fmt::print("      MemorySize:     0x{:x}\n", mHdr.getTextSegmentInfo().memory_layout.size);
-	fmt::print("    .ro:\n");
+	nstool::print("      MemoryOffset:   0x{:x}\n", mHdr.getTextSegmentInfo().memory_layout.offset);
+	nstool::print("      MemorySize:     0x{:x}\n", mHdr.getTextSegmentInfo().memory_layout.size);
+	nstool::print("    .ro:\n");
 	if (mCliOutputMode.show_layout)
 	{
-		fmt::print("      FileOffset:     0x{:x}\n", mHdr.getRoSegmentInfo().file_layout.offset);
-		fmt::print("      FileSize:       0x{:x}{:s}\n", mHdr.getRoSegmentInfo().file_layout.size, (mHdr.getRoSegmentInfo().is_compressed? " (COMPRESSED)" : ""));
+		nstool::print("      FileOffset:     0x{:x}\n", mHdr.getRoSegmentInfo().file_layout.offset);
+		nstool::print("      FileSize:       0x{:x}{:s}\n", mHdr.getRoSegmentInfo().file_layout.size, (mHdr.getRoSegmentInfo().is_compressed? " (COMPRESSED)" : ""));
 	}
-	fmt::print("      MemoryOffset:   0x{:x}\n", mHdr.getRoSegmentInfo().memory_layout.offset);
-	fmt::print("      MemorySize:     0x{:x}\n", mHdr.getRoSegmentInfo().memory_layout.size);
-	fmt::print("    .data:\n");
+	nstool::print("      MemoryOffset:   0x{:x}\n", mHdr.getRoSegmentInfo().memory_layout.offset);
+	nstool::print("      MemorySize:     0x{:x}\n", mHdr.getRoSegmentInfo().memory_layout.size);
+	nstool::print("    .data:\n");
 	if (mCliOutputMode.show_layout)
 	{
-		fmt::print("      FileOffset:     0x{:x}\n", mHdr.getDataSegmentInfo().file_layout.offset);
-		fmt::print("      FileSize:       0x{:x}{:s}\n", mHdr.getDataSegmentInfo().file_layout.size, (mHdr.getDataSegmentInfo().is_compressed? " (COMPRESSED)" : ""));
+		nstool::print("      FileOffset:     0x{:x}\n", mHdr.getDataSegmentInfo().file_layout.offset);
+		nstool::print("      FileSize:       0x{:x}{:s}\n", mHdr.getDataSegmentInfo().file_layout.size, (mHdr.getDataSegmentInfo().is_compressed? " (COMPRESSED)" : ""));
 	}
-	fmt::print("      MemoryOffset:   0x{:x}\n", mHdr.getDataSegmentInfo().memory_layout.offset);
-	fmt::print("      MemorySize:     0x{:x}\n", mHdr.getDataSegmentInfo().memory_layout.size);
-	fmt::print("    .bss:\n");
-	fmt::print("      MemorySize:     0x{:x}\n", mHdr.getBssSize());
+	nstool::print("      MemoryOffset:   0x{:x}\n", mHdr.getDataSegmentInfo().memory_layout.offset);
+	nstool::print("      MemorySize:     0x{:x}\n", mHdr.getDataSegmentInfo().memory_layout.size);
+	nstool::print("    .bss:\n");
+	nstool::print("      MemorySize:     0x{:x}\n", mHdr.getBssSize());
 
 }
 
 void nstool::KipProcess::displayKernelCap(const pie::hac::KernelCapabilityControl& kern)
 {
-	fmt::print("[Kernel Capabilities]\n");
+	nstool::print("[Kernel Capabilities]\n");
 	if (kern.getThreadInfo().isSet())
 	{
 		pie::hac::ThreadInfoHandler threadInfo = kern.getThreadInfo();
-		fmt::print("  Thread Priority:\n");
-		fmt::print("    Min:     {:d}\n", threadInfo.getMinPriority());
-		fmt::print("    Max:     {:d}\n", threadInfo.getMaxPriority());
-		fmt::print("  CpuId:\n");
-		fmt::print("    Min:     {:d}\n", threadInfo.getMinCpuId());
-		fmt::print("    Max:     {:d}\n", threadInfo.getMaxCpuId());
+		nstool::print("  Thread Priority:\n");
+		nstool::print("    Min:     {:d}\n", threadInfo.getMinPriority());
+		nstool::print("    Max:     {:d}\n", threadInfo.getMaxPriority());
+		nstool::print("  CpuId:\n");
+		nstool::print("    Min:     {:d}\n", threadInfo.getMinCpuId());
+		nstool::print("    Max:     {:d}\n", threadInfo.getMaxCpuId());
 	}
 
 	if (kern.getSystemCalls().isSet())
 	{
 		auto syscall_ids = kern.getSystemCalls().getSystemCallIds();
-		fmt::print("  SystemCalls:\n");
+		nstool::print("  SystemCalls:\n");
 		std::vector<std::string> syscall_names;
 		for (size_t syscall_id = 0; syscall_id < syscall_ids.size(); syscall_id++)
 		{
 			if (syscall_ids.test(syscall_id))
 				syscall_names.push_back(pie::hac::KernelCapabilityUtil::getSystemCallIdAsString(pie::hac::kc::SystemCallId(syscall_id)));
 		}
-		fmt::print("{:s}", tc::cli::FormatUtil::formatListWithLineLimit(syscall_names, 60, 4));
+		nstool::print("{:s}", tc::cli::FormatUtil::formatListWithLineLimit(syscall_names, 60, 4));
 	}
 	if (kern.getMemoryMaps().isSet())
 	{
 		auto maps = kern.getMemoryMaps().getMemoryMaps();
 		auto ioMaps = kern.getMemoryMaps().getIoMemoryMaps();
 
-		fmt::print("  MemoryMaps:\n");
+		nstool::print("  MemoryMaps:\n");
 		for (size_t i = 0; i < maps.size(); i++)
 		{
-			fmt::print("    {:s}\n", formatMappingAsString(maps[i]));	
+			nstool::print("    {:s}\n", formatMappingAsString(maps[i]));	
 		}
-		//fmt::print("  IoMaps:\n");
+		//nstool::print("  IoMaps:\n");
 		for (size_t i = 0; i < ioMaps.size(); i++)
 		{
-			fmt::print("    {:s}\n", formatMappingAsString(ioMaps[i]));
+			nstool::print("    {:s}\n", formatMappingAsString(ioMaps[i]));
 		}
 	}
 	if (kern.getInterupts().isSet())
@@ -238,32 +239,32 @@ void nstool::KipProcess::displayKernelCap(const pie::hac::KernelCapabilityContro
 		{
 			interupts.push_back(fmt::format("0x{:x}", *itr));
 		}
-		fmt::print("  Interupts Flags:\n");
-		fmt::print("{:s}", tc::cli::FormatUtil::formatListWithLineLimit(interupts, 60, 4));
+		nstool::print("  Interupts Flags:\n");
+		nstool::print("{:s}", tc::cli::FormatUtil::formatListWithLineLimit(interupts, 60, 4));
 	}
 	if (kern.getMiscParams().isSet())
 	{
-		fmt::print("  ProgramType:        {:s} ({:d})\n", pie::hac::KernelCapabilityUtil::getProgramTypeAsString(kern.getMiscParams().getProgramType()), (uint32_t)kern.getMiscParams().getProgramType());
+		nstool::print("  ProgramType:        {:s} ({:d})\n", pie::hac::KernelCapabilityUtil::getProgramTypeAsString(kern.getMiscParams().getProgramType()), (uint32_t)kern.getMiscParams().getProgramType());
 	}
 	if (kern.getKernelVersion().isSet())
 	{
-		fmt::print("  Kernel Version:     {:d}.{:d}\n", kern.getKernelVersion().getVerMajor(), kern.getKernelVersion().getVerMinor());
+		nstool::print("  Kernel Version:     {:d}.{:d}\n", kern.getKernelVersion().getVerMajor(), kern.getKernelVersion().getVerMinor());
 	}
 	if (kern.getHandleTableSize().isSet())
 	{
-		fmt::print("  Handle Table Size:  0x{:x}\n", kern.getHandleTableSize().getHandleTableSize());
+		nstool::print("  Handle Table Size:  0x{:x}\n", kern.getHandleTableSize().getHandleTableSize());
 	}
 	if (kern.getMiscFlags().isSet())
 	{
 		auto misc_flags = kern.getMiscFlags().getMiscFlags();
-		fmt::print("  Misc Flags:\n");
+		nstool::print("  Misc Flags:\n");
 		std::vector<std::string> misc_flags_names;
 		for (size_t misc_flags_bit = 0; misc_flags_bit < misc_flags.size(); misc_flags_bit++)
 		{
 			if (misc_flags.test(misc_flags_bit))
 				misc_flags_names.push_back(pie::hac::KernelCapabilityUtil::getMiscFlagsBitAsString(pie::hac::kc::MiscFlagsBit(misc_flags_bit)));
 		}
-		fmt::print("{:s}", tc::cli::FormatUtil::formatListWithLineLimit(misc_flags_names, 60, 4));
+		nstool::print("{:s}", tc::cli::FormatUtil::formatListWithLineLimit(misc_flags_names, 60, 4));
 	}
 }
 
@@ -0,0 +1,264 @@
+#include "MemoryMappedFileStream.h"
+
+#include <tc/io/StreamUtil.h>
+#include <tc/io/IOUtil.h>
+#include <tc/ObjectDisposedException.h>
+#include <tc/NotSupportedException.h>
+#include <tc/ArgumentNullException.h>
+
+#include <cstring>
+#include <limits>
+#include <algorithm>
+
+#ifdef _WIN32
+#include <windows.h>
+#else
+#include <fcntl.h>
+#include <unistd.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#endif
+
+class nstool::MemoryMappedFileStream::MappedFile
+{
+public:
+	MappedFile(const tc::io::Path& path) :
+		mData(nullptr),
+		mSize(0)
+#ifdef _WIN32
+		, mFileHandle(INVALID_HANDLE_VALUE),
+		mMappingHandle(nullptr)
+#endif
+	{
+		static const std::string kModuleName = "nstool::MemoryMappedFileStream";
+
+#ifdef _WIN32
+		std::u16string path_u16 = path.to_u16string();
+		mFileHandle = CreateFileW((LPCWSTR)path_u16.c_str(), GENERIC_READ, FILE_SHARE_READ, nullptr, OPEN_EXISTING, FILE_ATTRIBUTE_NORMAL, nullptr);
+		if (mFileHandle == INVALID_HANDLE_VALUE)
+		{
+			throw tc::io::IOException(kModuleName, "Failed to open file.");
+		}
+
+		LARGE_INTEGER file_size;
+		if (GetFileSizeEx(mFileHandle, &file_size) == FALSE)
+		{
+			CloseHandle(mFileHandle);
+			throw tc::io::IOException(kModuleName, "Failed to get file size.");
+		}
+		mSize = int64_t(file_size.QuadPart);
+
+		// a zero length file cannot be mapped, but is still a valid (empty) stream
+		if (mSize > 0)
+		{
+			mMappingHandle = CreateFileMappingW(mFileHandle, nullptr, PAGE_READONLY, 0, 0, nullptr);
+			if (mMappingHandle == nullptr)
+			{
+				CloseHandle(mFileHandle);
+				throw tc::io::IOException(kModuleName, "Failed to create file mapping.");
+			}
+
+			mData = (const byte_t*)MapViewOfFile(mMappingHandle, FILE_MAP_READ, 0, 0, 0);
+			if (mData == nullptr)
+			{
+				CloseHandle(mMappingHandle);
+				CloseHandle(mFileHandle);
+				throw tc::io::IOException(kModuleName, "Failed to map file.");
+			}
+		}
+#else
+		int fd = open(path.to_string().c_str(), O_RDONLY);
+		if (fd < 0)
+		{
+			throw tc::io::IOException(kModuleName, "Failed to open file.");
+		}
+
+		struct stat file_stat;
+		if (fstat(fd, &file_stat) != 0)
+		{
+			close(fd);
+			throw tc::io::IOException(kModuleName, "Failed to get file size.");
+		}
+		mSize = int64_t(file_stat.st_size);
+
+		// a zero length file cannot be mapped, but is still a valid (empty) stream
+		if (mSize > 0)
+		{
+			if (uint64_t(mSize) > uint64_t(std::numeric_limits<size_t>::max()))
+			{
+				close(fd);
+				throw tc::io::IOException(kModuleName, "File is too large to map.");
+			}
+
+			void* map = mmap(nullptr, size_t(mSize), PROT_READ, MAP_PRIVATE, fd, 0);
+			if (map == MAP_FAILED)
+			{
+				close(fd);
+				throw tc::io::IOException(kModuleName, "Failed to map file.");
+			}
+			mData = (const byte_t*)map;
+		}
+
+		// the mapping remains valid after the descriptor is closed
+		close(fd);
+#endif
+	}
+
+	~MappedFile()
+	{
+#ifdef _WIN32
+		if (mData != nullptr)
+			UnmapViewOfFile(mData);
+		if (mMappingHandle != nullptr)
+			CloseHandle(mMappingHandle);
+		if (mFileHandle != INVALID_HANDLE_VALUE)
+			CloseHandle(mFileHandle);
+#else
+		if (mData != nullptr)
+			munmap((void*)mData, size_t(mSize));
+#endif
+	}
+
+	const byte_t* data() const { return mData; }
+	int64_t size() const { return mSize; }
+
+	// hint that [offset, offset+length) will be read soon
+	void prefetch(int64_t offset, int64_t length) const
+	{
+		if (mData == nullptr || offset >= mSize)
+			return;
+
+		length = std::min<int64_t>(length, mSize - offset);
+#ifdef _WIN32
+		// PrefetchVirtualMemory() is not available on all supported Windows versions, so rely on the system's own read ahead
+#else
+		// madvise() requires a page aligned address
+		static const int64_t kPageSize = int64_t(sysconf(_SC_PAGESIZE));
+		int64_t aligned_offset = offset - (offset % kPageSize);
+		madvise((void*)(mData + aligned_offset), size_t(length + (offset - aligned_offset)), MADV_WILLNEED);
+#endif
+	}
+private:
+	const byte_t* mData;
+	int64_t mSize;
+#ifdef _WIN32
+	HANDLE mFileHandle;
+	HANDLE mMappingHandle;
+#endif
+
+	MappedFile(const MappedFile&) = delete;
+	MappedFile& operator=(const MappedFile&) = delete;
+};
+
+nstool::MemoryMappedFileStream::MemoryMappedFileStream() :
+	mModuleName("nstool::MemoryMappedFileStream"),
+	mFile(),
+	mPosition(0)
+{
+}
+
+nstool::MemoryMappedFileStream::MemoryMappedFileStream(const tc::io::Path& path) :
+	MemoryMappedFileStream()
+{
+	mFile = std::make_shared<MappedFile>(path);
+}
+
+bool nstool::MemoryMappedFileStream::canRead() const
+{
+	return mFile != nullptr;
+}
+
+bool nstool::MemoryMappedFileStream::canWrite() const
+{
+	return false;
+}
+
+bool nstool::MemoryMappedFileStream::canSeek() const
+{
+	return mFile != nullptr;
+}
+
+int64_t nstool::MemoryMappedFileStream::length()
+{
+	if (mFile == nullptr)
+	{
+		throw tc::ObjectDisposedException(mModuleName+"::length()", "Failed to get stream length (stream is disposed)");
+	}
+
+	return mFile->size();
+}
+
+int64_t nstool::MemoryMappedFileStream::position()
+{
+	if (mFile == nullptr)
+	{
+		throw tc::ObjectDisposedException(mModuleName+"::position()", "Failed to get stream position (stream is disposed)");
+	}
+
+	return mPosition;
+}
+
+size_t nstool::MemoryMappedFileStream::read(byte_t* ptr, size_t count)
+{
+	if (mFile == nullptr)
+	{
+		throw tc::ObjectDisposedException(mModuleName+"::read()", "Failed to read from stream (stream is disposed)");
+	}
+	if (ptr == nullptr)
+	{
+		throw tc::ArgumentNullException(mModuleName+"::read()", "ptr was null.");
+	}
+
+	size_t read_len = tc::io::IOUtil::getReadableCount(mFile->size(), mPosition, count);
+	if (read_len == 0)
+	{
+		return 0;
+	}
+
+	// large reads come from file extraction, which reads forward, so fault in the next region before it is needed
+	if (count >= kSequentialReadSize)
+	{
+		mFile->prefetch(mPosition + int64_t(read_len), kReadAheadSize);
+	}
+
+	memcpy(ptr, mFile->data() + mPosition, read_len);
+	mPosition += int64_t(read_len);
+
+	return read_len;
+}
+
+size_t nstool::MemoryMappedFileStream::write(const byte_t* ptr, size_t count)
+{
+	throw tc::NotSupportedException(mModuleName+"::write()", "write() is not supported for MemoryMappedFileStream");
+}
+
+int64_t nstool::MemoryMappedFileStream::seek(int64_t offset, tc::io::SeekOrigin origin)
+{
+	if (mFile == nullptr)
+	{
+		throw tc::ObjectDisposedException(mModuleName+"::seek()", "Failed to set stream position (stream is disposed)");
+	}
+
+	mPosition = tc::io::StreamUtil::getSeekResult(offset, origin, mPosition, mFile->size());
+
+	return mPosition;
+}
+
+void nstool::MemoryMappedFileStream::setLength(int64_t length)
+{
+	throw tc::NotSupportedException(mModuleName+"::setLength()", "setLength() is not supported for MemoryMappedFileStream");
+}
+
+void nstool::MemoryMappedFileStream::flush()
+{
+	if (mFile == nullptr)
+	{
+		throw tc::ObjectDisposedException(mModuleName+"::flush()", "Failed to flush stream (stream is disposed)");
+	}
+}
+
+void nstool::MemoryMappedFileStream::dispose()
+{
+	mFile.reset();
+	mPosition = 0;
+}
@@ -0,0 +1,37 @@
+#pragma once
+#include "types.h"
+
+namespace nstool {
+
+// Read-only IStream over a memory mapped local file.
+// Copies of a MemoryMappedFileStream share the mapping but have their own position, so each copy can be used from a different thread.
+class MemoryMappedFileStream : public tc::io::IStream
+{
+public:
+	MemoryMappedFileStream();
+	MemoryMappedFileStream(const tc::io::Path& path);
+
+	bool canRead() const;
+	bool canWrite() const;
+	bool canSeek() const;
+	int64_t length();
+	int64_t position();
+	size_t read(byte_t* ptr, size_t count);
+	size_t write(const byte_t* ptr, size_t count);
+	int64_t seek(int64_t offset, tc::io::SeekOrigin origin);
+	void setLength(int64_t length);
+	void flush();
+	void dispose();
+private:
+	// reads at least this large are treated as sequential and the following region is prefetched
+	static const size_t kSequentialReadSize = 0x10000;
+	static const size_t kReadAheadSize = 0x400000;
+
+	std::string mModuleName;
+
+	class MappedFile;
+	std::shared_ptr<MappedFile> mFile;
+	int64_t mPosition;
+};
+
+}
@@ -1,4 +1,5 @@
 #include "MetaProcess.h"
+#include "OutputCapture.h"
 
 #include <pietendo/hac/AccessControlInfoUtil.h>
 #include <pietendo/hac/FileSystemAccessUtil.h>
@@ -107,7 +108,7 @@ void nstool::MetaProcess::validateAcidSignature(const pie::hac::AccessControlInf
 		acid.validateSignature(mKeyCfg.acid_sign_key.at(key_generation));
 	}
 	catch (tc::Exception& e) {
-		fmt::print("[WARNING] ACID Signature: FAIL ({:s})\n", e.error());
+		nstool::print("[WARNING] ACID Signature: FAIL ({:s})\n", e.error());
 	}
 	
 }
@@ -117,11 +118,11 @@ void nstool::MetaProcess::validateAciFromAcid(const pie::hac::AccessControlInfo&
 	// check Program ID
 	if (acid.getProgramIdRestrict().min > 0 && aci.getProgramId() < acid.getProgramIdRestrict().min)
 	{
-		fmt::print("[WARNING] ACI ProgramId: FAIL (Outside Legal Range)\n");
+		nstool::print("[WARNING] ACI ProgramId: FAIL (Outside Legal Range)\n");
 	}
 	else if (acid.getProgramIdRestrict().max > 0 && aci.getProgramId() > acid.getProgramIdRestrict().max)
 	{
-		fmt::print("[WARNING] ACI ProgramId: FAIL (Outside Legal Range)\n");
+		nstool::print("[WARNING] ACI ProgramId: FAIL (Outside Legal Range)\n");
 	}
 
 	auto fs_access = aci.getFileSystemAccessControl().getFsAccess();
@@ -137,7 +138,7 @@ void nstool::MetaProcess::validateAciFromAcid(const pie::hac::AccessControlInfo&
 
 		if (rightFound == false)
 		{
-			fmt::print("[WARNING] ACI/FAC FsaRights: FAIL ({:s} not permitted)\n", pie::hac::FileSystemAccessUtil::getFsAccessFlagAsString(fs_access[i]));
+			nstool::print("[WARNING] ACI/FAC FsaRights: FAIL ({:s} not permitted)\n", pie::hac::FileSystemAccessUtil::getFsAccessFlagAsString(fs_access[i]));
 		}
 	}
 
@@ -153,7 +154,7 @@ void nstool::MetaProcess::validateAciFromAcid(const pie::hac::AccessControlInfo&
 		if (rightFound == false)
 		{
 
-			fmt::print("[WARNING] ACI/FAC ContentOwnerId: FAIL (0x{:016x} not permitted)\n", aci.getFileSystemAccessControl().getContentOwnerIdList()[i]);
+			nstool::print("[WARNING] ACI/FAC ContentOwnerId: FAIL (0x{:016x} not permitted)\n", aci.getFileSystemAccessControl().getContentOwnerIdList()[i]);
 		}
 	}
 
@@ -172,7 +173,7 @@ void nstool::MetaProcess::validateAciFromAcid(const pie::hac::AccessControlInfo&
 		if (rightFound == false)
 		{
 
-			fmt::print("[WARNING] ACI/FAC SaveDataOwnerId: FAIL (0x{:016x} ({:d}) not permitted)\n", aci.getFileSystemAccessControl().getSaveDataOwnerIdList()[i].id, (uint32_t)aci.getFileSystemAccessControl().getSaveDataOwnerIdList()[i].access_type);
+			nstool::print("[WARNING] ACI/FAC SaveDataOwnerId: FAIL (0x{:016x} ({:d}) not permitted)\n", aci.getFileSystemAccessControl().getSaveDataOwnerIdList()[i].id, (uint32_t)aci.getFileSystemAccessControl().getSaveDataOwnerIdList()[i].access_type);
 		}
 	}
 #endif
@@ -189,7 +190,7 @@ void nstool::MetaProcess::validateAciFromAcid(const pie::hac::AccessControlInfo&
 
 		if (rightFound == false)
 		{
-			fmt::print("[WARNING] ACI/SAC ServiceList: FAIL ({:s}{:s} not permitted)\n", aci.getServiceAccessControl().getServiceList()[i].getName(), (aci.getServiceAccessControl().getServiceList()[i].isServer()? " (Server)" : ""));
+			nstool::print("[WARNING] ACI/SAC ServiceList: FAIL ({:s}{:s} not permitted)\n", aci.getServiceAccessControl().getServiceList()[i].getName(), (aci.getServiceAccessControl().getServiceList()[i].isServer()? " (Server)" : ""));
 		}
 	}
 
@@ -197,19 +198,19 @@ void nstool::MetaProcess::validateAciFromAcid(const pie::hac::AccessControlInfo&
 	// check thread info
 	if (aci.getKernelCapabilities().getThreadInfo().getMaxCpuId() != acid.getKernelCapabilities().getThreadInfo().getMaxCpuId())
 	{
-		fmt::print("[WARNING] ACI/KC ThreadInfo/MaxCpuId: FAIL ({:d} not permitted)\n", aci.getKernelCapabilities().getThreadInfo().getMaxCpuId());
+		nstool::print("[WARNING] ACI/KC ThreadInfo/MaxCpuId: FAIL ({:d} not permitted)\n", aci.getKernelCapabilities().getThreadInfo().getMaxCpuId());
 	}
 	if (aci.getKernelCapabilities().getThreadInfo().getMinCpuId() != acid.getKernelCapabilities().getThreadInfo().getMinCpuId())
 	{
-		fmt::print("[WARNING] ACI/KC ThreadInfo/MinCpuId: FAIL ({:d} not permitted)\n", aci.getKernelCapabilities().getThreadInfo().getMinCpuId());
+		nstool::print("[WARNING] ACI/KC ThreadInfo/MinCpuId: FAIL ({:d} not permitted)\n", aci.getKernelCapabilities().getThreadInfo().getMinCpuId());
 	}
 	if (aci.getKernelCapabilities().getThreadInfo().getMaxPriority() != acid.getKernelCapabilities().getThreadInfo().getMaxPriority())
 	{
-		fmt::print("[WARNING] ACI/KC ThreadInfo/MaxPriority: FAIL ({:d} not permitted)\n", aci.getKernelCapabilities().getThreadInfo().getMaxPriority());
+		nstool::print("[WARNING] ACI/KC ThreadInfo/MaxPriority: FAIL ({:d} not permitted)\n", aci.getKernelCapabilities().getThreadInfo().getMaxPriority());
 	}
 	if (aci.getKernelCapabilities().getThreadInfo().getMinPriority() != acid.getKernelCapabilities().getThreadInfo().getMinPriority())
 	{
-		fmt::print("[WARNING] ACI/KC ThreadInfo/MinPriority: FAIL ({:d} not permitted)\n", aci.getKernelCapabilities().getThreadInfo().getMinPriority());
+		nstool::print("[WARNING] ACI/KC ThreadInfo/MinPriority: FAIL ({:d} not permitted)\n", aci.getKernelCapabilities().getThreadInfo().getMinPriority());
 	}
 	// check system calls
 	auto syscall_ids = aci.getKernelCapabilities().getSystemCalls().getSystemCallIds();
@@ -218,7 +219,7 @@ void nstool::MetaProcess::validateAciFromAcid(const pie::hac::AccessControlInfo&
 	{
 		if (syscall_ids.test(i) && desc_syscall_ids.test(i) == false)
 		{
-			fmt::print("[WARNING] ACI/KC SystemCallList: FAIL ({:s} not permitted)\n", pie::hac::KernelCapabilityUtil::getSystemCallIdAsString(pie::hac::kc::SystemCallId(i)));
+			nstool::print("[WARNING] ACI/KC SystemCallList: FAIL ({:s} not permitted)\n", pie::hac::KernelCapabilityUtil::getSystemCallIdAsString(pie::hac::kc::SystemCallId(i)));
 		}
 	}
 	// check memory maps
@@ -235,7 +236,7 @@ void nstool::MetaProcess::validateAciFromAcid(const pie::hac::AccessControlInfo&
 		{
 			auto map = aci.getKernelCapabilities().getMemoryMaps().getMemoryMaps()[i];
 
-			fmt::print("[WARNING] ACI/KC MemoryMap: FAIL ({:s} not permitted)\n", formatMappingAsString(map));
+			nstool::print("[WARNING] ACI/KC MemoryMap: FAIL ({:s} not permitted)\n", formatMappingAsString(map));
 		}
 	}
 	for (size_t i = 0; i < aci.getKernelCapabilities().getMemoryMaps().getIoMemoryMaps().size(); i++)
@@ -251,7 +252,7 @@ void nstool::MetaProcess::validateAciFromAcid(const pie::hac::AccessControlInfo&
 		{
 			auto map = aci.getKernelCapabilities().getMemoryMaps().getIoMemoryMaps()[i];
 
-			fmt::print("[WARNING] ACI/KC IoMemoryMap: FAIL ({:s} not permitted)\n", formatMappingAsString(map));
+			nstool::print("[WARNING] ACI/KC IoMemoryMap: FAIL ({:s} not permitted)\n", formatMappingAsString(map));
 		}
 	}
 	// check interupts
@@ -266,25 +267,25 @@ void nstool::MetaProcess::validateAciFromAcid(const pie::hac::AccessControlInfo&
 
 		if (rightFound == false)
 		{
-			fmt::print("[WARNING] ACI/KC InteruptsList: FAIL (0x{:x} not permitted)\n", aci.getKernelCapabilities().getInterupts().getInteruptList()[i]);
+			nstool::print("[WARNING] ACI/KC InteruptsList: FAIL (0x{:x} not permitted)\n", aci.getKernelCapabilities().getInterupts().getInteruptList()[i]);
 		}
 	}
 	// check misc params
 	if (aci.getKernelCapabilities().getMiscParams().getProgramType() != acid.getKernelCapabilities().getMiscParams().getProgramType())
 	{
-		fmt::print("[WARNING] ACI/KC ProgramType: FAIL ({:d} not permitted)\n", (uint32_t)aci.getKernelCapabilities().getMiscParams().getProgramType());
+		nstool::print("[WARNING] ACI/KC ProgramType: FAIL ({:d} not permitted)\n", (uint32_t)aci.getKernelCapabilities().getMiscParams().getProgramType());
 	}
 	// check kernel version
 	uint32_t aciKernelVersion = (uint32_t)aci.getKernelCapabilities().getKernelVersion().getVerMajor() << 16 |  (uint32_t)aci.getKernelCapabilities().getKernelVersion().getVerMinor();
 	uint32_t acidKernelVersion =  (uint32_t)acid.getKernelCapabilities().getKernelVersion().getVerMajor() << 16 |  (uint32_t)acid.getKernelCapabilities().getKernelVersion().getVerMinor();
 	if (aciKernelVersion < acidKernelVersion)
 	{
-		fmt::print("[WARNING] ACI/KC RequiredKernelVersion: FAIL ({:d}.{:d} not permitted)\n", aci.getKernelCapabilities().getKernelVersion().getVerMajor(), aci.getKernelCapabilities().getKernelVersion().getVerMinor());
+		nstool::print("[WARNING] ACI/KC RequiredKernelVersion: FAIL ({:d}.{:d} not permitted)\n", aci.getKernelCapabilities().getKernelVersion().getVerMajor(), aci.getKernelCapabilities().getKernelVersion().getVerMinor());
 	}
 	// check handle table size
 	if (aci.getKernelCapabilities().getHandleTableSize().getHandleTableSize() > acid.getKernelCapabilities().getHandleTableSize().getHandleTableSize())
 	{
-		fmt::print("[WARNING] ACI/KC HandleTableSize: FAIL (0x{:x} too large)\n", aci.getKernelCapabilities().getHandleTableSize().getHandleTableSize());
+		nstool::print("[WARNING] ACI/KC HandleTableSize: FAIL (0x{:x} too large)\n", aci.getKernelCapabilities().getHandleTableSize().getHandleTableSize());
 	}
 	// check misc flags
 	auto misc_flags = aci.getKernelCapabilities().getMiscFlags().getMiscFlags();
@@ -293,55 +294,55 @@ void nstool::MetaProcess::validateAciFromAcid(const pie::hac::AccessControlInfo&
 	{
 		if (misc_flags.test(i) && desc_misc_flags.test(i) == false)
 		{
-			fmt::print("[WARNING] ACI/KC MiscFlag: FAIL ({:s} not permitted)\n", pie::hac::KernelCapabilityUtil::getMiscFlagsBitAsString(pie::hac::kc::MiscFlagsBit(i)));
+			nstool::print("[WARNING] ACI/KC MiscFlag: FAIL ({:s} not permitted)\n", pie::hac::KernelCapabilityUtil::getMiscFlagsBitAsString(pie::hac::kc::MiscFlagsBit(i)));
 		}		
 	}
 }
 
 void nstool::MetaProcess::displayMetaHeader(const pie::hac::Meta& hdr)
 {
-	fmt::print("[Meta Header]\n");
-	fmt::print("  ACID KeyGeneration: {:d}\n", hdr.getAccessControlInfoDescKeyGeneration());
-	fmt::print("  Flags:\n");
-	fmt::print("    Is64BitInstruction:       {}\n", hdr.getIs64BitInstructionFlag());
-	fmt::print("    ProcessAddressSpace:      {:s}\n", pie::hac::MetaUtil::getProcessAddressSpaceAsString(hdr.getProcessAddressSpace()));
-	fmt::print("    OptimizeMemoryAllocation: {}\n", hdr.getOptimizeMemoryAllocationFlag());
-	fmt::print("  SystemResourceSize: 0x{:x}\n", hdr.getSystemResourceSize());
-	fmt::print("  Main Thread Params:\n");
-	fmt::print("    Priority:      {:d}\n", hdr.getMainThreadPriority());
-	fmt::print("    CpuId:         {:d}\n", hdr.getMainThreadCpuId());
-	fmt::print("    StackSize:     0x{:x}\n", hdr.getMainThreadStackSize());
-	fmt::print("  TitleInfo:\n");
-	fmt::print("    Version:       v{:d}\n", hdr.getVersion());
-	fmt::print("    Name:          {:s}\n", hdr.getName());
+	nstool::print("[Meta Header]\n");
+	nstool::print("  ACID KeyGeneration: {:d}\n", hdr.getAccessControlInfoDescKeyGeneration());
+	nstool::print("  Flags:\n");
+	nstool::print("    Is64BitInstruction:       {}\n", hdr.getIs64BitInstructionFlag());
+	nstool::print("    ProcessAddressSpace:      {:s}\n", pie::hac::MetaUtil::getProcessAddressSpaceAsString(hdr.getProcessAddressSpace()));
+	nstool::print("    OptimizeMemoryAllocation: {}\n", hdr.getOptimizeMemoryAllocationFlag());
+	nstool::print("  SystemResourceSize: 0x{:x}\n", hdr.getSystemResourceSize());
+	nstool::print("  Main Thread Params:\n");
+	nstool::print("    Priority:      {:d}\n", hdr.getMainThreadPriority());
+	nstool::print("    CpuId:         {:d}\n", hdr.getMainThreadCpuId());
+	nstool::print("    StackSize:     0x{:x}\n", hdr.getMainThreadStackSize());
+	nstool::print("  TitleInfo:\n");
+	nstool::print("    Version:       v{:d}\n", hdr.getVersion());
+	nstool::print("    Name:          {:s}\n", hdr.getName());
 	if (hdr.getProductCode().length())
 	{
-		fmt::print("    ProductCode:   {:s}\n", hdr.getProductCode());
+		nstool::print("    ProductCode:   {:s}\n", hdr.getProductCode());
 	}
 }
 
 void nstool::MetaProcess::displayAciHdr(const pie::hac::AccessControlInfo& aci)
 {
-	fmt::print("[Access Control Info]\n");
-	fmt::print("  ProgramID:       0x{:016x}\n", aci.getProgramId());
+	nstool::print("[Access Control Info]\n");
+	nstool::print("  ProgramID:       0x{:016x}\n", aci.getProgramId());
 }
 
 void nstool::MetaProcess::displayAciDescHdr(const pie::hac::AccessControlInfoDesc& acid)
 {
-	fmt::print("[Access Control Info Desc]\n");
-	fmt::print("  Flags:           \n");
-	fmt::print("    Production:            {}\n", acid.getProductionFlag());
-	fmt::print("    Unqualified Approval:  {}\n", acid.getUnqualifiedApprovalFlag());
-	fmt::print("    Memory Region:         {:s} ({:d})\n", pie::hac::AccessControlInfoUtil::getMemoryRegionAsString(acid.getMemoryRegion()), (uint32_t)acid.getMemoryRegion());
-	fmt::print("  ProgramID Restriction\n");
-	fmt::print("    Min:           0x{:016x}\n", acid.getProgramIdRestrict().min);
-	fmt::print("    Max:           0x{:016x}\n", acid.getProgramIdRestrict().max);
+	nstool::print("[Access Control Info Desc]\n");
+	nstool::print("  Flags:           \n");
+	nstool::print("    Production:            {}\n", acid.getProductionFlag());
+	nstool::print("    Unqualified Approval:  {}\n", acid.getUnqualifiedApprovalFlag());
+	nstool::print("    Memory Region:         {:s} ({:d})\n", pie::hac::AccessControlInfoUtil::getMemoryRegionAsString(acid.getMemoryRegion()), (uint32_t)acid.getMemoryRegion());
+	nstool::print("  ProgramID Restriction\n");
+	nstool::print("    Min:           0x{:016x}\n", acid.getProgramIdRestrict().min);
+	nstool::print("    Max:           0x{:016x}\n", acid.getProgramIdRestrict().max);
 }
 
 void nstool::MetaProcess::displayFac(const pie::hac::FileSystemAccessControl& fac)
 {
-	fmt::print("[FS Access Control]\n");
-	fmt::print("  Format Version:  {:d}\n", fac.getFormatVersion());
+	nstool::print("[FS Access Control]\n");
+	nstool::print("  Format Version:  {:d}\n", fac.getFormatVersion());
 
 	if (fac.getFsAccess().size())
 	{
@@ -360,81 +361,81 @@ void nstool::MetaProcess::displayFac(const pie::hac::FileSystemAccessControl& fa
 			
 		}
 
-		fmt::print("  FsAccess:\n");
-		fmt::print("{:s}", tc::cli::FormatUtil::formatListWithLineLimit(fs_access_str_list, 60, 4));
+		nstool::print("  FsAccess:\n");
+		nstool::print("{:s}", tc::cli::FormatUtil::formatListWithLineLimit(fs_access_str_list, 60, 4));
 	}
 	
 	if (fac.getContentOwnerIdList().size())
 	{
-		fmt::print("  Content Owner IDs:\n");
+		nstool::print("  Content Owner IDs:\n");
 		for (size_t i = 0; i < fac.getContentOwnerIdList().size(); i++)
 		{
-			fmt::print("    0x{:016x}\n", fac.getContentOwnerIdList()[i]);
+			nstool::print("    0x{:016x}\n", fac.getContentOwnerIdList()[i]);
 		}
 	}
 
 	if (fac.getSaveDataOwnerIdList().size())
 	{
-		fmt::print("  Save Data Owner IDs:\n");
+		nstool::print("  Save Data Owner IDs:\n");
 		for (size_t i = 0; i < fac.getSaveDataOwnerIdList().size(); i++)
 		{
-			fmt::print("    0x{:016x} ({:s})\n", fac.getSaveDataOwnerIdList()[i].id, pie::hac::FileSystemAccessUtil::getSaveDataOwnerAccessModeAsString(fac.getSaveDataOwnerIdList()[i].access_type));
+			nstool::print("    0x{:016x} ({:s})\n", fac.getSaveDataOwnerIdList()[i].id, pie::hac::FileSystemAccessUtil::getSaveDataOwnerAccessModeAsString(fac.getSaveDataOwnerIdList()[i].access_type));
 		}
 	}
 }
 
 void nstool::MetaProcess::displaySac(const pie::hac::ServiceAccessControl& sac)
 {
-	fmt::print("[Service Access Control]\n");
-	fmt::print("  Service List:\n");
+	nstool::print("[Service Access Control]\n");
+	nstool::print("  Service List:\n");
 	std::vector<std::string> service_name_list;
 	for (size_t i = 0; i < sac.getServiceList().size(); i++)
 	{
 		service_name_list.push_back(sac.getServiceList()[i].getName() + (sac.getServiceList()[i].isServer() ? "(isSrv)" : ""));
 	}
-	fmt::print("{:s}", tc::cli::FormatUtil::formatListWithLineLimit(service_name_list, 60, 4));
+	nstool::print("{:s}", tc::cli::FormatUtil::formatListWithLineLimit(service_name_list, 60, 4));
 }
 
 void nstool::MetaProcess::displayKernelCap(const pie::hac::KernelCapabilityControl& kern)
 {
-	fmt::print("[Kernel Capabilities]\n");
+	nstool::print("[Kernel Capabilities]\n");
 	if (kern.getThreadInfo().isSet())
 	{
 		pie::hac::ThreadInfoHandler threadInfo = kern.getThreadInfo();
-		fmt::print("  Thread Priority:\n");
-		fmt::print("    Min:     {:d}\n", threadInfo.getMinPriority());
-		fmt::print("    Max:     {:d}\n", threadInfo.getMaxPriority());
-		fmt::print("  CpuId:\n");
-		fmt::print("    Min:     {:d}\n", threadInfo.getMinCpuId());
-		fmt::print("    Max:     {:d}\n", threadInfo.getMaxCpuId());
+		nstool::print("  Thread Priority:\n");
+		nstool::print("    Min:     {:d}\n", threadInfo.getMinPriority());
+		nstool::print("    Max:     {:d}\n", threadInfo.getMaxPriority());
+		nstool::print("  CpuId:\n");
+		nstool::print("    Min:     {:d}\n", threadInfo.getMinCpuId());
+		nstool::print("    Max:     {:d}\n", threadInfo.getMaxCpuId());
 	}
 
 	if (kern.getSystemCalls().isSet())
 	{
 		auto syscall_ids = kern.getSystemCalls().getSystemCallIds();
-		fmt::print("  SystemCalls:\n");
+		nstool::print("  SystemCalls:\n");
 		std::vector<std::string> syscall_names;
 		for (size_t syscall_id = 0; syscall_id < syscall_ids.size(); syscall_id++)
 		{
 			if (syscall_ids.test(syscall_id))
 				syscall_names.push_back(pie::hac::KernelCapabilityUtil::getSystemCallIdAsString(pie::hac::kc::SystemCallId(syscall_id)));
 		}
-		fmt::print("{:s}", tc::cli::FormatUtil::formatListWithLineLimit(syscall_names, 60, 4));
+		nstool::print("{:s}", tc::cli::FormatUtil::formatListWithLineLimit(syscall_names, 60, 4));
 	}
 	if (kern.getMemoryMaps().isSet())
 	{
 		auto maps = kern.getMemoryMaps().getMemoryMaps();
 		auto ioMaps = kern.getMemoryMaps().getIoMemoryMaps();
 
-		fmt::print("  MemoryMaps:\n");
+		nstool::print("  MemoryMaps:\n");
 		for (size_t i = 0; i < maps.size(); i++)
 		{
-			fmt::print("    {:s}\n", formatMappingAsString(maps[i]));	
+			nstool::print("    {:s}\n", formatMappingAsString(maps[i]));	
 		}
-		//fmt::print("  IoMaps:\n");
+		//nstool::print("  IoMaps:\n");
 		for (size_t i = 0; i < ioMaps.size(); i++)
 		{
-			fmt::print("    {:s}\n", formatMappingAsString(ioMaps[i]));
+			nstool::print("    {:s}\n", formatMappingAsString(ioMaps[i]));
 		}
 	}
 	if (kern.getInterupts().isSet())
@@ -444,32 +445,32 @@ void nstool::MetaProcess::displayKernelCap(const pie::hac::KernelCapabilityContr
 		{
 			interupts.push_back(fmt::format("0x{:x}", *itr));
 		}
-		fmt::print("  Interupts Flags:\n");
-		fmt::print("{:s}", tc::cli::FormatUtil::formatListWithLineLimit(interupts, 60, 4));
+		nstool::print("  Interupts Flags:\n");
+		nstool::print("{:s}", tc::cli::FormatUtil::formatListWithLineLimit(interupts, 60, 4));
 	}
 	if (kern.getMiscParams().isSet())
 	{
-		fmt::print("  ProgramType:        {:s} ({:d})\n", pie::hac::KernelCapabilityUtil::getProgramTypeAsString(kern.getMiscParams().getProgramType()), (uint32_t)kern.getMiscParams().getProgramType());
+		nstool::print("  ProgramType:        {:s} ({:d})\n", pie::hac::KernelCapabilityUtil::getProgramTypeAsString(kern.getMiscParams().getProgramType()), (uint32_t)kern.getMiscParams().getProgramType());
 	}
 	if (kern.getKernelVersion().isSet())
 	{
-		fmt::print("  Kernel Version:     {:d}.{:d}\n", kern.getKernelVersion().getVerMajor(), kern.getKernelVersion().getVerMinor());
+		nstool::print("  Kernel Version:     {:d}.{:d}\n", kern.getKernelVersion().getVerMajor(), kern.getKernelVersion().getVerMinor());
 	}
 	if (kern.getHandleTableSize().isSet())
 	{
-		fmt::print("  Handle Table Size:  0x{:x}\n", kern.getHandleTableSize().getHandleTableSize());
+		nstool::print("  Handle Table Size:  0x{:x}\n", kern.getHandleTableSize().getHandleTableSize());
 	}
 	if (kern.getMiscFlags().isSet())
 	{
 		auto misc_flags = kern.getMiscFlags().getMiscFlags();
-		fmt::print("  Misc Flags:\n");
+		nstool::print("  Misc Flags:\n");
 		std::vector<std::string> misc_flags_names;
 		for (size_t misc_flags_bit = 0; misc_flags_bit < misc_flags.size(); misc_flags_bit++)
 		{
 			if (misc_flags.test(misc_flags_bit))
 				misc_flags_names.push_back(pie::hac::KernelCapabilityUtil::getMiscFlagsBitAsString(pie::hac::kc::MiscFlagsBit(misc_flags_bit)));
 		}
-		fmt::print("{:s}", tc::cli::FormatUtil::formatListWithLineLimit(misc_flags_names, 60, 4));
+		nstool::print("{:s}", tc::cli::FormatUtil::formatListWithLineLimit(misc_flags_names, 60, 4));
 	}
 }
 
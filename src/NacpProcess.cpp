@@ -1,4 +1,5 @@
 #include "NacpProcess.h"
+#include "OutputCapture.h"
 
 #include <pietendo/hac/ApplicationControlPropertyUtil.h>
 
@@ -66,465 +67,465 @@ void nstool::NacpProcess::importNacp()
 
 void nstool::NacpProcess::displayNacp()
 {
-	fmt::print("[ApplicationControlProperty]\n");
+	nstool::print("[ApplicationControlProperty]\n");
 	
 	// Title
 	if (mNacp.getTitle().size() > 0)
 	{
-		fmt::print("  Title:\n");
+		nstool::print("  Title:\n");
 		for (auto itr = mNacp.getTitle().begin(); itr != mNacp.getTitle().end(); itr++)
 		{
-			fmt::print("    {:s}:\n", pie::hac::ApplicationControlPropertyUtil::getLanguageAsString(itr->language));
-			fmt::print("      Name:       {:s}\n", itr->name);
-			fmt::print("      Publisher:  {:s}\n", itr->publisher);
+			nstool::print("    {:s}:\n", pie::hac::ApplicationControlPropertyUtil::getLanguageAsString(itr->language));
+			nstool::print("      Name:       {:s}\n", itr->name);
+			nstool::print("      Publisher:  {:s}\n", itr->publisher);
 		}
 	}
 	else if (mCliOutputMode.show_extended_info)
 	{
-		fmt::print("  Title:                                  None\n");
+		nstool::print("  Title:                                  None\n");
 	}
 
 	// Isbn
 	if (mNacp.getIsbn().empty() == false)
 	{
-		fmt::print("  ISBN:                                   {:s}\n", mNacp.getIsbn());
+		nstool::print("  ISBN:                                   {:s}\n", mNacp.getIsbn());
 	}
 	else if (mCliOutputMode.show_extended_info)
 	{
-		fmt::print("  ISBN:                                   (NotSet)\n");
+		nstool::print("  ISBN:                                   (NotSet)\n");
 	}
 	
 	// StartupUserAccount
 	if (mNacp.getStartupUserAccount() != pie::hac::nacp::StartupUserAccount_None || mCliOutputMode.show_extended_info)
 	{
-		fmt::print("  StartupUserAccount:                     {:s}\n", pie::hac::ApplicationControlPropertyUtil::getStartupUserAccountAsString(mNacp.getStartupUserAccount()));
+		nstool::print("  StartupUserAccount:                     {:s}\n", pie::hac::ApplicationControlPropertyUtil::getStartupUserAccountAsString(mNacp.getStartupUserAccount()));
 	}
 
 	// UserAccountSwitchLock
 	if (mNacp.getUserAccountSwitchLock() != pie::hac::nacp::UserAccountSwitchLock_Disable || mCliOutputMode.show_extended_info)
 	{
-		fmt::print("  UserAccountSwitchLock:                  {:s}\n", pie::hac::ApplicationControlPropertyUtil::getUserAccountSwitchLockAsString(mNacp.getUserAccountSwitchLock()));
+		nstool::print("  UserAccountSwitchLock:                  {:s}\n", pie::hac::ApplicationControlPropertyUtil::getUserAccountSwitchLockAsString(mNacp.getUserAccountSwitchLock()));
 	}
 
 	// AddOnContentRegistrationType
 	if (mNacp.getAddOnContentRegistrationType() != pie::hac::nacp::AddOnContentRegistrationType_AllOnLaunch || mCliOutputMode.show_extended_info)
 	{
-		fmt::print("  AddOnContentRegistrationType:           {:s}\n", pie::hac::ApplicationControlPropertyUtil::getAddOnContentRegistrationTypeAsString(mNacp.getAddOnContentRegistrationType()));
+		nstool::print("  AddOnContentRegistrationType:           {:s}\n", pie::hac::ApplicationControlPropertyUtil::getAddOnContentRegistrationTypeAsString(mNacp.getAddOnContentRegistrationType()));
 	}
 
 	// Attribute
 	if (mNacp.getAttribute().size() > 0)
 	{
-		fmt::print("  Attribute:\n");
+		nstool::print("  Attribute:\n");
 		for (auto itr = mNacp.getAttribute().begin(); itr != mNacp.getAttribute().end(); itr++)
 		{
-			fmt::print("    {:s}\n", pie::hac::ApplicationControlPropertyUtil::getAttributeFlagAsString(*itr));
+			nstool::print("    {:s}\n", pie::hac::ApplicationControlPropertyUtil::getAttributeFlagAsString(*itr));
 		}
 	}
 	else if (mCliOutputMode.show_extended_info)
 	{
-		fmt::print("  Attribute:                              None\n");
+		nstool::print("  Attribute:                              None\n");
 	}
 
 	// SupportedLanguage
 	if (mNacp.getSupportedLanguage().size() > 0)
 	{
-		fmt::print("  SupportedLanguage:\n");
+		nstool::print("  SupportedLanguage:\n");
 		for (auto itr = mNacp.getSupportedLanguage().begin(); itr != mNacp.getSupportedLanguage().end(); itr++)
 		{
-			fmt::print("    {:s}\n", pie::hac::ApplicationControlPropertyUtil::getLanguageAsString(*itr));
+			nstool::print("    {:s}\n", pie::hac::ApplicationControlPropertyUtil::getLanguageAsString(*itr));
 		}
 	}
 	else if (mCliOutputMode.show_extended_info)
 	{
-		fmt::print("  SupportedLanguage:                      None\n");
+		nstool::print("  SupportedLanguage:                      None\n");
 	}
 
 	// ParentalControl
 	if (mNacp.getParentalControl().size() > 0)
 	{
-		fmt::print("  ParentalControl:\n");
+		nstool::print("  ParentalControl:\n");
 		for (auto itr = mNacp.getParentalControl().begin(); itr != mNacp.getParentalControl().end(); itr++)
 		{
-			fmt::print("    {:s}\n", pie::hac::ApplicationControlPropertyUtil::getParentalControlFlagAsString(*itr));
+			nstool::print("    {:s}\n", pie::hac::ApplicationControlPropertyUtil::getParentalControlFlagAsString(*itr));
 		}
 	}
 	else if (mCliOutputMode.show_extended_info)
 	{
-		fmt::print("  ParentalControl:                        None\n");
+		nstool::print("  ParentalControl:                        None\n");
 	}
 
 	// Screenshot
 	if (mNacp.getScreenshot() != pie::hac::nacp::Screenshot_Allow || mCliOutputMode.show_extended_info)
 	{
-		fmt::print("  Screenshot:                             {:s}\n", pie::hac::ApplicationControlPropertyUtil::getScreenshotAsString(mNacp.getScreenshot()));
+		nstool::print("  Screenshot:                             {:s}\n", pie::hac::ApplicationControlPropertyUtil::getScreenshotAsString(mNacp.getScreenshot()));
 	}
 
 	// VideoCapture
 	if (mNacp.getVideoCapture() != pie::hac::nacp::VideoCapture_Disable || mCliOutputMode.show_extended_info)
 	{
-		fmt::print("  VideoCapture:                           {:s}\n", pie::hac::ApplicationControlPropertyUtil::getVideoCaptureAsString(mNacp.getVideoCapture()));
+		nstool::print("  VideoCapture:                           {:s}\n", pie::hac::ApplicationControlPropertyUtil::getVideoCaptureAsString(mNacp.getVideoCapture()));
 	}
 
 	// DataLossConfirmation
 	if (mNacp.getDataLossConfirmation() != pie::hac::nacp::DataLossConfirmation_None || mCliOutputMode.show_extended_info)
 	{
-		fmt::print("  DataLossConfirmation:                   {:s}\n", pie::hac::ApplicationControlPropertyUtil::getDataLossConfirmationAsString(mNacp.getDataLossConfirmation()));
+		nstool::print("  DataLossConfirmation:                   {:s}\n", pie::hac::ApplicationControlPropertyUtil::getDataLossConfirmationAsString(mNacp.getDataLossConfirmation()));
 	}
 
 	// PlayLogPolicy
 	if (mNacp.getPlayLogPolicy() != pie::hac::nacp::PlayLogPolicy_All || mCliOutputMode.show_extended_info)
 	{
-		fmt::print("  PlayLogPolicy:                          {:s}\n", pie::hac::ApplicationControlPropertyUtil::getPlayLogPolicyAsString(mNacp.getPlayLogPolicy()));
+		nstool::print("  PlayLogPolicy:                          {:s}\n", pie::hac::ApplicationControlPropertyUtil::getPlayLogPolicyAsString(mNacp.getPlayLogPolicy()));
 	}
 
 	// PresenceGroupId
 	if (mNacp.getPresenceGroupId() != 0 || mCliOutputMode.show_extended_info)
 	{
-		fmt::print("  PresenceGroupId:                        0x{:016x}\n", mNacp.getPresenceGroupId());
+		nstool::print("  PresenceGroupId:                        0x{:016x}\n", mNacp.getPresenceGroupId());
 	}
 
 	// RatingAge
 	if (mNacp.getRatingAge().size() > 0)
 	{
-		fmt::print("  RatingAge:\n");
+		nstool::print("  RatingAge:\n");
 		
 		for (auto itr = mNacp.getRatingAge().begin(); itr != mNacp.getRatingAge().end(); itr++)
 		{
-			fmt::print("    {:s}:\n", pie::hac::ApplicationControlPropertyUtil::getOrganisationAsString(itr->organisation));
-			fmt::print("      Age: {:d}\n", itr->age);
+			nstool::print("    {:s}:\n", pie::hac::ApplicationControlPropertyUtil::getOrganisationAsString(itr->organisation));
+			nstool::print("      Age: {:d}\n", itr->age);
 		}
 	}
 	else if (mCliOutputMode.show_extended_info)
 	{
-		fmt::print("  RatingAge:                              None\n");
+		nstool::print("  RatingAge:                              None\n");
 	}
 
 	// DisplayVersion
 	if (mNacp.getDisplayVersion().empty() == false)
 	{
-		fmt::print("  DisplayVersion:                         {:s}\n", mNacp.getDisplayVersion());
+		nstool::print("  DisplayVersion:                         {:s}\n", mNacp.getDisplayVersion());
 	}
 	else if (mCliOutputMode.show_extended_info)
 	{
-		fmt::print("  DisplayVersion:                         (NotSet)\n");
+		nstool::print("  DisplayVersion:                         (NotSet)\n");
 	}
 
 	// AddOnContentBaseId
 	if (mNacp.getAddOnContentBaseId() != 0 || mCliOutputMode.show_extended_info)
 	{
-		fmt::print("  AddOnContentBaseId:                     0x{:016x}\n", mNacp.getAddOnContentBaseId());
+		nstool::print("  AddOnContentBaseId:                     0x{:016x}\n", mNacp.getAddOnContentBaseId());
 	}
 
 	// SaveDataOwnerId
 	if (mNacp.getSaveDataOwnerId() != 0 || mCliOutputMode.show_extended_info)
 	{
-		fmt::print("  SaveDataOwnerId:                        0x{:016x}\n", mNacp.getSaveDataOwnerId());
+		nstool::print("  SaveDataOwnerId:                        0x{:016x}\n", mNacp.getSaveDataOwnerId());
 	}
 
 	// UserAccountSaveDataSize
 	if (mNacp.getUserAccountSaveDataSize().size != 0 || mCliOutputMode.show_extended_info)
 	{
-		fmt::print("  UserAccountSaveDataSize:                {:s}\n", pie::hac::ApplicationControlPropertyUtil::getSaveDataSizeAsString(mNacp.getUserAccountSaveDataSize().size));
+		nstool::print("  UserAccountSaveDataSize:                {:s}\n", pie::hac::ApplicationControlPropertyUtil::getSaveDataSizeAsString(mNacp.getUserAccountSaveDataSize().size));
 	}
 
 	// UserAccountSaveDataJournalSize
 	if (mNacp.getUserAccountSaveDataSize().journal_size != 0 || mCliOutputMode.show_extended_info)
 	{
-		fmt::print("  UserAccountSaveDataJournalSize:         {:s}\n", pie::hac::ApplicationControlPropertyUtil::getSaveDataSizeAsString(mNacp.getUserAccountSaveDataSize().journal_size));
+		nstool::print("  UserAccountSaveDataJournalSize:         {:s}\n", pie::hac::ApplicationControlPropertyUtil::getSaveDataSizeAsString(mNacp.getUserAccountSaveDataSize().journal_size));
 	}
 
 	// DeviceSaveDataSize
 	if (mNacp.getDeviceSaveDataSize().size != 0 || mCliOutputMode.show_extended_info)
 	{
-		fmt::print("  DeviceSaveDataSize:                     {:s}\n", pie::hac::ApplicationControlPropertyUtil::getSaveDataSizeAsString(mNacp.getDeviceSaveDataSize().size));
+		nstool::print("  DeviceSaveDataSize:                     {:s}\n", pie::hac::ApplicationControlPropertyUtil::getSaveDataSizeAsString(mNacp.getDeviceSaveDataSize().size));
 	}
 
 	// DeviceSaveDataJournalSize
 	if (mNacp.getDeviceSaveDataSize().journal_size != 0 || mCliOutputMode.show_extended_info)
 	{
-		fmt::print("  DeviceSaveDataJournalSize:              {:s}\n", pie::hac::ApplicationControlPropertyUtil::getSaveDataSizeAsString(mNacp.getDeviceSaveDataSize().journal_size));
+		nstool::print("  DeviceSaveDataJournalSize:              {:s}\n", pie::hac::ApplicationControlPropertyUtil::getSaveDataSizeAsString(mNacp.getDeviceSaveDataSize().journal_size));
 	}
 
 	// BcatDeliveryCacheStorageSize
 	if (mNacp.getBcatDeliveryCacheStorageSize() != 0 || mCliOutputMode.show_extended_info)
 	{
-		fmt::print("  BcatDeliveryCacheStorageSize:           {:s}\n", pie::hac::ApplicationControlPropertyUtil::getSaveDataSizeAsString(mNacp.getBcatDeliveryCacheStorageSize()));
+		nstool::print("  BcatDeliveryCacheStorageSize:           {:s}\n", pie::hac::ApplicationControlPropertyUtil::getSaveDataSizeAsString(mNacp.getBcatDeliveryCacheStorageSize()));
 	}
 
 	// ApplicationErrorCodeCategory
 	if (mNacp.getApplicationErrorCodeCategory().empty() == false)
 	{
-		fmt::print("  ApplicationErrorCodeCategory:           {:s}\n", mNacp.getApplicationErrorCodeCategory());
+		nstool::print("  ApplicationErrorCodeCategory:           {:s}\n", mNacp.getApplicationErrorCodeCategory());
 	}
 	else if (mCliOutputMode.show_extended_info)
 	{
-		fmt::print("  ApplicationErrorCodeCategory:           (NotSet)\n");
+		nstool::print("  ApplicationErrorCodeCategory:           (NotSet)\n");
 	}
 
 	// LocalCommunicationId
 	if (mNacp.getLocalCommunicationId().size() > 0)
 	{
-		fmt::print("  LocalCommunicationId:\n");
+		nstool::print("  LocalCommunicationId:\n");
 		for (auto itr = mNacp.getLocalCommunicationId().begin(); itr != mNacp.getLocalCommunicationId().end(); itr++)
 		{
-			fmt::print("    0x{:016x}\n", *itr);
+			nstool::print("    0x{:016x}\n", *itr);
 		}
 	}
 	else if (mCliOutputMode.show_extended_info)
 	{
-		fmt::print("  LocalCommunicationId:                   None\n");
+		nstool::print("  LocalCommunicationId:                   None\n");
 	}
 
 	// LogoType
 	//if (mNacp.getLogoType() != pie::hac::nacp::LogoType_Nintendo || mCliOutputMode.show_extended_info)
 	//{
-		fmt::print("  LogoType:                               {:s}\n", pie::hac::ApplicationControlPropertyUtil::getLogoTypeAsString(mNacp.getLogoType()));
+		nstool::print("  LogoType:                               {:s}\n", pie::hac::ApplicationControlPropertyUtil::getLogoTypeAsString(mNacp.getLogoType()));
 	//}
 
 	// LogoHandling
 	if (mNacp.getLogoHandling() != pie::hac::nacp::LogoHandling_Auto || mCliOutputMode.show_extended_info)
 	{
-		fmt::print("  LogoHandling:                           {:s}\n", pie::hac::ApplicationControlPropertyUtil::getLogoHandlingAsString(mNacp.getLogoHandling()));
+		nstool::print("  LogoHandling:                           {:s}\n", pie::hac::ApplicationControlPropertyUtil::getLogoHandlingAsString(mNacp.getLogoHandling()));
 	}
 
 	// RuntimeAddOnContentInstall
 	if (mNacp.getRuntimeAddOnContentInstall() != pie::hac::nacp::RuntimeAddOnContentInstall_Deny || mCliOutputMode.show_extended_info)
 	{
-		fmt::print("  RuntimeAddOnContentInstall:             {:s}\n", pie::hac::ApplicationControlPropertyUtil::getRuntimeAddOnContentInstallAsString(mNacp.getRuntimeAddOnContentInstall()));
+		nstool::print("  RuntimeAddOnContentInstall:             {:s}\n", pie::hac::ApplicationControlPropertyUtil::getRuntimeAddOnContentInstallAsString(mNacp.getRuntimeAddOnContentInstall()));
 	}
 
 	// RuntimeParameterDelivery
 	if (mNacp.getRuntimeParameterDelivery() != pie::hac::nacp::RuntimeParameterDelivery_Always || mCliOutputMode.show_extended_info)
 	{
-		fmt::print("  RuntimeParameterDelivery:               {:s}\n", pie::hac::ApplicationControlPropertyUtil::getRuntimeParameterDeliveryAsString(mNacp.getRuntimeParameterDelivery()));
+		nstool::print("  RuntimeParameterDelivery:               {:s}\n", pie::hac::ApplicationControlPropertyUtil::getRuntimeParameterDeliveryAsString(mNacp.getRuntimeParameterDelivery()));
 	}
 
 	// CrashReport
 	if (mNacp.getCrashReport() != pie::hac::nacp::CrashReport_Deny || mCliOutputMode.show_extended_info)
 	{
-		fmt::print("  CrashReport:                            {:s}\n", pie::hac::ApplicationControlPropertyUtil::getCrashReportAsString(mNacp.getCrashReport()));
+		nstool::print("  CrashReport:                            {:s}\n", pie::hac::ApplicationControlPropertyUtil::getCrashReportAsString(mNacp.getCrashReport()));
 	}
 
 	// Hdcp
 	if (mNacp.getHdcp() != pie::hac::nacp::Hdcp_None || mCliOutputMode.show_extended_info)
 	{
-		fmt::print("  Hdcp:                                   {:s}\n", pie::hac::ApplicationControlPropertyUtil::getHdcpAsString(mNacp.getHdcp()));
+		nstool::print("  Hdcp:                                   {:s}\n", pie::hac::ApplicationControlPropertyUtil::getHdcpAsString(mNacp.getHdcp()));
 	}
 
 	// SeedForPsuedoDeviceId
 	if (mNacp.getSeedForPsuedoDeviceId() != 0 || mCliOutputMode.show_extended_info)
 	{
-		fmt::print("  SeedForPsuedoDeviceId:                  0x{:016x}\n", mNacp.getSeedForPsuedoDeviceId());
+		nstool::print("  SeedForPsuedoDeviceId:                  0x{:016x}\n", mNacp.getSeedForPsuedoDeviceId());
 	}
 
 	// BcatPassphase
 	if (mNacp.getBcatPassphase().empty() == false)
 	{
-		fmt::print("  BcatPassphase:                          {:s}\n", mNacp.getBcatPassphase());
+		nstool::print("  BcatPassphase:                          {:s}\n", mNacp.getBcatPassphase());
 	}
 	else if (mCliOutputMode.show_extended_info)
 	{
-		fmt::print("  BcatPassphase:                          (NotSet)\n");
+		nstool::print("  BcatPassphase:                          (NotSet)\n");
 	}
 
 	// StartupUserAccountOption
 	if (mNacp.getStartupUserAccountOption().size() > 0)
 	{
-		fmt::print("  StartupUserAccountOption:\n");
+		nstool::print("  StartupUserAccountOption:\n");
 		for (auto itr = mNacp.getStartupUserAccountOption().begin(); itr != mNacp.getStartupUserAccountOption().end(); itr++)
 		{
-			fmt::print("    {:s}\n", pie::hac::ApplicationControlPropertyUtil::getStartupUserAccountOptionFlagAsString(*itr));
+			nstool::print("    {:s}\n", pie::hac::ApplicationControlPropertyUtil::getStartupUserAccountOptionFlagAsString(*itr));
 		}
 	}
 	else if (mCliOutputMode.show_extended_info)
 	{
-		fmt::print("  StartupUserAccountOption:               None\n");
+		nstool::print("  StartupUserAccountOption:               None\n");
 	}
 
 	// UserAccountSaveDataSizeMax
 	if (mNacp.getUserAccountSaveDataMax().size != 0 || mCliOutputMode.show_extended_info)
 	{
-		fmt::print("  UserAccountSaveDataSizeMax:             {:s}\n", pie::hac::ApplicationControlPropertyUtil::getSaveDataSizeAsString(mNacp.getUserAccountSaveDataMax().size));
+		nstool::print("  UserAccountSaveDataSizeMax:             {:s}\n", pie::hac::ApplicationControlPropertyUtil::getSaveDataSizeAsString(mNacp.getUserAccountSaveDataMax().size));
 	}
 
 	// UserAccountSaveDataJournalSizeMax
 	if (mNacp.getUserAccountSaveDataMax().journal_size != 0 || mCliOutputMode.show_extended_info)
 	{
-		fmt::print("  UserAccountSaveDataJournalSizeMax:      {:s}\n", pie::hac::ApplicationControlPropertyUtil::getSaveDataSizeAsString(mNacp.getUserAccountSaveDataMax().journal_size));
+		nstool::print("  UserAccountSaveDataJournalSizeMax:      {:s}\n", pie::hac::ApplicationControlPropertyUtil::getSaveDataSizeAsString(mNacp.getUserAccountSaveDataMax().journal_size));
 	}
 
 	// DeviceSaveDataSizeMax
 	if (mNacp.getDeviceSaveDataMax().size != 0 || mCliOutputMode.show_extended_info)
 	{
-		fmt::print("  DeviceSaveDataSizeMax:                  {:s}\n", pie::hac::ApplicationControlPropertyUtil::getSaveDataSizeAsString(mNacp.getDeviceSaveDataMax().size));
+		nstool::print("  DeviceSaveDataSizeMax:                  {:s}\n", pie::hac::ApplicationControlPropertyUtil::getSaveDataSizeAsString(mNacp.getDeviceSaveDataMax().size));
 	}
 
 	// DeviceSaveDataJournalSizeMax
 	if (mNacp.getDeviceSaveDataMax().journal_size != 0 || mCliOutputMode.show_extended_info)
 	{
-		fmt::print("  DeviceSaveDataJournalSizeMax:           {:s}\n", pie::hac::ApplicationControlPropertyUtil::getSaveDataSizeAsString(mNacp.getDeviceSaveDataMax().journal_size));
+		nstool::print("  DeviceSaveDataJournalSizeMax:           {:s}\n", pie::hac::ApplicationControlPropertyUtil::getSaveDataSizeAsString(mNacp.getDeviceSaveDataMax().journal_size));
 	}
 
 	// TemporaryStorageSize
 	if (mNacp.getTemporaryStorageSize() != 0 || mCliOutputMode.show_extended_info)
 	{
-		fmt::print("  TemporaryStorageSize:                   {:s}\n", pie::hac::ApplicationControlPropertyUtil::getSaveDataSizeAsString(mNacp.getTemporaryStorageSize()));
+		nstool::print("  TemporaryStorageSize:                   {:s}\n", pie::hac::ApplicationControlPropertyUtil::getSaveDataSizeAsString(mNacp.getTemporaryStorageSize()));
 	}
 
 	// CacheStorageSize
 	if (mNacp.getCacheStorageSize().size != 0 || mCliOutputMode.show_extended_info)
 	{
-		fmt::print("  CacheStorageSize:                       {:s}\n", pie::hac::ApplicationControlPropertyUtil::getSaveDataSizeAsString(mNacp.getCacheStorageSize().size));
+		nstool::print("  CacheStorageSize:                       {:s}\n", pie::hac::ApplicationControlPropertyUtil::getSaveDataSizeAsString(mNacp.getCacheStorageSize().size));
 	}
 
 	// CacheStorageJournalSize
 	if (mNacp.getCacheStorageSize().journal_size != 0 || mCliOutputMode.show_extended_info)
 	{
-		fmt::print("  CacheStorageJournalSize:                {:s}\n", pie::hac::ApplicationControlPropertyUtil::getSaveDataSizeAsString(mNacp.getCacheStorageSize().journal_size));
+		nstool::print("  CacheStorageJournalSize:                {:s}\n", pie::hac::ApplicationControlPropertyUtil::getSaveDataSizeAsString(mNacp.getCacheStorageSize().journal_size));
 	}
 
 	// CacheStorageDataAndJournalSizeMax
 	if (mNacp.getCacheStorageDataAndJournalSizeMax() != 0 || mCliOutputMode.show_extended_info)
 	{
-		fmt::print("  CacheStorageDataAndJournalSizeMax:      {:s}\n", pie::hac::ApplicationControlPropertyUtil::getSaveDataSizeAsString(mNacp.getCacheStorageDataAndJournalSizeMax()));
+		nstool::print("  CacheStorageDataAndJournalSizeMax:      {:s}\n", pie::hac::ApplicationControlPropertyUtil::getSaveDataSizeAsString(mNacp.getCacheStorageDataAndJournalSizeMax()));
 	}
 
 	// CacheStorageIndexMax
 	if (mNacp.getCacheStorageIndexMax() != 0 || mCliOutputMode.show_extended_info)
 	{
-		fmt::print("  CacheStorageIndexMax:                   0x{:04x}\n", mNacp.getCacheStorageIndexMax());
+		nstool::print("  CacheStorageIndexMax:                   0x{:04x}\n", mNacp.getCacheStorageIndexMax());
 	}
 
 	// PlayLogQueryableApplicationId
 	if (mNacp.getPlayLogQueryableApplicationId().size() > 0)
 	{
-		fmt::print("  PlayLogQueryableApplicationId:\n");
+		nstool::print("  PlayLogQueryableApplicationId:\n");
 		for (auto itr = mNacp.getPlayLogQueryableApplicationId().begin(); itr != mNacp.getPlayLogQueryableApplicationId().end(); itr++)
 		{
-			fmt::print("    0x{:016x}\n", *itr);
+			nstool::print("    0x{:016x}\n", *itr);
 		}
 	}
 	else if (mCliOutputMode.show_extended_info)
 	{
-		fmt::print("  PlayLogQueryableApplicationId:          None\n");
+		nstool::print("  PlayLogQueryableApplicationId:          None\n");
 	}
 
 	// PlayLogQueryCapability
 	if (mNacp.getPlayLogQueryCapability() != pie::hac::nacp::PlayLogQueryCapability_None || mCliOutputMode.show_extended_info)
 	{
-		fmt::print("  PlayLogQueryCapability:                 {:s}\n", pie::hac::ApplicationControlPropertyUtil::getPlayLogQueryCapabilityAsString(mNacp.getPlayLogQueryCapability()));
+		nstool::print("  PlayLogQueryCapability:                 {:s}\n", pie::hac::ApplicationControlPropertyUtil::getPlayLogQueryCapabilityAsString(mNacp.getPlayLogQueryCapability()));
 	}
 
 	// Repair
 	if (mNacp.getRepair().size() > 0)
 	{
-		fmt::print("  Repair:\n");
+		nstool::print("  Repair:\n");
 		for (auto itr = mNacp.getRepair().begin(); itr != mNacp.getRepair().end(); itr++)
 		{
-			fmt::print("    {:s}\n", pie::hac::ApplicationControlPropertyUtil::getRepairFlagAsString(*itr));
+			nstool::print("    {:s}\n", pie::hac::ApplicationControlPropertyUtil::getRepairFlagAsString(*itr));
 		}
 	}
 	else if (mCliOutputMode.show_extended_info)
 	{
-		fmt::print("  Repair:                                 None\n");
+		nstool::print("  Repair:                                 None\n");
 	}
 
 	// ProgramIndex
 	if (mNacp.getProgramIndex() != 0 || mCliOutputMode.show_extended_info)
 	{
-		fmt::print("  ProgramIndex:                           0x{:02x}\n", mNacp.getProgramIndex());
+		nstool::print("  ProgramIndex:                           0x{:02x}\n", mNacp.getProgramIndex());
 	}
 
 	// RequiredNetworkServiceLicenseOnLaunch
 	if (mNacp.getRequiredNetworkServiceLicenseOnLaunch().size() > 0)
 	{
-		fmt::print("  RequiredNetworkServiceLicenseOnLaunch:\n");
+		nstool::print("  RequiredNetworkServiceLicenseOnLaunch:\n");
 		for (auto itr = mNacp.getRequiredNetworkServiceLicenseOnLaunch().begin(); itr != mNacp.getRequiredNetworkServiceLicenseOnLaunch().end(); itr++)
 		{
-			fmt::print("    {:s}\n", pie::hac::ApplicationControlPropertyUtil::getRequiredNetworkServiceLicenseOnLaunchFlagAsString(*itr));
+			nstool::print("    {:s}\n", pie::hac::ApplicationControlPropertyUtil::getRequiredNetworkServiceLicenseOnLaunchFlagAsString(*itr));
 		}
 	}
 	else if (mCliOutputMode.show_extended_info)
 	{
-		fmt::print("  RequiredNetworkServiceLicenseOnLaunch:  None\n");
+		nstool::print("  RequiredNetworkServiceLicenseOnLaunch:  None\n");
 	}
 
 	// NeighborDetectionClientConfiguration
 	auto detect_config = mNacp.getNeighborDetectionClientConfiguration();
 	if (detect_config.countSendGroupConfig() > 0 || detect_config.countReceivableGroupConfig() > 0)
 	{
-		fmt::print("  NeighborDetectionClientConfiguration:\n");
+		nstool::print("  NeighborDetectionClientConfiguration:\n");
 		if (detect_config.countSendGroupConfig() > 0)
 		{
-			fmt::print("    SendGroupConfig:\n");
-			fmt::print("      GroupId:  0x{:016x}\n", detect_config.send_data_configuration.group_id);
-			fmt::print("        Key:    {:s}\n", tc::cli::FormatUtil::formatBytesAsString(detect_config.send_data_configuration.key.data(), detect_config.send_data_configuration.key.size(), false, ""));
+			nstool::print("    SendGroupConfig:\n");
+			nstool::print("      GroupId:  0x{:016x}\n", detect_config.send_data_configuration.group_id);
+			nstool::print("        Key:    {:s}\n", tc::cli::FormatUtil::formatBytesAsString(detect_config.send_data_configuration.key.data(), detect_config.send_data_configuration.key.size(), false, ""));
 		}
 		else if (mCliOutputMode.show_extended_info)
 		{
-			fmt::print("    SendGroupConfig: None\n");
+			nstool::print("    SendGroupConfig: None\n");
 		}
 		if (detect_config.countReceivableGroupConfig() > 0)
 		{
-			fmt::print("    ReceivableGroupConfig:\n");
+			nstool::print("    ReceivableGroupConfig:\n");
 			for (size_t i = 0; i < pie::hac::nacp::kReceivableGroupConfigurationCount; i++)
 			{
 				if (detect_config.receivable_data_configuration[i].isNull())
 					continue;
 
-				fmt::print("      GroupId:  0x{:016x}\n", detect_config.receivable_data_configuration[i].group_id);
-				fmt::print("        Key:    {:s}\n", tc::cli::FormatUtil::formatBytesAsString(detect_config.receivable_data_configuration[i].key.data(), detect_config.receivable_data_configuration[i].key.size(), false, ""));
+				nstool::print("      GroupId:  0x{:016x}\n", detect_config.receivable_data_configuration[i].group_id);
+				nstool::print("        Key:    {:s}\n", tc::cli::FormatUtil::formatBytesAsString(detect_config.receivable_data_configuration[i].key.data(), detect_config.receivable_data_configuration[i].key.size(), false, ""));
 			}
 		}
 		else if (mCliOutputMode.show_extended_info)
 		{
-			fmt::print("    ReceivableGroupConfig: None\n");
+			nstool::print("    ReceivableGroupConfig: None\n");
 		}
 	}
 	else if (mCliOutputMode.show_extended_info)
 	{
-		fmt::print("  NeighborDetectionClientConfiguration:   None\n");
+		nstool::print("  NeighborDetectionClientConfiguration:   None\n");
 	}
 	
 	// JitConfiguration
 	if (mNacp.getJitConfiguration().is_enabled || mCliOutputMode.show_extended_info)
 	{
-		fmt::print("  JitConfiguration:\n");
-		fmt::print("    IsEnabled:  {}\n", mNacp.getJitConfiguration().is_enabled);
-		fmt::print("    MemorySize: 0x{:016x}\n", mNacp.getJitConfiguration().memory_size);
+		nstool::print("  JitConfiguration:\n");
+		nstool::print("    IsEnabled:  {}\n", mNacp.getJitConfiguration().is_enabled);
+		nstool::print("    MemorySize: 0x{:016x}\n", mNacp.getJitConfiguration().memory_size);
 	}
 	
 	// PlayReportPermission
 	if (mNacp.getPlayReportPermission() != pie::hac::nacp::PlayReportPermission_None || mCliOutputMode.show_extended_info)
 	{
-		fmt::print("  PlayReportPermission:                   {:s}\n", pie::hac::ApplicationControlPropertyUtil::getPlayReportPermissionAsString(mNacp.getPlayReportPermission()));
+		nstool::print("  PlayReportPermission:                   {:s}\n", pie::hac::ApplicationControlPropertyUtil::getPlayReportPermissionAsString(mNacp.getPlayReportPermission()));
 	}
 
 	// CrashScreenshotForProd
 	if (mNacp.getCrashScreenshotForProd() != pie::hac::nacp::CrashScreenshotForProd_Deny || mCliOutputMode.show_extended_info)
 	{
-		fmt::print("  CrashScreenshotForProd:                 {:s}\n", pie::hac::ApplicationControlPropertyUtil::getCrashScreenshotForProdAsString(mNacp.getCrashScreenshotForProd()));
+		nstool::print("  CrashScreenshotForProd:                 {:s}\n", pie::hac::ApplicationControlPropertyUtil::getCrashScreenshotForProdAsString(mNacp.getCrashScreenshotForProd()));
 	}
 
 	// CrashScreenshotForDev
 	if (mNacp.getCrashScreenshotForDev() != pie::hac::nacp::CrashScreenshotForDev_Deny || mCliOutputMode.show_extended_info)
 	{
-		fmt::print("  CrashScreenshotForDev:                  {:s}\n", pie::hac::ApplicationControlPropertyUtil::getCrashScreenshotForDevAsString(mNacp.getCrashScreenshotForDev()));
+		nstool::print("  CrashScreenshotForDev:                  {:s}\n", pie::hac::ApplicationControlPropertyUtil::getCrashScreenshotForDevAsString(mNacp.getCrashScreenshotForDev()));
 	}
 
 	// AccessibleLaunchRequiredVersion
 	if (mNacp.getAccessibleLaunchRequiredVersionApplicationId().size() > 0)
 	{
-		fmt::print("  AccessibleLaunchRequiredVersion:\n");
-		fmt::print("    ApplicationId:\n");
+		nstool::print("  AccessibleLaunchRequiredVersion:\n");
+		nstool::print("    ApplicationId:\n");
 		for (auto itr = mNacp.getAccessibleLaunchRequiredVersionApplicationId().begin(); itr != mNacp.getAccessibleLaunchRequiredVersionApplicationId().end(); itr++)
 		{
-			fmt::print("      0x{:016x}\n", *itr);
+			nstool::print("      0x{:016x}\n", *itr);
 		}
 	}
 	else if (mCliOutputMode.show_extended_info)
 	{
-		fmt::print("  AccessibleLaunchRequiredVersion:        None\n");
+		nstool::print("  AccessibleLaunchRequiredVersion:        None\n");
 	}
 }
\ No newline at end of file
@@ -0,0 +1,261 @@
+#include "NcaHeaderScanProcess.h"
+#include "OutputCapture.h"
+#include "ThreadPool.h"
+#include "util.h"
+
+#include <tc/io/FileStream.h>
+#include <tc/io/DirectoryNotFoundException.h>
+
+#include <pietendo/hac/ContentArchiveUtil.h>
+
+#include <algorithm>
+#include <cctype>
+#include <thread>
+
+nstool::NcaHeaderScanProcess::NcaHeaderScanProcess() :
+	mModuleName("nstool::NcaHeaderScanProcess"),
+	mInputPath(),
+	mKeyCfg(),
+	mThreadCount(1)
+{
+}
+
+void nstool::NcaHeaderScanProcess::process()
+{
+	if (mInputPath.isNull())
+	{
+		throw tc::Exception(mModuleName, "No input path set.");
+	}
+	if (mKeyCfg.nca_header_key.isNull())
+	{
+		throw tc::Exception(mModuleName, "Failed to decrypt NCA header. (nca_header_key could not be loaded)");
+	}
+
+	std::vector<tc::io::Path> nca_paths;
+	collectNcaPaths(nca_paths);
+
+	// the header sector is decrypted with a copy of this engine per group
+	Aes128XtsEngine engine;
+	engine.initialize(mKeyCfg.nca_header_key.get()[0].data(), mKeyCfg.nca_header_key.get()[0].size(), mKeyCfg.nca_header_key.get()[1].data(), mKeyCfg.nca_header_key.get()[1].size(), pie::hac::nca::kSectorSize);
+
+	// reading headers is mostly waiting on open()/read(), so one thread per core is used unless more are requested
+	size_t thread_count = mThreadCount > 1 ? mThreadCount : std::max<size_t>(std::thread::hardware_concurrency(), 1);
+	std::shared_ptr<ThreadPool> thread_pool = thread_count > 1 ? std::make_shared<ThreadPool>(thread_count - 1) : nullptr;
+
+	nstool::print("#status\tprogram_id\tcontent_type\tkey_generation\trights_id\tpartitions\tpath\n");
+
+	std::vector<std::string> records;
+	for (size_t batch_offset = 0; batch_offset < nca_paths.size(); batch_offset += size_t(kScanBatchSize))
+	{
+		size_t batch_size = std::min<size_t>(size_t(kScanBatchSize), nca_paths.size() - batch_offset);
+		size_t group_num = (batch_size + size_t(kScanGroupSize) - 1) / size_t(kScanGroupSize);
+
+		records.clear();
+		records.resize(batch_size);
+
+		const tc::io::Path* batch_paths = nca_paths.data() + batch_offset;
+		std::string* batch_records = records.data();
+		auto scan_group = [this, &engine, batch_paths, batch_records, batch_size](size_t group_index) {
+			size_t group_offset = group_index * size_t(kScanGroupSize);
+			scanGroup(engine, batch_paths + group_offset, std::min<size_t>(size_t(kScanGroupSize), batch_size - group_offset), batch_records + group_offset);
+		};
+
+		if (thread_pool != nullptr)
+		{
+			thread_pool->parallelFor(group_num, scan_group);
+		}
+		else
+		{
+			for (size_t i = 0; i < group_num; i++)
+			{
+				scan_group(i);
+			}
+		}
+
+		// one write per batch rather than per record
+		std::string out;
+		for (auto itr = records.begin(); itr != records.end(); itr++)
+		{
+			out += *itr;
+		}
+		nstool::print("{:s}", out);
+		fflush(stdout);
+	}
+}
+
+void nstool::NcaHeaderScanProcess::setInputPath(const tc::io::Path& path)
+{
+	mInputPath = path;
+}
+
+void nstool::NcaHeaderScanProcess::setKeyCfg(const KeyBag& keycfg)
+{
+	mKeyCfg = keycfg;
+}
+
+void nstool::NcaHeaderScanProcess::setThreadCount(size_t thread_count)
+{
+	mThreadCount = thread_count;
+}
+
+void nstool::NcaHeaderScanProcess::collectNcaPaths(std::vector<tc::io::Path>& nca_paths) const
+{
+	// case: the input path is a directory, scan it for NCA files
+	try {
+		std::vector<tc::io::Path> file_list;
+		getLocalFileListRecursive(mInputPath.get(), file_list);
+
+		for (auto itr = file_list.begin(); itr != file_list.end(); itr++)
+		{
+			std::string file_name = itr->back();
+			std::transform(file_name.begin(), file_name.end(), file_name.begin(), ::tolower);
+
+			if (file_name.size() > 4 && file_name.compare(file_name.size() - 4, 4, ".nca") == 0)
+			{
+				nca_paths.push_back(*itr);
+			}
+		}
+
+		return;
+	} catch (tc::io::DirectoryNotFoundException&) {
+		// acceptable exception, just means the input path is a list file
+	}
+
+	// case: the input path is a list file, every listed path is scanned whatever its extension
+	std::vector<std::string> list;
+	processListFile(std::make_shared<tc::io::FileStream>(tc::io::FileStream(mInputPath.get(), tc::io::FileMode::Open, tc::io::FileAccess::Read)), list);
+
+	for (auto itr = list.begin(); itr != list.end(); itr++)
+	{
+		nca_paths.push_back(tc::io::Path(*itr));
+	}
+}
+
+void nstool::NcaHeaderScanProcess::scanGroup(const Aes128XtsEngine& engine, const tc::io::Path* nca_paths, size_t count, std::string* records) const
+{
+	const size_t sector_size = pie::hac::nca::kSectorSize;
+
+	// the header sectors of the group are read into one buffer, so they can be decrypted in one call
+	tc::ByteData sectors = tc::ByteData(count * sector_size);
+	std::vector<bool> is_read(count, false);
+	for (size_t i = 0; i < count; i++)
+	{
+		is_read[i] = readHeaderSector(nca_paths[i], sectors.data() + i * sector_size);
+	}
+
+	// every header sector is sector 1 of its NCA (the sector number is the same for NCA2 and NCA3)
+	Aes128XtsEngine group_engine = engine;
+	group_engine.decryptSameSector(sectors.data(), sectors.data(), sectors.size(), 1);
+
+	pie::hac::ContentArchiveHeader hdr;
+	for (size_t i = 0; i < count; i++)
+	{
+		if (is_read[i] == false)
+		{
+			records[i] = formatErrorRecord(nca_paths[i], ScanStatus_ReadError);
+			continue;
+		}
+
+		const pie::hac::sContentArchiveHeader* raw_hdr = (const pie::hac::sContentArchiveHeader*)(sectors.data() + i * sector_size);
+		if (raw_hdr->st_magic.unwrap() != pie::hac::nca::kNca2StructMagic && raw_hdr->st_magic.unwrap() != pie::hac::nca::kNca3StructMagic)
+		{
+			records[i] = formatErrorRecord(nca_paths[i], ScanStatus_BadMagic);
+			continue;
+		}
+
+		try {
+			hdr.fromBytes((const byte_t*)raw_hdr, sizeof(pie::hac::sContentArchiveHeader));
+		} catch (tc::Exception&) {
+			records[i] = formatErrorRecord(nca_paths[i], ScanStatus_ParseError);
+			continue;
+		}
+
+		records[i] = formatRecord(nca_paths[i], hdr);
+	}
+}
+
+bool nstool::NcaHeaderScanProcess::readHeaderSector(const tc::io::Path& path, byte_t* sector) const
+{
+	const size_t sector_size = pie::hac::nca::kSectorSize;
+
+	// unread sectors are still decrypted with the rest of the group
+	memset(sector, 0, sector_size);
+
+	try {
+		tc::io::FileStream file = tc::io::FileStream(path, tc::io::FileMode::Open, tc::io::FileAccess::Read);
+
+		if (file.length() < int64_t(pie::hac::nca::kHeaderSize))
+		{
+			return false;
+		}
+
+		file.seek(pie::hac::ContentArchiveUtil::sectorToOffset(1), tc::io::SeekOrigin::Begin);
+		for (size_t done = 0; done < sector_size;)
+		{
+			size_t read_len = file.read(sector + done, sector_size - done);
+			if (read_len == 0)
+			{
+				return false;
+			}
+			done += read_len;
+		}
+	} catch (tc::Exception&) {
+		return false;
+	}
+
+	return true;
+}
+
+std::string nstool::NcaHeaderScanProcess::formatRecord(const tc::io::Path& path, const pie::hac::ContentArchiveHeader& hdr) const
+{
+	std::string rights_id = "-";
+	if (hdr.hasRightsId())
+	{
+		rights_id = tc::cli::FormatUtil::formatBytesAsString(hdr.getRightsId().data(), hdr.getRightsId().size(), false, "");
+	}
+
+	// index:offset+size of each partition, comma separated
+	std::string partitions;
+	for (size_t i = 0; i < hdr.getPartitionEntryList().size(); i++)
+	{
+		const pie::hac::ContentArchiveHeader::sPartitionEntry& partition = hdr.getPartitionEntryList()[i];
+
+		partitions += fmt::format("{:s}{:d}:0x{:x}+0x{:x}", (partitions.empty() ? "" : ","), partition.header_index, partition.offset, partition.size);
+	}
+	if (partitions.empty())
+	{
+		partitions = "-";
+	}
+
+	return fmt::format("{:s}\t{:016x}\t{:s}\t{:d}\t{:s}\t{:s}\t{:s}\n", getScanStatusAsString(ScanStatus_Ok), hdr.getProgramId(), pie::hac::ContentArchiveUtil::getContentTypeAsString(hdr.getContentType()), hdr.getKeyGeneration(), rights_id, partitions, path.to_string());
+}
+
+std::string nstool::NcaHeaderScanProcess::formatErrorRecord(const tc::io::Path& path, ScanStatus status) const
+{
+	return fmt::format("{:s}\t-\t-\t-\t-\t-\t{:s}\n", getScanStatusAsString(status), path.to_string());
+}
+
+std::string nstool::NcaHeaderScanProcess::getScanStatusAsString(ScanStatus status) const
+{
+	std::string str;
+	switch (status)
+	{
+	case (ScanStatus_Ok):
+		str = "ok";
+		break;
+	case (ScanStatus_ReadError):
+		str = "read_error";
+		break;
+	case (ScanStatus_BadMagic):
+		str = "bad_magic";
+		break;
+	case (ScanStatus_ParseError):
+		str = "parse_error";
+		break;
+	default:
+		str = "unknown";
+		break;
+	}
+
+	return str;
+}
@@ -0,0 +1,59 @@
+#pragma once
+#include "types.h"
+#include "KeyBag.h"
+#include "Aes128XtsEngine.h"
+
+#include <pietendo/hac/ContentArchiveHeader.h>
+
+namespace nstool {
+
+// Prints one tab separated record per NCA (program id, content type, key generation, rights id, partition table) for a directory of NCAs or a list file of NCA paths.
+// Only the main header sector of each NCA is read, the headers of a group of NCAs are decrypted together (they are all sector 1) and groups are scanned in parallel.
+class NcaHeaderScanProcess
+{
+public:
+	NcaHeaderScanProcess();
+
+	void process();
+
+	// a directory (scanned recursively for *.nca files) or a text file with one NCA path per line
+	void setInputPath(const tc::io::Path& path);
+	void setKeyCfg(const KeyBag& keycfg);
+	// 0 or 1 uses one thread per core
+	void setThreadCount(size_t thread_count);
+private:
+	// NCAs whose header sectors are read into one buffer and decrypted together
+	static const size_t kScanGroupSize = 64;
+
+	// NCAs scanned before their records are printed, records are printed in input order
+	static const size_t kScanBatchSize = 4096;
+
+	std::string mModuleName;
+
+	tc::Optional<tc::io::Path> mInputPath;
+	KeyBag mKeyCfg;
+	size_t mThreadCount;
+
+	enum ScanStatus
+	{
+		ScanStatus_Ok,
+		ScanStatus_ReadError, // could not be opened, or is smaller than an NCA header
+		ScanStatus_BadMagic, // not an NCA, or the header key is wrong
+		ScanStatus_ParseError
+	};
+
+	void collectNcaPaths(std::vector<tc::io::Path>& nca_paths) const;
+
+	// scan count NCAs, writing the record line of nca_paths[i] to records[i]
+	void scanGroup(const Aes128XtsEngine& engine, const tc::io::Path* nca_paths, size_t count, std::string* records) const;
+
+	// read the encrypted main header sector of the NCA at path to sector, returns false if it could not be read
+	bool readHeaderSector(const tc::io::Path& path, byte_t* sector) const;
+
+	std::string formatRecord(const tc::io::Path& path, const pie::hac::ContentArchiveHeader& hdr) const;
+	std::string formatErrorRecord(const tc::io::Path& path, ScanStatus status) const;
+
+	std::string getScanStatusAsString(ScanStatus status) const;
+};
+
+}
@@ -1,23 +1,47 @@
 #include "NcaProcess.h"
+#include "OutputCapture.h"
 #include "MetaProcess.h"
 #include "util.h"
+#include "Aes128CtrStream.h"
+#include "Aes128XtsStream.h"
+#include "HierarchicalSha256Stream.h"
+#include "HierarchicalIntegrityStream.h"
+#include "HashTreeVerifier.h"
+#include "BktrStream.h"
+#include "SparseStream.h"
 
 #include <pietendo/hac/ContentArchiveUtil.h>
 #include <pietendo/hac/AesKeygen.h>
-#include <pietendo/hac/HierarchicalSha256Stream.h>
-#include <pietendo/hac/HierarchicalIntegrityStream.h>
-#include <pietendo/hac/BKTREncryptedStream.h>
 #include <pietendo/hac/PartitionFsSnapshotGenerator.h>
 #include <pietendo/hac/RomFsSnapshotGenerator.h>
 #include <pietendo/hac/CombinedFsSnapshotGenerator.h>
 
+#include <algorithm>
+
+// pool for hashing when extraction is single threaded (one thread per core), created once and shared by every NcaProcess
+// batch/server mode process several inputs at once, a pool per input would start a thread per core for each of them
+static std::shared_ptr<nstool::ThreadPool> getSharedHashThreadPool()
+{
+	static std::shared_ptr<nstool::ThreadPool> thread_pool = std::thread::hardware_concurrency() > 1 ? std::make_shared<nstool::ThreadPool>(std::thread::hardware_concurrency() - 1) : nullptr;
+
+	return thread_pool;
+}
+
 nstool::NcaProcess::NcaProcess() :
 	mModuleName("nstool::NcaProcess"),
 	mFile(),
+	mFileFactory(),
 	mCliOutputMode(true, false, false, false),
 	mVerify(false),
+	mVerifyFull(false),
+	mBaseNcaPath(),
+	mBaseNca(),
+	mShowFsTree(false),
+	mExtractJobs(),
 	mFileSystem(),
-	mFsProcess()
+	mFsProcess(),
+	mDecryptThreadPool(),
+	mVerifiedBlockCache(std::make_shared<VerifiedBlockCache>(size_t(kVerifiedBlockCacheSize)))
 {
 }
 
@@ -36,6 +60,10 @@ void nstool::NcaProcess::process()
 	if (mVerify)
 		validateNcaSignatures();
 
+	// validate every block of the partition hash trees
+	if (mVerifyFull)
+		validatePartitionHashTrees();
+
 	// display header
 	if (mCliOutputMode.show_basic_info)
 		displayHeader();
@@ -49,11 +77,21 @@ void nstool::NcaProcess::setInputFile(const std::shared_ptr<tc::io::IStream>& fi
 	mFile = file;
 }
 
+void nstool::NcaProcess::setInputFileFactory(const StreamFactory& file_factory)
+{
+	mFileFactory = file_factory;
+}
+
 void nstool::NcaProcess::setBaseNcaPath(const tc::Optional<tc::io::Path>& nca_path)
 {
 	mBaseNcaPath = nca_path;
 }
 
+void nstool::NcaProcess::setBaseNcaSession(const std::shared_ptr<BaseNcaSession>& base_nca)
+{
+	mBaseNca = base_nca;
+}
+
 void nstool::NcaProcess::setKeyCfg(const KeyBag& keycfg)
 {
 	mKeyCfg = keycfg;
@@ -69,8 +107,14 @@ void nstool::NcaProcess::setVerifyMode(bool verify)
 	mVerify = verify;
 }
 
+void nstool::NcaProcess::setFullVerifyMode(bool verify_full)
+{
+	mVerifyFull = verify_full;
+}
+
 void nstool::NcaProcess::setShowFsTree(bool show_fs_tree)
 {
+	mShowFsTree = show_fs_tree;
 	mFsProcess.setShowFsTree(show_fs_tree);
 }
 
@@ -81,9 +125,18 @@ void nstool::NcaProcess::setFsRootLabel(const std::string& root_label)
 
 void nstool::NcaProcess::setExtractJobs(const std::vector<nstool::ExtractJob>& extract_jobs)
 {
+	mExtractJobs = extract_jobs;
 	mFsProcess.setExtractJobs(extract_jobs);
 }
 
+void nstool::NcaProcess::setExtractOptions(const nstool::ExtractOptions& extract_options)
+{
+	mFsProcess.setExtractOptions(extract_options);
+
+	// the thread reading from the partition also decrypts, so one less worker is needed
+	mDecryptThreadPool = extract_options.thread_count > 1 ? std::make_shared<ThreadPool>(extract_options.thread_count - 1) : nullptr;
+}
+
 const std::shared_ptr<tc::io::IFileSystem>& nstool::NcaProcess::getFileSystem() const
 {
 	return mFileSystem;
@@ -116,7 +169,7 @@ void nstool::NcaProcess::importHeader()
 	pie::hac::ContentArchiveUtil::decryptContentArchiveHeader((byte_t*)&mHdrBlock, (byte_t*)&mHdrBlock, mKeyCfg.nca_header_key.get());
 
 	// generate header hash
-	tc::crypto::GenerateSha2256Hash(mHdrHash.data(), (byte_t*)&mHdrBlock.header, sizeof(pie::hac::sContentArchiveHeader));
+	nstool::Sha256Engine::GenerateHash(mHdrHash.data(), (byte_t*)&mHdrBlock.header, sizeof(pie::hac::sContentArchiveHeader));
 
 	// proccess main header
 	mHdr.fromBytes((byte_t*)&mHdrBlock.header, sizeof(pie::hac::sContentArchiveHeader));
@@ -163,6 +216,7 @@ void nstool::NcaProcess::generateNcaBodyEncryptionKeys()
 
 	// clear content key
 	mContentKey.aes_ctr = tc::Optional<pie::hac::detail::aes128_key_t>();
+	mContentKey.aes_xts = tc::Optional<KeyBag::aes128_xtskey_t>();
 
 	// if this has a rights id, the key needs to be sourced from a ticket
 	if (mHdr.hasRightsId() == true)
@@ -198,12 +252,26 @@ void nstool::NcaProcess::generateNcaBodyEncryptionKeys()
 	// otherwise used decrypt key area
 	else
 	{
+		KeyBag::aes128_xtskey_t aes_xts;
+		bool aes_xts_decrypted[2] = { false, false };
 		for (size_t i = 0; i < mContentKey.kak_list.size(); i++)
 		{
 			if (mContentKey.kak_list[i].index == pie::hac::nca::KeyBankIndex_AesCtr && mContentKey.kak_list[i].decrypted)
 			{
 				mContentKey.aes_ctr = mContentKey.kak_list[i].dec;
 			}
+			else if ((mContentKey.kak_list[i].index == pie::hac::nca::KeyBankIndex_AesXts0 || mContentKey.kak_list[i].index == pie::hac::nca::KeyBankIndex_AesXts1) && mContentKey.kak_list[i].decrypted)
+			{
+				size_t xts_index = mContentKey.kak_list[i].index - pie::hac::nca::KeyBankIndex_AesXts0;
+				aes_xts[xts_index] = mContentKey.kak_list[i].dec;
+				aes_xts_decrypted[xts_index] = true;
+			}
+		}
+
+		// AES-XTS needs both halves of the key
+		if (aes_xts_decrypted[0] && aes_xts_decrypted[1])
+		{
+			mContentKey.aes_xts = aes_xts;
 		}
 	}
 
@@ -218,38 +286,30 @@ void nstool::NcaProcess::generateNcaBodyEncryptionKeys()
 	
 	if (mCliOutputMode.show_keydata)
 	{
+		if (mContentKey.aes_ctr.isSet() || mContentKey.aes_xts.isSet())
+		{
+			nstool::print("[NCA Content Key]\n");
+		}
 		if (mContentKey.aes_ctr.isSet())
 		{
-			fmt::print("[NCA Content Key]\n");
-			fmt::print("  AES-CTR Key: {:s}\n", tc::cli::FormatUtil::formatBytesAsString(mContentKey.aes_ctr.get().data(), mContentKey.aes_ctr.get().size(), true, ""));
+			nstool::print("  AES-CTR Key: {:s}\n", tc::cli::FormatUtil::formatBytesAsString(mContentKey.aes_ctr.get().data(), mContentKey.aes_ctr.get().size(), true, ""));
+		}
+		if (mContentKey.aes_xts.isSet())
+		{
+			nstool::print("  AES-XTS Key: {:s}{:s}\n", tc::cli::FormatUtil::formatBytesAsString(mContentKey.aes_xts.get()[0].data(), mContentKey.aes_xts.get()[0].size(), true, ""), tc::cli::FormatUtil::formatBytesAsString(mContentKey.aes_xts.get()[1].data(), mContentKey.aes_xts.get()[1].size(), true, ""));
 		}
 	}
 }
 
-nstool::NcaProcess nstool::NcaProcess::readBaseNCA()
+const std::shared_ptr<nstool::BaseNcaSession>& nstool::NcaProcess::getBaseNcaSession()
 {
-	// open base nca stream
-	if (mBaseNcaPath.isNull())
+	// a base NCA path without a shared session gets a session for this NcaProcess
+	if (mBaseNca == nullptr && mBaseNcaPath.isSet())
 	{
-		throw tc::Exception(mModuleName, "Base NCA not supplied. Necessary for update NCA.");
+		mBaseNca = std::make_shared<BaseNcaSession>(mBaseNcaPath.get(), mKeyCfg);
 	}
-	std::shared_ptr<tc::io::IStream> base_stream = std::make_shared<tc::io::FileStream>(tc::io::FileStream(mBaseNcaPath.get(), tc::io::FileMode::Open, tc::io::FileAccess::Read));
 
-	// process base nca with output suppressed
-	NcaProcess obj;
-	nstool::CliOutputMode cliOutput;
-	cliOutput.show_basic_info = false;
-	cliOutput.show_extended_info = false;
-	cliOutput.show_keydata = false;
-	cliOutput.show_layout = false;
-	obj.setCliOutputMode(cliOutput);
-	obj.setVerifyMode(true);
-	obj.setKeyCfg(mKeyCfg);
-	obj.setInputFile(base_stream);
-	obj.process();
-
-	// return processed base nca
-	return obj;
+	return mBaseNca;
 }
 
 void nstool::NcaProcess::generatePartitionConfiguration()
@@ -265,7 +325,7 @@ void nstool::NcaProcess::generatePartitionConfiguration()
 
 		// validate header hash
 		pie::hac::detail::sha256_hash_t fs_header_hash;
-		tc::crypto::GenerateSha2256Hash(fs_header_hash.data(), (const byte_t*)&mHdrBlock.fs_header[partition.header_index], sizeof(pie::hac::sContentArchiveFsHeader));
+		nstool::Sha256Engine::GenerateHash(fs_header_hash.data(), (const byte_t*)&mHdrBlock.fs_header[partition.header_index], sizeof(pie::hac::sContentArchiveFsHeader));
 		if (fs_header_hash != partition.fs_header_hash)
 		{
 			throw tc::Exception(mModuleName, fmt::format("NCA FS Header [{:d}] Hash: FAIL", partition.header_index));
@@ -286,6 +346,11 @@ void nstool::NcaProcess::generatePartitionConfiguration()
 		info.hash_type = (pie::hac::nca::HashType)fs_header.hash_type;
 		info.enc_type = (pie::hac::nca::EncryptionType)fs_header.encryption_type;
 		info.metadata_hash_type = (pie::hac::nca::MetaDataHashType)fs_header.meta_data_hash_type;
+		static_assert(sizeof(info.sparse_info) == sizeof(fs_header.sparse_info), "SparseStream::sSparseInfo does not match the FS header sparse_info.");
+		memcpy(&info.sparse_info, &fs_header.sparse_info, sizeof(info.sparse_info));
+		// compression_info directly follows sparse_info (it is in the reserved space of pie::hac::sContentArchiveFsHeader)
+		static_assert(sizeof(pie::hac::sContentArchiveFsHeader) == 0x200, "Unexpected NCA FS header size.");
+		memcpy(&info.compression_info, (const byte_t*)&fs_header.sparse_info + sizeof(fs_header.sparse_info), sizeof(info.compression_info));
 
 		if (info.hash_type == pie::hac::nca::HashType_HierarchicalSha256)
 		{
@@ -296,123 +361,241 @@ void nstool::NcaProcess::generatePartitionConfiguration()
 			info.hierarchicalintegrity_hdr.fromBytes(fs_header.hash_info.data(), fs_header.hash_info.size());
 		}
 
-		// create reader
-		try 
+		// the partition streams are created when the partition is first used (see openPartitionReader()/mountPartition())
+		info.reader_opened = false;
+		info.mounted = false;
+	}
+}
+
+void nstool::NcaProcess::openPartitionReader(uint32_t index)
+{
+	sPartitionInfo& info = mPartitions[index];
+	if (info.reader_opened)
+	{
+		return;
+	}
+	info.reader_opened = true;
+
+	pie::hac::sContentArchiveFsHeader& fs_header = mHdrBlock.fs_header[index];
+
+	try 
+	{
+		// handle partition encryption and partition compaction (sparse layer)
+		if (info.sparse_info.generation.unwrap() != 0)
 		{
-			// handle partition encryption and partition compaction (sparse layer)
-			if (fs_header.sparse_info.generation.unwrap() != 0)
+			// only the present regions of a sparse partition are stored, so there is no raw partition stream
+			if (info.enc_type == pie::hac::nca::EncryptionType_None)
 			{
-				throw tc::Exception("SparseStorage: Not currently supported.");
+				info.decrypt_reader = std::make_shared<nstool::SparseStream>(nstool::SparseStream(mFile, info.offset, info.size, info.sparse_info));
 			}
-			else
+			else if (info.enc_type == pie::hac::nca::EncryptionType_AesCtr)
 			{
-				// create raw partition
-				info.raw_reader = std::make_shared<tc::io::SubStream>(tc::io::SubStream(mFile, info.offset, info.size));
-
-				// handle encryption if required reader based on encryption type
-				if (info.enc_type == pie::hac::nca::EncryptionType_None)
-				{
-					// no encryption so do nothing
-					info.decrypt_reader = info.raw_reader;
-				}
-				else if (info.enc_type == pie::hac::nca::EncryptionType_AesCtr)
-				{
-					if (mContentKey.aes_ctr.isNull())
-						throw tc::Exception(mModuleName, "AES-CTR Key was not determined");
+				if (mContentKey.aes_ctr.isNull())
+					throw tc::Exception(mModuleName, "AES-CTR Key was not determined");
 
-					// get partition key
-					pie::hac::detail::aes128_key_t partition_key = mContentKey.aes_ctr.get();
+				// absent regions are zeros, present data is decrypted at its partition offset
+				info.decrypt_reader = std::make_shared<nstool::SparseStream>(nstool::SparseStream(mFile, info.offset, info.size, info.sparse_info, mContentKey.aes_ctr.get(), info.aes_ctr));
+			}
+			else
+			{
+				throw tc::Exception(mModuleName, fmt::format("SparseStorage with EncryptionType({:s}): UNSUPPORTED", pie::hac::ContentArchiveUtil::getEncryptionTypeAsString(info.enc_type)));
+			}
+		}
+		else
+		{
+			// create raw partition
+			info.raw_reader = std::make_shared<tc::io::SubStream>(tc::io::SubStream(mFile, info.offset, info.size));
 
-					// get partition counter
-					pie::hac::detail::aes_iv_t partition_ctr = info.aes_ctr;
-					tc::crypto::IncrementCounterAes128Ctr(partition_ctr.data(), info.offset >> 4);
+			// handle encryption if required reader based on encryption type
+			if (info.enc_type == pie::hac::nca::EncryptionType_None)
+			{
+				// no encryption so do nothing
+				info.decrypt_reader = info.raw_reader;
+			}
+			else if (info.enc_type == pie::hac::nca::EncryptionType_AesCtr)
+			{
+				if (mContentKey.aes_ctr.isNull())
+					throw tc::Exception(mModuleName, "AES-CTR Key was not determined");
 
-					// create decryption stream
-					info.decrypt_reader = std::make_shared<tc::crypto::Aes128CtrEncryptedStream>(tc::crypto::Aes128CtrEncryptedStream(info.raw_reader, partition_key, partition_ctr));
-				}
-				else if (info.enc_type == pie::hac::nca::EncryptionType_AesCtrEx)
-				{
-					if (mContentKey.aes_ctr.isNull())
-						throw tc::Exception(mModuleName, "AES-CTR Key was not determined");
+				// get partition key
+				pie::hac::detail::aes128_key_t partition_key = mContentKey.aes_ctr.get();
 
-					// get partition key
-					pie::hac::detail::aes128_key_t partition_key = mContentKey.aes_ctr.get();
+				// get partition counter
+				pie::hac::detail::aes_iv_t partition_ctr = info.aes_ctr;
+				tc::crypto::IncrementCounterAes128Ctr(partition_ctr.data(), info.offset >> 4);
 
-					// get partition counter
-					pie::hac::detail::aes_iv_t partition_ctr = info.aes_ctr;
-					tc::crypto::IncrementCounterAes128Ctr(partition_ctr.data(), info.offset >> 4);
+				// create decryption stream (uses AES-NI/ARMv8 crypto instructions where available, large reads are decrypted in parallel with the thread pool)
+				info.decrypt_reader = std::make_shared<nstool::Aes128CtrStream>(nstool::Aes128CtrStream(info.raw_reader, partition_key, partition_ctr, mDecryptThreadPool));
+			}
+			else if (info.enc_type == pie::hac::nca::EncryptionType_AesCtrEx)
+			{
+				if (mContentKey.aes_ctr.isNull())
+					throw tc::Exception(mModuleName, "AES-CTR Key was not determined");
 
-					// TODO see if AesCtrEx encryption can just be for creating the transparent decryption, with IndirectStorage IStream construction being done after decryption but before hash layer processing
-					// this might be relevant when processing compressed or sparse storage
+				// get partition key
+				pie::hac::detail::aes128_key_t partition_key = mContentKey.aes_ctr.get();
 
-					NcaProcess nca_base = readBaseNCA();
-					if (nca_base.mHdr.getProgramId() != mHdr.getProgramId())
-					{
-						throw tc::Exception(mModuleName, "Invalid base nca. ProgramID diferent.");
-					}
+				// get partition counter
+				pie::hac::detail::aes_iv_t partition_ctr = info.aes_ctr;
+				tc::crypto::IncrementCounterAes128Ctr(partition_ctr.data(), info.offset >> 4);
 
-					std::shared_ptr<tc::io::IStream> base_reader;
-					for (auto& partition_base : nca_base.mPartitions)
-					{
-						if (partition_base.format_type == pie::hac::nca::FormatType::FormatType_RomFs && partition_base.raw_reader != nullptr)
-						{
-							base_reader = partition_base.decrypt_reader;
-						}
-					}
-					if (base_reader == nullptr)
-					{
-						throw tc::Exception(mModuleName, "Cannot determine RomFs from base nca.");
-					}
+				// TODO see if AesCtrEx encryption can just be for creating the transparent decryption, with IndirectStorage IStream construction being done after decryption but before hash layer processing
+				// this might be relevant when processing compressed or sparse storage
 
-					// create decryption stream
-					info.decrypt_reader = std::make_shared<pie::hac::BKTREncryptedStream>(pie::hac::BKTREncryptedStream(info.raw_reader, partition_key, partition_ctr, fs_header.patch_info, base_reader));
-				}
-				else if (info.enc_type == pie::hac::nca::EncryptionType_AesXts)
+				std::shared_ptr<BaseNcaSession> base_nca = getBaseNcaSession();
+				if (base_nca == nullptr)
 				{
-					throw tc::Exception(mModuleName, fmt::format("EncryptionType({:s}): UNSUPPORTED", pie::hac::ContentArchiveUtil::getEncryptionTypeAsString(info.enc_type)));
+					throw tc::Exception(mModuleName, "Base NCA not supplied. Necessary for update NCA.");
 				}
-				else
+				if (base_nca->getProgramId() != mHdr.getProgramId())
 				{
-					throw tc::Exception(mModuleName, fmt::format("EncryptionType({:s}): UNKNOWN", pie::hac::ContentArchiveUtil::getEncryptionTypeAsString(info.enc_type)));
+					throw tc::Exception(mModuleName, "Invalid base nca. ProgramID diferent.");
 				}
-			}
 
-			// filter out unrecognised hash types, and hash based readers
-			switch (info.hash_type)
-			{
-			case (pie::hac::nca::HashType_None):
-				// no hash layer, do nothing
-				info.reader = info.decrypt_reader;
-				break;
-			case (pie::hac::nca::HashType_HierarchicalSha256):
-				info.reader = std::make_shared<pie::hac::HierarchicalSha256Stream>(pie::hac::HierarchicalSha256Stream(info.decrypt_reader, info.hierarchicalsha256_hdr));
-				break;
-			case (pie::hac::nca::HashType_HierarchicalIntegrity):
-				info.reader = std::make_shared<pie::hac::HierarchicalIntegrityStream>(pie::hac::HierarchicalIntegrityStream(info.decrypt_reader, info.hierarchicalintegrity_hdr));
-				break;
-			default:
-				throw tc::Exception(mModuleName, fmt::format("HashType({:s}): UNKNOWN", pie::hac::ContentArchiveUtil::getHashTypeAsString(info.hash_type)));
+				// the base NCA header is only processed once per session, this is a new stream of its RomFs
+				std::shared_ptr<tc::io::IStream> base_reader = base_nca->createRomFsReader(mDecryptThreadPool);
+
+				// create decryption stream (relocation/subsection tables are loaded once and indexed)
+				BktrStream::sPatchInfo patch_info;
+				static_assert(sizeof(patch_info) == sizeof(fs_header.patch_info), "BktrStream::sPatchInfo does not match the FS header patch_info.");
+				memcpy(&patch_info, &fs_header.patch_info, sizeof(patch_info));
+				info.decrypt_reader = std::make_shared<nstool::BktrStream>(nstool::BktrStream(info.raw_reader, partition_key, partition_ctr, patch_info, base_reader));
 			}
+			else if (info.enc_type == pie::hac::nca::EncryptionType_AesXts)
+			{
+				if (mContentKey.aes_xts.isNull())
+					throw tc::Exception(mModuleName, "AES-XTS Key was not determined");
 
-			// filter out unrecognised format types
-			switch (info.format_type)
+				// sector numbers (the tweaks) start at 0 at the start of the partition
+				info.decrypt_reader = std::make_shared<nstool::Aes128XtsStream>(nstool::Aes128XtsStream(info.raw_reader, mContentKey.aes_xts.get()[0], mContentKey.aes_xts.get()[1], Aes128XtsStream::kDefaultSectorSize, mDecryptThreadPool));
+			}
+			else
 			{
-			case (pie::hac::nca::FormatType_PartitionFs):
-				info.fs_snapshot = pie::hac::PartitionFsSnapshotGenerator(info.reader);
-				info.fs_reader = std::make_shared<tc::io::VirtualFileSystem>(tc::io::VirtualFileSystem(info.fs_snapshot));
-				break;
-			case (pie::hac::nca::FormatType_RomFs):
-				info.fs_snapshot = pie::hac::RomFsSnapshotGenerator(info.reader);
-				info.fs_reader = std::make_shared<tc::io::VirtualFileSystem>(tc::io::VirtualFileSystem(info.fs_snapshot));
-				break;
-			default:
-				throw tc::Exception(mModuleName, fmt::format("FormatType({:s}): UNKNOWN", pie::hac::ContentArchiveUtil::getFormatTypeAsString(info.format_type)));
+				throw tc::Exception(mModuleName, fmt::format("EncryptionType({:s}): UNKNOWN", pie::hac::ContentArchiveUtil::getEncryptionTypeAsString(info.enc_type)));
 			}
 		}
-		catch (const tc::Exception& e)
+	}
+	catch (const tc::Exception& e)
+	{
+		info.fail_reason = std::string(e.error());
+	}
+}
+
+bool nstool::NcaProcess::checkPartitionReadable(uint32_t index)
+{
+	sPartitionInfo& info = mPartitions[index];
+	if (info.mounted)
+	{
+		return info.fs_reader != nullptr;
+	}
+	if (info.reader_opened && info.decrypt_reader == nullptr)
+	{
+		return false;
+	}
+
+	try
+	{
+		// keys and base NCA needed by openPartitionReader()
+		if (info.sparse_info.generation.unwrap() != 0 && info.enc_type != pie::hac::nca::EncryptionType_None && info.enc_type != pie::hac::nca::EncryptionType_AesCtr)
+		{
+			throw tc::Exception(mModuleName, fmt::format("SparseStorage with EncryptionType({:s}): UNSUPPORTED", pie::hac::ContentArchiveUtil::getEncryptionTypeAsString(info.enc_type)));
+		}
+		switch (info.enc_type)
 		{
-			info.fail_reason = std::string(e.error());
+		case (pie::hac::nca::EncryptionType_None):
+			break;
+		case (pie::hac::nca::EncryptionType_AesCtr):
+		case (pie::hac::nca::EncryptionType_AesCtrEx):
+			if (mContentKey.aes_ctr.isNull())
+				throw tc::Exception(mModuleName, "AES-CTR Key was not determined");
+			if (info.enc_type == pie::hac::nca::EncryptionType_AesCtrEx && mBaseNca == nullptr && mBaseNcaPath.isNull())
+				throw tc::Exception(mModuleName, "Base NCA not supplied. Necessary for update NCA.");
+			break;
+		case (pie::hac::nca::EncryptionType_AesXts):
+			if (mContentKey.aes_xts.isNull())
+				throw tc::Exception(mModuleName, "AES-XTS Key was not determined");
+			break;
+		default:
+			throw tc::Exception(mModuleName, fmt::format("EncryptionType({:s}): UNKNOWN", pie::hac::ContentArchiveUtil::getEncryptionTypeAsString(info.enc_type)));
 		}
+
+		// types handled by mountPartition()
+		if (info.hash_type != pie::hac::nca::HashType_None && info.hash_type != pie::hac::nca::HashType_HierarchicalSha256 && info.hash_type != pie::hac::nca::HashType_HierarchicalIntegrity)
+		{
+			throw tc::Exception(mModuleName, fmt::format("HashType({:s}): UNKNOWN", pie::hac::ContentArchiveUtil::getHashTypeAsString(info.hash_type)));
+		}
+		if (info.format_type != pie::hac::nca::FormatType_PartitionFs && info.format_type != pie::hac::nca::FormatType_RomFs)
+		{
+			throw tc::Exception(mModuleName, fmt::format("FormatType({:s}): UNKNOWN", pie::hac::ContentArchiveUtil::getFormatTypeAsString(info.format_type)));
+		}
+	}
+	catch (const tc::Exception& e)
+	{
+		info.fail_reason = std::string(e.error());
+		return false;
+	}
+
+	return true;
+}
+
+void nstool::NcaProcess::mountPartition(uint32_t index)
+{
+	sPartitionInfo& info = mPartitions[index];
+	if (info.mounted)
+	{
+		return;
+	}
+	info.mounted = true;
+
+	openPartitionReader(index);
+	if (info.decrypt_reader == nullptr)
+	{
+		return;
+	}
+
+	try 
+	{
+		// filter out unrecognised hash types, and hash based readers
+		switch (info.hash_type)
+		{
+		case (pie::hac::nca::HashType_None):
+			// no hash layer, do nothing
+			info.reader = info.decrypt_reader;
+			break;
+		case (pie::hac::nca::HashType_HierarchicalSha256):
+			info.reader = std::make_shared<nstool::HierarchicalSha256Stream>(nstool::HierarchicalSha256Stream(info.decrypt_reader, info.hierarchicalsha256_hdr, mVerifiedBlockCache, index));
+			break;
+		case (pie::hac::nca::HashType_HierarchicalIntegrity):
+			info.reader = std::make_shared<nstool::HierarchicalIntegrityStream>(nstool::HierarchicalIntegrityStream(info.decrypt_reader, info.hierarchicalintegrity_hdr, mVerifiedBlockCache, index));
+			break;
+		default:
+			throw tc::Exception(mModuleName, fmt::format("HashType({:s}): UNKNOWN", pie::hac::ContentArchiveUtil::getHashTypeAsString(info.hash_type)));
+		}
+
+		// the compression layer is on top of the hash layer, the file system is read from the decompressed data
+		if (info.compression_info.table_size.unwrap() != 0)
+		{
+			info.reader = std::make_shared<nstool::CompressedStream>(nstool::CompressedStream(info.reader, info.compression_info, mDecryptThreadPool));
+		}
+
+		// filter out unrecognised format types
+		switch (info.format_type)
+		{
+		case (pie::hac::nca::FormatType_PartitionFs):
+			info.fs_snapshot = pie::hac::PartitionFsSnapshotGenerator(info.reader);
+			info.fs_reader = std::make_shared<tc::io::VirtualFileSystem>(tc::io::VirtualFileSystem(info.fs_snapshot));
+			break;
+		case (pie::hac::nca::FormatType_RomFs):
+			info.fs_snapshot = pie::hac::RomFsSnapshotGenerator(info.reader);
+			info.fs_reader = std::make_shared<tc::io::VirtualFileSystem>(tc::io::VirtualFileSystem(info.fs_snapshot));
+			break;
+		default:
+			throw tc::Exception(mModuleName, fmt::format("FormatType({:s}): UNKNOWN", pie::hac::ContentArchiveUtil::getFormatTypeAsString(info.format_type)));
+		}
+	}
+	catch (const tc::Exception& e)
+	{
+		info.fail_reason = std::string(e.error());
 	}
 }
 
@@ -423,12 +606,12 @@ void nstool::NcaProcess::validateNcaSignatures()
 	{
 		if (tc::crypto::VerifyRsa2048PssSha2256(mHdrBlock.signature_main.data(), mHdrHash.data(), mKeyCfg.nca_header_sign0_key[mHdr.getSignatureKeyGeneration()]) == false)
 		{
-			fmt::print("[WARNING] NCA Header Main Signature: FAIL\n");
+			nstool::print("[WARNING] NCA Header Main Signature: FAIL\n");
 		}
 	}
 	else
 	{
-		fmt::print("[WARNING] NCA Header Main Signature: FAIL (could not load header key)\n");
+		nstool::print("[WARNING] NCA Header Main Signature: FAIL (could not load header key)\n");
 	}
 	
 
@@ -438,6 +621,7 @@ void nstool::NcaProcess::validateNcaSignatures()
 		try {
 			if (mPartitions[pie::hac::nca::ProgramContentPartitionIndex_Code].format_type == pie::hac::nca::FormatType_PartitionFs)
 			{
+				mountPartition(pie::hac::nca::ProgramContentPartitionIndex_Code);
 				if (mPartitions[pie::hac::nca::ProgramContentPartitionIndex_Code].fs_reader != nullptr)
 				{
 					std::shared_ptr<tc::io::IStream> npdm_file;
@@ -471,114 +655,202 @@ void nstool::NcaProcess::validateNcaSignatures()
 			}
 		}
 		catch (tc::Exception& e) {
-			fmt::print("[WARNING] NCA Header ACID Signature: FAIL ({:s})\n", e.error());
+			nstool::print("[WARNING] NCA Header ACID Signature: FAIL ({:s})\n", e.error());
+		}
+	}
+}
+
+void nstool::NcaProcess::validatePartitionHashTrees()
+{
+	// hashing is spread over the extraction thread pool, or the shared hashing pool if extraction is single threaded
+	std::shared_ptr<ThreadPool> thread_pool = mDecryptThreadPool != nullptr ? mDecryptThreadPool : getSharedHashThreadPool();
+
+	nstool::print("[NCA Hash Tree Verification]\n");
+	for (size_t i = 0; i < mHdr.getPartitionEntryList().size(); i++)
+	{
+		uint32_t index = mHdr.getPartitionEntryList()[i].header_index;
+		const sPartitionInfo& info = mPartitions[index];
+
+		if (info.hash_type != pie::hac::nca::HashType_HierarchicalSha256 && info.hash_type != pie::hac::nca::HashType_HierarchicalIntegrity)
+		{
+			nstool::print("  Partition {:d}: SKIPPED (no hash tree)\n", index);
+			continue;
+		}
+
+		openPartitionReader(index);
+		if (info.decrypt_reader == nullptr)
+		{
+			nstool::print("  Partition {:d}: FAIL (partition could not be read: {:s})\n", index, info.fail_reason.empty() ? "unknown reason" : info.fail_reason);
+			continue;
+		}
+
+		std::vector<HashTreeStream::sLayer> layers;
+		std::vector<HashTreeStream::sha256_hash_t> master_hashes;
+		bool pad_partial_block;
+		if (info.hash_type == pie::hac::nca::HashType_HierarchicalSha256)
+		{
+			layers = HierarchicalSha256Stream::getLayers(info.hierarchicalsha256_hdr);
+			master_hashes.push_back(info.hierarchicalsha256_hdr.getMasterHash());
+			pad_partial_block = false;
+		}
+		else
+		{
+			layers = HierarchicalIntegrityStream::getLayers(info.hierarchicalintegrity_hdr);
+			master_hashes = HierarchicalIntegrityStream::getMasterHashes(info.hierarchicalintegrity_hdr);
+			pad_partial_block = true;
+		}
+
+		std::vector<HashTreeVerifier::sBlockRange> failures;
+		try {
+			HashTreeVerifier verifier(info.decrypt_reader, layers, master_hashes, pad_partial_block, thread_pool);
+			failures = verifier.verify();
+		}
+		catch (const tc::Exception& e) {
+			nstool::print("  Partition {:d}: FAIL ({:s})\n", index, e.error());
+			continue;
+		}
+
+		if (failures.empty())
+		{
+			nstool::print("  Partition {:d}: OK\n", index);
+			continue;
+		}
+
+		nstool::print("  Partition {:d}: FAIL\n", index);
+		for (auto itr = failures.begin(); itr != failures.end(); itr++)
+		{
+			const HashTreeStream::sLayer& layer = layers[itr->layer_index];
+			std::string layer_name = (itr->layer_index + 1 == layers.size()) ? "Data Layer" : fmt::format("Hash Layer {:d}", itr->layer_index);
+			int64_t offset = layer.offset + int64_t(itr->first_block) * int64_t(layer.block_size);
+			int64_t size = std::min<int64_t>(int64_t(itr->block_num) * int64_t(layer.block_size), layer.offset + layer.size - offset);
+
+			if (itr->block_num == 1)
+				nstool::print("    {:s} Block 0x{:x} (offset 0x{:x}, size 0x{:x})\n", layer_name, itr->first_block, offset, size);
+			else
+				nstool::print("    {:s} Blocks 0x{:x}-0x{:x} (offset 0x{:x}, size 0x{:x})\n", layer_name, itr->first_block, itr->first_block + itr->block_num - 1, offset, size);
 		}
 	}
 }
 
 void nstool::NcaProcess::displayHeader()
 {
-	fmt::print("[NCA Header]\n");
-	fmt::print("  Format Type:     {:s}\n", pie::hac::ContentArchiveUtil::getFormatHeaderVersionAsString((pie::hac::nca::HeaderFormatVersion)mHdr.getFormatVersion()));
-	fmt::print("  Dist. Type:      {:s}\n", pie::hac::ContentArchiveUtil::getDistributionTypeAsString(mHdr.getDistributionType()));
-	fmt::print("  Content Type:    {:s}\n", pie::hac::ContentArchiveUtil::getContentTypeAsString(mHdr.getContentType()));
-	fmt::print("  Key Generation:  {:d}\n", mHdr.getKeyGeneration());
-	fmt::print("  Sig. Generation: {:d}\n", mHdr.getSignatureKeyGeneration());
-	fmt::print("  Kaek Index:      {:s} ({:d})\n", pie::hac::ContentArchiveUtil::getKeyAreaEncryptionKeyIndexAsString((pie::hac::nca::KeyAreaEncryptionKeyIndex)mHdr.getKeyAreaEncryptionKeyIndex()), mHdr.getKeyAreaEncryptionKeyIndex());
-	fmt::print("  Size:            0x{:x}\n", mHdr.getContentSize());
-	fmt::print("  ProgID:          0x{:016x}\n", mHdr.getProgramId());
-	fmt::print("  Content Index:   {:d}\n", mHdr.getContentIndex());
-	fmt::print("  SdkAddon Ver.:   {:s} (v{:d})\n", pie::hac::ContentArchiveUtil::getSdkAddonVersionAsString(mHdr.getSdkAddonVersion()), mHdr.getSdkAddonVersion());
+	nstool::print("[NCA Header]\n");
+	nstool::print("  Format Type:     {:s}\n", pie::hac::ContentArchiveUtil::getFormatHeaderVersionAsString((pie::hac::nca::HeaderFormatVersion)mHdr.getFormatVersion()));
+	nstool::print("  Dist. Type:      {:s}\n", pie::hac::ContentArchiveUtil::getDistributionTypeAsString(mHdr.getDistributionType()));
+	nstool::print("  Content Type:    {:s}\n", pie::hac::ContentArchiveUtil::getContentTypeAsString(mHdr.getContentType()));
+	nstool::print("  Key Generation:  {:d}\n", mHdr.getKeyGeneration());
+	nstool::print("  Sig. Generation: {:d}\n", mHdr.getSignatureKeyGeneration());
+	nstool::print("  Kaek Index:      {:s} ({:d})\n", pie::hac::ContentArchiveUtil::getKeyAreaEncryptionKeyIndexAsString((pie::hac::nca::KeyAreaEncryptionKeyIndex)mHdr.getKeyAreaEncryptionKeyIndex()), mHdr.getKeyAreaEncryptionKeyIndex());
+	nstool::print("  Size:            0x{:x}\n", mHdr.getContentSize());
+	nstool::print("  ProgID:          0x{:016x}\n", mHdr.getProgramId());
+	nstool::print("  Content Index:   {:d}\n", mHdr.getContentIndex());
+	nstool::print("  SdkAddon Ver.:   {:s} (v{:d})\n", pie::hac::ContentArchiveUtil::getSdkAddonVersionAsString(mHdr.getSdkAddonVersion()), mHdr.getSdkAddonVersion());
 	if (mHdr.hasRightsId())
 	{
-		fmt::print("  RightsId:        {:s}\n", tc::cli::FormatUtil::formatBytesAsString(mHdr.getRightsId().data(), mHdr.getRightsId().size(), true, ""));
+		nstool::print("  RightsId:        {:s}\n", tc::cli::FormatUtil::formatBytesAsString(mHdr.getRightsId().data(), mHdr.getRightsId().size(), true, ""));
 	}
 	
 	if (mContentKey.kak_list.size() > 0 && mCliOutputMode.show_keydata)
 	{
-		fmt::print("  Key Area:\n");
-		fmt::print("    <--------------------------------------------------------------------------->\n");
-		fmt::print("    | IDX | ENCRYPTED KEY                    | DECRYPTED KEY                    |\n");
-		fmt::print("    |-----|----------------------------------|----------------------------------|\n");
+		nstool::print("  Key Area:\n");
+		nstool::print("    <--------------------------------------------------------------------------->\n");
+		nstool::print("    | IDX | ENCRYPTED KEY                    | DECRYPTED KEY                    |\n");
+		nstool::print("    |-----|----------------------------------|----------------------------------|\n");
 		for (size_t i = 0; i < mContentKey.kak_list.size(); i++)
 		{
 			std::string enc_key = tc::cli::FormatUtil::formatBytesAsString(mContentKey.kak_list[i].enc.data(), mContentKey.kak_list[i].enc.size(), true, "");
 			std::string dec_key = mContentKey.kak_list[i].decrypted ? tc::cli::FormatUtil::formatBytesAsString(mContentKey.kak_list[i].dec.data(), mContentKey.kak_list[i].dec.size(), true, "") : "<unable to decrypt>";
 			
-			fmt::print("    | {:3d} | {:32s} | {:32s} |\n", mContentKey.kak_list[i].index, enc_key, dec_key);
+			nstool::print("    | {:3d} | {:32s} | {:32s} |\n", mContentKey.kak_list[i].index, enc_key, dec_key);
 		
 		}
-		fmt::print("    <--------------------------------------------------------------------------->\n");
+		nstool::print("    <--------------------------------------------------------------------------->\n");
 	}
 
 	if (mCliOutputMode.show_layout)
 	{
-		fmt::print("  Partitions:\n");
+		nstool::print("  Partitions:\n");
 		for (size_t i = 0; i < mHdr.getPartitionEntryList().size(); i++)
 		{
 			uint32_t index = mHdr.getPartitionEntryList()[i].header_index;
 			sPartitionInfo& info = mPartitions[index];
 			if (info.size == 0) continue;
 
-			fmt::print("    {:d}:\n", index);
-			fmt::print("      Offset:      0x{:x}\n", info.offset);
-			fmt::print("      Size:        0x{:x}\n", info.size);
-			fmt::print("      Format Type: {:s}\n", pie::hac::ContentArchiveUtil::getFormatTypeAsString(info.format_type));
-			fmt::print("      Hash Type:   {:s}\n", pie::hac::ContentArchiveUtil::getHashTypeAsString(info.hash_type));
-			fmt::print("      Enc. Type:   {:s}\n", pie::hac::ContentArchiveUtil::getEncryptionTypeAsString(info.enc_type));
+			nstool::print("    {:d}:\n", index);
+			nstool::print("      Offset:      0x{:x}\n", info.offset);
+			nstool::print("      Size:        0x{:x}\n", info.size);
+			nstool::print("      Format Type: {:s}\n", pie::hac::ContentArchiveUtil::getFormatTypeAsString(info.format_type));
+			nstool::print("      Hash Type:   {:s}\n", pie::hac::ContentArchiveUtil::getHashTypeAsString(info.hash_type));
+			nstool::print("      Enc. Type:   {:s}\n", pie::hac::ContentArchiveUtil::getEncryptionTypeAsString(info.enc_type));
 			if (info.enc_type == pie::hac::nca::EncryptionType_AesCtr)
 			{
 				pie::hac::detail::aes_iv_t aes_ctr;
 				memcpy(aes_ctr.data(), info.aes_ctr.data(), aes_ctr.size());
 				tc::crypto::IncrementCounterAes128Ctr(aes_ctr.data(), info.offset>>4);
-				fmt::print("      AesCtr Counter:\n");
-				fmt::print("        {:s}\n", tc::cli::FormatUtil::formatBytesAsString(aes_ctr.data(), aes_ctr.size(), true, ""));
+				nstool::print("      AesCtr Counter:\n");
+				nstool::print("        {:s}\n", tc::cli::FormatUtil::formatBytesAsString(aes_ctr.data(), aes_ctr.size(), true, ""));
+			}
+			if (info.sparse_info.generation.unwrap() != 0)
+			{
+				nstool::print("      SparseInfo:\n");
+				nstool::print("        PhysicalOffset:    0x{:x}\n", info.sparse_info.physical_offset.unwrap());
+				nstool::print("        TableOffset:       0x{:x}\n", info.sparse_info.table_offset.unwrap());
+				nstool::print("        TableSize:         0x{:x}\n", info.sparse_info.table_size.unwrap());
+				nstool::print("        TableEntries:      {:d}\n", info.sparse_info.table_header.entry_count.unwrap());
+				nstool::print("        Generation:        {:d}\n", info.sparse_info.generation.unwrap());
+			}
+			if (info.compression_info.table_size.unwrap() != 0)
+			{
+				nstool::print("      CompressionInfo:\n");
+				nstool::print("        TableOffset:       0x{:x}\n", info.compression_info.table_offset.unwrap());
+				nstool::print("        TableSize:         0x{:x}\n", info.compression_info.table_size.unwrap());
+				nstool::print("        TableEntries:      {:d}\n", info.compression_info.table_header.entry_count.unwrap());
 			}
 			if (info.hash_type == pie::hac::nca::HashType_HierarchicalIntegrity)
 			{
 				auto hash_hdr = info.hierarchicalintegrity_hdr;
-				fmt::print("      HierarchicalIntegrity Header:\n");
+				nstool::print("      HierarchicalIntegrity Header:\n");
 				for (size_t j = 0; j < hash_hdr.getLayerInfo().size(); j++)
 				{
 					if (j+1 == hash_hdr.getLayerInfo().size())
 					{
-						fmt::print("        Data Layer:\n");
+						nstool::print("        Data Layer:\n");
 					}
 					else
 					{
-						fmt::print("        Hash Layer {:d}:\n", j);
+						nstool::print("        Hash Layer {:d}:\n", j);
 					}
-					fmt::print("          Offset:          0x{:x}\n", hash_hdr.getLayerInfo()[j].offset);
-					fmt::print("          Size:            0x{:x}\n", hash_hdr.getLayerInfo()[j].size);
-					fmt::print("          BlockSize:       0x{:x}\n", hash_hdr.getLayerInfo()[j].block_size);
+					nstool::print("          Offset:          0x{:x}\n", hash_hdr.getLayerInfo()[j].offset);
+					nstool::print("          Size:            0x{:x}\n", hash_hdr.getLayerInfo()[j].size);
+					nstool::print("          BlockSize:       0x{:x}\n", hash_hdr.getLayerInfo()[j].block_size);
 				}
 				for (size_t j = 0; j < hash_hdr.getMasterHashList().size(); j++)
 				{
-					fmt::print("        Master Hash {:d}:\n", j);
-					fmt::print("          {:s}\n", tc::cli::FormatUtil::formatBytesAsString(hash_hdr.getMasterHashList()[j].data(), 0x10, true, ""));
-					fmt::print("          {:s}\n", tc::cli::FormatUtil::formatBytesAsString(hash_hdr.getMasterHashList()[j].data()+0x10, 0x10, true, ""));
+					nstool::print("        Master Hash {:d}:\n", j);
+					nstool::print("          {:s}\n", tc::cli::FormatUtil::formatBytesAsString(hash_hdr.getMasterHashList()[j].data(), 0x10, true, ""));
+					nstool::print("          {:s}\n", tc::cli::FormatUtil::formatBytesAsString(hash_hdr.getMasterHashList()[j].data()+0x10, 0x10, true, ""));
 				}
 			}
 			else if (info.hash_type == pie::hac::nca::HashType_HierarchicalSha256)
 			{
 				auto hash_hdr = info.hierarchicalsha256_hdr;
-				fmt::print("      HierarchicalSha256 Header:\n");
-				fmt::print("        Master Hash:\n");
-				fmt::print("          {:s}\n", tc::cli::FormatUtil::formatBytesAsString(hash_hdr.getMasterHash().data(), 0x10, true, ""));
-				fmt::print("          {:s}\n", tc::cli::FormatUtil::formatBytesAsString(hash_hdr.getMasterHash().data()+0x10, 0x10, true, ""));
-				fmt::print("        HashBlockSize:     0x{:x}\n", hash_hdr.getHashBlockSize());
+				nstool::print("      HierarchicalSha256 Header:\n");
+				nstool::print("        Master Hash:\n");
+				nstool::print("          {:s}\n", tc::cli::FormatUtil::formatBytesAsString(hash_hdr.getMasterHash().data(), 0x10, true, ""));
+				nstool::print("          {:s}\n", tc::cli::FormatUtil::formatBytesAsString(hash_hdr.getMasterHash().data()+0x10, 0x10, true, ""));
+				nstool::print("        HashBlockSize:     0x{:x}\n", hash_hdr.getHashBlockSize());
 				for (size_t j = 0; j < hash_hdr.getLayerInfo().size(); j++)
 				{
 					if (j+1 == hash_hdr.getLayerInfo().size())
 					{
-						fmt::print("        Data Layer:\n");
+						nstool::print("        Data Layer:\n");
 					}
 					else
 					{
-						fmt::print("        Hash Layer {:d}:\n", j);
+						nstool::print("        Hash Layer {:d}:\n", j);
 					}
-					fmt::print("          Offset:          0x{:x}\n", hash_hdr.getLayerInfo()[j].offset);
-					fmt::print("          Size:            0x{:x}\n", hash_hdr.getLayerInfo()[j].size);
+					nstool::print("          Offset:          0x{:x}\n", hash_hdr.getLayerInfo()[j].offset);
+					nstool::print("          Size:            0x{:x}\n", hash_hdr.getLayerInfo()[j].size);
 				}
 			}
 		}
@@ -587,6 +859,172 @@ void nstool::NcaProcess::displayHeader()
 
 
 void nstool::NcaProcess::processPartitions()
+{
+	// only the partitions the extract jobs/fs tree use are mounted
+	std::vector<uint32_t> partition_indexes = getRequiredPartitions();
+	std::shared_ptr<tc::io::IFileSystem> nca_fs = generateFileSystem(partition_indexes, true);
+
+	mFsProcess.setInputFileSystem(nca_fs);
+	mFsProcess.setIoAlignment(getPartitionIoAlignment());
+	// the offsets only order extraction, so the entry tables are not walked again for a fs tree
+	if (mExtractJobs.empty() == false)
+	{
+		mFsProcess.setFileOffsets(getPartitionFileOffsets());
+	}
+	if (mFileFactory != nullptr)
+	{
+		// each extraction worker gets its own copy of the partition stream stack, built by a silent NcaProcess over an independent input stream
+		StreamFactory file_factory = mFileFactory;
+		KeyBag keycfg = mKeyCfg;
+		std::shared_ptr<BaseNcaSession> base_nca = getBaseNcaSession();
+		std::shared_ptr<VerifiedBlockCache> block_cache = mVerifiedBlockCache;
+		mFsProcess.setInputFileSystemFactory([file_factory, keycfg, base_nca, block_cache, partition_indexes]() -> std::shared_ptr<tc::io::IFileSystem> {
+			NcaProcess obj;
+			nstool::CliOutputMode cliOutput;
+			cliOutput.show_basic_info = false;
+			cliOutput.show_extended_info = false;
+			cliOutput.show_keydata = false;
+			cliOutput.show_layout = false;
+			obj.setCliOutputMode(cliOutput);
+			obj.setKeyCfg(keycfg);
+			obj.setBaseNcaSession(base_nca);
+			obj.setInputFile(file_factory());
+			obj.mVerifiedBlockCache = block_cache;
+
+			obj.importHeader();
+			obj.generateNcaBodyEncryptionKeys();
+			obj.generatePartitionConfiguration();
+			return obj.generateFileSystem(partition_indexes, false);
+		});
+	}
+	mFsProcess.setFsFormatName("ContentArchive");
+	mFsProcess.setFsRootLabel(getContentTypeForMountStr(mHdr.getContentType()));
+	mFsProcess.process();
+
+	if (mCliOutputMode.show_extended_info)
+	{
+		nstool::print("[NCA Verified Block Cache]\n");
+		nstool::print("  Hits:          {:d}\n", mVerifiedBlockCache->getHitCount());
+		nstool::print("  Misses:        {:d}\n", mVerifiedBlockCache->getMissCount());
+		nstool::print("  Cached Size:   0x{:x} (of 0x{:x})\n", mVerifiedBlockCache->getSize(), mVerifiedBlockCache->getCapacity());
+	}
+}
+
+nstool::FileOffsetMap nstool::NcaProcess::getPartitionFileOffsets() const
+{
+	// offsets within a partition are relative to the decrypted/hash layer stream, adding the partition offset keeps their order and orders partitions by their position in the NCA
+	FileOffsetMap file_offsets;
+
+	for (size_t i = 0; i < mHdr.getPartitionEntryList().size(); i++)
+	{
+		uint32_t index = mHdr.getPartitionEntryList()[i].header_index;
+		const sPartitionInfo& partition = mPartitions[index];
+
+		if (partition.fs_reader == nullptr)
+		{
+			continue;
+		}
+
+		tc::io::Path mount_path = tc::io::Path("/") + fmt::format("{:d}", index);
+		if (partition.format_type == pie::hac::nca::FormatType_PartitionFs)
+		{
+			getPartitionFsFileOffsets(partition.reader, mount_path, partition.offset, file_offsets);
+		}
+		else if (partition.format_type == pie::hac::nca::FormatType_RomFs)
+		{
+			getRomFsFileOffsets(partition.reader, mount_path, partition.offset, file_offsets);
+		}
+	}
+
+	return file_offsets;
+}
+
+size_t nstool::NcaProcess::getPartitionIoAlignment() const
+{
+	// hash and cipher block sizes are powers of two, so the largest one is a multiple of all the others
+	size_t io_alignment = 1;
+
+	for (size_t i = 0; i < mHdr.getPartitionEntryList().size(); i++)
+	{
+		const sPartitionInfo& partition = mPartitions[mHdr.getPartitionEntryList()[i].header_index];
+
+		if (partition.fs_reader == nullptr)
+		{
+			continue;
+		}
+
+		size_t block_size = 1;
+		if (partition.hash_type == pie::hac::nca::HashType_HierarchicalSha256)
+		{
+			block_size = tc::io::IOUtil::castInt64ToSize(partition.hierarchicalsha256_hdr.getHashBlockSize());
+		}
+		else if (partition.hash_type == pie::hac::nca::HashType_HierarchicalIntegrity && partition.hierarchicalintegrity_hdr.getLayerInfo().empty() == false)
+		{
+			block_size = tc::io::IOUtil::castInt64ToSize(partition.hierarchicalintegrity_hdr.getLayerInfo().back().block_size);
+		}
+
+		if (partition.enc_type == pie::hac::nca::EncryptionType_AesXts)
+		{
+			// AES-XTS is decrypted a whole sector at a time
+			block_size = std::max<size_t>(block_size, Aes128XtsStream::kDefaultSectorSize);
+		}
+		else if (partition.enc_type != pie::hac::nca::EncryptionType_None)
+		{
+			block_size = std::max<size_t>(block_size, tc::crypto::Aes128CtrEncryptor::kBlockSize);
+		}
+
+		io_alignment = std::max<size_t>(io_alignment, block_size);
+	}
+
+	return io_alignment;
+}
+
+std::vector<uint32_t> nstool::NcaProcess::getRequiredPartitions() const
+{
+	std::vector<uint32_t> partition_indexes;
+
+	// extract jobs under a partition's mount point only need that partition, anything else (e.g. the root or showing the fs tree) needs all of them
+	bool require_all = mShowFsTree;
+	std::vector<bool> required(pie::hac::nca::kPartitionNum, false);
+	for (auto job = mExtractJobs.begin(); job != mExtractJobs.end() && require_all == false; job++)
+	{
+		// first non-empty path element is the mount point
+		std::string mount_point_name;
+		for (auto element = job->virtual_path.begin(); element != job->virtual_path.end(); element++)
+		{
+			if (element->empty() == false)
+			{
+				mount_point_name = *element;
+				break;
+			}
+		}
+
+		bool found = false;
+		for (size_t i = 0; i < mHdr.getPartitionEntryList().size(); i++)
+		{
+			uint32_t index = mHdr.getPartitionEntryList()[i].header_index;
+			if (mount_point_name == fmt::format("{:d}", index))
+			{
+				required[index] = true;
+				found = true;
+			}
+		}
+		require_all = (found == false);
+	}
+
+	for (size_t i = 0; i < mHdr.getPartitionEntryList().size(); i++)
+	{
+		uint32_t index = mHdr.getPartitionEntryList()[i].header_index;
+		if (require_all || required[index])
+		{
+			partition_indexes.push_back(index);
+		}
+	}
+
+	return partition_indexes;
+}
+
+std::shared_ptr<tc::io::IFileSystem> nstool::NcaProcess::generateFileSystem(const std::vector<uint32_t>& partition_indexes, bool show_warnings)
 {
 	std::vector<pie::hac::CombinedFsSnapshotGenerator::MountPointInfo> mount_points;
 
@@ -595,15 +1033,30 @@ void nstool::NcaProcess::processPartitions()
 		uint32_t index = mHdr.getPartitionEntryList()[i].header_index;
 		struct sPartitionInfo& partition = mPartitions[index];
 
+		// partitions that aren't needed are not mounted, but are still checked so the warnings show which partitions can't be read
+		if (std::find(partition_indexes.begin(), partition_indexes.end(), index) != partition_indexes.end())
+		{
+			mountPartition(index);
+		}
+		else if (show_warnings == false || checkPartitionReadable(index))
+		{
+			continue;
+		}
+
 		// if the reader is null, skip
 		if (partition.fs_reader == nullptr)
 		{
-			fmt::print("[WARNING] NCA Partition {:d} not readable.", index);
+			if (show_warnings == false)
+			{
+				continue;
+			}
+
+			nstool::print("[WARNING] NCA Partition {:d} not readable.", index);
 			if (partition.fail_reason.empty() == false)
 			{
-				fmt::print(" ({:s})", partition.fail_reason);
+				nstool::print(" ({:s})", partition.fail_reason);
 			}
-			fmt::print("\n");
+			nstool::print("\n");
 			continue;
 		}
 
@@ -624,12 +1077,7 @@ void nstool::NcaProcess::processPartitions()
 
 	tc::io::VirtualFileSystem::FileSystemSnapshot fs_snapshot = pie::hac::CombinedFsSnapshotGenerator(mount_points);
 
-	std::shared_ptr<tc::io::IFileSystem> nca_fs = std::make_shared<tc::io::VirtualFileSystem>(tc::io::VirtualFileSystem(fs_snapshot));
-
-	mFsProcess.setInputFileSystem(nca_fs);
-	mFsProcess.setFsFormatName("ContentArchive");
-	mFsProcess.setFsRootLabel(getContentTypeForMountStr(mHdr.getContentType()));
-	mFsProcess.process();
+	return std::make_shared<tc::io::VirtualFileSystem>(tc::io::VirtualFileSystem(fs_snapshot));
 }
 
 std::string nstool::NcaProcess::getContentTypeForMountStr(pie::hac::nca::ContentType cont_type) const
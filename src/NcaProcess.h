@@ -2,6 +2,11 @@
 #include "types.h"
 #include "KeyBag.h"
 #include "FsProcess.h"
+#include "ThreadPool.h"
+#include "VerifiedBlockCache.h"
+#include "BaseNcaSession.h"
+#include "SparseStream.h"
+#include "CompressedStream.h"
 
 #include <pietendo/hac/ContentArchiveHeader.h>
 #include <pietendo/hac/HierarchicalIntegrityHeader.h>
@@ -11,6 +16,8 @@ namespace nstool {
 
 class NcaProcess
 {
+	// processes the base NCA header with NcaProcess's private steps
+	friend class BaseNcaSession;
 public:
 	NcaProcess();
 
@@ -18,16 +25,20 @@ public:
 
 	// generic
 	void setInputFile(const std::shared_ptr<tc::io::IStream>& file);
+	void setInputFileFactory(const StreamFactory& file_factory);
 	void setKeyCfg(const KeyBag& keycfg);
 	void setCliOutputMode(CliOutputMode type);
 	void setVerifyMode(bool verify);
+	void setFullVerifyMode(bool verify_full);
 	void setBaseNcaPath(const tc::Optional<tc::io::Path>& nca_path);
+	void setBaseNcaSession(const std::shared_ptr<BaseNcaSession>& base_nca); // shared alternative to setBaseNcaPath(), for processing many patch NCAs against the same base
 
 
 	// fs specific
 	void setShowFsTree(bool show_fs_tree);
 	void setFsRootLabel(const std::string& root_label);
 	void setExtractJobs(const std::vector<nstool::ExtractJob>& extract_jobs);
+	void setExtractOptions(const nstool::ExtractOptions& extract_options);
 
 	// post process() get FS out
 	const std::shared_ptr<tc::io::IFileSystem>& getFileSystem() const;
@@ -38,15 +49,27 @@ private:
 
 	// user options
 	std::shared_ptr<tc::io::IStream> mFile;
+	StreamFactory mFileFactory;
 	KeyBag mKeyCfg;
 	CliOutputMode mCliOutputMode;
 	bool mVerify;
+	bool mVerifyFull;
 	tc::Optional<tc::io::Path> mBaseNcaPath;
+	std::shared_ptr<BaseNcaSession> mBaseNca;
+	bool mShowFsTree;
+	std::vector<nstool::ExtractJob> mExtractJobs;
 
 	// fs processing
 	std::shared_ptr<tc::io::IFileSystem> mFileSystem;
 	FsProcess mFsProcess;
 
+	// decrypts large reads from AES-CTR partitions in parallel (only created when extracting with more than one thread)
+	std::shared_ptr<ThreadPool> mDecryptThreadPool;
+
+	// verified hash tree blocks of all partitions (keyed by partition index), shared with the extraction workers' partition streams
+	static const size_t kVerifiedBlockCacheSize = 0x2000000;
+	std::shared_ptr<VerifiedBlockCache> mVerifiedBlockCache;
+
 	// nca data
 	pie::hac::sContentArchiveHeaderBlock mHdrBlock;
 	pie::hac::detail::sha256_hash_t mHdrHash;
@@ -86,22 +109,20 @@ private:
 		std::vector<sKeyAreaKey> kak_list;
 
 		tc::Optional<pie::hac::detail::aes128_key_t> aes_ctr;
+		tc::Optional<KeyBag::aes128_xtskey_t> aes_xts;
 	} mContentKey;
 
-	struct SparseInfo
-	{
-
-	};
-
 	// raw partition data
 	struct sPartitionInfo
 	{
 		std::shared_ptr<tc::io::IStream> raw_reader; // raw unprocessed partition stream
 		std::shared_ptr<tc::io::IStream> decrypt_reader; // partition stream with transparent decryption
-		std::shared_ptr<tc::io::IStream> reader; // partition stream with transparent decryption & hash layer processing
+		std::shared_ptr<tc::io::IStream> reader; // partition stream with transparent decryption, hash layer processing & decompression
 		tc::io::VirtualFileSystem::FileSystemSnapshot fs_snapshot;
 		std::shared_ptr<tc::io::IFileSystem> fs_reader;
 		std::string fail_reason;
+		bool reader_opened; // openPartitionReader() was called (decrypt_reader is set unless it failed, raw_reader also unless the partition is sparse)
+		bool mounted; // mountPartition() was called (reader/fs_snapshot/fs_reader are set unless it failed)
 		int64_t offset;
 		int64_t size;
 
@@ -119,7 +140,10 @@ private:
 		pie::hac::detail::aes_iv_t aes_ctr;
 
 		// sparse metadata
-		SparseInfo sparse_info;
+		SparseStream::sSparseInfo sparse_info;
+
+		// compression metadata
+		CompressedStream::sCompressionInfo compression_info;
 	};
 	
 	std::array<sPartitionInfo, pie::hac::nca::kPartitionNum> mPartitions;
@@ -127,11 +151,21 @@ private:
 	void importHeader();
 	void generateNcaBodyEncryptionKeys();
 	void generatePartitionConfiguration();
+	void openPartitionReader(uint32_t index);
+	// checks the keys, base NCA and partition types the partition needs without creating its streams, returns false with fail_reason set if it can't be mounted
+	// (a partition that passes can still fail to mount, e.g. if its hash tree or filesystem header is bad)
+	bool checkPartitionReadable(uint32_t index);
+	void mountPartition(uint32_t index);
 	void validateNcaSignatures();
+	void validatePartitionHashTrees();
 	void displayHeader();
 	void processPartitions();
+	std::vector<uint32_t> getRequiredPartitions() const;
+	std::shared_ptr<tc::io::IFileSystem> generateFileSystem(const std::vector<uint32_t>& partition_indexes, bool show_warnings);
+	size_t getPartitionIoAlignment() const;
+	nstool::FileOffsetMap getPartitionFileOffsets() const;
 
-	NcaProcess readBaseNCA();
+	const std::shared_ptr<BaseNcaSession>& getBaseNcaSession();
 
 	std::string getContentTypeForMountStr(pie::hac::nca::ContentType cont_type) const;
 };
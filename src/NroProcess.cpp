@@ -1,8 +1,10 @@
 #include "NroProcess.h"
+#include "OutputCapture.h"
 
 nstool::NroProcess::NroProcess() :
 	mModuleName("nstool::NroProcess"),
 	mFile(),
+	mFileFactory(),
 	mCliOutputMode(true, false, false, false),
 	mVerify(false)
 {
@@ -27,6 +29,11 @@ void nstool::NroProcess::setInputFile(const std::shared_ptr<tc::io::IStream>& fi
 	mFile = file;
 }
 
+void nstool::NroProcess::setInputFileFactory(const StreamFactory& file_factory)
+{
+	mFileFactory = file_factory;
+}
+
 void nstool::NroProcess::setCliOutputMode(CliOutputMode type)
 {
 	mCliOutputMode = type;
@@ -72,6 +79,11 @@ void nstool::NroProcess::setAssetRomfsExtractJobs(const std::vector<nstool::Extr
 	mAssetProc.setRomfsExtractJobs(extract_jobs);
 }
 
+void nstool::NroProcess::setAssetRomfsExtractOptions(const nstool::ExtractOptions& extract_options)
+{
+	mAssetProc.setRomfsExtractOptions(extract_options);
+}
+
 const nstool::RoMetadataProcess& nstool::NroProcess::getRoMetadataProcess() const
 {
 	return mRoMeta;
@@ -110,6 +122,15 @@ void nstool::NroProcess::importHeader()
 	{
 		mIsHomebrewNro = true;
 		mAssetProc.setInputFile(std::make_shared<tc::io::SubStream>(tc::io::SubStream(mFile, int64_t(mHdr.getNroSize()), file_size - int64_t(mHdr.getNroSize()))));
+		if (mFileFactory != nullptr)
+		{
+			StreamFactory file_factory = mFileFactory;
+			int64_t asset_offset = int64_t(mHdr.getNroSize());
+			int64_t asset_size = file_size - int64_t(mHdr.getNroSize());
+			mAssetProc.setInputFileFactory([file_factory, asset_offset, asset_size]() -> std::shared_ptr<tc::io::IStream> {
+				return std::make_shared<tc::io::SubStream>(tc::io::SubStream(file_factory(), asset_offset, asset_size));
+			});
+		}
 		mAssetProc.setCliOutputMode(mCliOutputMode);
 		mAssetProc.setVerifyMode(mVerify);
 	}
@@ -143,36 +164,36 @@ void nstool::NroProcess::importCodeSegments()
 
 void nstool::NroProcess::displayHeader()
 {
-	fmt::print("[NRO Header]\n");
-	fmt::print("  RoCrt:       \n");
-	fmt::print("    EntryPoint: 0x{:x}\n", mHdr.getRoCrtEntryPoint());
-	fmt::print("    ModOffset:  0x{:x}\n", mHdr.getRoCrtModOffset());
-	fmt::print("  ModuleId:    {:s}\n", tc::cli::FormatUtil::formatBytesAsString(mHdr.getModuleId().data(), mHdr.getModuleId().size(), false, ""));
-	fmt::print("  NroSize:     0x{:x}\n", mHdr.getNroSize());
-	fmt::print("  Program Sections:\n");
-	fmt::print("     .text:\n");
-	fmt::print("      Offset:     0x{:x}\n", mHdr.getTextInfo().memory_offset);
-	fmt::print("      Size:       0x{:x}\n", mHdr.getTextInfo().size);
-	fmt::print("    .ro:\n");
-	fmt::print("      Offset:     0x{:x}\n", mHdr.getRoInfo().memory_offset);
-	fmt::print("      Size:       0x{:x}\n", mHdr.getRoInfo().size);
+	nstool::print("[NRO Header]\n");
+	nstool::print("  RoCrt:       \n");
+	nstool::print("    EntryPoint: 0x{:x}\n", mHdr.getRoCrtEntryPoint());
+	nstool::print("    ModOffset:  0x{:x}\n", mHdr.getRoCrtModOffset());
+	nstool::print("  ModuleId:    {:s}\n", tc::cli::FormatUtil::formatBytesAsString(mHdr.getModuleId().data(), mHdr.getModuleId().size(), false, ""));
+	nstool::print("  NroSize:     0x{:x}\n", mHdr.getNroSize());
+	nstool::print("  Program Sections:\n");
+	nstool::print("     .text:\n");
+	nstool::print("      Offset:     0x{:x}\n", mHdr.getTextInfo().memory_offset);
+	nstool::print("      Size:       0x{:x}\n", mHdr.getTextInfo().size);
+	nstool::print("    .ro:\n");
+	nstool::print("      Offset:     0x{:x}\n", mHdr.getRoInfo().memory_offset);
+	nstool::print("      Size:       0x{:x}\n", mHdr.getRoInfo().size);
 	if (mCliOutputMode.show_extended_info)
 	{
-		fmt::print("    .api_info:\n");
-		fmt::print("      Offset:     0x{:x}\n", mHdr.getRoEmbeddedInfo().memory_offset);
-		fmt::print("      Size:       0x{:x}\n", mHdr.getRoEmbeddedInfo().size);
-		fmt::print("    .dynstr:\n");
-		fmt::print("      Offset:     0x{:x}\n", mHdr.getRoDynStrInfo().memory_offset);
-		fmt::print("      Size:       0x{:x}\n", mHdr.getRoDynStrInfo().size);
-		fmt::print("    .dynsym:\n");
-		fmt::print("      Offset:     0x{:x}\n", mHdr.getRoDynSymInfo().memory_offset);
-		fmt::print("      Size:       0x{:x}\n", mHdr.getRoDynSymInfo().size);
+		nstool::print("    .api_info:\n");
+		nstool::print("      Offset:     0x{:x}\n", mHdr.getRoEmbeddedInfo().memory_offset);
+		nstool::print("      Size:       0x{:x}\n", mHdr.getRoEmbeddedInfo().size);
+		nstool::print("    .dynstr:\n");
+		nstool::print("      Offset:     0x{:x}\n", mHdr.getRoDynStrInfo().memory_offset);
+		nstool::print("      Size:       0x{:x}\n", mHdr.getRoDynStrInfo().size);
+		nstool::print("    .dynsym:\n");
+		nstool::print("      Offset:     0x{:x}\n", mHdr.getRoDynSymInfo().memory_offset);
+		nstool::print("      Size:       0x{:x}\n", mHdr.getRoDynSymInfo().size);
 	}                                                                
-	fmt::print("    .data:\n");
-	fmt::print("      Offset:     0x{:x}\n", mHdr.getDataInfo().memory_offset);
-	fmt::print("      Size:       0x{:x}\n", mHdr.getDataInfo().size);
-	fmt::print("    .bss:\n");
-	fmt::print("      Size:       0x{:x}\n", mHdr.getBssSize());
+	nstool::print("    .data:\n");
+	nstool::print("      Offset:     0x{:x}\n", mHdr.getDataInfo().memory_offset);
+	nstool::print("      Size:       0x{:x}\n", mHdr.getDataInfo().size);
+	nstool::print("    .bss:\n");
+	nstool::print("      Size:       0x{:x}\n", mHdr.getBssSize());
 }
 
 void nstool::NroProcess::processRoMeta()
@@ -15,6 +15,7 @@ public:
 	void process();
 
 	void setInputFile(const std::shared_ptr<tc::io::IStream>& file);
+	void setInputFileFactory(const StreamFactory& file_factory);
 	void setCliOutputMode(CliOutputMode type);
 	void setVerifyMode(bool verify);
 
@@ -27,12 +28,14 @@ public:
 	void setAssetNacpExtractPath(const tc::io::Path& path);
 	void setAssetRomfsShowFsTree(bool show_fs_tree);
 	void setAssetRomfsExtractJobs(const std::vector<nstool::ExtractJob>& extract_jobs);
+	void setAssetRomfsExtractOptions(const nstool::ExtractOptions& extract_options);
 
 	const nstool::RoMetadataProcess& getRoMetadataProcess() const;
 private:
 	std::string mModuleName;
 
 	std::shared_ptr<tc::io::IStream> mFile;
+	StreamFactory mFileFactory;
 	CliOutputMode mCliOutputMode;
 	bool mVerify;
 
@@ -1,4 +1,6 @@
 #include "NsoProcess.h"
+#include "OutputCapture.h"
+#include "Sha256Engine.h"
 
 #include <lz4.h>
 
@@ -116,7 +118,7 @@ void nstool::NsoProcess::importCodeSegments()
 	}
 	if (mHdr.getTextSegmentInfo().is_hashed)
 	{
-		tc::crypto::GenerateSha2256Hash(calc_hash.data(), mTextBlob.data(), mTextBlob.size());
+		nstool::Sha256Engine::GenerateHash(calc_hash.data(), mTextBlob.data(), mTextBlob.size());
 		if (calc_hash != mHdr.getTextSegmentInfo().hash)
 		{
 			throw tc::Exception(mModuleName, "NSO text segment failed SHA256 verification");
@@ -149,7 +151,7 @@ void nstool::NsoProcess::importCodeSegments()
 	}
 	if (mHdr.getRoSegmentInfo().is_hashed)
 	{
-		tc::crypto::GenerateSha2256Hash(calc_hash.data(), mRoBlob.data(), mRoBlob.size());
+		nstool::Sha256Engine::GenerateHash(calc_hash.data(), mRoBlob.data(), mRoBlob.size());
 		if (calc_hash != mHdr.getRoSegmentInfo().hash)
 		{
 			throw tc::Exception(mModuleName, "NSO ro segment failed SHA256 verification");
@@ -182,7 +184,7 @@ void nstool::NsoProcess::importCodeSegments()
 	}
 	if (mHdr.getDataSegmentInfo().is_hashed)
 	{
-		tc::crypto::GenerateSha2256Hash(calc_hash.data(), mDataBlob.data(), mDataBlob.size());
+		nstool::Sha256Engine::GenerateHash(calc_hash.data(), mDataBlob.data(), mDataBlob.size());
 		if (calc_hash != mHdr.getDataSegmentInfo().hash)
 		{
 			throw tc::Exception(mModuleName, "NSO data segment failed SHA256 verification");
@@ -192,61 +194,61 @@ void nstool::NsoProcess::importCodeSegments()
 
 void nstool::NsoProcess::displayNsoHeader()
 {
-	fmt::print("[NSO Header]\n");
-	fmt::print("  ModuleId:           {:s}\n", tc::cli::FormatUtil::formatBytesAsString(mHdr.getModuleId().data(), mHdr.getModuleId().size(), false, ""));
+	nstool::print("[NSO Header]\n");
+	nstool::print("  ModuleId:           {:s}\n", tc::cli::FormatUtil::formatBytesAsString(mHdr.getModuleId().data(), mHdr.getModuleId().size(), false, ""));
 	if (mCliOutputMode.show_layout)
 	{
-		fmt::print("  Program Segments:\n");
-		fmt::print("     .module_name:\n");
-		fmt::print("      FileOffset:     0x{:x}\n", mHdr.getModuleNameInfo().offset);
-		fmt::print("      FileSize:       0x{:x}\n", mHdr.getModuleNameInfo().size);
-		fmt::print("    .text:\n");
-		fmt::print("      FileOffset:     0x{:x}\n", mHdr.getTextSegmentInfo().file_layout.offset);
-		fmt::print("      FileSize:       0x{:x}{:s}\n", mHdr.getTextSegmentInfo().file_layout.size, (mHdr.getTextSegmentInfo().is_compressed? " (COMPRESSED)" : ""));
-		fmt::print("    .ro:\n");
-		fmt::print("      FileOffset:     0x{:x}\n", mHdr.getRoSegmentInfo().file_layout.offset);
-		fmt::print("      FileSize:       0x{:x}{:s}\n", mHdr.getRoSegmentInfo().file_layout.size, (mHdr.getRoSegmentInfo().is_compressed? " (COMPRESSED)" : ""));
-		fmt::print("    .data:\n");
-		fmt::print("      FileOffset:     0x{:x}\n", mHdr.getDataSegmentInfo().file_layout.offset);
-		fmt::print("      FileSize:       0x{:x}{:s}\n", mHdr.getDataSegmentInfo().file_layout.size, (mHdr.getDataSegmentInfo().is_compressed? " (COMPRESSED)" : ""));
+		nstool::print("  Program Segments:\n");
+		nstool::print("     .module_name:\n");
+		nstool::print("      FileOffset:     0x{:x}\n", mHdr.getModuleNameInfo().offset);
+		nstool::print("      FileSize:       0x{:x}\n", mHdr.getModuleNameInfo().size);
+		nstool::print("    .text:\n");
+		nstool::print("      FileOffset:     0x{:x}\n", mHdr.getTextSegmentInfo().file_layout.offset);
+		nstool::print("      FileSize:       0x{:x}{:s}\n", mHdr.getTextSegmentInfo().file_layout.size, (mHdr.getTextSegmentInfo().is_compressed? " (COMPRESSED)" : ""));
+		nstool::print("    .ro:\n");
+		nstool::print("      FileOffset:     0x{:x}\n", mHdr.getRoSegmentInfo().file_layout.offset);
+		nstool::print("      FileSize:       0x{:x}{:s}\n", mHdr.getRoSegmentInfo().file_layout.size, (mHdr.getRoSegmentInfo().is_compressed? " (COMPRESSED)" : ""));
+		nstool::print("    .data:\n");
+		nstool::print("      FileOffset:     0x{:x}\n", mHdr.getDataSegmentInfo().file_layout.offset);
+		nstool::print("      FileSize:       0x{:x}{:s}\n", mHdr.getDataSegmentInfo().file_layout.size, (mHdr.getDataSegmentInfo().is_compressed? " (COMPRESSED)" : ""));
 	}
-	fmt::print("  Program Sections:\n");
-	fmt::print("     .text:\n");
-	fmt::print("      MemoryOffset:   0x{:x}\n", mHdr.getTextSegmentInfo().memory_layout.offset);
-	fmt::print("      MemorySize:     0x{:x}\n", mHdr.getTextSegmentInfo().memory_layout.size);
+	nstool::print("  Program Sections:\n");
+	nstool::print("     .text:\n");
+	nstool::print("      MemoryOffset:   0x{:x}\n", mHdr.getTextSegmentInfo().memory_layout.offset);
+	nstool::print("      MemorySize:     0x{:x}\n", mHdr.getTextSegmentInfo().memory_layout.size);
 	if (mHdr.getTextSegmentInfo().is_hashed && mCliOutputMode.show_extended_info)
 	{
-		fmt::print("      Hash:           {:s}\n", tc::cli::FormatUtil::formatBytesAsString(mHdr.getTextSegmentInfo().hash.data(), mHdr.getTextSegmentInfo().hash.size(), false, ""));
+		nstool::print("      Hash:           {:s}\n", tc::cli::FormatUtil::formatBytesAsString(mHdr.getTextSegmentInfo().hash.data(), mHdr.getTextSegmentInfo().hash.size(), false, ""));
 	}
-	fmt::print("    .ro:\n");
-	fmt::print("      MemoryOffset:   0x{:x}\n", mHdr.getRoSegmentInfo().memory_layout.offset);
-	fmt::print("      MemorySize:     0x{:x}\n", mHdr.getRoSegmentInfo().memory_layout.size);
+	nstool::print("    .ro:\n");
+	nstool::print("      MemoryOffset:   0x{:x}\n", mHdr.getRoSegmentInfo().memory_layout.offset);
+	nstool::print("      MemorySize:     0x{:x}\n", mHdr.getRoSegmentInfo().memory_layout.size);
 	if (mHdr.getRoSegmentInfo().is_hashed && mCliOutputMode.show_extended_info)
 	{
-		fmt::print("      Hash:           {:s}\n", tc::cli::FormatUtil::formatBytesAsString(mHdr.getRoSegmentInfo().hash.data(), mHdr.getRoSegmentInfo().hash.size(), false, ""));
+		nstool::print("      Hash:           {:s}\n", tc::cli::FormatUtil::formatBytesAsString(mHdr.getRoSegmentInfo().hash.data(), mHdr.getRoSegmentInfo().hash.size(), false, ""));
 	}
 	if (mCliOutputMode.show_extended_info)
 	{
-		fmt::print("    .api_info:\n");
-		fmt::print("      MemoryOffset:   0x{:x}\n", mHdr.getRoEmbeddedInfo().offset);
-		fmt::print("      MemorySize:     0x{:x}\n", mHdr.getRoEmbeddedInfo().size);
-		fmt::print("    .dynstr:\n");
-		fmt::print("      MemoryOffset:   0x{:x}\n", mHdr.getRoDynStrInfo().offset);
-		fmt::print("      MemorySize:     0x{:x}\n", mHdr.getRoDynStrInfo().size);
-		fmt::print("    .dynsym:\n");
-		fmt::print("      MemoryOffset:   0x{:x}\n", mHdr.getRoDynSymInfo().offset);
-		fmt::print("      MemorySize:     0x{:x}\n", mHdr.getRoDynSymInfo().size);
+		nstool::print("    .api_info:\n");
+		nstool::print("      MemoryOffset:   0x{:x}\n", mHdr.getRoEmbeddedInfo().offset);
+		nstool::print("      MemorySize:     0x{:x}\n", mHdr.getRoEmbeddedInfo().size);
+		nstool::print("    .dynstr:\n");
+		nstool::print("      MemoryOffset:   0x{:x}\n", mHdr.getRoDynStrInfo().offset);
+		nstool::print("      MemorySize:     0x{:x}\n", mHdr.getRoDynStrInfo().size);
+		nstool::print("    .dynsym:\n");
+		nstool::print("      MemoryOffset:   0x{:x}\n", mHdr.getRoDynSymInfo().offset);
+		nstool::print("      MemorySize:     0x{:x}\n", mHdr.getRoDynSymInfo().size);
 	}
 	
-	fmt::print("    .data:\n");
-	fmt::print("      MemoryOffset:   0x{:x}\n", mHdr.getDataSegmentInfo().memory_layout.offset);
-	fmt::print("      MemorySize:     0x{:x}\n", mHdr.getDataSegmentInfo().memory_layout.size);
+	nstool::print("    .data:\n");
+	nstool::print("      MemoryOffset:   0x{:x}\n", mHdr.getDataSegmentInfo().memory_layout.offset);
+	nstool::print("      MemorySize:     0x{:x}\n", mHdr.getDataSegmentInfo().memory_layout.size);
 	if (mHdr.getDataSegmentInfo().is_hashed && mCliOutputMode.show_extended_info)
 	{
-		fmt::print("      Hash:           {:s}\n", tc::cli::FormatUtil::formatBytesAsString(mHdr.getDataSegmentInfo().hash.data(), mHdr.getDataSegmentInfo().hash.size(), false, ""));
+		nstool::print("      Hash:           {:s}\n", tc::cli::FormatUtil::formatBytesAsString(mHdr.getDataSegmentInfo().hash.data(), mHdr.getDataSegmentInfo().hash.size(), false, ""));
 	}
-	fmt::print("    .bss:\n");
-	fmt::print("      MemorySize:     0x{:x}\n", mHdr.getBssSize());
+	nstool::print("    .bss:\n");
+	nstool::print("      MemorySize:     0x{:x}\n", mHdr.getBssSize());
 }
 
 void nstool::NsoProcess::processRoMeta()
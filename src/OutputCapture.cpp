@@ -0,0 +1,67 @@
+#include "OutputCapture.h"
+
+#include <cstdio>
+#include <algorithm>
+
+namespace {
+
+// innermost capture of each thread
+thread_local nstool::OutputCapture* gThreadCapture = nullptr;
+
+}
+
+nstool::OutputCapture::OutputCapture() :
+	mOutput(),
+	mRecords(),
+	mOuterCapture(gThreadCapture)
+{
+	gThreadCapture = this;
+}
+
+nstool::OutputCapture::~OutputCapture()
+{
+	gThreadCapture = mOuterCapture;
+}
+
+const std::string& nstool::OutputCapture::getOutput() const
+{
+	return mOutput;
+}
+
+const std::vector<std::string>& nstool::OutputCapture::getRecords() const
+{
+	return mRecords;
+}
+
+void nstool::OutputCapture::write(const std::string& str)
+{
+	if (gThreadCapture != nullptr)
+	{
+		gThreadCapture->mOutput += str;
+	}
+	else
+	{
+		fwrite(str.data(), 1, str.size(), stdout);
+	}
+}
+
+void nstool::OutputCapture::addRecord(const std::vector<std::string>& fields)
+{
+	if (gThreadCapture != nullptr)
+	{
+		gThreadCapture->mRecords.push_back(formatRecord(fields));
+	}
+}
+
+std::string nstool::OutputCapture::formatRecord(const std::vector<std::string>& fields)
+{
+	std::string record;
+	for (size_t i = 0; i < fields.size(); i++)
+	{
+		std::string field = fields[i];
+		std::replace_if(field.begin(), field.end(), [](char c) { return c == '\t' || c == '\r' || c == '\n'; }, ' ');
+		record += (i == 0 ? "" : "\t") + field;
+	}
+
+	return record;
+}
@@ -0,0 +1,44 @@
+#pragma once
+#include "types.h"
+
+namespace nstool {
+
+// Console output written with nstool::print() goes to stdout, unless an OutputCapture exists on the calling thread, in which case it is appended to that capture.
+// This lets the output of inputs processed in parallel be collected per input and printed whole, instead of interleaved.
+class OutputCapture
+{
+public:
+	// captures the output of the calling thread until destroyed, captures on the same thread nest (the innermost one receives the output)
+	OutputCapture();
+	~OutputCapture();
+
+	const std::string& getOutput() const;
+
+	// machine readable results added with addRecord(), one line of tab separated fields each (without the line break)
+	const std::vector<std::string>& getRecords() const;
+
+	// write str to the innermost capture of the calling thread, or stdout if there is none
+	static void write(const std::string& str);
+
+	// add a record (e.g. {"file", <virtual path>}) to the innermost capture of the calling thread, it is dropped if there is none as records are only read by callers that capture
+	static void addRecord(const std::vector<std::string>& fields);
+
+	// join fields with tabs, tabs and line breaks within a field are replaced with spaces
+	static std::string formatRecord(const std::vector<std::string>& fields);
+private:
+	OutputCapture(const OutputCapture&) = delete;
+	OutputCapture& operator=(const OutputCapture&) = delete;
+
+	std::string mOutput;
+	std::vector<std::string> mRecords;
+	OutputCapture* mOuterCapture;
+};
+
+// used in place of fmt::print() for all output made while processing an input
+template <typename S, typename... Args>
+inline void print(const S& format_str, const Args&... args)
+{
+	OutputCapture::write(fmt::format(format_str, args...));
+}
+
+}
@@ -11,6 +11,8 @@
 nstool::PfsProcess::PfsProcess() :
 	mModuleName("nstool::PfsProcess"),
 	mFile(),
+	mFileFactory(),
+	mFilePath(),
 	mCliOutputMode(true, false, false, false),
 	mVerify(false),
 	mPfs(),
@@ -65,6 +67,27 @@ void nstool::PfsProcess::process()
 	mFileSystem = std::make_shared<tc::io::VirtualFileSystem>(tc::io::VirtualFileSystem(pie::hac::PartitionFsSnapshotGenerator(mFile, mVerify ? pie::hac::PartitionFsSnapshotGenerator::ValidationMode_Warn : pie::hac::PartitionFsSnapshotGenerator::ValidationMode_None)));
 	mFsProcess.setInputFileSystem(mFileSystem);
 
+	FileOffsetMap file_offsets;
+	for (auto itr = mPfs.getFileList().begin(); itr != mPfs.getFileList().end(); itr++)
+	{
+		file_offsets[(tc::io::Path("/") + itr->name).to_string()] = itr->offset;
+	}
+	mFsProcess.setFileOffsets(file_offsets);
+
+	// file data is stored as is in the input file, unless verification requires it to be read back
+	if (mFilePath.isSet() && mVerify == false)
+	{
+		mFsProcess.setRawInputFile(mFilePath.get());
+	}
+	if (mFileFactory != nullptr)
+	{
+		// snapshot validation warnings were already shown for mFileSystem, so these copies are created without validation
+		StreamFactory file_factory = mFileFactory;
+		mFsProcess.setInputFileSystemFactory([file_factory]() -> std::shared_ptr<tc::io::IFileSystem> {
+			return std::make_shared<tc::io::VirtualFileSystem>(tc::io::VirtualFileSystem(pie::hac::PartitionFsSnapshotGenerator(file_factory(), pie::hac::PartitionFsSnapshotGenerator::ValidationMode_None)));
+		});
+	}
+
 	// set properties for FsProcess
 	mFsProcess.setFsProperties({
 		fmt::format("Type:        {:s}", pie::hac::PartitionFsUtil::getFsTypeAsString(mPfs.getFsType())), 
@@ -79,6 +102,16 @@ void nstool::PfsProcess::setInputFile(const std::shared_ptr<tc::io::IStream>& fi
 	mFile = file;
 }
 
+void nstool::PfsProcess::setInputFileFactory(const StreamFactory& file_factory)
+{
+	mFileFactory = file_factory;
+}
+
+void nstool::PfsProcess::setInputFilePath(const tc::io::Path& file_path)
+{
+	mFilePath = file_path;
+}
+
 void nstool::PfsProcess::setCliOutputMode(CliOutputMode type)
 {
 	mCliOutputMode = type;
@@ -105,6 +138,11 @@ void nstool::PfsProcess::setExtractJobs(const std::vector<nstool::ExtractJob>& e
 	mFsProcess.setExtractJobs(extract_jobs);
 }
 
+void nstool::PfsProcess::setExtractOptions(const nstool::ExtractOptions& extract_options)
+{
+	mFsProcess.setExtractOptions(extract_options);
+}
+
 const pie::hac::PartitionFsHeader& nstool::PfsProcess::getPfsHeader() const
 {
 	return mPfs;
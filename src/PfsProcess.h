@@ -15,6 +15,8 @@ public:
 
 	// generic
 	void setInputFile(const std::shared_ptr<tc::io::IStream>& file);
+	void setInputFileFactory(const StreamFactory& file_factory);
+	void setInputFilePath(const tc::io::Path& file_path);
 	void setCliOutputMode(CliOutputMode type);
 	void setVerifyMode(bool verify);
 
@@ -22,17 +24,18 @@ public:
 	void setShowFsTree(bool show_fs_tree);
 	void setFsRootLabel(const std::string& root_label);
 	void setExtractJobs(const std::vector<nstool::ExtractJob>& extract_jobs);
+	void setExtractOptions(const nstool::ExtractOptions& extract_options);
 
 	// post process() get PFS/FS out
 	const pie::hac::PartitionFsHeader& getPfsHeader() const;
 	const std::shared_ptr<tc::io::IFileSystem>& getFileSystem() const;
 
 private:
-	static const size_t kCacheSize = 0x10000;
-
 	std::string mModuleName;
 
 	std::shared_ptr<tc::io::IStream> mFile;
+	StreamFactory mFileFactory;
+	tc::Optional<tc::io::Path> mFilePath;
 	CliOutputMode mCliOutputMode;
 	bool mVerify;
 
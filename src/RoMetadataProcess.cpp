@@ -1,4 +1,5 @@
 #include "RoMetadataProcess.h"
+#include "OutputCapture.h"
 
 #include <sstream>
 #include <iostream>
@@ -153,51 +154,51 @@ void nstool::RoMetadataProcess::displayRoMetaData()
 	
 	if (api_num > 0 && (mListApi || mCliOutputMode.show_extended_info))
 	{
-		fmt::print("[SDK API List]\n");
+		nstool::print("[SDK API List]\n");
 		if (mSdkVerApiList.size() > 0)
 		{
-			fmt::print("  Sdk Revision: {:s}\n", mSdkVerApiList[0].getModuleName());
+			nstool::print("  Sdk Revision: {:s}\n", mSdkVerApiList[0].getModuleName());
 		}
 		if (mPublicApiList.size() > 0)
 		{
-			fmt::print("  Public APIs:\n");
+			nstool::print("  Public APIs:\n");
 			for (size_t i = 0; i < mPublicApiList.size(); i++)
 			{
-				fmt::print("    {:s} (vender: {:s})\n", mPublicApiList[i].getModuleName(), mPublicApiList[i].getVenderName());
+				nstool::print("    {:s} (vender: {:s})\n", mPublicApiList[i].getModuleName(), mPublicApiList[i].getVenderName());
 			}
 		}
 		if (mDebugApiList.size() > 0)
 		{
-			fmt::print("  Debug APIs:\n");
+			nstool::print("  Debug APIs:\n");
 			for (size_t i = 0; i < mDebugApiList.size(); i++)
 			{
-				fmt::print("    {:s} (vender: {:s})\n", mDebugApiList[i].getModuleName(), mDebugApiList[i].getVenderName());
+				nstool::print("    {:s} (vender: {:s})\n", mDebugApiList[i].getModuleName(), mDebugApiList[i].getVenderName());
 			}
 		}
 		if (mPrivateApiList.size() > 0)
 		{
-			fmt::print("  Private APIs:\n");
+			nstool::print("  Private APIs:\n");
 			for (size_t i = 0; i < mPrivateApiList.size(); i++)
 			{
-				fmt::print("    {:s} (vender: {:s})\n", mPrivateApiList[i].getModuleName(), mPrivateApiList[i].getVenderName());
+				nstool::print("    {:s} (vender: {:s})\n", mPrivateApiList[i].getModuleName(), mPrivateApiList[i].getVenderName());
 			}
 		}
 		if (mGuidelineApiList.size() > 0)
 		{
-			fmt::print("  Guideline APIs:\n");
+			nstool::print("  Guideline APIs:\n");
 			for (size_t i = 0; i < mGuidelineApiList.size(); i++)
 			{
-				fmt::print("    {:s} (vender: {:s})\n", mGuidelineApiList[i].getModuleName(), mGuidelineApiList[i].getVenderName());
+				nstool::print("    {:s} (vender: {:s})\n", mGuidelineApiList[i].getModuleName(), mGuidelineApiList[i].getVenderName());
 			}
 		}
 	}
 	if (mSymbolList.getSymbolList().size() > 0 && (mListSymbols || mCliOutputMode.show_extended_info))
 	{
-		fmt::print("[Symbol List]\n");
+		nstool::print("[Symbol List]\n");
 		for (size_t i = 0; i < mSymbolList.getSymbolList().size(); i++)
 		{
 			const ElfSymbolParser::sElfSymbol& symbol = mSymbolList.getSymbolList()[i];
-			fmt::print("  {:s}  [SHN={:s} ({:04x})][STT={:s}][STB={:s}]\n", symbol.name, getSectionIndexStr(symbol.shn_index), symbol.shn_index, getSymbolTypeStr(symbol.symbol_type), getSymbolBindingStr(symbol.symbol_binding));
+			nstool::print("  {:s}  [SHN={:s} ({:04x})][STT={:s}][STB={:s}]\n", symbol.name, getSectionIndexStr(symbol.shn_index), symbol.shn_index, getSymbolTypeStr(symbol.symbol_type), getSymbolBindingStr(symbol.symbol_binding));
 		}
 	}
 }
@@ -1,4 +1,5 @@
 #include "RomfsProcess.h"
+#include "OutputCapture.h"
 #include "util.h"
 
 #include <tc/io/VirtualFileSystem.h>
@@ -8,6 +9,8 @@
 nstool::RomfsProcess::RomfsProcess() :
 	mModuleName("nstool::RomfsProcess"),
 	mFile(),
+	mFileFactory(),
+	mFilePath(),
 	mCliOutputMode(true, false, false, false),
 	mVerify(false),
 	mDirNum(0),
@@ -46,21 +49,21 @@ void nstool::RomfsProcess::process()
 	}
 
 	/*
-	fmt::print("RomFsHeader:\n");
-	fmt::print(" > header_size = 0x{:04x}\n", mRomfsHeader.header_size.unwrap());
-	fmt::print(" > dir_hash_bucket\n");
-	fmt::print("   > offset =    0x{:04x}\n", mRomfsHeader.dir_hash_bucket.offset.unwrap());
-	fmt::print("   > size =      0x{:04x}\n", mRomfsHeader.dir_hash_bucket.size.unwrap());
-	fmt::print(" > dir_entry\n");
-	fmt::print("   > offset =    0x{:04x}\n", mRomfsHeader.dir_entry.offset.unwrap());
-	fmt::print("   > size =      0x{:04x}\n", mRomfsHeader.dir_entry.size.unwrap());
-	fmt::print(" > file_hash_bucket\n");
-	fmt::print("   > offset =    0x{:04x}\n", mRomfsHeader.file_hash_bucket.offset.unwrap())
-	fmt::print("   > size =      0x{:04x}\n", mRomfsHeader.file_hash_bucket.size.unwrap());
-	fmt::print(" > file_entry\n");
-	fmt::print("   > offset =    0x{:04x}\n", mRomfsHeader.file_entry.offset.unwrap());
-	fmt::print("   > size =      0x{:04x}\n", mRomfsHeader.file_entry.size.unwrap());
-	fmt::print(" > data_offset = 0x{:04x}\n", mRomfsHeader.data_offset.unwrap());
+	nstool::print("RomFsHeader:\n");
+	nstool::print(" > header_size = 0x{:04x}\n", mRomfsHeader.header_size.unwrap());
+	nstool::print(" > dir_hash_bucket\n");
+	nstool::print("   > offset =    0x{:04x}\n", mRomfsHeader.dir_hash_bucket.offset.unwrap());
+	nstool::print("   > size =      0x{:04x}\n", mRomfsHeader.dir_hash_bucket.size.unwrap());
+	nstool::print(" > dir_entry\n");
+	nstool::print("   > offset =    0x{:04x}\n", mRomfsHeader.dir_entry.offset.unwrap());
+	nstool::print("   > size =      0x{:04x}\n", mRomfsHeader.dir_entry.size.unwrap());
+	nstool::print(" > file_hash_bucket\n");
+	nstool::print("   > offset =    0x{:04x}\n", mRomfsHeader.file_hash_bucket.offset.unwrap())
+	nstool::print("   > size =      0x{:04x}\n", mRomfsHeader.file_hash_bucket.size.unwrap());
+	nstool::print(" > file_entry\n");
+	nstool::print("   > offset =    0x{:04x}\n", mRomfsHeader.file_entry.offset.unwrap());
+	nstool::print("   > size =      0x{:04x}\n", mRomfsHeader.file_entry.size.unwrap());
+	nstool::print(" > data_offset = 0x{:04x}\n", mRomfsHeader.data_offset.unwrap());
 	*/
 
 	// get dir entry ptr
@@ -111,6 +114,23 @@ void nstool::RomfsProcess::process()
 	mFileSystem = std::make_shared<tc::io::VirtualFileSystem>(tc::io::VirtualFileSystem(pie::hac::RomFsSnapshotGenerator(mFile)));
 	mFsProcess.setInputFileSystem(mFileSystem);
 
+	FileOffsetMap file_offsets;
+	getRomFsFileOffsets(mFile, tc::io::Path("/"), 0, file_offsets);
+	mFsProcess.setFileOffsets(file_offsets);
+
+	// file data is stored as is in the input file
+	if (mFilePath.isSet())
+	{
+		mFsProcess.setRawInputFile(mFilePath.get());
+	}
+	if (mFileFactory != nullptr)
+	{
+		StreamFactory file_factory = mFileFactory;
+		mFsProcess.setInputFileSystemFactory([file_factory]() -> std::shared_ptr<tc::io::IFileSystem> {
+			return std::make_shared<tc::io::VirtualFileSystem>(tc::io::VirtualFileSystem(pie::hac::RomFsSnapshotGenerator(file_factory())));
+		});
+	}
+
 	// set properties for FsProcess
 	mFsProcess.setFsProperties({
 		fmt::format("DirNum:      {:d}", mDirNum), 
@@ -126,6 +146,16 @@ void nstool::RomfsProcess::setInputFile(const std::shared_ptr<tc::io::IStream>&
 	mFile = file;
 }
 
+void nstool::RomfsProcess::setInputFileFactory(const StreamFactory& file_factory)
+{
+	mFileFactory = file_factory;
+}
+
+void nstool::RomfsProcess::setInputFilePath(const tc::io::Path& file_path)
+{
+	mFilePath = file_path;
+}
+
 void nstool::RomfsProcess::setCliOutputMode(CliOutputMode type)
 {
 	mCliOutputMode = type;
@@ -147,6 +177,11 @@ void nstool::RomfsProcess::setExtractJobs(const std::vector<nstool::ExtractJob>&
 	mFsProcess.setExtractJobs(extract_jobs);
 }
 
+void nstool::RomfsProcess::setExtractOptions(const nstool::ExtractOptions& extract_options)
+{
+	mFsProcess.setExtractOptions(extract_options);
+}
+
 void nstool::RomfsProcess::setShowFsTree(bool list_fs)
 {
 	mFsProcess.setShowFsTree(list_fs);
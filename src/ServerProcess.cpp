@@ -0,0 +1,393 @@
+#include "ServerProcess.h"
+#include "OutputCapture.h"
+
+#include <tc/ArgumentException.h>
+#include <tc/NotSupportedException.h>
+
+#include <array>
+#include <thread>
+#include <cstring>
+
+#ifndef _WIN32
+#include <cerrno>
+#include <csignal>
+#include <unistd.h>
+#include <sys/types.h>
+#include <sys/stat.h>
+#include <sys/socket.h>
+#include <sys/un.h>
+#endif
+
+nstool::ServerProcess::ServerProcess() :
+	mModuleName("nstool::ServerProcess"),
+	mSocketPath(),
+	mInputFileOpener(),
+	mRequestHandler(),
+	mInputCacheMutex(),
+	mInputCache(),
+	mConnectionMutex(),
+	mConnectionClosed(),
+	mConnectionNum(0)
+{
+}
+
+void nstool::ServerProcess::setSocketPath(const tc::io::Path& path)
+{
+	mSocketPath = path;
+}
+
+void nstool::ServerProcess::setInputFileOpener(const InputFileOpener& opener)
+{
+	mInputFileOpener = opener;
+}
+
+void nstool::ServerProcess::setRequestHandler(const RequestHandler& handler)
+{
+	mRequestHandler = handler;
+}
+
+#ifdef _WIN32
+
+void nstool::ServerProcess::process()
+{
+	throw tc::NotSupportedException(mModuleName, "Server mode is not supported on this platform.");
+}
+
+int nstool::ServerProcess::openListenSocket()
+{
+	return -1;
+}
+
+void nstool::ServerProcess::handleConnection(int fd)
+{
+}
+
+nstool::StreamFactory nstool::ServerProcess::getInputFileFactory(const tc::io::Path& path)
+{
+	return mInputFileOpener(path);
+}
+
+#else
+
+void nstool::ServerProcess::process()
+{
+	if (mSocketPath.isNull())
+	{
+		throw tc::Exception(mModuleName, "No socket path set.");
+	}
+	if (mInputFileOpener == nullptr || mRequestHandler == nullptr)
+	{
+		throw tc::Exception(mModuleName, "No request handler set.");
+	}
+
+	// a client closing its connection early must not end the server
+	signal(SIGPIPE, SIG_IGN);
+
+	int listen_fd = openListenSocket();
+
+	fmt::print("Listening on {:s}\n", mSocketPath.get().to_string());
+	fflush(stdout);
+
+	int accept_error = 0;
+	for (;;)
+	{
+		// wait for a connection to close rather than accept more than kMaxConnectionNum
+		{
+			std::unique_lock<std::mutex> lock(mConnectionMutex);
+			mConnectionClosed.wait(lock, [this]() { return mConnectionNum < size_t(kMaxConnectionNum); });
+		}
+
+		int fd = accept(listen_fd, nullptr, nullptr);
+		if (fd < 0)
+		{
+			if (errno == EINTR || errno == ECONNABORTED)
+				continue;
+
+			accept_error = errno;
+			break;
+		}
+
+		{
+			std::lock_guard<std::mutex> lock(mConnectionMutex);
+			mConnectionNum++;
+		}
+		std::thread(&ServerProcess::handleConnection, this, fd).detach();
+	}
+
+	close(listen_fd);
+	unlink(mSocketPath.get().to_string().c_str());
+
+	// connection threads use this object, so they must finish first
+	{
+		std::unique_lock<std::mutex> lock(mConnectionMutex);
+		mConnectionClosed.wait(lock, [this]() { return mConnectionNum == 0; });
+	}
+
+	throw tc::Exception(mModuleName, fmt::format("Failed to accept connection ({:s}).", strerror(accept_error)));
+}
+
+int nstool::ServerProcess::openListenSocket()
+{
+	std::string socket_path = mSocketPath.get().to_string();
+
+	struct sockaddr_un addr;
+	memset(&addr, 0, sizeof(addr));
+	addr.sun_family = AF_UNIX;
+	if (socket_path.size() >= sizeof(addr.sun_path))
+	{
+		throw tc::ArgumentException(mModuleName, "Socket path is too long.");
+	}
+	memcpy(addr.sun_path, socket_path.c_str(), socket_path.size());
+
+	// a socket left by a server that did not exit cleanly is replaced, any other file is not
+	struct stat socket_stat;
+	if (lstat(socket_path.c_str(), &socket_stat) == 0)
+	{
+		if (S_ISSOCK(socket_stat.st_mode) == false)
+		{
+			throw tc::ArgumentException(mModuleName, "Socket path exists and is not a socket.");
+		}
+		unlink(socket_path.c_str());
+	}
+
+	int fd = socket(AF_UNIX, SOCK_STREAM, 0);
+	if (fd < 0)
+	{
+		throw tc::Exception(mModuleName, fmt::format("Failed to create socket ({:s}).", strerror(errno)));
+	}
+
+	// only the user running the server may connect, as requests can read and write any file the server can
+	mode_t old_umask = umask(0077);
+	int bind_result = bind(fd, (const struct sockaddr*)&addr, sizeof(addr));
+	int bind_error = errno;
+	umask(old_umask);
+	if (bind_result != 0)
+	{
+		close(fd);
+		throw tc::Exception(mModuleName, fmt::format("Failed to bind socket ({:s}).", strerror(bind_error)));
+	}
+
+	if (listen(fd, SOMAXCONN) != 0)
+	{
+		int listen_error = errno;
+		close(fd);
+		unlink(socket_path.c_str());
+		throw tc::Exception(mModuleName, fmt::format("Failed to listen on socket ({:s}).", strerror(listen_error)));
+	}
+
+	return fd;
+}
+
+void nstool::ServerProcess::handleConnection(int fd)
+{
+	std::string pending;
+	std::array<char, 0x1000> buffer;
+
+	for (bool connected = true; connected;)
+	{
+		// next request line
+		size_t line_end = pending.find('\n');
+		if (line_end == std::string::npos)
+		{
+			if (pending.size() > size_t(kMaxRequestSize))
+				break;
+
+			ssize_t read_len = recv(fd, buffer.data(), buffer.size(), 0);
+			if (read_len < 0 && errno == EINTR)
+				continue;
+			if (read_len <= 0)
+				break;
+
+			pending.append(buffer.data(), size_t(read_len));
+			continue;
+		}
+
+		std::string line = pending.substr(0, line_end);
+		pending.erase(0, line_end + 1);
+		if (line.empty() == false && line.back() == '\r')
+			line.pop_back();
+		if (line.empty())
+			continue;
+
+		sRequest request;
+		sResponse response;
+		std::string error;
+		if (parseRequest(line, request, error) == false)
+		{
+			response = makeErrorResponse(fmt::format("[{:s} ERROR] {:s}", mModuleName, error));
+		}
+		else
+		{
+			try {
+				response = mRequestHandler(request, getInputFileFactory(request.input_path));
+			} catch (tc::Exception& e) {
+				response = makeErrorResponse(fmt::format("[{0}{1}ERROR] {2}", e.module(), (strlen(e.module()) != 0 ? " ": ""), e.error()));
+			} catch (std::exception& e) {
+				// the connection thread must not end with an exception, that would terminate the server
+				response = makeErrorResponse(fmt::format("[{:s} ERROR] {:s}", mModuleName, e.what()));
+			} catch (...) {
+				response = makeErrorResponse(fmt::format("[{:s} ERROR] Unknown error.", mModuleName));
+			}
+		}
+
+		std::string out = formatResponse(response);
+		for (size_t done = 0; done < out.size();)
+		{
+			ssize_t write_len = send(fd, out.data() + done, out.size() - done, 0);
+			if (write_len < 0 && errno == EINTR)
+				continue;
+			if (write_len <= 0)
+			{
+				connected = false;
+				break;
+			}
+			done += size_t(write_len);
+		}
+	}
+
+	close(fd);
+
+	std::lock_guard<std::mutex> lock(mConnectionMutex);
+	mConnectionNum--;
+	mConnectionClosed.notify_all();
+}
+
+// st_mtim is st_mtimespec on Apple platforms
+static int64_t getModifiedTimeNsec(const struct stat& file_stat)
+{
+#if defined(__APPLE__)
+	return int64_t(file_stat.st_mtimespec.tv_nsec);
+#else
+	return int64_t(file_stat.st_mtim.tv_nsec);
+#endif
+}
+
+nstool::StreamFactory nstool::ServerProcess::getInputFileFactory(const tc::io::Path& path)
+{
+	std::string path_str = path.to_string();
+
+	// a file that was replaced or modified since it was opened is opened again
+	struct stat file_stat;
+	if (stat(path_str.c_str(), &file_stat) != 0)
+	{
+		throw tc::io::FileNotFoundException(mModuleName, "Failed to open input file.");
+	}
+
+	{
+		std::lock_guard<std::mutex> lock(mInputCacheMutex);
+		for (auto itr = mInputCache.begin(); itr != mInputCache.end(); itr++)
+		{
+			if (itr->path != path_str)
+				continue;
+
+			if (itr->device == uint64_t(file_stat.st_dev) && itr->inode == uint64_t(file_stat.st_ino) && itr->size == int64_t(file_stat.st_size) && itr->modified_time == int64_t(file_stat.st_mtime) && itr->modified_time_nsec == getModifiedTimeNsec(file_stat))
+			{
+				mInputCache.splice(mInputCache.begin(), mInputCache, itr);
+				return mInputCache.front().factory;
+			}
+
+			mInputCache.erase(itr);
+			break;
+		}
+	}
+
+	// opened without holding the lock, so a slow open does not hold up other connections
+	sCachedInput input;
+	input.path = path_str;
+	input.device = uint64_t(file_stat.st_dev);
+	input.inode = uint64_t(file_stat.st_ino);
+	input.size = int64_t(file_stat.st_size);
+	input.modified_time = int64_t(file_stat.st_mtime);
+	input.modified_time_nsec = getModifiedTimeNsec(file_stat);
+	input.factory = mInputFileOpener(path);
+
+	std::lock_guard<std::mutex> lock(mInputCacheMutex);
+	mInputCache.push_front(input);
+	if (mInputCache.size() > size_t(kInputCacheNum))
+	{
+		mInputCache.pop_back();
+	}
+
+	return input.factory;
+}
+
+#endif
+
+bool nstool::ServerProcess::parseRequest(const std::string& line, sRequest& request, std::string& error) const
+{
+	std::vector<std::string> fields;
+	for (size_t pos = 0;;)
+	{
+		size_t tab_pos = line.find('\t', pos);
+		fields.push_back(line.substr(pos, tab_pos == std::string::npos ? std::string::npos : tab_pos - pos));
+		if (tab_pos == std::string::npos)
+			break;
+		pos = tab_pos + 1;
+	}
+
+	if (fields.size() < 2 || fields[1].empty())
+	{
+		error = "Request has no input path.";
+		return false;
+	}
+
+	if (fields[0] == "info")
+		request.command = Command_Info;
+	else if (fields[0] == "list")
+		request.command = Command_List;
+	else if (fields[0] == "extract")
+		request.command = Command_Extract;
+	else if (fields[0] == "verify")
+		request.command = Command_Verify;
+	else
+	{
+		error = fmt::format("Unknown command \"{:s}\".", fields[0]);
+		return false;
+	}
+
+	request.input_path = tc::io::Path(fields[1]);
+	request.extract_path = tc::Optional<tc::io::Path>();
+	request.virtual_path = tc::io::Path("/");
+
+	if (request.command == Command_Extract)
+	{
+		if (fields.size() < 3 || fields[2].empty())
+		{
+			error = "Extract request has no extract path.";
+			return false;
+		}
+		request.extract_path = tc::io::Path(fields[2]);
+
+		if (fields.size() >= 4 && fields[3].empty() == false)
+		{
+			request.virtual_path = tc::io::Path(fields[3]);
+		}
+	}
+
+	return true;
+}
+
+std::string nstool::ServerProcess::formatResponse(const sResponse& response) const
+{
+	std::string status = response.status == Status_Ok ? "ok" : (response.status == Status_Warning ? "warning" : "error");
+
+	std::string out = fmt::format("{:s}\t{:s}\t{:d}\t{:d}\n", status, response.filetype, response.records.size(), response.output.size());
+	for (auto itr = response.records.begin(); itr != response.records.end(); itr++)
+	{
+		out += *itr + "\n";
+	}
+	out += response.output;
+
+	return out;
+}
+
+nstool::ServerProcess::sResponse nstool::ServerProcess::makeErrorResponse(const std::string& error) const
+{
+	sResponse response;
+	response.status = Status_Error;
+	response.filetype = "unknown";
+	response.records.push_back(OutputCapture::formatRecord({"error", error}));
+	response.output = error + "\n";
+
+	return response;
+}
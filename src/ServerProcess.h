@@ -0,0 +1,119 @@
+#pragma once
+#include "types.h"
+
+#include <list>
+#include <mutex>
+#include <condition_variable>
+
+namespace nstool {
+
+// Serves requests on a local (Unix domain) socket, so a caller making many requests pays for process startup and key loading once (POSIX only).
+// Each connection is handled on its own thread and may make any number of requests, the input files of recent requests are kept open (see setInputFileOpener()).
+//
+// Request (one line, tab separated): <command>\t<input path>[\t<extract path>[\t<virtual path>]]\n
+//   command is one of info, list, extract, verify (extract requires the extract path, the virtual path defaults to "/")
+// Response: <status>\t<file type>\t<record count>\t<output size>\n, then record count records (one line each), then output size bytes of output
+//   status is ok, warning (processing printed a warning, e.g. a failed signature or hash check for verify) or error
+//   records are tab separated fields, the first field is the record type:
+//     dir\t<virtual path> and file\t<virtual path>   each entry of the filesystem listed by list
+//     warning\t<message>                             each warning, in output order
+//     error\t<message>                               the error, if status is error
+//   the output is what nstool would have printed for the input (for an error it ends with the error message)
+class ServerProcess
+{
+public:
+	enum Command
+	{
+		Command_Info,
+		Command_List,
+		Command_Extract,
+		Command_Verify
+	};
+
+	struct sRequest
+	{
+		Command command;
+		tc::io::Path input_path;
+		tc::Optional<tc::io::Path> extract_path;
+		tc::io::Path virtual_path;
+	};
+
+	enum Status
+	{
+		Status_Ok,
+		Status_Warning,
+		Status_Error
+	};
+
+	struct sResponse
+	{
+		Status status;
+		std::string filetype;
+		std::vector<std::string> records; // formatted with OutputCapture::formatRecord()
+		std::string output;
+	};
+
+	// opens an input file, the returned factory is kept for later requests for the same (unmodified) file
+	// a factory of a memory mapped file must only be used while the file is not truncated, reading a mapped page past the new end raises SIGBUS
+	using InputFileOpener = std::function<StreamFactory(const tc::io::Path& path)>;
+
+	// processes a request, called from the thread of the connection
+	using RequestHandler = std::function<sResponse(const sRequest& request, const StreamFactory& infile_factory)>;
+
+	ServerProcess();
+
+	// runs until the socket fails
+	void process();
+
+	void setSocketPath(const tc::io::Path& path);
+	void setInputFileOpener(const InputFileOpener& opener);
+	void setRequestHandler(const RequestHandler& handler);
+private:
+	// number of input files kept open
+	static const size_t kInputCacheNum = 16;
+
+	// connections beyond this wait to be accepted
+	static const size_t kMaxConnectionNum = 64;
+
+	// longest request line accepted, the connection is closed after a longer one
+	static const size_t kMaxRequestSize = 0x10000;
+
+	std::string mModuleName;
+
+	tc::Optional<tc::io::Path> mSocketPath;
+	InputFileOpener mInputFileOpener;
+	RequestHandler mRequestHandler;
+
+	// a cached input is reused while the file at path is the same file (device and inode) with the same size and modification time (in nanoseconds)
+	struct sCachedInput
+	{
+		std::string path;
+		uint64_t device;
+		uint64_t inode;
+		int64_t size;
+		int64_t modified_time;
+		int64_t modified_time_nsec;
+		StreamFactory factory;
+	};
+
+	// most recently used first
+	std::mutex mInputCacheMutex;
+	std::list<sCachedInput> mInputCache;
+
+	std::mutex mConnectionMutex;
+	std::condition_variable mConnectionClosed;
+	size_t mConnectionNum;
+
+	int openListenSocket();
+	void handleConnection(int fd);
+
+	// parse a request line, returns false (with the reason in error) if it is malformed
+	bool parseRequest(const std::string& line, sRequest& request, std::string& error) const;
+	std::string formatResponse(const sResponse& response) const;
+	sResponse makeErrorResponse(const std::string& error) const;
+
+	// factory for the input file at path, from the cache if the file is unchanged since it was opened
+	StreamFactory getInputFileFactory(const tc::io::Path& path);
+};
+
+}
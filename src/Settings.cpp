@@ -2,6 +2,7 @@
 #include "types.h"
 #include "version.h"
 #include "util.h"
+#include "OutputCapture.h"
 
 #include <tc/cli.h>
 #include <tc/os/Environment.h>
@@ -9,6 +10,11 @@
 #include <tc/io/FileStream.h>
 #include <tc/io/StreamSource.h>
 
+#include <thread>
+#include <sstream>
+#include <iostream>
+#include <algorithm>
+
 #include <pietendo/hac/ContentArchiveUtil.h>
 #include <pietendo/hac/AesKeygen.h>
 #include <pietendo/hac/define/gc.h>
@@ -442,6 +448,69 @@ private:
 	std::vector<std::string> mOptRegex;
 };
 
+class ManifestHashTypeOptionHandler : public tc::cli::OptionParser::IOptionHandler
+{
+public:
+	ManifestHashTypeOptionHandler(uint32_t& param, const std::vector<std::string>& opts) :
+		mParam(param),
+		mOptStrings(opts),
+		mOptRegex()
+	{}
+
+	const std::vector<std::string>& getOptionStrings() const
+	{
+		return mOptStrings;
+	}
+
+	const std::vector<std::string>& getOptionRegexPatterns() const
+	{
+		return mOptRegex;
+	}
+
+	void processOption(const std::string& option, const std::vector<std::string>& params)
+	{
+		if (params.size() != 1)
+		{
+			throw tc::ArgumentOutOfRangeException(fmt::format("Option \"{:s}\" requires a parameter.", option));
+		}
+
+		// comma separated list of hash names
+		uint32_t hash_types = 0;
+		std::stringstream list_stream(params[0]);
+		std::string hash_name;
+		while (std::getline(list_stream, hash_name, ','))
+		{
+			if (hash_name == "sha256")
+			{
+				hash_types |= nstool::ContentHasher::HashType_Sha256;
+			}
+			else if (hash_name == "crc32")
+			{
+				hash_types |= nstool::ContentHasher::HashType_Crc32;
+			}
+			else if (hash_name == "xxh64")
+			{
+				hash_types |= nstool::ContentHasher::HashType_XxHash64;
+			}
+			else
+			{
+				throw tc::ArgumentException(fmt::format("Hash type \"{}\" unrecognised. Try \"sha256\", \"crc32\" or \"xxh64\"", hash_name));
+			}
+		}
+
+		if (hash_types == 0)
+		{
+			throw tc::ArgumentException(fmt::format("Option \"{:s}\" requires at least one hash type.", option));
+		}
+
+		mParam = hash_types;
+	}
+private:
+	uint32_t& mParam;
+	std::vector<std::string> mOptStrings;
+	std::vector<std::string> mOptRegex;
+};
+
 class ExtractDataPathOptionHandler : public tc::cli::OptionParser::IOptionHandler
 {
 public:
@@ -543,8 +612,20 @@ nstool::SettingsInitializer::SettingsInitializer(const std::vector<std::string>&
 {
 	// parse input arguments
 	parse_args(args);
-	if (infile.path.isNull())
+	if (infile.path.isNull() && infile.batch_path_list.empty())
 		throw tc::ArgumentException(mModuleLabel, "No input file was specified.");
+	if (infile.batch_path_list.empty() == false && nca.header_scan)
+		throw tc::ArgumentException(mModuleLabel, "--headerscan takes a single directory or list file.");
+	if (infile.batch_path_list.empty() == false && infile.scan_directory)
+		throw tc::ArgumentException(mModuleLabel, "--scan takes a single directory.");
+	if ((infile.batch_path_list.empty() == false || infile.scan_directory) && (fs.extract_jobs.empty() == false || kip.extract_path.isSet() || aset.icon_extract_path.isSet() || aset.nacp_extract_path.isSet() || fs.manifest_path.isSet()))
+		throw tc::ArgumentException(mModuleLabel, "Files cannot be extracted when more than one input file (or --scan) is specified.");
+	if (opt.server && (infile.batch_path_list.empty() == false || infile.scan_directory || nca.header_scan))
+		throw tc::ArgumentException(mModuleLabel, "--server takes a single socket path.");
+	if (opt.server && (fs.extract_jobs.empty() == false || kip.extract_path.isSet() || aset.icon_extract_path.isSet() || aset.nacp_extract_path.isSet() || fs.manifest_path.isSet()))
+		throw tc::ArgumentException(mModuleLabel, "Files to extract are specified per request with --server.");
+	if (fs.extract_options.max_io_size == 0)
+		throw tc::ArgumentException(mModuleLabel, "--iosize must be larger than 0.");
 
 	// determine CLI output mode
 	opt.cli_output_mode.show_basic_info = true;
@@ -585,8 +666,24 @@ nstool::SettingsInitializer::SettingsInitializer(const std::vector<std::string>&
 		dump_keys();
 	}
 
-	// determine filetype if not manually specified
-	if (infile.filetype == FILE_TYPE_ERROR)
+	// full verification includes the normal verification
+	if (opt.verify_full)
+	{
+		opt.verify = true;
+	}
+
+	// "--threads 0" selects one thread per hardware thread (hardware_concurrency() may also return 0 if it cannot be determined)
+	if (fs.extract_options.thread_count == 0)
+	{
+		fs.extract_options.thread_count = std::thread::hardware_concurrency();
+	}
+	if (fs.extract_options.thread_count == 0)
+	{
+		fs.extract_options.thread_count = 1;
+	}
+
+	// determine filetype if not manually specified (a header scan or scan input is a directory, the server input is a socket, the type of each batch/scanned/requested input is determined when it is processed)
+	if (infile.filetype == FILE_TYPE_ERROR && nca.header_scan == false && infile.scan_directory == false && opt.server == false && infile.batch_path_list.empty())
 	{
 		determine_filetype();
 		if (infile.filetype == FILE_TYPE_ERROR)
@@ -615,8 +712,54 @@ void nstool::SettingsInitializer::parse_args(const std::vector<std::string>& arg
 		}
 	}
 
-	// save input file
-	infile.path = tc::io::Path(args.back());
+	// save input file(s)
+	// every argument after "--" is an input, otherwise the last argument is the only input
+	std::vector<std::string> input_args;
+	size_t option_arg_num;
+	auto input_separator = std::find(args.begin() + 1, args.end(), std::string("--"));
+	if (input_separator != args.end())
+	{
+		input_args = std::vector<std::string>(input_separator + 1, args.end());
+		option_arg_num = size_t(input_separator - args.begin()) - 1;
+	}
+	else
+	{
+		input_args.push_back(args.back());
+		option_arg_num = args.size() - 2;
+	}
+
+	// "@<file>" inputs are list files of input paths, "-" reads input paths from stdin
+	std::vector<std::string> input_paths;
+	bool is_batch_input = input_args.size() > 1;
+	for (auto itr = input_args.begin(); itr != input_args.end(); itr++)
+	{
+		if (*itr == "-")
+		{
+			processListFile(std::cin, input_paths);
+			is_batch_input = true;
+		}
+		else if (itr->size() > 1 && (*itr)[0] == '@')
+		{
+			processListFile(std::make_shared<tc::io::FileStream>(tc::io::FileStream(tc::io::Path(itr->substr(1)), tc::io::FileMode::Open, tc::io::FileAccess::Read)), input_paths);
+			is_batch_input = true;
+		}
+		else
+		{
+			input_paths.push_back(*itr);
+		}
+	}
+
+	if (is_batch_input)
+	{
+		for (auto itr = input_paths.begin(); itr != input_paths.end(); itr++)
+		{
+			infile.batch_path_list.push_back(tc::io::Path(*itr));
+		}
+	}
+	else if (input_paths.empty() == false)
+	{
+		infile.path = tc::io::Path(input_paths.front());
+	}
 
 	// test new option parser
 	tc::cli::OptionParser opts;
@@ -632,7 +775,11 @@ void nstool::SettingsInitializer::parse_args(const std::vector<std::string>& arg
 	opts.registerOptionHandler(std::shared_ptr<FlagOptionHandler>(new FlagOptionHandler(mShowKeydata, { "--showkeys" })));
 	opts.registerOptionHandler(std::shared_ptr<FlagOptionHandler>(new FlagOptionHandler(mVerbose, {"-v", "--verbose"})));
 	opts.registerOptionHandler(std::shared_ptr<FlagOptionHandler>(new FlagOptionHandler(opt.verify, {"-y", "--verify"})));
+	opts.registerOptionHandler(std::shared_ptr<FlagOptionHandler>(new FlagOptionHandler(opt.verify_full, {"--verify-full"})));
+	opts.registerOptionHandler(std::shared_ptr<FlagOptionHandler>(new FlagOptionHandler(opt.mmap_input, {"--mmap"})));
 	opts.registerOptionHandler(std::shared_ptr<FlagOptionHandler>(new FlagOptionHandler(opt.is_dev, {"-d", "--dev"})));
+	opts.registerOptionHandler(std::shared_ptr<FlagOptionHandler>(new FlagOptionHandler(infile.scan_directory, {"--scan"})));
+	opts.registerOptionHandler(std::shared_ptr<FlagOptionHandler>(new FlagOptionHandler(opt.server, {"--server"})));
 
 	// process input file type
 	opts.registerOptionHandler(std::shared_ptr<FileTypeOptionHandler>(new FileTypeOptionHandler(infile.filetype, { "-t", "--type" })));
@@ -653,6 +800,12 @@ void nstool::SettingsInitializer::parse_args(const std::vector<std::string>& arg
 	// fs options
 	opts.registerOptionHandler(std::shared_ptr<FlagOptionHandler>(new FlagOptionHandler(fs.show_fs_tree, { "--fstree", "--listfs" })));
 	opts.registerOptionHandler(std::shared_ptr<ExtractDataPathOptionHandler>(new ExtractDataPathOptionHandler(fs.extract_jobs, { "-x", "--extract" })));
+	opts.registerOptionHandler(std::shared_ptr<SingleParamSizetOptionHandler>(new SingleParamSizetOptionHandler(fs.extract_options.thread_count, { "--threads" })));
+	opts.registerOptionHandler(std::shared_ptr<SingleParamSizetOptionHandler>(new SingleParamSizetOptionHandler(fs.extract_options.max_io_size, { "--iosize" })));
+	opts.registerOptionHandler(std::shared_ptr<FlagOptionHandler>(new FlagOptionHandler(fs.extract_options.sparse_output, { "--sparse" })));
+	opts.registerOptionHandler(std::shared_ptr<FlagOptionHandler>(new FlagOptionHandler(fs.extract_options.resume, { "--resume" })));
+	opts.registerOptionHandler(std::shared_ptr<SingleParamPathOptionHandler>(new SingleParamPathOptionHandler(fs.manifest_path, { "--manifest" })));
+	opts.registerOptionHandler(std::shared_ptr<ManifestHashTypeOptionHandler>(new ManifestHashTypeOptionHandler(fs.manifest_hash_types, { "--manifesthash" })));
 	opts.registerOptionHandler(std::shared_ptr<CustomExtractDataPathOptionHandler>(new CustomExtractDataPathOptionHandler(fs.extract_jobs, { "--fsdir" }, tc::io::Path("/"))));
 
 	// xci options
@@ -668,6 +821,7 @@ void nstool::SettingsInitializer::parse_args(const std::vector<std::string>& arg
 	opts.registerOptionHandler(std::shared_ptr<CustomExtractDataPathOptionHandler>(new CustomExtractDataPathOptionHandler(fs.extract_jobs, { "--part3" }, tc::io::Path("/3/"))));
 
 	opts.registerOptionHandler(std::shared_ptr<SingleParamPathOptionHandler>(new SingleParamPathOptionHandler(nca.base_nca_path, { "--basenca" })));
+	opts.registerOptionHandler(std::shared_ptr<FlagOptionHandler>(new FlagOptionHandler(nca.header_scan, { "--headerscan" })));
 
 	// kip options
 	opts.registerOptionHandler(std::shared_ptr<SingleParamPathOptionHandler>(new SingleParamPathOptionHandler(kip.extract_path, { "--kipdir" })));
@@ -678,14 +832,21 @@ void nstool::SettingsInitializer::parse_args(const std::vector<std::string>& arg
 
 	
 	// process option
-	opts.processOptions(args, 1, args.size() - 2);
+	opts.processOptions(args, 1, option_arg_num);
 }
 
 void nstool::SettingsInitializer::determine_filetype()
 {
-	//fmt::print("infile path = \"{}\"\n", infile.path.get().to_string());
+	infile.filetype = determineFileType(infile.path.get(), opt.keybag);
+}
+
+nstool::Settings::FileType nstool::SettingsInitializer::determineFileType(const tc::io::Path& path, const KeyBag& keybag)
+{
+	//fmt::print("infile path = \"{}\"\n", path.to_string());
 	
-	auto file = tc::io::StreamSource(std::make_shared<tc::io::FileStream>(tc::io::FileStream(infile.path.get(), tc::io::FileMode::Open, tc::io::FileAccess::Read)));
+	FileType filetype = FILE_TYPE_ERROR;
+
+	auto file = tc::io::StreamSource(std::make_shared<tc::io::FileStream>(tc::io::FileStream(path, tc::io::FileMode::Open, tc::io::FileAccess::Read)));
 
 	auto raw_data = file.pullData(0, 0x5000);
 
@@ -698,99 +859,158 @@ void nstool::SettingsInitializer::determine_filetype()
 	if (_ASSERT_FILE_SIZE(sizeof(pie::hac::sGcHeader_Rsa2048Signed))
 	 && _TYPE_PTR(pie::hac::sGcHeader_Rsa2048Signed)->header.st_magic.unwrap() == pie::hac::gc::kGcHeaderStructMagic)
 	{
-		infile.filetype = FILE_TYPE_GAMECARD;
+		filetype = FILE_TYPE_GAMECARD;
 	}
 	// detect "SDK" XCI
 	else if (_ASSERT_FILE_SIZE(sizeof(pie::hac::sSdkGcHeader))
 		&& _TYPE_PTR(pie::hac::sSdkGcHeader)->signed_header.header.st_magic.unwrap() == pie::hac::gc::kGcHeaderStructMagic)
 	{
-		infile.filetype = FILE_TYPE_GAMECARD;
+		filetype = FILE_TYPE_GAMECARD;
 	}
 	// detect PFS0
 	else if (_ASSERT_FILE_SIZE(sizeof(pie::hac::sPfsHeader))
 	      && _TYPE_PTR(pie::hac::sPfsHeader)->st_magic.unwrap() == pie::hac::pfs::kPfsStructMagic)
 	{
-		infile.filetype = FILE_TYPE_PARTITIONFS;
+		filetype = FILE_TYPE_PARTITIONFS;
 	}
 	// detect HFS0
 	else if (_ASSERT_FILE_SIZE(sizeof(pie::hac::sPfsHeader))
 		&& _TYPE_PTR(pie::hac::sPfsHeader)->st_magic.unwrap() == pie::hac::pfs::kHashedPfsStructMagic)
 	{
-		infile.filetype = FILE_TYPE_PARTITIONFS;
+		filetype = FILE_TYPE_PARTITIONFS;
 	}
 	// detect ROMFS
 	else if (_ASSERT_FILE_SIZE(sizeof(pie::hac::sRomfsHeader))
 		&& _TYPE_PTR(pie::hac::sRomfsHeader)->header_size.unwrap() == sizeof(pie::hac::sRomfsHeader)
 		&& _TYPE_PTR(pie::hac::sRomfsHeader)->dir_entry.offset.unwrap() == (_TYPE_PTR(pie::hac::sRomfsHeader)->dir_hash_bucket.offset.unwrap() + _TYPE_PTR(pie::hac::sRomfsHeader)->dir_hash_bucket.size.unwrap()))
 	{
-		infile.filetype = FILE_TYPE_ROMFS;
+		filetype = FILE_TYPE_ROMFS;
 	}
 	// detect NPDM
 	else if (_ASSERT_FILE_SIZE(sizeof(pie::hac::sMetaHeader))
 		&& _TYPE_PTR(pie::hac::sMetaHeader)->st_magic.unwrap() == pie::hac::meta::kMetaStructMagic)
 	{
-		infile.filetype = FILE_TYPE_META;
+		filetype = FILE_TYPE_META;
 	}
 	// detect NSO
 	else if (_ASSERT_FILE_SIZE(sizeof(pie::hac::sNsoHeader))
 		&& _TYPE_PTR(pie::hac::sNsoHeader)->st_magic.unwrap() == pie::hac::nso::kNsoStructMagic)
 	{
-		infile.filetype = FILE_TYPE_NSO;
+		filetype = FILE_TYPE_NSO;
 	}
 	// detect NRO
 	else if (_ASSERT_FILE_SIZE(sizeof(pie::hac::sNroHeader))
 		&& _TYPE_PTR(pie::hac::sNroHeader)->st_magic.unwrap() == pie::hac::nro::kNroStructMagic)
 	{
-		infile.filetype = FILE_TYPE_NRO;
+		filetype = FILE_TYPE_NRO;
 	}
 	// detect INI
 	else if (_ASSERT_FILE_SIZE(sizeof(pie::hac::sIniHeader))
 		&& _TYPE_PTR(pie::hac::sIniHeader)->st_magic.unwrap() == pie::hac::ini::kIniStructMagic)
 	{
-		infile.filetype = FILE_TYPE_INI;
+		filetype = FILE_TYPE_INI;
 	}
 	// detect KIP
 	else if (_ASSERT_FILE_SIZE(sizeof(pie::hac::sKipHeader))
 		&& _TYPE_PTR(pie::hac::sKipHeader)->st_magic.unwrap() == pie::hac::kip::kKipStructMagic)
 	{
-		infile.filetype = FILE_TYPE_KIP;
+		filetype = FILE_TYPE_KIP;
 	}
 	// detect HB ASET
 	else if (_ASSERT_FILE_SIZE(sizeof(pie::hac::sAssetHeader))
 		&& _TYPE_PTR(pie::hac::sAssetHeader)->st_magic.unwrap() == pie::hac::aset::kAssetStructMagic)
 	{
-		infile.filetype = FILE_TYPE_KIP;
+		filetype = FILE_TYPE_KIP;
 	}
 
 	// more complicated tests
 
 	// detect NCA
-	else if (determineValidNcaFromSample(raw_data))
+	else if (determineValidNcaFromSample(raw_data, keybag))
 	{
-		infile.filetype = FILE_TYPE_NCA;
+		filetype = FILE_TYPE_NCA;
 	}
 	// detect Certificate
 	else if (determineValidEsCertFromSample(raw_data))
 	{
-		infile.filetype = FILE_TYPE_ES_CERT;
+		filetype = FILE_TYPE_ES_CERT;
 	}
 	// detect Ticket
 	else if (determineValidEsTikFromSample(raw_data))
 	{
-		infile.filetype = FILE_TYPE_ES_TIK;
+		filetype = FILE_TYPE_ES_TIK;
 	}
 	// detect Ticket
 	else if (determineValidCnmtFromSample(raw_data))
 	{
-		infile.filetype = FILE_TYPE_CNMT;
+		filetype = FILE_TYPE_CNMT;
 	}
 	// detect Ticket
 	else if (determineValidNacpFromSample(raw_data))
 	{
-		infile.filetype = FILE_TYPE_NACP;
+		filetype = FILE_TYPE_NACP;
 	}
 #undef _TYPE_PTR
 #undef _ASSERT_FILE_SIZE
+
+	return filetype;
+}
+
+std::string nstool::SettingsInitializer::getFileTypeAsString(FileType filetype)
+{
+	std::string str;
+	switch (filetype)
+	{
+	case (FILE_TYPE_GAMECARD):
+		str = "xci";
+		break;
+	case (FILE_TYPE_NSP):
+		str = "nsp";
+		break;
+	case (FILE_TYPE_PARTITIONFS):
+		str = "pfs";
+		break;
+	case (FILE_TYPE_ROMFS):
+		str = "romfs";
+		break;
+	case (FILE_TYPE_NCA):
+		str = "nca";
+		break;
+	case (FILE_TYPE_META):
+		str = "meta";
+		break;
+	case (FILE_TYPE_CNMT):
+		str = "cnmt";
+		break;
+	case (FILE_TYPE_NSO):
+		str = "nso";
+		break;
+	case (FILE_TYPE_NRO):
+		str = "nro";
+		break;
+	case (FILE_TYPE_NACP):
+		str = "nacp";
+		break;
+	case (FILE_TYPE_INI):
+		str = "ini";
+		break;
+	case (FILE_TYPE_KIP):
+		str = "kip";
+		break;
+	case (FILE_TYPE_ES_CERT):
+		str = "cert";
+		break;
+	case (FILE_TYPE_ES_TIK):
+		str = "tik";
+		break;
+	case (FILE_TYPE_HB_ASSET):
+		str = "aset";
+		break;
+	default:
+		str = "unknown";
+		break;
+	}
+	return str;
 }
 
 void nstool::SettingsInitializer::usage_text() const
@@ -798,11 +1018,24 @@ void nstool::SettingsInitializer::usage_text() const
 	fmt::print("{:s} v{:d}.{:d}.{:d} (C) {:s}\n", APP_NAME, VER_MAJOR, VER_MINOR, VER_PATCH, AUTHORS);
 	fmt::print("Built: {:s} {:s}\n\n", __TIME__, __DATE__);
 	fmt::print("Usage: {:s} [options... ] <file>\n", BIN_NAME);
+	fmt::print("       {:s} [options... ] -- <file|@list file|-> ...\n", BIN_NAME);
+	fmt::print("       (with several inputs, each path in a list file (or read from stdin with \"-\") is an input, inputs are processed in parallel and extracting is not supported)\n");
+	fmt::print("       {:s} [options... ] --server <socket path>\n", BIN_NAME);
+	fmt::print("       (serves info/list/extract/verify requests on a local socket with the keys loaded once, see nstool_client, POSIX only)\n");
 	fmt::print("\n  General Options:\n");
 	fmt::print("      -d, --dev       Use devkit keyset.\n");
 	fmt::print("      -k, --keyset    Specify keyset file.\n");
 	fmt::print("      -t, --type      Specify input file type. [xci, pfs, romfs, nca, meta, cnmt, nso, nro, ini, kip, nacp, aset, cert, tik]\n");
 	fmt::print("      -y, --verify    Verify file.\n");
+	fmt::print("      --verify-full   Verify file, including every block of every NCA partition hash tree.\n");
+	fmt::print("      --mmap          Memory map the input file. (Default for input files larger than 1GiB on 64bit builds)\n");
+	fmt::print("      --threads       Number of threads used to extract files (and to decrypt NCA partitions), 0 uses all cores. (Default: 1)\n");
+	fmt::print("      --iosize        Maximum size of a single read when extracting files, rounded down to the hash block size (at least 0x1000). (Default: 0x100000)\n");
+	fmt::print("      --sparse        Leave zero filled regions of extracted files as holes instead of writing them.\n");
+	fmt::print("      --resume        Keep a manifest in the extract directory, and skip files that are unchanged since the last extract.\n");
+	fmt::print("      --manifest      Write the size and hash of every extracted file to this file.\n");
+	fmt::print("      --manifesthash  Hashes written to the manifest, comma separated. [sha256, crc32, xxh64] (Default: sha256)\n");
+	fmt::print("      --scan          Input is a directory, detect the type of every file in it (and its subdirectories) and process each without printing its info, printing one line per file with the result.\n");
 	fmt::print("\n  Output Options:\n");
 	fmt::print("      --showkeys      Show keys generated.\n");
 	fmt::print("      --showlayout    Show layout metadata.\n");
@@ -832,6 +1065,8 @@ void nstool::SettingsInitializer::usage_text() const
 	fmt::print("      --part2         Extract partition \"2\" to directory. (Alias for \"-x /2 <out path>\")\n");
 	fmt::print("      --part3         Extract partition \"3\" to directory. (Alias for \"-x /3 <out path>\")\n");
 	fmt::print("      --basenca       Specify base NCA file for update NCA files.\n");
+	fmt::print("    {:s} --headerscan [--threads <n>] <dir|list file>\n", BIN_NAME);
+	fmt::print("      --headerscan    Print one tab separated line per NCA in a directory (or listed in a text file, one path per line), reading only the NCA headers.\n");
 	fmt::print("\n  NSO (Nintendo Shared Object), NRO (Nintendo Relocatable Object)\n");
 	fmt::print("    {:s} [--listapi --listsym] [--insttype <inst. type>] <file>\n", BIN_NAME);
 	fmt::print("      --listapi       Print SDK API List.\n");
@@ -1014,20 +1249,20 @@ void nstool::SettingsInitializer::loadKeyFile(tc::Optional<tc::io::Path>& keyfil
 }
 
 
-bool nstool::SettingsInitializer::determineValidNcaFromSample(const tc::ByteData& sample) const
+bool nstool::SettingsInitializer::determineValidNcaFromSample(const tc::ByteData& sample, const KeyBag& keybag)
 {
 	if (sample.size() < pie::hac::nca::kHeaderSize)
 	{
 		return false;
 	}
 	
-	if (opt.keybag.nca_header_key.isNull())
+	if (keybag.nca_header_key.isNull())
 	{
-		fmt::print("[WARNING] Failed to load NCA Header Key.\n");
+		nstool::print("[WARNING] Failed to load NCA Header Key.\n");
 		return false;
 	}
 
-	pie::hac::detail::aes128_xtskey_t key = opt.keybag.nca_header_key.get();
+	pie::hac::detail::aes128_xtskey_t key = keybag.nca_header_key.get();
 
 	//fmt::print("NCA header key: {} {}\n", tc::cli::FormatUtil::formatBytesAsString(opt.keybag.nca_header_key.get()[0].data(), opt.keybag.nca_header_key.get()[0].size(), true, ""), tc::cli::FormatUtil::formatBytesAsString(opt.keybag.nca_header_key.get()[1].data(), opt.keybag.nca_header_key.get()[1].size(), true, ""));
 
@@ -1054,7 +1289,7 @@ bool nstool::SettingsInitializer::determineValidNcaFromSample(const tc::ByteData
 	return true;
 }
 
-bool nstool::SettingsInitializer::determineValidCnmtFromSample(const tc::ByteData& sample) const
+bool nstool::SettingsInitializer::determineValidCnmtFromSample(const tc::ByteData& sample)
 {
 	if (sample.size() < sizeof(pie::hac::sContentMetaHeader))
 		return false;
@@ -1111,7 +1346,7 @@ bool nstool::SettingsInitializer::determineValidCnmtFromSample(const tc::ByteDat
 	return true;
 }
 
-bool nstool::SettingsInitializer::determineValidNacpFromSample(const tc::ByteData& sample) const
+bool nstool::SettingsInitializer::determineValidNacpFromSample(const tc::ByteData& sample)
 {
 	if (sample.size() != sizeof(pie::hac::sApplicationControlProperty))
 		return false;
@@ -1136,7 +1371,7 @@ bool nstool::SettingsInitializer::determineValidNacpFromSample(const tc::ByteDat
 	return true;
 }
 
-bool nstool::SettingsInitializer::determineValidEsCertFromSample(const tc::ByteData& sample) const
+bool nstool::SettingsInitializer::determineValidEsCertFromSample(const tc::ByteData& sample)
 {
 	pie::hac::es::SignatureBlock sign;
 
@@ -1158,7 +1393,7 @@ bool nstool::SettingsInitializer::determineValidEsCertFromSample(const tc::ByteD
 	return true;
 }
 
-bool nstool::SettingsInitializer::determineValidEsTikFromSample(const tc::ByteData& sample) const
+bool nstool::SettingsInitializer::determineValidEsTikFromSample(const tc::ByteData& sample)
 {
 	pie::hac::es::SignatureBlock sign;
 
@@ -6,9 +6,12 @@
 #include <tc/io.h>
 
 #include "KeyBag.h"
+#include "ContentHasher.h"
 
 namespace nstool {
 
+class BaseNcaSession;
+
 struct Settings
 {
 	enum FileType
@@ -35,13 +38,18 @@ struct Settings
 	{
 		FileType filetype;
 		tc::Optional<tc::io::Path> path;
+		std::vector<tc::io::Path> batch_path_list; // set instead of path when several inputs are given, filetype is then determined per input (unless specified)
+		bool scan_directory; // path is a directory, the type of every file in it is determined and each is processed without output (only a summary is printed)
 	} infile;
 
 	struct Options
 	{
 		CliOutputMode cli_output_mode;
 		bool verify;
+		bool verify_full;
 		bool is_dev;
+		bool mmap_input;
+		bool server; // path is a local socket to serve requests on (see ServerProcess), rather than an input file
 		KeyBag keybag;
 	} opt;
 
@@ -58,6 +66,9 @@ struct Settings
 	{
 		bool show_fs_tree;
 		std::vector<ExtractJob> extract_jobs;
+		ExtractOptions extract_options;
+		tc::Optional<tc::io::Path> manifest_path;
+		uint32_t manifest_hash_types; // ContentHasher::HashType flags
 	} fs;
 
 	// XCI options
@@ -77,6 +88,8 @@ struct Settings
 		tc::Optional<tc::io::Path> part2_extract_path;
 		tc::Optional<tc::io::Path> part3_extract_path;
 		tc::Optional<tc::io::Path> base_nca_path;
+		std::shared_ptr<BaseNcaSession> base_nca_session; // session of base_nca_path shared by every input of a batch/scan/server, so the base NCA is only opened once
+		bool header_scan; // input is a directory or list file of NCAs, only their headers are read
 	} nca;
 
 	// KIP options
@@ -96,10 +109,15 @@ struct Settings
 	{
 		infile.filetype = FILE_TYPE_ERROR;
 		infile.path = tc::Optional<tc::io::Path>();
+		infile.batch_path_list = std::vector<tc::io::Path>();
+		infile.scan_directory = false;
 
 		opt.cli_output_mode = CliOutputMode();
 		opt.verify = false;
+		opt.verify_full = false;
 		opt.is_dev = false;
+		opt.mmap_input = false;
+		opt.server = false;
 		opt.keybag = KeyBag();
 
 		code.list_api = false;
@@ -108,10 +126,15 @@ struct Settings
 
 		fs.show_fs_tree = false;
 		fs.extract_jobs = std::vector<ExtractJob>();
+		fs.extract_options = ExtractOptions();
+		fs.manifest_path = tc::Optional<tc::io::Path>();
+		fs.manifest_hash_types = ContentHasher::HashType_Sha256;
 
 		kip.extract_path = tc::Optional<tc::io::Path>();
 
 		nca.base_nca_path = tc::Optional<tc::io::Path>();
+		nca.base_nca_session = nullptr;
+		nca.header_scan = false;
 
 		aset.icon_extract_path = tc::Optional<tc::io::Path>();
 		aset.nacp_extract_path = tc::Optional<tc::io::Path>();
@@ -122,6 +145,12 @@ class SettingsInitializer : public Settings
 {
 public:
 	SettingsInitializer(const std::vector<std::string>& args);
+
+	// type of the file at path, from its first 0x5000 bytes (keybag is needed to detect NCAs), FILE_TYPE_ERROR if it was undetermined
+	static FileType determineFileType(const tc::io::Path& path, const KeyBag& keybag);
+
+	// name of filetype as accepted by "-t", "unknown" for FILE_TYPE_ERROR
+	static std::string getFileTypeAsString(FileType filetype);
 private:
 	void parse_args(const std::vector<std::string>& args);
 	void determine_filetype();
@@ -145,11 +174,11 @@ private:
 
 	void loadKeyFile(tc::Optional<tc::io::Path>& keyfile_path, const std::string& keyfile_name, const std::string& cli_hint);
 
-	bool determineValidNcaFromSample(const tc::ByteData& raw_data) const;
-	bool determineValidEsCertFromSample(const tc::ByteData& raw_data) const;
-	bool determineValidEsTikFromSample(const tc::ByteData& raw_data) const;
-	bool determineValidCnmtFromSample(const tc::ByteData& raw_data) const;
-	bool determineValidNacpFromSample(const tc::ByteData& raw_data) const;
+	static bool determineValidNcaFromSample(const tc::ByteData& raw_data, const KeyBag& keybag);
+	static bool determineValidEsCertFromSample(const tc::ByteData& raw_data);
+	static bool determineValidEsTikFromSample(const tc::ByteData& raw_data);
+	static bool determineValidCnmtFromSample(const tc::ByteData& raw_data);
+	static bool determineValidNacpFromSample(const tc::ByteData& raw_data);
 };
 
 }
\ No newline at end of file
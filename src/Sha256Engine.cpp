@@ -0,0 +1,582 @@
+#include "Sha256Engine.h"
+
+#include <tc/ArgumentNullException.h>
+#include <tc/ArgumentOutOfRangeException.h>
+#include <tc/NotSupportedException.h>
+
+#include <cstring>
+#include <algorithm>
+
+// select hardware kernels for this target
+#if defined(__x86_64__) || defined(__i386__) || defined(_M_X64) || defined(_M_IX86)
+	#define NSTOOL_SHA256_HAS_SHANI
+	#define NSTOOL_SHA256_HAS_AVX2
+	#if defined(_MSC_VER) && !defined(__clang__)
+		#include <intrin.h>
+		#define NSTOOL_SHANI_TARGET
+		#define NSTOOL_AVX2_TARGET
+	#else
+		#include <cpuid.h>
+		#define NSTOOL_SHANI_TARGET __attribute__((target("sha,sse4.1,ssse3")))
+		#define NSTOOL_AVX2_TARGET __attribute__((target("avx2")))
+	#endif
+	#include <immintrin.h>
+#elif defined(__aarch64__)
+	// clang only allows the crypto intrinsics when they are enabled for the whole translation unit, gcc allows them per function
+	#if defined(__ARM_FEATURE_CRYPTO) || defined(__ARM_FEATURE_SHA2)
+		#define NSTOOL_SHA256_HAS_ARMCE
+		#define NSTOOL_ARMCE_TARGET
+	#elif defined(__GNUC__) && !defined(__clang__)
+		#define NSTOOL_SHA256_HAS_ARMCE
+		#define NSTOOL_ARMCE_TARGET __attribute__((target("+crypto")))
+	#endif
+	#ifdef NSTOOL_SHA256_HAS_ARMCE
+		#include <arm_neon.h>
+		#if defined(__linux__)
+			#include <sys/auxv.h>
+			#include <asm/hwcap.h>
+		#endif
+	#endif
+#endif
+
+namespace {
+
+const uint32_t kSha256InitialState[8] = {
+	0x6a09e667, 0xbb67ae85, 0x3c6ef372, 0xa54ff53a, 0x510e527f, 0x9b05688c, 0x1f83d9ab, 0x5be0cd19
+};
+
+const uint32_t kSha256RoundConstants[64] = {
+	0x428a2f98, 0x71374491, 0xb5c0fbcf, 0xe9b5dba5, 0x3956c25b, 0x59f111f1, 0x923f82a4, 0xab1c5ed5,
+	0xd807aa98, 0x12835b01, 0x243185be, 0x550c7dc3, 0x72be5d74, 0x80deb1fe, 0x9bdc06a7, 0xc19bf174,
+	0xe49b69c1, 0xefbe4786, 0x0fc19dc6, 0x240ca1cc, 0x2de92c6f, 0x4a7484aa, 0x5cb0a9dc, 0x76f988da,
+	0x983e5152, 0xa831c66d, 0xb00327c8, 0xbf597fc7, 0xc6e00bf3, 0xd5a79147, 0x06ca6351, 0x14292967,
+	0x27b70a85, 0x2e1b2138, 0x4d2c6dfc, 0x53380d13, 0x650a7354, 0x766a0abb, 0x81c2c92e, 0x92722c85,
+	0xa2bfe8a1, 0xa81a664b, 0xc24b8b70, 0xc76c51a3, 0xd192e819, 0xd6990624, 0xf40e3585, 0x106aa070,
+	0x19a4c116, 0x1e376c08, 0x2748774c, 0x34b0bcb5, 0x391c0cb3, 0x4ed8aa4a, 0x5b9cca4f, 0x682e6ff3,
+	0x748f82ee, 0x78a5636f, 0x84c87814, 0x8cc70208, 0x90befffa, 0xa4506ceb, 0xbef9a3f7, 0xc67178f2
+};
+
+inline uint32_t readBe32(const byte_t* data)
+{
+	return (uint32_t(data[0]) << 24) | (uint32_t(data[1]) << 16) | (uint32_t(data[2]) << 8) | uint32_t(data[3]);
+}
+
+inline void writeBe32(byte_t* data, uint32_t value)
+{
+	data[0] = byte_t(value >> 24);
+	data[1] = byte_t(value >> 16);
+	data[2] = byte_t(value >> 8);
+	data[3] = byte_t(value);
+}
+
+inline void writeBe64(byte_t* data, uint64_t value)
+{
+	for (size_t i = 0; i < 8; i++)
+	{
+		data[7 - i] = byte_t(value);
+		value >>= 8;
+	}
+}
+
+inline uint32_t rotr32(uint32_t value, int shift)
+{
+	return (value >> shift) | (value << (32 - shift));
+}
+
+// the final one or two blocks of a message: the last (size % 64) bytes, 0x80, zeros, then the message size in bits
+size_t makeFinalBlocks(byte_t* final_blocks, const byte_t* tail, size_t tail_size, uint64_t total_size)
+{
+	size_t final_size = (tail_size + 1 + 8 <= 64) ? 64 : 128;
+	memset(final_blocks, 0, final_size);
+	memcpy(final_blocks, tail, tail_size);
+	final_blocks[tail_size] = 0x80;
+	writeBe64(final_blocks + final_size - 8, total_size * 8);
+	return final_size / 64;
+}
+
+void compressBlocksGeneric(uint32_t* state, const byte_t* data, size_t num_blocks)
+{
+	for (; num_blocks > 0; num_blocks--, data += 64)
+	{
+		uint32_t w[64];
+		for (size_t t = 0; t < 16; t++)
+		{
+			w[t] = readBe32(data + t * 4);
+		}
+		for (size_t t = 16; t < 64; t++)
+		{
+			uint32_t s0 = rotr32(w[t - 15], 7) ^ rotr32(w[t - 15], 18) ^ (w[t - 15] >> 3);
+			uint32_t s1 = rotr32(w[t - 2], 17) ^ rotr32(w[t - 2], 19) ^ (w[t - 2] >> 10);
+			w[t] = w[t - 16] + s0 + w[t - 7] + s1;
+		}
+
+		uint32_t a = state[0], b = state[1], c = state[2], d = state[3], e = state[4], f = state[5], g = state[6], h = state[7];
+		for (size_t t = 0; t < 64; t++)
+		{
+			uint32_t t1 = h + (rotr32(e, 6) ^ rotr32(e, 11) ^ rotr32(e, 25)) + ((e & f) ^ (~e & g)) + kSha256RoundConstants[t] + w[t];
+			uint32_t t2 = (rotr32(a, 2) ^ rotr32(a, 13) ^ rotr32(a, 22)) + ((a & b) ^ (a & c) ^ (b & c));
+			h = g; g = f; f = e; e = d + t1;
+			d = c; c = b; b = a; a = t1 + t2;
+		}
+
+		state[0] += a; state[1] += b; state[2] += c; state[3] += d;
+		state[4] += e; state[5] += f; state[6] += g; state[7] += h;
+	}
+}
+
+#if defined(NSTOOL_SHA256_HAS_SHANI) || defined(NSTOOL_SHA256_HAS_AVX2)
+void getCpuid(uint32_t leaf, uint32_t* regs)
+{
+#if defined(_MSC_VER) && !defined(__clang__)
+	int cpu_info[4];
+	__cpuidex(cpu_info, int(leaf), 0);
+	for (size_t i = 0; i < 4; i++)
+	{
+		regs[i] = uint32_t(cpu_info[i]);
+	}
+#else
+	regs[0] = regs[1] = regs[2] = regs[3] = 0;
+	if (__get_cpuid_max(0, nullptr) >= leaf)
+	{
+		__cpuid_count(leaf, 0, regs[0], regs[1], regs[2], regs[3]);
+	}
+#endif
+}
+#endif
+
+#ifdef NSTOOL_SHA256_HAS_SHANI
+bool isShaNiSupported()
+{
+	uint32_t leaf1[4], leaf7[4];
+	getCpuid(1, leaf1);
+	getCpuid(7, leaf7);
+	bool has_ssse3 = (leaf1[2] & (1 << 9)) != 0;
+	bool has_sse41 = (leaf1[2] & (1 << 19)) != 0;
+	bool has_sha = (leaf7[1] & (1 << 29)) != 0;
+	return has_ssse3 && has_sse41 && has_sha;
+}
+
+NSTOOL_SHANI_TARGET void compressBlocksShaNi(uint32_t* state, const byte_t* data, size_t num_blocks)
+{
+	const __m128i byte_swap_mask = _mm_set_epi64x(0x0c0d0e0f08090a0bULL, 0x0405060700010203ULL);
+
+	// sha256rnds2 works on the state as ABEF and CDGH
+	__m128i tmp = _mm_shuffle_epi32(_mm_loadu_si128((const __m128i*)&state[0]), 0xB1); // CDAB
+	__m128i state1 = _mm_shuffle_epi32(_mm_loadu_si128((const __m128i*)&state[4]), 0x1B); // EFGH
+	__m128i state0 = _mm_alignr_epi8(tmp, state1, 8); // ABEF
+	state1 = _mm_blend_epi16(state1, tmp, 0xF0); // CDGH
+
+	for (; num_blocks > 0; num_blocks--, data += 64)
+	{
+		__m128i abef_save = state0;
+		__m128i cdgh_save = state1;
+
+		// msg[i % 4] holds message words 4i..4i+3
+		__m128i msg[4];
+		for (size_t i = 0; i < 16; i++)
+		{
+			if (i < 4)
+			{
+				msg[i] = _mm_shuffle_epi8(_mm_loadu_si128((const __m128i*)(data + i * 16)), byte_swap_mask);
+			}
+			else
+			{
+				// W[t] = s1(W[t-2]) + W[t-7] + s0(W[t-15]) + W[t-16]
+				__m128i w = _mm_sha256msg1_epu32(msg[i % 4], msg[(i + 1) % 4]);
+				w = _mm_add_epi32(w, _mm_alignr_epi8(msg[(i + 3) % 4], msg[(i + 2) % 4], 4));
+				msg[i % 4] = _mm_sha256msg2_epu32(w, msg[(i + 3) % 4]);
+			}
+
+			__m128i wk = _mm_add_epi32(msg[i % 4], _mm_loadu_si128((const __m128i*)&kSha256RoundConstants[i * 4]));
+			state1 = _mm_sha256rnds2_epu32(state1, state0, wk);
+			state0 = _mm_sha256rnds2_epu32(state0, state1, _mm_shuffle_epi32(wk, 0x0E));
+		}
+
+		state0 = _mm_add_epi32(state0, abef_save);
+		state1 = _mm_add_epi32(state1, cdgh_save);
+	}
+
+	tmp = _mm_shuffle_epi32(state0, 0x1B); // FEBA
+	state1 = _mm_shuffle_epi32(state1, 0xB1); // DCHG
+	_mm_storeu_si128((__m128i*)&state[0], _mm_blend_epi16(tmp, state1, 0xF0)); // DCBA
+	_mm_storeu_si128((__m128i*)&state[4], _mm_alignr_epi8(state1, tmp, 8)); // HGFE
+}
+#endif
+
+#ifdef NSTOOL_SHA256_HAS_AVX2
+bool isAvx2Supported()
+{
+	uint32_t leaf1[4], leaf7[4];
+	getCpuid(1, leaf1);
+	getCpuid(7, leaf7);
+	bool has_osxsave = (leaf1[2] & (1 << 27)) != 0;
+	bool has_avx = (leaf1[2] & (1 << 28)) != 0;
+	bool has_avx2 = (leaf7[1] & (1 << 5)) != 0;
+	if (has_osxsave == false || has_avx == false || has_avx2 == false)
+	{
+		return false;
+	}
+
+	// the OS must also save the upper halves of the ymm registers
+#if defined(_MSC_VER) && !defined(__clang__)
+	uint64_t xcr0 = _xgetbv(0);
+#else
+	uint32_t xcr0_lo, xcr0_hi;
+	__asm__ __volatile__("xgetbv" : "=a"(xcr0_lo), "=d"(xcr0_hi) : "c"(0));
+	uint64_t xcr0 = (uint64_t(xcr0_hi) << 32) | xcr0_lo;
+#endif
+	return (xcr0 & 0x6) == 0x6;
+}
+
+#define NSTOOL_SHA256_ROTR8X(x, n) _mm256_or_si256(_mm256_srli_epi32((x), (n)), _mm256_slli_epi32((x), 32 - (n)))
+
+// hash num_blocks blocks of 8 messages, message i is data[i] and has state states[i*8..i*8+7]
+NSTOOL_AVX2_TARGET void compressBlocksAvx2x8(uint32_t* states, const byte_t* const* data, size_t num_blocks)
+{
+	__m256i s[8];
+	for (size_t j = 0; j < 8; j++)
+	{
+		s[j] = _mm256_set_epi32(int(states[7 * 8 + j]), int(states[6 * 8 + j]), int(states[5 * 8 + j]), int(states[4 * 8 + j]), int(states[3 * 8 + j]), int(states[2 * 8 + j]), int(states[1 * 8 + j]), int(states[0 * 8 + j]));
+	}
+
+	for (size_t block = 0; block < num_blocks; block++)
+	{
+		size_t block_offset = block * 64;
+
+		__m256i w[64];
+		for (size_t t = 0; t < 16; t++)
+		{
+			size_t word_offset = block_offset + t * 4;
+			w[t] = _mm256_set_epi32(int(readBe32(data[7] + word_offset)), int(readBe32(data[6] + word_offset)), int(readBe32(data[5] + word_offset)), int(readBe32(data[4] + word_offset)), int(readBe32(data[3] + word_offset)), int(readBe32(data[2] + word_offset)), int(readBe32(data[1] + word_offset)), int(readBe32(data[0] + word_offset)));
+		}
+		for (size_t t = 16; t < 64; t++)
+		{
+			__m256i s0 = _mm256_xor_si256(_mm256_xor_si256(NSTOOL_SHA256_ROTR8X(w[t - 15], 7), NSTOOL_SHA256_ROTR8X(w[t - 15], 18)), _mm256_srli_epi32(w[t - 15], 3));
+			__m256i s1 = _mm256_xor_si256(_mm256_xor_si256(NSTOOL_SHA256_ROTR8X(w[t - 2], 17), NSTOOL_SHA256_ROTR8X(w[t - 2], 19)), _mm256_srli_epi32(w[t - 2], 10));
+			w[t] = _mm256_add_epi32(_mm256_add_epi32(w[t - 16], s0), _mm256_add_epi32(w[t - 7], s1));
+		}
+
+		__m256i a = s[0], b = s[1], c = s[2], d = s[3], e = s[4], f = s[5], g = s[6], h = s[7];
+		for (size_t t = 0; t < 64; t++)
+		{
+			__m256i big_s1 = _mm256_xor_si256(_mm256_xor_si256(NSTOOL_SHA256_ROTR8X(e, 6), NSTOOL_SHA256_ROTR8X(e, 11)), NSTOOL_SHA256_ROTR8X(e, 25));
+			__m256i ch = _mm256_xor_si256(_mm256_and_si256(e, f), _mm256_andnot_si256(e, g));
+			__m256i t1 = _mm256_add_epi32(_mm256_add_epi32(h, big_s1), _mm256_add_epi32(ch, _mm256_add_epi32(_mm256_set1_epi32(int(kSha256RoundConstants[t])), w[t])));
+			__m256i big_s0 = _mm256_xor_si256(_mm256_xor_si256(NSTOOL_SHA256_ROTR8X(a, 2), NSTOOL_SHA256_ROTR8X(a, 13)), NSTOOL_SHA256_ROTR8X(a, 22));
+			__m256i maj = _mm256_xor_si256(_mm256_xor_si256(_mm256_and_si256(a, b), _mm256_and_si256(a, c)), _mm256_and_si256(b, c));
+			__m256i t2 = _mm256_add_epi32(big_s0, maj);
+			h = g; g = f; f = e; e = _mm256_add_epi32(d, t1);
+			d = c; c = b; b = a; a = _mm256_add_epi32(t1, t2);
+		}
+
+		s[0] = _mm256_add_epi32(s[0], a); s[1] = _mm256_add_epi32(s[1], b); s[2] = _mm256_add_epi32(s[2], c); s[3] = _mm256_add_epi32(s[3], d);
+		s[4] = _mm256_add_epi32(s[4], e); s[5] = _mm256_add_epi32(s[5], f); s[6] = _mm256_add_epi32(s[6], g); s[7] = _mm256_add_epi32(s[7], h);
+	}
+
+	for (size_t j = 0; j < 8; j++)
+	{
+		uint32_t lanes[8];
+		_mm256_storeu_si256((__m256i*)lanes, s[j]);
+		for (size_t i = 0; i < 8; i++)
+		{
+			states[i * 8 + j] = lanes[i];
+		}
+	}
+}
+
+#undef NSTOOL_SHA256_ROTR8X
+
+// hash 8 messages of size bytes each
+void generateHashesAvx2x8(byte_t* const* hashes, const byte_t* const* data, size_t size)
+{
+	uint32_t states[8 * 8];
+	for (size_t i = 0; i < 8; i++)
+	{
+		memcpy(states + i * 8, kSha256InitialState, sizeof(kSha256InitialState));
+	}
+
+	size_t num_blocks = size / 64;
+	compressBlocksAvx2x8(states, data, num_blocks);
+
+	// every message has the same size, so the final blocks line up
+	byte_t final_blocks[8][128];
+	const byte_t* final_data[8];
+	size_t num_final_blocks = 0;
+	for (size_t i = 0; i < 8; i++)
+	{
+		num_final_blocks = makeFinalBlocks(final_blocks[i], data[i] + num_blocks * 64, size % 64, size);
+		final_data[i] = final_blocks[i];
+	}
+	compressBlocksAvx2x8(states, final_data, num_final_blocks);
+
+	for (size_t i = 0; i < 8; i++)
+	{
+		for (size_t j = 0; j < 8; j++)
+		{
+			writeBe32(hashes[i] + j * 4, states[i * 8 + j]);
+		}
+	}
+}
+#endif
+
+#ifdef NSTOOL_SHA256_HAS_ARMCE
+bool isArmCeSupported()
+{
+#if defined(__APPLE__)
+	// every arm64 apple cpu has the crypto extensions
+	return true;
+#elif defined(__linux__)
+	return (getauxval(AT_HWCAP) & HWCAP_SHA2) != 0;
+#elif defined(__ARM_FEATURE_CRYPTO) || defined(__ARM_FEATURE_SHA2)
+	return true;
+#else
+	return false;
+#endif
+}
+
+NSTOOL_ARMCE_TARGET void compressBlocksArmCe(uint32_t* state, const byte_t* data, size_t num_blocks)
+{
+	uint32x4_t state0 = vld1q_u32(&state[0]); // ABCD
+	uint32x4_t state1 = vld1q_u32(&state[4]); // EFGH
+
+	for (; num_blocks > 0; num_blocks--, data += 64)
+	{
+		uint32x4_t abcd_save = state0;
+		uint32x4_t efgh_save = state1;
+
+		// msg[i % 4] holds message words 4i..4i+3
+		uint32x4_t msg[4];
+		for (size_t i = 0; i < 4; i++)
+		{
+			msg[i] = vreinterpretq_u32_u8(vrev32q_u8(vld1q_u8(data + i * 16)));
+		}
+
+		for (size_t i = 0; i < 16; i++)
+		{
+			uint32x4_t wk = vaddq_u32(msg[i % 4], vld1q_u32(&kSha256RoundConstants[i * 4]));
+
+			// the words for 4 rounds later replace the ones consumed here
+			if (i < 12)
+			{
+				msg[i % 4] = vsha256su1q_u32(vsha256su0q_u32(msg[i % 4], msg[(i + 1) % 4]), msg[(i + 2) % 4], msg[(i + 3) % 4]);
+			}
+
+			uint32x4_t abcd = state0;
+			state0 = vsha256hq_u32(state0, state1, wk);
+			state1 = vsha256h2q_u32(state1, abcd, wk);
+		}
+
+		state0 = vaddq_u32(state0, abcd_save);
+		state1 = vaddq_u32(state1, efgh_save);
+	}
+
+	vst1q_u32(&state[0], state0);
+	vst1q_u32(&state[4], state1);
+}
+#endif
+
+}
+
+nstool::Sha256Engine::Sha256Engine() :
+	Sha256Engine(getBestImplementation())
+{
+}
+
+nstool::Sha256Engine::Sha256Engine(Implementation implementation) :
+	mModuleName("nstool::Sha256Engine"),
+	mImplementation(implementation),
+	mState(),
+	mBuffer(),
+	mBufferSize(0),
+	mTotalSize(0)
+{
+	if (isImplementationSupported(mImplementation) == false)
+	{
+		throw tc::NotSupportedException(mModuleName, fmt::format("{:s} is not supported on this CPU.", getImplementationName(mImplementation)));
+	}
+
+	initialize();
+}
+
+void nstool::Sha256Engine::initialize()
+{
+	memcpy(mState.data(), kSha256InitialState, sizeof(kSha256InitialState));
+	mBufferSize = 0;
+	mTotalSize = 0;
+}
+
+void nstool::Sha256Engine::update(const byte_t* data, size_t size)
+{
+	if (data == nullptr && size != 0)
+	{
+		throw tc::ArgumentNullException(mModuleName, "data was null.");
+	}
+
+	mTotalSize += size;
+
+	// complete a buffered block first
+	if (mBufferSize != 0)
+	{
+		size_t copy_len = std::min<size_t>(size, kBlockSize - mBufferSize);
+		memcpy(mBuffer.data() + mBufferSize, data, copy_len);
+		mBufferSize += copy_len;
+		data += copy_len;
+		size -= copy_len;
+
+		if (mBufferSize < kBlockSize)
+		{
+			return;
+		}
+		compressBlocks(mState.data(), mBuffer.data(), 1);
+		mBufferSize = 0;
+	}
+
+	// whole blocks are hashed straight from data
+	size_t num_blocks = size / kBlockSize;
+	compressBlocks(mState.data(), data, num_blocks);
+	data += num_blocks * kBlockSize;
+	size -= num_blocks * kBlockSize;
+
+	memcpy(mBuffer.data(), data, size);
+	mBufferSize = size;
+}
+
+void nstool::Sha256Engine::getHash(byte_t* hash)
+{
+	if (hash == nullptr)
+	{
+		throw tc::ArgumentNullException(mModuleName, "hash was null.");
+	}
+
+	byte_t final_blocks[kBlockSize * 2];
+	size_t num_final_blocks = makeFinalBlocks(final_blocks, mBuffer.data(), mBufferSize, mTotalSize);
+
+	std::array<uint32_t, 8> state = mState;
+	compressBlocks(state.data(), final_blocks, num_final_blocks);
+	for (size_t i = 0; i < state.size(); i++)
+	{
+		writeBe32(hash + i * 4, state[i]);
+	}
+}
+
+void nstool::Sha256Engine::generateHash(byte_t* hash, const byte_t* data, size_t size)
+{
+	initialize();
+	update(data, size);
+	getHash(hash);
+}
+
+void nstool::Sha256Engine::generateBlockHashes(byte_t* hashes, const byte_t* data, size_t size, size_t block_size)
+{
+	if (block_size == 0)
+	{
+		throw tc::ArgumentOutOfRangeException(mModuleName, "block_size was 0.");
+	}
+
+	size_t num_blocks = size / block_size;
+	size_t done_blocks = 0;
+
+#ifdef NSTOOL_SHA256_HAS_AVX2
+	if (mImplementation == Implementation_Avx2)
+	{
+		for (; done_blocks + 8 <= num_blocks; done_blocks += 8)
+		{
+			byte_t* lane_hashes[8];
+			const byte_t* lane_data[8];
+			for (size_t i = 0; i < 8; i++)
+			{
+				lane_hashes[i] = hashes + (done_blocks + i) * kHashSize;
+				lane_data[i] = data + (done_blocks + i) * block_size;
+			}
+			generateHashesAvx2x8(lane_hashes, lane_data, block_size);
+		}
+	}
+#endif
+
+	// the remaining blocks (and a shorter final block) one at a time
+	for (size_t offset = done_blocks * block_size; offset < size; offset += block_size, done_blocks++)
+	{
+		generateHash(hashes + done_blocks * kHashSize, data + offset, std::min<size_t>(block_size, size - offset));
+	}
+}
+
+nstool::Sha256Engine::Implementation nstool::Sha256Engine::getImplementation() const
+{
+	return mImplementation;
+}
+
+nstool::Sha256Engine::Implementation nstool::Sha256Engine::getBestImplementation()
+{
+	static const Implementation kBestImplementation = isImplementationSupported(Implementation_ShaNi) ? Implementation_ShaNi : (isImplementationSupported(Implementation_ArmCe) ? Implementation_ArmCe : (isImplementationSupported(Implementation_Avx2) ? Implementation_Avx2 : Implementation_Generic));
+
+	return kBestImplementation;
+}
+
+bool nstool::Sha256Engine::isImplementationSupported(Implementation implementation)
+{
+	switch (implementation)
+	{
+	case (Implementation_Generic):
+		return true;
+#ifdef NSTOOL_SHA256_HAS_SHANI
+	case (Implementation_ShaNi):
+		return isShaNiSupported();
+#endif
+#ifdef NSTOOL_SHA256_HAS_AVX2
+	case (Implementation_Avx2):
+		return isAvx2Supported();
+#endif
+#ifdef NSTOOL_SHA256_HAS_ARMCE
+	case (Implementation_ArmCe):
+		return isArmCeSupported();
+#endif
+	default:
+		return false;
+	}
+}
+
+std::string nstool::Sha256Engine::getImplementationName(Implementation implementation)
+{
+	switch (implementation)
+	{
+	case (Implementation_ShaNi):
+		return "SHA-NI";
+	case (Implementation_ArmCe):
+		return "ARMv8-CE";
+	case (Implementation_Avx2):
+		return "AVX2 multi-buffer";
+	default:
+		return "Generic";
+	}
+}
+
+void nstool::Sha256Engine::GenerateHash(byte_t* hash, const byte_t* data, size_t size)
+{
+	Sha256Engine engine;
+	engine.generateHash(hash, data, size);
+}
+
+void nstool::Sha256Engine::compressBlocks(uint32_t* state, const byte_t* data, size_t num_blocks) const
+{
+	if (num_blocks == 0)
+	{
+		return;
+	}
+
+	switch (mImplementation)
+	{
+#ifdef NSTOOL_SHA256_HAS_SHANI
+	case (Implementation_ShaNi):
+		compressBlocksShaNi(state, data, num_blocks);
+		break;
+#endif
+#ifdef NSTOOL_SHA256_HAS_ARMCE
+	case (Implementation_ArmCe):
+		compressBlocksArmCe(state, data, num_blocks);
+		break;
+#endif
+	default:
+		compressBlocksGeneric(state, data, num_blocks);
+		break;
+	}
+}
@@ -0,0 +1,62 @@
+#pragma once
+#include "types.h"
+
+#include <array>
+
+namespace nstool {
+
+// SHA-256 with hardware kernels (SHA-NI on x86/x86_64, ARMv8 SHA2 instructions on arm64) selected at runtime.
+// generateBlockHashes() hashes many independent blocks (e.g. a hash layer's data blocks), on CPUs with AVX2 but without SHA instructions it hashes 8 blocks at once in the lanes of AVX2 registers.
+// When no hardware support is available a portable implementation is used.
+class Sha256Engine
+{
+public:
+	static const size_t kHashSize = 32;
+	static const size_t kBlockSize = 64;
+
+	enum Implementation
+	{
+		Implementation_Generic,
+		Implementation_ShaNi,
+		Implementation_ArmCe,
+		Implementation_Avx2 // only generateBlockHashes() benefits, a single message is hashed with the generic implementation
+	};
+
+	Sha256Engine();
+
+	// use implementation instead of the best one available (used to compare implementations), throws tc::NotSupportedException if it is not supported
+	Sha256Engine(Implementation implementation);
+
+	void initialize();
+	void update(const byte_t* data, size_t size);
+	void getHash(byte_t* hash);
+
+	// hash = SHA-256(data)
+	void generateHash(byte_t* hash, const byte_t* data, size_t size);
+
+	// hashes (kHashSize bytes each) of each block_size block of data, the final block is shorter if size is not a multiple of block_size
+	void generateBlockHashes(byte_t* hashes, const byte_t* data, size_t size, size_t block_size);
+
+	Implementation getImplementation() const;
+
+	// fastest implementation supported by this CPU (detected once)
+	static Implementation getBestImplementation();
+	static bool isImplementationSupported(Implementation implementation);
+	static std::string getImplementationName(Implementation implementation);
+
+	// hash = SHA-256(data) with the best implementation
+	static void GenerateHash(byte_t* hash, const byte_t* data, size_t size);
+private:
+	std::string mModuleName;
+
+	Implementation mImplementation;
+
+	std::array<uint32_t, 8> mState;
+	std::array<byte_t, kBlockSize> mBuffer;
+	size_t mBufferSize;
+	uint64_t mTotalSize;
+
+	void compressBlocks(uint32_t* state, const byte_t* data, size_t num_blocks) const;
+};
+
+}
@@ -0,0 +1,329 @@
+#include "SparseStream.h"
+#include "util.h"
+
+#include <tc/io/StreamUtil.h>
+#include <tc/io/IOUtil.h>
+#include <tc/ObjectDisposedException.h>
+#include <tc/NotSupportedException.h>
+#include <tc/ArgumentNullException.h>
+#include <tc/ArgumentOutOfRangeException.h>
+
+#include <cstring>
+#include <algorithm>
+
+nstool::SparseStream::SparseStream() :
+	mModuleName("nstool::SparseStream"),
+	mDataStream(),
+	mPartitionOffset(0),
+	mLength(0),
+	mIsEncrypted(false),
+	mEngine(),
+	mEntries(),
+	mCursor(0),
+	mPosition(0)
+{
+}
+
+nstool::SparseStream::SparseStream(const std::shared_ptr<tc::io::IStream>& nca_stream, int64_t partition_offset, int64_t partition_size, const sSparseInfo& sparse_info) :
+	SparseStream()
+{
+	mPartitionOffset = partition_offset;
+	mLength = partition_size;
+
+	loadTable(nca_stream, sparse_info, nullptr, nullptr);
+}
+
+nstool::SparseStream::SparseStream(const std::shared_ptr<tc::io::IStream>& nca_stream, int64_t partition_offset, int64_t partition_size, const sSparseInfo& sparse_info, const key_t& key, const counter_t& counter) :
+	SparseStream()
+{
+	mPartitionOffset = partition_offset;
+	mLength = partition_size;
+
+	// the table is encrypted with the sparse generation in place of the partition's generation
+	counter_t table_counter = counter;
+	uint32_t generation = uint32_t(sparse_info.generation.unwrap()) << 16;
+	table_counter[4] = byte_t(generation >> 24);
+	table_counter[5] = byte_t(generation >> 16);
+	table_counter[6] = byte_t(generation >> 8);
+	table_counter[7] = byte_t(generation);
+
+	loadTable(nca_stream, sparse_info, &key, &table_counter);
+
+	mIsEncrypted = true;
+	mEngine.initialize(key.data(), key.size(), counter.data(), counter.size());
+}
+
+bool nstool::SparseStream::getRegion(int64_t offset, int64_t& region_end)
+{
+	if (mDataStream == nullptr)
+	{
+		throw tc::ObjectDisposedException(mModuleName+"::getRegion()", "Failed to get region (stream is disposed)");
+	}
+	if (offset < 0 || offset >= mLength)
+	{
+		throw tc::ArgumentOutOfRangeException(mModuleName+"::getRegion()", "offset was outside of the stream.");
+	}
+
+	size_t index = findEntry(offset);
+	bool is_zero = mEntries[index].is_zero;
+
+	// adjacent absent entries are merged when loaded, adjacent present entries are not (their data is not contiguous)
+	size_t next = index + 1;
+	while (next < mEntries.size() && mEntries[next].is_zero == is_zero)
+	{
+		next++;
+	}
+	region_end = (next < mEntries.size()) ? mEntries[next].offset : mLength;
+
+	return is_zero;
+}
+
+bool nstool::SparseStream::canRead() const
+{
+	return mDataStream != nullptr;
+}
+
+bool nstool::SparseStream::canWrite() const
+{
+	return false;
+}
+
+bool nstool::SparseStream::canSeek() const
+{
+	return mDataStream != nullptr;
+}
+
+int64_t nstool::SparseStream::length()
+{
+	if (mDataStream == nullptr)
+	{
+		throw tc::ObjectDisposedException(mModuleName+"::length()", "Failed to get stream length (stream is disposed)");
+	}
+
+	return mLength;
+}
+
+int64_t nstool::SparseStream::position()
+{
+	if (mDataStream == nullptr)
+	{
+		throw tc::ObjectDisposedException(mModuleName+"::position()", "Failed to get stream position (stream is disposed)");
+	}
+
+	return mPosition;
+}
+
+size_t nstool::SparseStream::read(byte_t* ptr, size_t count)
+{
+	if (mDataStream == nullptr)
+	{
+		throw tc::ObjectDisposedException(mModuleName+"::read()", "Failed to read from stream (stream is disposed)");
+	}
+	if (ptr == nullptr)
+	{
+		throw tc::ArgumentNullException(mModuleName+"::read()", "ptr was null.");
+	}
+
+	size_t read_len = tc::io::IOUtil::getReadableCount(mLength, mPosition, count);
+
+	for (size_t done = 0; done < read_len;)
+	{
+		int64_t offset = mPosition + int64_t(done);
+		size_t index = findEntry(offset);
+		const sEntry& entry = mEntries[index];
+
+		int64_t entry_end = (index + 1 < mEntries.size()) ? mEntries[index + 1].offset : mLength;
+		size_t run_len = std::min<size_t>(read_len - done, size_t(entry_end - offset));
+
+		if (entry.is_zero)
+		{
+			memset(ptr + done, 0, run_len);
+		}
+		else
+		{
+			readData(offset, entry.physical_offset + (offset - entry.offset), ptr + done, run_len);
+		}
+
+		done += run_len;
+	}
+
+	mPosition += int64_t(read_len);
+
+	return read_len;
+}
+
+size_t nstool::SparseStream::write(const byte_t* ptr, size_t count)
+{
+	throw tc::NotSupportedException(mModuleName+"::write()", "write() is not supported for SparseStream");
+}
+
+int64_t nstool::SparseStream::seek(int64_t offset, tc::io::SeekOrigin origin)
+{
+	if (mDataStream == nullptr)
+	{
+		throw tc::ObjectDisposedException(mModuleName+"::seek()", "Failed to set stream position (stream is disposed)");
+	}
+
+	mPosition = tc::io::StreamUtil::getSeekResult(offset, origin, mPosition, mLength);
+
+	return mPosition;
+}
+
+void nstool::SparseStream::setLength(int64_t length)
+{
+	throw tc::NotSupportedException(mModuleName+"::setLength()", "setLength() is not supported for SparseStream");
+}
+
+void nstool::SparseStream::flush()
+{
+	if (mDataStream == nullptr)
+	{
+		throw tc::ObjectDisposedException(mModuleName+"::flush()", "Failed to flush stream (stream is disposed)");
+	}
+
+	mDataStream->flush();
+}
+
+void nstool::SparseStream::dispose()
+{
+	mDataStream.reset();
+	mEntries.clear();
+	mCursor = 0;
+	mPosition = 0;
+}
+
+void nstool::SparseStream::loadTable(const std::shared_ptr<tc::io::IStream>& nca_stream, const sSparseInfo& sparse_info, const key_t* key, const counter_t* table_counter)
+{
+	if (nca_stream == nullptr)
+	{
+		throw tc::ArgumentNullException(mModuleName, "nca_stream is null.");
+	}
+	if (nca_stream->canRead() == false || nca_stream->canSeek() == false)
+	{
+		throw tc::InvalidOperationException(mModuleName, "nca_stream must support reading and seeking.");
+	}
+	if (mPartitionOffset < 0 || mLength < 0)
+	{
+		throw tc::ArgumentOutOfRangeException(mModuleName, "Partition geometry was invalid.");
+	}
+
+	// the stored data is followed by the table
+	int64_t physical_offset = sparse_info.physical_offset.unwrap();
+	int64_t table_offset = physical_offset + sparse_info.table_offset.unwrap();
+	size_t table_size = BucketTree::getTableSize(sparse_info.table_header, kEntrySize);
+	if (physical_offset < 0 || sparse_info.table_offset.unwrap() < 0 || sparse_info.table_size.unwrap() < int64_t(table_size) || table_offset + int64_t(table_size) > nca_stream->length())
+	{
+		throw tc::ArgumentOutOfRangeException(mModuleName, "Sparse table was outside of the NCA.");
+	}
+	if (table_offset % int64_t(Aes128CtrEngine::kBlockSize) != 0)
+	{
+		throw tc::ArgumentOutOfRangeException(mModuleName, "Sparse table was not block aligned.");
+	}
+
+	mDataStream = std::make_shared<tc::io::SubStream>(tc::io::SubStream(nca_stream, physical_offset, sparse_info.table_offset.unwrap()));
+
+	tc::ByteData table = tc::ByteData(table_size);
+	readStreamExact(nca_stream, table_offset, table.data(), table.size(), mModuleName+"::read()");
+	if (table_counter != nullptr)
+	{
+		Aes128CtrEngine table_engine;
+		table_engine.initialize(key->data(), key->size(), table_counter->data(), table_counter->size());
+		table_engine.crypt(table.data(), table.data(), table.size(), uint64_t(table_offset) / Aes128CtrEngine::kBlockSize);
+	}
+
+	tc::ByteData entries;
+	int64_t end_offset = 0;
+	BucketTree::readEntries(table.data(), sparse_info.table_header, kEntrySize, entries, end_offset);
+	if (end_offset > mLength)
+	{
+		throw tc::ArgumentOutOfRangeException(mModuleName, "Sparse table was larger than the partition.");
+	}
+
+	mEntries.clear();
+	for (size_t i = 0; i < entries.size() / kEntrySize; i++)
+	{
+		const byte_t* raw = entries.data() + i * kEntrySize;
+		sEntry entry;
+		entry.offset = ((const tc::bn::le64<int64_t>*)(raw + 0x0))->unwrap();
+		entry.physical_offset = ((const tc::bn::le64<int64_t>*)(raw + 0x8))->unwrap();
+		entry.is_zero = ((const tc::bn::le32<uint32_t>*)(raw + 0x10))->unwrap() != 0;
+
+		if ((mEntries.empty() && entry.offset != 0) || (mEntries.empty() == false && entry.offset <= mEntries.back().offset) || entry.offset >= end_offset)
+		{
+			throw tc::ArgumentOutOfRangeException(mModuleName, "Sparse table was corrupt.");
+		}
+		// present data is decrypted from the start of its first block, so it must start block aligned
+		if (entry.is_zero == false && (entry.physical_offset < 0 || (mPartitionOffset + entry.offset) % int64_t(Aes128CtrEngine::kBlockSize) != 0))
+		{
+			throw tc::ArgumentOutOfRangeException(mModuleName, "Sparse table entry was invalid.");
+		}
+
+		if (mEntries.empty() == false && mEntries.back().is_zero && entry.is_zero)
+		{
+			continue;
+		}
+		mEntries.push_back(entry);
+	}
+
+	// the partition beyond the table is absent
+	if (end_offset < mLength && (mEntries.empty() || mEntries.back().is_zero == false))
+	{
+		sEntry entry;
+		entry.offset = end_offset;
+		entry.physical_offset = 0;
+		entry.is_zero = true;
+		mEntries.push_back(entry);
+	}
+}
+
+void nstool::SparseStream::readData(int64_t offset, int64_t physical_offset, byte_t* ptr, size_t count)
+{
+	if (mIsEncrypted == false)
+	{
+		readStreamExact(mDataStream, physical_offset, ptr, count, mModuleName+"::read()");
+		return;
+	}
+
+	const int64_t block_size = int64_t(Aes128CtrEngine::kBlockSize);
+	int64_t nca_offset = mPartitionOffset + offset;
+
+	// an unaligned start is decrypted from a copy of its block, the rest is decrypted in place
+	size_t block_offset = size_t(nca_offset % block_size);
+	if (block_offset != 0)
+	{
+		std::array<byte_t, Aes128CtrEngine::kBlockSize> block;
+		size_t block_len = std::min<size_t>(size_t(block_size), block_offset + count);
+		readStreamExact(mDataStream, physical_offset - int64_t(block_offset), block.data(), block_len, mModuleName+"::read()");
+		mEngine.crypt(block.data(), block.data(), block_len, uint64_t(nca_offset - int64_t(block_offset)) / Aes128CtrEngine::kBlockSize);
+
+		size_t copy_len = block_len - block_offset;
+		memcpy(ptr, block.data() + block_offset, copy_len);
+		ptr += copy_len;
+		count -= copy_len;
+		nca_offset += int64_t(copy_len);
+		physical_offset += int64_t(copy_len);
+	}
+
+	if (count > 0)
+	{
+		readStreamExact(mDataStream, physical_offset, ptr, count, mModuleName+"::read()");
+		mEngine.crypt(ptr, ptr, count, uint64_t(nca_offset) / Aes128CtrEngine::kBlockSize);
+	}
+}
+
+size_t nstool::SparseStream::findEntry(int64_t offset)
+{
+	// sequential reads stay in the last entry or move on to the next one
+	for (size_t i = mCursor; i < mEntries.size() && i <= mCursor + 1; i++)
+	{
+		if (mEntries[i].offset <= offset && (i + 1 == mEntries.size() || offset < mEntries[i + 1].offset))
+		{
+			mCursor = i;
+			return mCursor;
+		}
+	}
+
+	auto itr = std::upper_bound(mEntries.begin(), mEntries.end(), offset, [](int64_t value, const sEntry& entry) { return value < entry.offset; });
+	mCursor = size_t(itr - mEntries.begin()) - 1;
+	return mCursor;
+}
@@ -0,0 +1,88 @@
+#pragma once
+#include "types.h"
+#include "Aes128CtrEngine.h"
+#include "BucketTree.h"
+
+namespace nstool {
+
+// Read-only IStream over a sparse NCA partition, where only some regions of the partition are stored in the NCA.
+// The sparse table maps the partition to the stored (physical) data or to regions that are absent, absent regions are read as zeros without any read or decryption.
+// Present data is decrypted with the partition's normal AES-CTR counter at its partition offset. HashTreeStream skips verifying blocks in absent regions (see getRegion()).
+class SparseStream : public tc::io::IStream
+{
+public:
+	using key_t = std::array<byte_t, Aes128CtrEngine::kKeySize>;
+	using counter_t = std::array<byte_t, Aes128CtrEngine::kBlockSize>;
+
+#pragma pack(push,1)
+	// sparse_info of the NCA FS header
+	struct sSparseInfo
+	{
+		tc::bn::le64<int64_t> table_offset; // relative to physical_offset
+		tc::bn::le64<int64_t> table_size;
+		BucketTree::sHeader table_header;
+		tc::bn::le64<int64_t> physical_offset; // NCA offset of the stored data (the table follows it)
+		tc::bn::le16<uint16_t> generation;
+		std::array<byte_t, 6> reserved;
+	};
+#pragma pack(pop)
+	static_assert(sizeof(sSparseInfo) == 0x30, "sSparseInfo size.");
+
+	SparseStream();
+
+	// sparse partition without encryption, nca_stream is the whole NCA, partition_offset/partition_size are the partition's location before it was made sparse
+	SparseStream(const std::shared_ptr<tc::io::IStream>& nca_stream, int64_t partition_offset, int64_t partition_size, const sSparseInfo& sparse_info);
+
+	// AES-CTR encrypted sparse partition, counter is the partition's counter for NCA offset 0 (the sparse generation replaces its generation for the table)
+	SparseStream(const std::shared_ptr<tc::io::IStream>& nca_stream, int64_t partition_offset, int64_t partition_size, const sSparseInfo& sparse_info, const key_t& key, const counter_t& counter);
+
+	// returns true if offset is in an absent (zero) region, region_end is where the run of absent (or present) regions containing offset ends
+	bool getRegion(int64_t offset, int64_t& region_end);
+
+	bool canRead() const;
+	bool canWrite() const;
+	bool canSeek() const;
+	int64_t length();
+	int64_t position();
+	size_t read(byte_t* ptr, size_t count);
+	size_t write(const byte_t* ptr, size_t count);
+	int64_t seek(int64_t offset, tc::io::SeekOrigin origin);
+	void setLength(int64_t length);
+	void flush();
+	void dispose();
+private:
+	std::string mModuleName;
+
+	static const size_t kEntrySize = 0x14;
+
+	// maps [offset, next entry offset) of the partition to the stored data, or to zeros
+	struct sEntry
+	{
+		int64_t offset;
+		int64_t physical_offset;
+		bool is_zero;
+	};
+
+	std::shared_ptr<tc::io::IStream> mDataStream;
+	int64_t mPartitionOffset;
+	int64_t mLength;
+
+	bool mIsEncrypted;
+	Aes128CtrEngine mEngine;
+
+	std::vector<sEntry> mEntries;
+	size_t mCursor;
+
+	int64_t mPosition;
+
+	// load the sparse table, table_counter is null when the partition is not encrypted
+	void loadTable(const std::shared_ptr<tc::io::IStream>& nca_stream, const sSparseInfo& sparse_info, const key_t* key, const counter_t* table_counter);
+
+	// read count bytes of stored data at physical_offset, which is at offset of the partition
+	void readData(int64_t offset, int64_t physical_offset, byte_t* ptr, size_t count);
+
+	// index of the entry containing offset
+	size_t findEntry(int64_t offset);
+};
+
+}
@@ -0,0 +1,259 @@
+#include "StreamCopyPipeline.h"
+#include "util.h"
+
+#include <algorithm>
+
+// write a block to out_stream, when sparse is set zero filled kSparseBlockSize blocks are skipped with a seek
+static void writeBlockToStream(const std::shared_ptr<tc::io::IStream>& out_stream, const byte_t* data, size_t len, bool sparse)
+{
+	if (sparse == false)
+	{
+		out_stream->write(data, len);
+		return;
+	}
+
+	for (size_t pos = 0; pos < len;)
+	{
+		// measure run of blocks that are either all zero or all contain data
+		size_t block_len = std::min<size_t>(nstool::kSparseBlockSize, len - pos);
+		bool is_hole = nstool::isZeroFilled(data + pos, block_len);
+		size_t run_len = block_len;
+		while (pos + run_len < len)
+		{
+			block_len = std::min<size_t>(nstool::kSparseBlockSize, len - (pos + run_len));
+			if (nstool::isZeroFilled(data + pos + run_len, block_len) != is_hole)
+				break;
+			run_len += block_len;
+		}
+
+		if (is_hole)
+		{
+			out_stream->seek(tc::io::IOUtil::castSizeToInt64(run_len), tc::io::SeekOrigin::Current);
+		}
+		else
+		{
+			out_stream->write(data + pos, run_len);
+		}
+
+		pos += run_len;
+	}
+}
+
+nstool::StreamCopyPipeline::StreamCopyPipeline(const std::string& module_label) :
+	mModuleLabel(module_label),
+	mExtraBlocks(),
+	mWriter(),
+	mStateMutex(),
+	mStateChanged(),
+	mStopRequested(false),
+	mCopyActive(false),
+	mOutStream(),
+	mSparse(false),
+	mObserver(nullptr),
+	mBlockData(),
+	mBlockLen(),
+	mReadCount(0),
+	mWriteCount(0),
+	mReadDone(false),
+	mReadFailed(false),
+	mWriteDone(false),
+	mWriteError()
+{
+}
+
+nstool::StreamCopyPipeline::~StreamCopyPipeline()
+{
+	if (mWriter.joinable())
+	{
+		{
+			std::lock_guard<std::mutex> lock(mStateMutex);
+			mStopRequested = true;
+		}
+		mStateChanged.notify_all();
+		mWriter.join();
+	}
+}
+
+void nstool::StreamCopyPipeline::copy(const std::shared_ptr<tc::io::IStream>& in_stream, const std::shared_ptr<tc::io::IStream>& out_stream, tc::ByteData& cache, bool sparse, const StreamDataObserver& observer, const std::string& source_name)
+{
+	in_stream->seek(0, tc::io::SeekOrigin::Begin);
+	out_stream->seek(0, tc::io::SeekOrigin::Begin);
+
+	int64_t remaining_data = in_stream->length();
+	const int64_t total_data = remaining_data;
+
+	// streams that fit in one block gain nothing from the pipeline, so copy them directly
+	if (remaining_data <= tc::io::IOUtil::castSizeToInt64(cache.size()))
+	{
+		size_t cache_read_len;
+		for (; remaining_data > 0;)
+		{
+			cache_read_len = in_stream->read(cache.data(), cache.size());
+			if (cache_read_len == 0)
+			{
+				throw tc::io::IOException(mModuleLabel, fmt::format("Failed to read from {:s}.", source_name));
+			}
+
+			writeBlockToStream(out_stream, cache.data(), cache_read_len, sparse);
+			if (observer != nullptr)
+			{
+				observer(cache.data(), cache_read_len);
+			}
+
+			remaining_data -= int64_t(cache_read_len);
+		}
+
+		// a trailing hole is only a seek, so the file must be extended to its full length
+		if (sparse)
+		{
+			out_stream->setLength(total_data);
+		}
+		out_stream->flush();
+		return;
+	}
+
+	// the caller's cache is the first block
+	const size_t block_size = cache.size();
+	if (mExtraBlocks.size() != block_size * (kStreamCopyPipelineDepth - 1))
+	{
+		mExtraBlocks = tc::ByteData(block_size * (kStreamCopyPipelineDepth - 1));
+	}
+
+	{
+		std::lock_guard<std::mutex> lock(mStateMutex);
+		for (size_t i = 0; i < kStreamCopyPipelineDepth; i++)
+		{
+			mBlockData[i] = (i == 0) ? cache.data() : (mExtraBlocks.data() + (i - 1) * block_size);
+			mBlockLen[i] = 0;
+		}
+		mOutStream = out_stream;
+		mSparse = sparse;
+		mObserver = &observer;
+		mReadCount = 0;
+		mWriteCount = 0;
+		mReadDone = false;
+		mReadFailed = false;
+		mWriteDone = false;
+		mWriteError = nullptr;
+		mCopyActive = true;
+	}
+	if (mWriter.joinable() == false)
+	{
+		mWriter = std::thread(&StreamCopyPipeline::writerMain, this);
+	}
+	mStateChanged.notify_all();
+
+	// reader stage (decryption and hash verification in the source stream happen here, overlapping with the write of the previous block)
+	std::exception_ptr read_error;
+	try
+	{
+		while (remaining_data > 0)
+		{
+			size_t slot;
+			{
+				std::unique_lock<std::mutex> lock(mStateMutex);
+				mStateChanged.wait(lock, [this]() { return mReadCount - mWriteCount < kStreamCopyPipelineDepth || mWriteDone; });
+				if (mWriteDone)
+				{
+					break;
+				}
+				slot = size_t(mReadCount % kStreamCopyPipelineDepth);
+			}
+
+			size_t cache_read_len = in_stream->read(mBlockData[slot], block_size);
+			if (cache_read_len == 0)
+			{
+				throw tc::io::IOException(mModuleLabel, fmt::format("Failed to read from {:s}.", source_name));
+			}
+
+			{
+				std::lock_guard<std::mutex> lock(mStateMutex);
+				mBlockLen[slot] = cache_read_len;
+				mReadCount++;
+			}
+			mStateChanged.notify_all();
+
+			remaining_data -= int64_t(cache_read_len);
+		}
+	}
+	catch (...)
+	{
+		read_error = std::current_exception();
+	}
+
+	// wait for the writer to finish with this copy, it stops early if the read failed
+	std::exception_ptr write_error;
+	{
+		std::unique_lock<std::mutex> lock(mStateMutex);
+		mReadDone = true;
+		mReadFailed = (read_error != nullptr);
+		mStateChanged.notify_all();
+		mStateChanged.wait(lock, [this]() { return mWriteDone; });
+
+		write_error = mWriteError;
+		mCopyActive = false;
+		mOutStream.reset();
+		mObserver = nullptr;
+	}
+
+	if (read_error != nullptr)
+	{
+		std::rethrow_exception(read_error);
+	}
+	if (write_error != nullptr)
+	{
+		std::rethrow_exception(write_error);
+	}
+
+	if (sparse)
+	{
+		out_stream->setLength(total_data);
+	}
+
+	// streams with queued writes report write errors here
+	out_stream->flush();
+}
+
+void nstool::StreamCopyPipeline::writerMain()
+{
+	for (;;)
+	{
+		size_t slot;
+		{
+			std::unique_lock<std::mutex> lock(mStateMutex);
+			mStateChanged.wait(lock, [this]() { return mStopRequested || (mCopyActive && mWriteDone == false && (mWriteCount < mReadCount || mReadDone)); });
+			if (mStopRequested)
+			{
+				return;
+			}
+
+			// this copy is complete (or was abandoned), wait for the next one
+			if (mReadFailed || mWriteCount == mReadCount)
+			{
+				mWriteDone = true;
+				mStateChanged.notify_all();
+				continue;
+			}
+			slot = size_t(mWriteCount % kStreamCopyPipelineDepth);
+		}
+
+		try
+		{
+			writeBlockToStream(mOutStream, mBlockData[slot], mBlockLen[slot], mSparse);
+			if (*mObserver != nullptr)
+			{
+				(*mObserver)(mBlockData[slot], mBlockLen[slot]);
+			}
+
+			std::lock_guard<std::mutex> lock(mStateMutex);
+			mWriteCount++;
+		}
+		catch (...)
+		{
+			std::lock_guard<std::mutex> lock(mStateMutex);
+			mWriteError = std::current_exception();
+			mWriteDone = true;
+		}
+		mStateChanged.notify_all();
+	}
+}
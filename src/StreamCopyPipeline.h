@@ -0,0 +1,63 @@
+#pragma once
+#include "types.h"
+
+#include <array>
+#include <thread>
+#include <mutex>
+#include <condition_variable>
+#include <exception>
+
+namespace nstool {
+
+// number of blocks in flight between the reader and writer stage of a stream copy.
+// the caller's cache is the size of one block, blocks beyond the first are allocated by the pipeline.
+static const size_t kStreamCopyPipelineDepth = 4;
+
+// called with each block of data copied by a stream copy, in stream order (e.g. to hash the content while it is extracted)
+using StreamDataObserver = std::function<void(const byte_t* data, size_t len)>;
+
+// Copies streams in two stages, a writer thread drains filled blocks while the calling thread reads (which is where decryption and hash checks run).
+// The writer thread is started by the first copy larger than one block and kept for later copies, so a caller copying many files keeps one pipeline rather than paying for a thread per file.
+// copy() must not be called by several threads at once, each thread copying files should have its own pipeline.
+class StreamCopyPipeline
+{
+public:
+	// module_label is the module of exceptions thrown when the source stream ends early
+	StreamCopyPipeline(const std::string& module_label);
+	~StreamCopyPipeline();
+
+	// copy in_stream to out_stream, source_name describes the source stream in the error thrown if it ends early
+	// when sparse is true, all zero kSparseBlockSize blocks are seeked over instead of written, leaving holes in the output file on filesystems that support them
+	void copy(const std::shared_ptr<tc::io::IStream>& in_stream, const std::shared_ptr<tc::io::IStream>& out_stream, tc::ByteData& cache, bool sparse, const StreamDataObserver& observer, const std::string& source_name);
+private:
+	StreamCopyPipeline(const StreamCopyPipeline&) = delete;
+	StreamCopyPipeline& operator=(const StreamCopyPipeline&) = delete;
+
+	std::string mModuleLabel;
+
+	// blocks beyond the caller's cache
+	tc::ByteData mExtraBlocks;
+
+	std::thread mWriter;
+	std::mutex mStateMutex;
+	std::condition_variable mStateChanged;
+	bool mStopRequested;
+
+	// state of the current copy, blocks [mWriteCount, mReadCount) are filled and waiting to be written, block n lives in slot (n % kStreamCopyPipelineDepth)
+	bool mCopyActive;
+	std::shared_ptr<tc::io::IStream> mOutStream;
+	bool mSparse;
+	const StreamDataObserver* mObserver;
+	std::array<byte_t*, kStreamCopyPipelineDepth> mBlockData;
+	std::array<size_t, kStreamCopyPipelineDepth> mBlockLen;
+	uint64_t mReadCount;
+	uint64_t mWriteCount;
+	bool mReadDone;
+	bool mReadFailed;
+	bool mWriteDone;
+	std::exception_ptr mWriteError;
+
+	void writerMain();
+};
+
+}
@@ -0,0 +1,135 @@
+#include "ThreadPool.h"
+
+#include <algorithm>
+
+nstool::ThreadPool::ThreadPool(size_t thread_count) :
+	mWorkers(),
+	mQueueMutex(),
+	mQueueChanged(),
+	mQueue(),
+	mStopRequested(false)
+{
+	for (size_t i = 0; i < thread_count; i++)
+	{
+		mWorkers.push_back(std::thread(&ThreadPool::workerMain, this));
+	}
+}
+
+nstool::ThreadPool::~ThreadPool()
+{
+	{
+		std::lock_guard<std::mutex> lock(mQueueMutex);
+		mStopRequested = true;
+	}
+	mQueueChanged.notify_all();
+
+	for (auto itr = mWorkers.begin(); itr != mWorkers.end(); itr++)
+	{
+		itr->join();
+	}
+}
+
+size_t nstool::ThreadPool::getThreadCount() const
+{
+	return mWorkers.size();
+}
+
+void nstool::ThreadPool::parallelFor(size_t count, const std::function<void(size_t)>& func)
+{
+	if (count == 0)
+	{
+		return;
+	}
+
+	// nothing to share, run on this thread
+	if (count == 1 || mWorkers.empty())
+	{
+		for (size_t i = 0; i < count; i++)
+		{
+			func(i);
+		}
+		return;
+	}
+
+	std::shared_ptr<sBatch> batch = std::make_shared<sBatch>(&func, count);
+	{
+		std::lock_guard<std::mutex> lock(mQueueMutex);
+		mQueue.push_back(batch);
+	}
+	mQueueChanged.notify_all();
+
+	runBatch(*batch);
+	retireBatch(batch);
+
+	// wait for parts claimed by workers
+	std::unique_lock<std::mutex> lock(batch->mutex);
+	batch->completed_changed.wait(lock, [&batch]() { return batch->completed == batch->count; });
+
+	if (batch->error != nullptr)
+	{
+		std::rethrow_exception(batch->error);
+	}
+}
+
+void nstool::ThreadPool::workerMain()
+{
+	for (;;)
+	{
+		std::shared_ptr<sBatch> batch;
+		{
+			std::unique_lock<std::mutex> lock(mQueueMutex);
+			mQueueChanged.wait(lock, [this]() { return mStopRequested || mQueue.empty() == false; });
+			if (mStopRequested)
+			{
+				return;
+			}
+			batch = mQueue.front();
+		}
+
+		runBatch(*batch);
+		retireBatch(batch);
+	}
+}
+
+void nstool::ThreadPool::retireBatch(const std::shared_ptr<sBatch>& batch)
+{
+	std::lock_guard<std::mutex> lock(mQueueMutex);
+	auto itr = std::find(mQueue.begin(), mQueue.end(), batch);
+	if (itr != mQueue.end())
+	{
+		mQueue.erase(itr);
+	}
+}
+
+void nstool::ThreadPool::runBatch(sBatch& batch)
+{
+	for (size_t i = batch.next++; i < batch.count; i = batch.next++)
+	{
+		// parts after a failure are only counted as completed, so the waiting thread still wakes up
+		if (batch.failed == false)
+		{
+			try {
+				(*batch.func)(i);
+			}
+			catch (...) {
+				std::lock_guard<std::mutex> lock(batch.mutex);
+				if (batch.error == nullptr)
+				{
+					batch.error = std::current_exception();
+				}
+				batch.failed = true;
+			}
+		}
+
+		bool all_completed;
+		{
+			std::lock_guard<std::mutex> lock(batch.mutex);
+			batch.completed++;
+			all_completed = batch.completed == batch.count;
+		}
+		if (all_completed)
+		{
+			batch.completed_changed.notify_all();
+		}
+	}
+}
@@ -0,0 +1,62 @@
+#pragma once
+#include "types.h"
+
+#include <thread>
+#include <mutex>
+#include <condition_variable>
+#include <atomic>
+#include <deque>
+#include <exception>
+
+namespace nstool {
+
+// Fixed set of worker threads for splitting one operation into independent parts (e.g. decrypting chunks of a large read).
+// parallelFor() may be called from several threads at once, each call only waits for its own parts.
+class ThreadPool
+{
+public:
+	// thread_count worker threads are created, the thread calling parallelFor() also works on its parts, so thread_count can be one less than the desired parallelism
+	ThreadPool(size_t thread_count);
+	~ThreadPool();
+
+	size_t getThreadCount() const;
+
+	// calls func(i) for each i in [0, count) and returns when all calls have completed
+	// if any call throws, the remaining calls are skipped and the first exception is rethrown here
+	void parallelFor(size_t count, const std::function<void(size_t)>& func);
+private:
+	ThreadPool(const ThreadPool&) = delete;
+	ThreadPool& operator=(const ThreadPool&) = delete;
+
+	struct sBatch
+	{
+		const std::function<void(size_t)>* func;
+		size_t count;
+		std::atomic<size_t> next;
+		std::atomic<bool> failed;
+
+		std::mutex mutex;
+		std::condition_variable completed_changed;
+		size_t completed;
+		std::exception_ptr error;
+
+		sBatch(const std::function<void(size_t)>* func, size_t count) : func(func), count(count), next(0), failed(false), completed(0), error() {}
+	};
+
+	std::vector<std::thread> mWorkers;
+
+	std::mutex mQueueMutex;
+	std::condition_variable mQueueChanged;
+	std::deque<std::shared_ptr<sBatch>> mQueue;
+	bool mStopRequested;
+
+	void workerMain();
+
+	// remove batch from the queue once all of its parts have been claimed
+	void retireBatch(const std::shared_ptr<sBatch>& batch);
+
+	// claim and run parts of batch until none are left
+	static void runBatch(sBatch& batch);
+};
+
+}
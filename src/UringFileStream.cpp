@@ -0,0 +1,475 @@
+#include "UringFileStream.h"
+
+#include <tc/io/StreamUtil.h>
+#include <tc/NotSupportedException.h>
+#include <tc/ObjectDisposedException.h>
+#include <tc/ArgumentNullException.h>
+
+#include <cstring>
+#include <algorithm>
+
+#if defined(__linux__) && defined(__has_include)
+#if __has_include(<linux/io_uring.h>)
+#define NSTOOL_HAS_IO_URING
+#endif
+#endif
+
+#ifdef NSTOOL_HAS_IO_URING
+#include <cerrno>
+#include <fcntl.h>
+#include <unistd.h>
+#include <sys/mman.h>
+#include <sys/syscall.h>
+#include <sys/uio.h>
+#include <linux/io_uring.h>
+
+// minimal io_uring wrapper (liburing is not a dependency), only what is needed to queue IORING_OP_WRITEV and wait for completions
+class nstool::UringFileStream::Ring
+{
+public:
+	Ring(unsigned entries) :
+		mIovecs(entries),
+		mRingFd(-1),
+		mSqMap(nullptr),
+		mSqMapSize(0),
+		mCqMap(nullptr),
+		mCqMapSize(0),
+		mSqes(nullptr),
+		mSqesSize(0)
+	{
+		struct io_uring_params params;
+		memset(&params, 0, sizeof(params));
+
+		mRingFd = int(syscall(__NR_io_uring_setup, entries, &params));
+		if (mRingFd < 0)
+		{
+			throw tc::NotSupportedException("nstool::UringFileStream", "io_uring_setup() failed.");
+		}
+
+		mSqMapSize = params.sq_off.array + params.sq_entries * sizeof(unsigned);
+		mCqMapSize = params.cq_off.cqes + params.cq_entries * sizeof(struct io_uring_cqe);
+		bool single_mmap = (params.features & IORING_FEAT_SINGLE_MMAP) != 0;
+		if (single_mmap)
+		{
+			mSqMapSize = mCqMapSize = std::max(mSqMapSize, mCqMapSize);
+		}
+
+		mSqMap = mmap(nullptr, mSqMapSize, PROT_READ | PROT_WRITE, MAP_SHARED | MAP_POPULATE, mRingFd, IORING_OFF_SQ_RING);
+		if (mSqMap == MAP_FAILED)
+		{
+			mSqMap = nullptr;
+			release();
+			throw tc::NotSupportedException("nstool::UringFileStream", "Failed to map io_uring submission queue.");
+		}
+
+		if (single_mmap)
+		{
+			mCqMap = mSqMap;
+		}
+		else
+		{
+			mCqMap = mmap(nullptr, mCqMapSize, PROT_READ | PROT_WRITE, MAP_SHARED | MAP_POPULATE, mRingFd, IORING_OFF_CQ_RING);
+			if (mCqMap == MAP_FAILED)
+			{
+				mCqMap = nullptr;
+				release();
+				throw tc::NotSupportedException("nstool::UringFileStream", "Failed to map io_uring completion queue.");
+			}
+		}
+
+		mSqesSize = params.sq_entries * sizeof(struct io_uring_sqe);
+		void* sqes = mmap(nullptr, mSqesSize, PROT_READ | PROT_WRITE, MAP_SHARED | MAP_POPULATE, mRingFd, IORING_OFF_SQES);
+		if (sqes == MAP_FAILED)
+		{
+			release();
+			throw tc::NotSupportedException("nstool::UringFileStream", "Failed to map io_uring submission queue entries.");
+		}
+		mSqes = (struct io_uring_sqe*)sqes;
+
+		byte_t* sq = (byte_t*)mSqMap;
+		mSqHead = (unsigned*)(sq + params.sq_off.head);
+		mSqTail = (unsigned*)(sq + params.sq_off.tail);
+		mSqMask = *(unsigned*)(sq + params.sq_off.ring_mask);
+		mSqArray = (unsigned*)(sq + params.sq_off.array);
+
+		byte_t* cq = (byte_t*)mCqMap;
+		mCqHead = (unsigned*)(cq + params.cq_off.head);
+		mCqTail = (unsigned*)(cq + params.cq_off.tail);
+		mCqMask = *(unsigned*)(cq + params.cq_off.ring_mask);
+		mCqes = (struct io_uring_cqe*)(cq + params.cq_off.cqes);
+	}
+
+	~Ring()
+	{
+		release();
+	}
+
+	// queue a write of data at offset and submit it, returns true if the kernel took the entry (a completion will follow) or false if the write was not queued
+	// slot is returned as the completion's user_data, and selects the iovec which must stay valid until the write completes
+	bool submitWrite(int fd, const byte_t* data, size_t size, int64_t offset, size_t slot)
+	{
+		mIovecs[slot].iov_base = (void*)data;
+		mIovecs[slot].iov_len = size;
+
+		// only this thread produces entries, so the tail can be read without synchronisation
+		unsigned tail = *mSqTail;
+		unsigned index = tail & mSqMask;
+
+		struct io_uring_sqe* sqe = &mSqes[index];
+		memset(sqe, 0, sizeof(*sqe));
+		sqe->opcode = IORING_OP_WRITEV;
+		sqe->fd = fd;
+		sqe->addr = (uint64_t)(uintptr_t)&mIovecs[slot];
+		sqe->len = 1;
+		sqe->off = uint64_t(offset);
+		sqe->user_data = uint64_t(slot);
+
+		mSqArray[index] = index;
+		__atomic_store_n(mSqTail, tail + 1, __ATOMIC_RELEASE);
+
+		for (;;)
+		{
+			int ret = int(syscall(__NR_io_uring_enter, mRingFd, 1, 0, 0, nullptr, 0));
+			if (ret < 0 && errno == EINTR)
+				continue;
+			break;
+		}
+
+		// the kernel consumed the entry if its head moved past it, a completion follows even if io_uring_enter() reported an error
+		if (__atomic_load_n(mSqHead, __ATOMIC_ACQUIRE) != tail)
+		{
+			return true;
+		}
+
+		// not consumed, withdraw the entry so a later io_uring_enter() can't submit it after the caller wrote the block itself
+		// (without SQPOLL the kernel only reads the submission queue inside io_uring_enter(), so this can't race)
+		__atomic_store_n(mSqTail, tail, __ATOMIC_RELEASE);
+		return false;
+	}
+
+	// block until a completion is available, then return it
+	void waitCompletion(uint64_t& user_data, int32_t& result)
+	{
+		for (;;)
+		{
+			unsigned head = *mCqHead;
+			if (head != __atomic_load_n(mCqTail, __ATOMIC_ACQUIRE))
+			{
+				struct io_uring_cqe* cqe = &mCqes[head & mCqMask];
+				user_data = cqe->user_data;
+				result = cqe->res;
+				__atomic_store_n(mCqHead, head + 1, __ATOMIC_RELEASE);
+				return;
+			}
+
+			int ret = int(syscall(__NR_io_uring_enter, mRingFd, 0, 1, IORING_ENTER_GETEVENTS, nullptr, 0));
+			if (ret < 0 && errno != EINTR)
+			{
+				throw tc::io::IOException("nstool::UringFileStream", "io_uring_enter() failed while waiting for a write to complete.");
+			}
+		}
+	}
+private:
+	std::vector<struct iovec> mIovecs;
+	int mRingFd;
+	void* mSqMap;
+	size_t mSqMapSize;
+	void* mCqMap;
+	size_t mCqMapSize;
+	struct io_uring_sqe* mSqes;
+	size_t mSqesSize;
+
+	unsigned* mSqHead;
+	unsigned* mSqTail;
+	unsigned mSqMask;
+	unsigned* mSqArray;
+	unsigned* mCqHead;
+	unsigned* mCqTail;
+	unsigned mCqMask;
+	struct io_uring_cqe* mCqes;
+
+	void release()
+	{
+		if (mSqes != nullptr)
+			munmap(mSqes, mSqesSize);
+		if (mCqMap != nullptr && mCqMap != mSqMap)
+			munmap(mCqMap, mCqMapSize);
+		if (mSqMap != nullptr)
+			munmap(mSqMap, mSqMapSize);
+		if (mRingFd >= 0)
+			close(mRingFd);
+
+		mSqes = nullptr;
+		mCqMap = nullptr;
+		mSqMap = nullptr;
+		mRingFd = -1;
+	}
+};
+#else
+class nstool::UringFileStream::Ring
+{
+};
+#endif
+
+nstool::UringFileStream::UringFileStream(const tc::io::Path& path) :
+	mModuleName("nstool::UringFileStream"),
+	mRing(),
+	mFd(-1),
+	mPosition(0),
+	mLength(0),
+	mSlots(),
+	mBusySlotNum(0),
+	mWriteError()
+{
+#ifdef NSTOOL_HAS_IO_URING
+	mRing = std::unique_ptr<Ring>(new Ring(kQueueDepth));
+
+	mFd = open(path.to_string().c_str(), O_WRONLY | O_CREAT | O_TRUNC | O_CLOEXEC, 0666);
+	if (mFd < 0)
+	{
+		throw tc::io::IOException(mModuleName, "Failed to open output file.");
+	}
+
+	for (size_t i = 0; i < mSlots.size(); i++)
+	{
+		mSlots[i].size = 0;
+		mSlots[i].offset = 0;
+		mSlots[i].busy = false;
+	}
+#else
+	throw tc::NotSupportedException(mModuleName, "io_uring is not supported on this platform.");
+#endif
+}
+
+nstool::UringFileStream::~UringFileStream()
+{
+	try {
+		dispose();
+	} catch (...) {
+		// errors can't be reported from a destructor, callers that care call flush() first
+	}
+}
+
+bool nstool::UringFileStream::canRead() const
+{
+	return false;
+}
+
+bool nstool::UringFileStream::canWrite() const
+{
+	return mFd >= 0;
+}
+
+bool nstool::UringFileStream::canSeek() const
+{
+	return mFd >= 0;
+}
+
+int64_t nstool::UringFileStream::length()
+{
+	if (mFd < 0)
+	{
+		throw tc::ObjectDisposedException(mModuleName+"::length()", "Failed to get stream length (stream is disposed)");
+	}
+
+	return mLength;
+}
+
+int64_t nstool::UringFileStream::position()
+{
+	if (mFd < 0)
+	{
+		throw tc::ObjectDisposedException(mModuleName+"::position()", "Failed to get stream position (stream is disposed)");
+	}
+
+	return mPosition;
+}
+
+size_t nstool::UringFileStream::read(byte_t* ptr, size_t count)
+{
+	throw tc::NotSupportedException(mModuleName+"::read()", "read() is not supported for UringFileStream");
+}
+
+size_t nstool::UringFileStream::write(const byte_t* ptr, size_t count)
+{
+#ifdef NSTOOL_HAS_IO_URING
+	if (mFd < 0)
+	{
+		throw tc::ObjectDisposedException(mModuleName+"::write()", "Failed to write to stream (stream is disposed)");
+	}
+	if (ptr == nullptr)
+	{
+		throw tc::ArgumentNullException(mModuleName+"::write()", "ptr was null.");
+	}
+	throwPendingError();
+
+	for (size_t written = 0; written < count;)
+	{
+		size_t slot_index = acquireSlot();
+		sWriteSlot& slot = mSlots[slot_index];
+
+		slot.size = std::min<size_t>(count - written, size_t(kMaxWriteSize));
+		slot.offset = mPosition;
+		if (slot.buffer.size() < slot.size)
+		{
+			slot.buffer = tc::ByteData(slot.size, false);
+		}
+		memcpy(slot.buffer.data(), ptr + written, slot.size);
+
+		if (mRing->submitWrite(mFd, slot.buffer.data(), slot.size, slot.offset, slot_index) == false)
+		{
+			// kernel refused the submission, write this block directly instead
+			if (pwrite(mFd, slot.buffer.data(), slot.size, off_t(slot.offset)) != ssize_t(slot.size))
+			{
+				throw tc::io::IOException(mModuleName+"::write()", "Failed to write to file.");
+			}
+		}
+		else
+		{
+			slot.busy = true;
+			mBusySlotNum++;
+		}
+
+		mPosition += int64_t(slot.size);
+		mLength = std::max<int64_t>(mLength, mPosition);
+		written += slot.size;
+	}
+
+	return count;
+#else
+	throw tc::NotSupportedException(mModuleName+"::write()", "io_uring is not supported on this platform.");
+#endif
+}
+
+int64_t nstool::UringFileStream::seek(int64_t offset, tc::io::SeekOrigin origin)
+{
+	if (mFd < 0)
+	{
+		throw tc::ObjectDisposedException(mModuleName+"::seek()", "Failed to set stream position (stream is disposed)");
+	}
+	throwPendingError();
+
+	// writes carry their own offset, so seeking only moves where the next write goes (seeking past the end leaves a hole, as with FileStream)
+	mPosition = tc::io::StreamUtil::getSeekResult(offset, origin, mPosition, mLength);
+
+	return mPosition;
+}
+
+void nstool::UringFileStream::setLength(int64_t length)
+{
+#ifdef NSTOOL_HAS_IO_URING
+	if (mFd < 0)
+	{
+		throw tc::ObjectDisposedException(mModuleName+"::setLength()", "Failed to set stream length (stream is disposed)");
+	}
+
+	drain();
+	if (ftruncate(mFd, off_t(length)) != 0)
+	{
+		throw tc::io::IOException(mModuleName+"::setLength()", "Failed to set file length.");
+	}
+	mLength = length;
+#endif
+}
+
+void nstool::UringFileStream::flush()
+{
+	if (mFd < 0)
+	{
+		throw tc::ObjectDisposedException(mModuleName+"::flush()", "Failed to flush stream (stream is disposed)");
+	}
+
+	drain();
+}
+
+void nstool::UringFileStream::dispose()
+{
+#ifdef NSTOOL_HAS_IO_URING
+	if (mFd < 0)
+	{
+		return;
+	}
+
+	// buffers must not be released while the kernel may still read them, so wait for all writes even if one failed
+	try {
+		drain();
+	} catch (...) {
+		close(mFd);
+		mFd = -1;
+		mRing.reset();
+		throw;
+	}
+
+	close(mFd);
+	mFd = -1;
+	mRing.reset();
+#endif
+}
+
+size_t nstool::UringFileStream::acquireSlot()
+{
+	if (mBusySlotNum == mSlots.size())
+	{
+		reapCompletion();
+		throwPendingError();
+	}
+
+	for (size_t i = 0; i < mSlots.size(); i++)
+	{
+		if (mSlots[i].busy == false)
+			return i;
+	}
+
+	throw tc::io::IOException(mModuleName, "No write slot available.");
+}
+
+void nstool::UringFileStream::reapCompletion()
+{
+#ifdef NSTOOL_HAS_IO_URING
+	uint64_t user_data;
+	int32_t result;
+	mRing->waitCompletion(user_data, result);
+
+	if (user_data >= mSlots.size())
+	{
+		throw tc::io::IOException(mModuleName, "Unexpected io_uring completion.");
+	}
+	sWriteSlot& slot = mSlots[size_t(user_data)];
+
+	if (result < 0)
+	{
+		mWriteError = fmt::format("Failed to write to file. ({:s})", strerror(-result));
+	}
+	else if (size_t(result) < slot.size)
+	{
+		// short write, finish the remainder synchronously
+		size_t remaining = slot.size - size_t(result);
+		if (pwrite(mFd, slot.buffer.data() + result, remaining, off_t(slot.offset + result)) != ssize_t(remaining))
+		{
+			mWriteError = "Failed to write to file.";
+		}
+	}
+
+	slot.busy = false;
+	mBusySlotNum--;
+#endif
+}
+
+void nstool::UringFileStream::drain()
+{
+	while (mBusySlotNum > 0)
+	{
+		reapCompletion();
+	}
+	throwPendingError();
+}
+
+void nstool::UringFileStream::throwPendingError()
+{
+	if (mWriteError.empty() == false)
+	{
+		std::string error = mWriteError;
+		mWriteError.clear();
+		throw tc::io::IOException(mModuleName, error);
+	}
+}
@@ -0,0 +1,62 @@
+#pragma once
+#include "types.h"
+
+#include <array>
+#include <memory>
+
+namespace nstool {
+
+// Write-only IStream for a new local file that queues writes with io_uring (Linux only), so several writes are in flight while the caller prepares more data.
+// Data is copied into an internal buffer before write() returns. Write errors are reported by a later write(), seek(), setLength() or flush(), so callers must flush() before disposing.
+// Construction throws tc::NotSupportedException when io_uring is unavailable (non-Linux builds, old kernels, seccomp restrictions), see openOutputFileStream() for the fallback.
+class UringFileStream : public tc::io::IStream
+{
+public:
+	UringFileStream(const tc::io::Path& path);
+	~UringFileStream();
+
+	bool canRead() const;
+	bool canWrite() const;
+	bool canSeek() const;
+	int64_t length();
+	int64_t position();
+	size_t read(byte_t* ptr, size_t count);
+	size_t write(const byte_t* ptr, size_t count);
+	int64_t seek(int64_t offset, tc::io::SeekOrigin origin);
+	void setLength(int64_t length);
+	void flush();
+	void dispose();
+private:
+	static const size_t kQueueDepth = 8;
+	static const size_t kMaxWriteSize = 0x100000;
+
+	std::string mModuleName;
+
+	class Ring;
+	std::unique_ptr<Ring> mRing;
+	int mFd;
+
+	int64_t mPosition;
+	int64_t mLength;
+
+	struct sWriteSlot
+	{
+		tc::ByteData buffer;
+		size_t size;
+		int64_t offset;
+		bool busy;
+	};
+	std::array<sWriteSlot, kQueueDepth> mSlots;
+	size_t mBusySlotNum;
+	std::string mWriteError;
+
+	size_t acquireSlot();
+	void reapCompletion();
+	void drain();
+	void throwPendingError();
+
+	UringFileStream(const UringFileStream&) = delete;
+	UringFileStream& operator=(const UringFileStream&) = delete;
+};
+
+}
@@ -0,0 +1,96 @@
+#include "VerifiedBlockCache.h"
+
+nstool::VerifiedBlockCache::VerifiedBlockCache(size_t capacity) :
+	mCapacity(capacity),
+	mMutex(),
+	mSize(0),
+	mEntries(),
+	mEntryMap(),
+	mHitCount(0),
+	mMissCount(0)
+{
+}
+
+std::shared_ptr<const tc::ByteData> nstool::VerifiedBlockCache::getBlock(uint64_t tree_id, uint32_t layer_index, uint64_t block_index)
+{
+	sKey key = { tree_id, layer_index, block_index };
+
+	std::lock_guard<std::mutex> lock(mMutex);
+
+	auto itr = mEntryMap.find(key);
+	if (itr == mEntryMap.end())
+	{
+		mMissCount++;
+		return nullptr;
+	}
+
+	// move to the front (most recently used)
+	mEntries.splice(mEntries.begin(), mEntries, itr->second);
+	mHitCount++;
+
+	return itr->second->block;
+}
+
+bool nstool::VerifiedBlockCache::hasBlock(uint64_t tree_id, uint32_t layer_index, uint64_t block_index) const
+{
+	sKey key = { tree_id, layer_index, block_index };
+
+	std::lock_guard<std::mutex> lock(mMutex);
+
+	return mEntryMap.find(key) != mEntryMap.end();
+}
+
+void nstool::VerifiedBlockCache::addBlock(uint64_t tree_id, uint32_t layer_index, uint64_t block_index, const std::shared_ptr<const tc::ByteData>& block)
+{
+	if (block == nullptr || block->size() > mCapacity)
+	{
+		return;
+	}
+
+	sKey key = { tree_id, layer_index, block_index };
+
+	std::lock_guard<std::mutex> lock(mMutex);
+
+	auto itr = mEntryMap.find(key);
+	if (itr != mEntryMap.end())
+	{
+		mSize -= itr->second->block->size();
+		mEntries.erase(itr->second);
+		mEntryMap.erase(itr);
+	}
+
+	sEntry entry = { key, block };
+	mEntries.push_front(entry);
+	mEntryMap[key] = mEntries.begin();
+	mSize += block->size();
+
+	// evict least recently used blocks
+	while (mSize > mCapacity)
+	{
+		const sEntry& lru = mEntries.back();
+		mSize -= lru.block->size();
+		mEntryMap.erase(lru.key);
+		mEntries.pop_back();
+	}
+}
+
+size_t nstool::VerifiedBlockCache::getCapacity() const
+{
+	return mCapacity;
+}
+
+size_t nstool::VerifiedBlockCache::getSize() const
+{
+	std::lock_guard<std::mutex> lock(mMutex);
+	return mSize;
+}
+
+uint64_t nstool::VerifiedBlockCache::getHitCount() const
+{
+	return mHitCount;
+}
+
+uint64_t nstool::VerifiedBlockCache::getMissCount() const
+{
+	return mMissCount;
+}
@@ -0,0 +1,70 @@
+#pragma once
+#include "types.h"
+
+#include <list>
+#include <mutex>
+#include <atomic>
+
+namespace nstool {
+
+// Bounded LRU cache of hash tree blocks that have already passed hash validation, so reading them again needs neither a read nor a hash.
+// Blocks are keyed by tree (e.g. NCA partition index), layer and block index. It is thread safe, so it can be shared by streams used from different threads.
+class VerifiedBlockCache
+{
+public:
+	// capacity is the total size of the cached blocks in bytes, the least recently used blocks are evicted beyond it
+	VerifiedBlockCache(size_t capacity);
+
+	// returns the verified block, or null if it is not cached
+	std::shared_ptr<const tc::ByteData> getBlock(uint64_t tree_id, uint32_t layer_index, uint64_t block_index);
+
+	// returns true if the block is cached, without counting a hit or miss or making it the most recently used
+	bool hasBlock(uint64_t tree_id, uint32_t layer_index, uint64_t block_index) const;
+
+	// add a verified block (replaces a cached copy)
+	void addBlock(uint64_t tree_id, uint32_t layer_index, uint64_t block_index, const std::shared_ptr<const tc::ByteData>& block);
+
+	size_t getCapacity() const;
+	size_t getSize() const;
+	uint64_t getHitCount() const;
+	uint64_t getMissCount() const;
+private:
+	VerifiedBlockCache(const VerifiedBlockCache&) = delete;
+	VerifiedBlockCache& operator=(const VerifiedBlockCache&) = delete;
+
+	struct sKey
+	{
+		uint64_t tree_id;
+		uint32_t layer_index;
+		uint64_t block_index;
+
+		bool operator<(const sKey& other) const
+		{
+			if (tree_id != other.tree_id)
+				return tree_id < other.tree_id;
+			if (layer_index != other.layer_index)
+				return layer_index < other.layer_index;
+			return block_index < other.block_index;
+		}
+	};
+
+	struct sEntry
+	{
+		sKey key;
+		std::shared_ptr<const tc::ByteData> block;
+	};
+
+	size_t mCapacity;
+
+	mutable std::mutex mMutex;
+	size_t mSize;
+
+	// most recently used at the front
+	std::list<sEntry> mEntries;
+	std::map<sKey, std::list<sEntry>::iterator> mEntryMap;
+
+	std::atomic<uint64_t> mHitCount;
+	std::atomic<uint64_t> mMissCount;
+};
+
+}
@@ -1,6 +1,12 @@
 #include <tc.h>
 #include <tc/os/UnicodeMain.h>
 #include "Settings.h"
+#include "MemoryMappedFileStream.h"
+#include "HashManifest.h"
+#include "ExtractManifest.h"
+#include "ThreadPool.h"
+#include "OutputCapture.h"
+#include "util.h"
 
 
 #include "GameCardProcess.h"
@@ -17,205 +23,592 @@
 #include "EsCertProcess.h"
 #include "EsTikProcess.h"
 #include "AssetProcess.h"
+#include "NcaHeaderScanProcess.h"
+#include "ServerProcess.h"
 
+#include <thread>
+#include <mutex>
+#include <atomic>
+#include <algorithm>
+#include <map>
+#include <limits>
 
-int umain(const std::vector<std::string>& args, const std::vector<std::string>& env)
+
+// large inputs are memory mapped, so the many small reads made while parsing nested headers are not each a syscall
+// (only on 64bit builds, as 32bit builds may not have enough address space to map the whole file)
+static const int64_t kAutoMmapInputSize = 0x40000000;
+
+// factory for streams of the input file at infile_path, memory mapped if mmap_input is set or the file is at least auto_mmap_size bytes
+nstool::StreamFactory openInputFile(const tc::io::Path& infile_path, bool mmap_input, int64_t auto_mmap_size)
 {
-	try 
+	nstool::StreamFactory infile_factory = [infile_path]() -> std::shared_ptr<tc::io::IStream> {
+		return std::make_shared<tc::io::FileStream>(tc::io::FileStream(infile_path, tc::io::FileMode::Open, tc::io::FileAccess::Read));
+	};
+
+	if (mmap_input || (sizeof(void*) >= 8 && infile_factory()->length() >= auto_mmap_size))
 	{
-		nstool::Settings set = nstool::SettingsInitializer(args);
+		std::shared_ptr<nstool::MemoryMappedFileStream> mapped_infile;
+		try {
+			mapped_infile = std::make_shared<nstool::MemoryMappedFileStream>(nstool::MemoryMappedFileStream(infile_path));
+		} catch (tc::io::IOException&) {
+			// mapping is only an optimisation unless explicitly requested
+			if (mmap_input)
+				throw;
+		}
+
+		if (mapped_infile != nullptr)
+		{
+			// each stream shares the mapping but has its own position
+			infile_factory = [mapped_infile]() -> std::shared_ptr<tc::io::IStream> {
+				return std::make_shared<nstool::MemoryMappedFileStream>(*mapped_infile);
+			};
+		}
+	}
+
+	return infile_factory;
+}
+
+// process the input file set.infile.path, of type set.infile.filetype
+// infile_factory creates streams of the input file, if it is null the input file is opened
+void processInputFile(nstool::Settings& set, nstool::StreamFactory infile_factory = nullptr)
+{
+	tc::io::Path infile_path = set.infile.path.get();
+	if (infile_factory == nullptr)
+	{
+		infile_factory = openInputFile(infile_path, set.opt.mmap_input, kAutoMmapInputSize);
+	}
+
+	std::shared_ptr<tc::io::IStream> infile_stream = infile_factory();
+
+	if (set.fs.extract_options.resume)
+	{
+		set.fs.extract_options.input_identity = nstool::ExtractManifest::getInputIdentity(infile_path, infile_stream);
+	}
+
+	// shared by every filesystem extracted from this input, so it lists all extracted files
+	if (set.fs.manifest_path.isSet())
+	{
+		set.fs.extract_options.hash_manifest = std::make_shared<nstool::HashManifest>(set.fs.manifest_path.get(), set.fs.manifest_hash_types);
+	}
+
+	if (set.infile.filetype == nstool::Settings::FILE_TYPE_GAMECARD)
+	{	
+		nstool::GameCardProcess obj;
+
+		obj.setInputFile(infile_stream);
+		obj.setInputFileFactory(infile_factory);
+		obj.setInputFilePath(infile_path);
 		
-		std::shared_ptr<tc::io::IStream> infile_stream = std::make_shared<tc::io::FileStream>(tc::io::FileStream(set.infile.path.get(), tc::io::FileMode::Open, tc::io::FileAccess::Read));
+		obj.setKeyCfg(set.opt.keybag);
+		obj.setCliOutputMode(set.opt.cli_output_mode);
+		obj.setVerifyMode(set.opt.verify);
+
+		obj.setShowFsTree(set.fs.show_fs_tree);
+		obj.setExtractJobs(set.fs.extract_jobs);
+		obj.setExtractOptions(set.fs.extract_options);
+	
+		obj.process();
+	}
+	else if (set.infile.filetype == nstool::Settings::FILE_TYPE_PARTITIONFS || set.infile.filetype == nstool::Settings::FILE_TYPE_NSP)
+	{
+		nstool::PfsProcess obj;
 
-		if (set.infile.filetype == nstool::Settings::FILE_TYPE_GAMECARD)
-		{	
-			nstool::GameCardProcess obj;
+		obj.setInputFile(infile_stream);
+		obj.setInputFileFactory(infile_factory);
+		obj.setInputFilePath(infile_path);
 
-			obj.setInputFile(infile_stream);
-			
-			obj.setKeyCfg(set.opt.keybag);
-			obj.setCliOutputMode(set.opt.cli_output_mode);
-			obj.setVerifyMode(set.opt.verify);
+		obj.setCliOutputMode(set.opt.cli_output_mode);
+		obj.setVerifyMode(set.opt.verify);
 
-			obj.setShowFsTree(set.fs.show_fs_tree);
-			obj.setExtractJobs(set.fs.extract_jobs);
+		obj.setShowFsTree(set.fs.show_fs_tree);
+		obj.setExtractJobs(set.fs.extract_jobs);
+		obj.setExtractOptions(set.fs.extract_options);
 		
-			obj.process();
+		obj.process();
+	}
+	
+	else if (set.infile.filetype == nstool::Settings::FILE_TYPE_ROMFS)
+	{
+		nstool::RomfsProcess obj;
+
+		obj.setInputFile(infile_stream);
+		obj.setInputFileFactory(infile_factory);
+		obj.setInputFilePath(infile_path);
+		obj.setCliOutputMode(set.opt.cli_output_mode);
+		obj.setVerifyMode(set.opt.verify);
+
+		obj.setShowFsTree(set.fs.show_fs_tree);
+		obj.setExtractJobs(set.fs.extract_jobs);
+		obj.setExtractOptions(set.fs.extract_options);
+
+		obj.process();
+	}
+	else if (set.infile.filetype == nstool::Settings::FILE_TYPE_NCA)
+	{
+		nstool::NcaProcess obj;
+
+		obj.setInputFile(infile_stream);
+		obj.setInputFileFactory(infile_factory);
+		if (set.nca.base_nca_session != nullptr)
+		{
+			obj.setBaseNcaSession(set.nca.base_nca_session);
 		}
-		else if (set.infile.filetype == nstool::Settings::FILE_TYPE_PARTITIONFS || set.infile.filetype == nstool::Settings::FILE_TYPE_NSP)
+		else
 		{
-			nstool::PfsProcess obj;
+			obj.setBaseNcaPath(set.nca.base_nca_path);
+		}
+		obj.setKeyCfg(set.opt.keybag);
+		obj.setCliOutputMode(set.opt.cli_output_mode);
+		obj.setVerifyMode(set.opt.verify);
+		obj.setFullVerifyMode(set.opt.verify_full);
 
-			obj.setInputFile(infile_stream);
+		obj.setShowFsTree(set.fs.show_fs_tree);
+		obj.setExtractJobs(set.fs.extract_jobs);
+		obj.setExtractOptions(set.fs.extract_options);
 
-			obj.setCliOutputMode(set.opt.cli_output_mode);
-			obj.setVerifyMode(set.opt.verify);
+		obj.process();
+	}
+	else if (set.infile.filetype == nstool::Settings::FILE_TYPE_META)
+	{
+		nstool::MetaProcess obj;
 
-			obj.setShowFsTree(set.fs.show_fs_tree);
-			obj.setExtractJobs(set.fs.extract_jobs);
-			
-			obj.process();
-		}
+		obj.setInputFile(infile_stream);
+		obj.setKeyCfg(set.opt.keybag);
+		obj.setCliOutputMode(set.opt.cli_output_mode);
+		obj.setVerifyMode(set.opt.verify);
+
+		obj.process();
+	}
+	else if (set.infile.filetype == nstool::Settings::FILE_TYPE_CNMT)
+	{
+		nstool::CnmtProcess obj;
+
+		obj.setInputFile(infile_stream);
+		obj.setCliOutputMode(set.opt.cli_output_mode);
+		obj.setVerifyMode(set.opt.verify);
+
+		obj.process();
+	}
+	else if (set.infile.filetype == nstool::Settings::FILE_TYPE_NSO)
+	{
+		nstool::NsoProcess obj;
+
+		obj.setInputFile(infile_stream);
+		obj.setCliOutputMode(set.opt.cli_output_mode);
+		obj.setVerifyMode(set.opt.verify);
 		
-		else if (set.infile.filetype == nstool::Settings::FILE_TYPE_ROMFS)
-		{
-			nstool::RomfsProcess obj;
+		obj.setIs64BitInstruction(set.code.is_64bit_instruction);
+		obj.setListApi(set.code.list_api);
+		obj.setListSymbols(set.code.list_symbols);
 
-			obj.setInputFile(infile_stream);
-			obj.setCliOutputMode(set.opt.cli_output_mode);
-			obj.setVerifyMode(set.opt.verify);
+		obj.process();
+	}
+	else if (set.infile.filetype == nstool::Settings::FILE_TYPE_NRO)
+	{
+		nstool::NroProcess obj;
 
-			obj.setShowFsTree(set.fs.show_fs_tree);
-			obj.setExtractJobs(set.fs.extract_jobs);
+		obj.setInputFile(infile_stream);
+		obj.setInputFileFactory(infile_factory);
+		obj.setCliOutputMode(set.opt.cli_output_mode);
+		obj.setVerifyMode(set.opt.verify);
+		
+		obj.setIs64BitInstruction(set.code.is_64bit_instruction);
+		obj.setListApi(set.code.list_api);
+		obj.setListSymbols(set.code.list_symbols);
 
-			obj.process();
-		}
-		else if (set.infile.filetype == nstool::Settings::FILE_TYPE_NCA)
-		{
-			nstool::NcaProcess obj;
+		if (set.aset.icon_extract_path.isSet())
+			obj.setAssetIconExtractPath(set.aset.icon_extract_path.get());
+		if (set.aset.nacp_extract_path.isSet())
+			obj.setAssetNacpExtractPath(set.aset.nacp_extract_path.get());
 
-			obj.setInputFile(infile_stream);
-			obj.setBaseNcaPath(set.nca.base_nca_path);
-			obj.setKeyCfg(set.opt.keybag);
-			obj.setCliOutputMode(set.opt.cli_output_mode);
-			obj.setVerifyMode(set.opt.verify);
+		obj.setAssetRomfsShowFsTree(set.fs.show_fs_tree);
+		obj.setAssetRomfsExtractJobs(set.fs.extract_jobs);
+		obj.setAssetRomfsExtractOptions(set.fs.extract_options);
 
-			obj.setShowFsTree(set.fs.show_fs_tree);
-			obj.setExtractJobs(set.fs.extract_jobs);
+		obj.process();
+	}
+	else if (set.infile.filetype == nstool::Settings::FILE_TYPE_NACP)
+	{
+		nstool::NacpProcess obj;
 
-			obj.process();
-		}
-		else if (set.infile.filetype == nstool::Settings::FILE_TYPE_META)
-		{
-			nstool::MetaProcess obj;
+		obj.setInputFile(infile_stream);
+		obj.setCliOutputMode(set.opt.cli_output_mode);
+		obj.setVerifyMode(set.opt.verify);
 
-			obj.setInputFile(infile_stream);
-			obj.setKeyCfg(set.opt.keybag);
-			obj.setCliOutputMode(set.opt.cli_output_mode);
-			obj.setVerifyMode(set.opt.verify);
+		obj.process();
+	}
+	else if (set.infile.filetype == nstool::Settings::FILE_TYPE_INI)
+	{
+		nstool::IniProcess obj;
 
-			obj.process();
-		}
-		else if (set.infile.filetype == nstool::Settings::FILE_TYPE_CNMT)
-		{
-			nstool::CnmtProcess obj;
+		obj.setInputFile(infile_stream);
+		obj.setCliOutputMode(set.opt.cli_output_mode);
+		obj.setVerifyMode(set.opt.verify);
 
-			obj.setInputFile(infile_stream);
-			obj.setCliOutputMode(set.opt.cli_output_mode);
-			obj.setVerifyMode(set.opt.verify);
+		if (set.kip.extract_path.isSet())
+			obj.setKipExtractPath(set.kip.extract_path.get());
+		obj.setKipExtractOptions(set.fs.extract_options);
 
-			obj.process();
+		obj.process();
+	}
+	else if (set.infile.filetype == nstool::Settings::FILE_TYPE_KIP)
+	{
+		nstool::KipProcess obj;
+
+		obj.setInputFile(infile_stream);
+		obj.setCliOutputMode(set.opt.cli_output_mode);
+		obj.setVerifyMode(set.opt.verify);
+
+		obj.process();
+	}
+	else if (set.infile.filetype == nstool::Settings::FILE_TYPE_ES_CERT)
+	{
+		nstool::EsCertProcess obj;
+
+		obj.setInputFile(infile_stream);
+		obj.setKeyCfg(set.opt.keybag);
+		obj.setCliOutputMode(set.opt.cli_output_mode);
+		obj.setVerifyMode(set.opt.verify);
+
+		obj.process();
+	}
+	else if (set.infile.filetype == nstool::Settings::FILE_TYPE_ES_TIK)
+	{
+		nstool::EsTikProcess obj;
+
+		obj.setInputFile(infile_stream);
+		obj.setKeyCfg(set.opt.keybag);
+		//obj.setCertificateChain(user_set.getCertificateChain());
+		obj.setCliOutputMode(set.opt.cli_output_mode);
+		obj.setVerifyMode(set.opt.verify);
+
+		obj.process();
+	}
+	else if (set.infile.filetype == nstool::Settings::FILE_TYPE_HB_ASSET)
+	{
+		nstool::AssetProcess obj;
+
+		obj.setInputFile(infile_stream);
+		obj.setInputFileFactory(infile_factory);
+		obj.setCliOutputMode(set.opt.cli_output_mode);
+		obj.setVerifyMode(set.opt.verify);
+
+		if (set.aset.icon_extract_path.isSet())
+			obj.setIconExtractPath(set.aset.icon_extract_path.get());
+		if (set.aset.nacp_extract_path.isSet())
+			obj.setNacpExtractPath(set.aset.nacp_extract_path.get());
+
+		obj.setRomfsShowFsTree(set.fs.show_fs_tree);
+		obj.setRomfsExtractJobs(set.fs.extract_jobs);
+		obj.setRomfsExtractOptions(set.fs.extract_options);
+
+		obj.process();
+	}
+}
+
+// calls process_input(i) for each input i in [0, input_num), with the inputs spread over a pool of threads (one thread per core unless more are requested)
+// the string returned for each input is written to stdout once it and every input before it have completed, so the output is in input order and not interleaved
+void processInputsInOrder(size_t input_num, size_t requested_thread_count, const std::function<std::string(size_t)>& process_input)
+{
+	size_t thread_count = requested_thread_count > 1 ? requested_thread_count : std::max<size_t>(std::thread::hardware_concurrency(), 1);
+	thread_count = std::min<size_t>(thread_count, input_num);
+	std::shared_ptr<nstool::ThreadPool> thread_pool = thread_count > 1 ? std::make_shared<nstool::ThreadPool>(thread_count - 1) : nullptr;
+
+	std::mutex output_mutex;
+	std::vector<std::string> output_list(input_num);
+	std::vector<bool> is_complete(input_num, false);
+	size_t next_output = 0;
+
+	auto process_func = [&](size_t index) {
+		std::string output = process_input(index);
+
+		std::lock_guard<std::mutex> lock(output_mutex);
+		output_list[index] = std::move(output);
+		is_complete[index] = true;
+		for (; next_output < output_list.size() && is_complete[next_output]; next_output++)
+		{
+			nstool::OutputCapture::write(output_list[next_output]);
+			output_list[next_output] = std::string();
 		}
-		else if (set.infile.filetype == nstool::Settings::FILE_TYPE_NSO)
+		fflush(stdout);
+	};
+
+	if (thread_pool != nullptr)
+	{
+		thread_pool->parallelFor(input_num, process_func);
+	}
+	else
+	{
+		for (size_t i = 0; i < input_num; i++)
 		{
-			nstool::NsoProcess obj;
+			process_func(i);
+		}
+	}
+}
+
+// process input_path with the settings of input_set_base (each input uses a copy), its type is determined unless specified
+// the output is captured and returned rather than printed, an exception thrown while processing is caught and returned as error
+// if the type was undetermined, filetype is FILE_TYPE_ERROR and the input is not processed (this is not an error)
+// infile_factory creates streams of the input file, if it is null the input file is opened
+// if records is not null the machine-readable records added while processing are appended to it (see OutputCapture::addRecord())
+std::string processCapturedInputFile(const nstool::Settings& input_set_base, const tc::io::Path& input_path, nstool::Settings::FileType& filetype, tc::Optional<std::string>& error, const nstool::StreamFactory& infile_factory = nullptr, std::vector<std::string>* records = nullptr)
+{
+	nstool::OutputCapture capture;
 
-			obj.setInputFile(infile_stream);
-			obj.setCliOutputMode(set.opt.cli_output_mode);
-			obj.setVerifyMode(set.opt.verify);
-			
-			obj.setIs64BitInstruction(set.code.is_64bit_instruction);
-			obj.setListApi(set.code.list_api);
-			obj.setListSymbols(set.code.list_symbols);
+	filetype = input_set_base.infile.filetype;
+	try {
+		nstool::Settings input_set = input_set_base;
+		input_set.infile.path = input_path;
 
-			obj.process();
+		if (input_set.infile.filetype == nstool::Settings::FILE_TYPE_ERROR)
+		{
+			input_set.infile.filetype = nstool::SettingsInitializer::determineFileType(input_path, input_set.opt.keybag);
+			filetype = input_set.infile.filetype;
 		}
-		else if (set.infile.filetype == nstool::Settings::FILE_TYPE_NRO)
+
+		if (input_set.infile.filetype != nstool::Settings::FILE_TYPE_ERROR)
 		{
-			nstool::NroProcess obj;
+			processInputFile(input_set, infile_factory);
+		}
+	}
+	catch (tc::Exception& e)
+	{
+		error = fmt::format("[{0}{1}ERROR] {2}", e.module(), (strlen(e.module()) != 0 ? " ": ""), e.error());
+	}
+	catch (std::exception& e)
+	{
+		// e.g. std::bad_alloc from a corrupt size, this input fails rather than the whole batch/server
+		error = fmt::format("[ERROR] {:s}", e.what());
+	}
+	catch (...)
+	{
+		error = std::string("[ERROR] Unknown error.");
+	}
 
-			obj.setInputFile(infile_stream);
-			obj.setCliOutputMode(set.opt.cli_output_mode);
-			obj.setVerifyMode(set.opt.verify);
-			
-			obj.setIs64BitInstruction(set.code.is_64bit_instruction);
-			obj.setListApi(set.code.list_api);
-			obj.setListSymbols(set.code.list_symbols);
+	if (records != nullptr)
+	{
+		records->insert(records->end(), capture.getRecords().begin(), capture.getRecords().end());
+	}
 
-			if (set.aset.icon_extract_path.isSet())
-				obj.setAssetIconExtractPath(set.aset.icon_extract_path.get());
-			if (set.aset.nacp_extract_path.isSet())
-				obj.setAssetNacpExtractPath(set.aset.nacp_extract_path.get());
+	return capture.getOutput();
+}
 
-			obj.setAssetRomfsShowFsTree(set.fs.show_fs_tree);
-			obj.setAssetRomfsExtractJobs(set.fs.extract_jobs);
+// patch NCAs processed with set share one session of the base NCA (set.nca.base_nca_path), rather than each opening and processing it again
+void openSharedBaseNcaSession(nstool::Settings& set)
+{
+	if (set.nca.base_nca_path.isSet())
+	{
+		set.nca.base_nca_session = std::make_shared<nstool::BaseNcaSession>(set.nca.base_nca_path.get(), set.opt.keybag);
+	}
+}
 
-			obj.process();
+// process each input of set.infile.batch_path_list in parallel, printing the output of each input whole, returns false if any input failed
+bool processInputFileBatch(const nstool::Settings& set)
+{
+	const std::vector<tc::io::Path>& path_list = set.infile.batch_path_list;
+
+	// settings shared by every input (the keys are only loaded once), each input is processed on a single thread
+	nstool::Settings input_set_base = set;
+	input_set_base.infile.batch_path_list.clear();
+	input_set_base.fs.extract_options.thread_count = 1;
+	openSharedBaseNcaSession(input_set_base);
+
+	std::atomic<bool> failed(false);
+	processInputsInOrder(path_list.size(), set.fs.extract_options.thread_count, [&](size_t index) -> std::string {
+		nstool::Settings::FileType filetype;
+		tc::Optional<std::string> error;
+		std::string output = fmt::format("==> {:s} <==\n", path_list[index].to_string());
+		output += processCapturedInputFile(input_set_base, path_list[index], filetype, error);
+		if (filetype == nstool::Settings::FILE_TYPE_ERROR && error.isNull())
+		{
+			error = std::string("[nstool::SettingsInitializer ERROR] Input file type was undetermined.");
 		}
-		else if (set.infile.filetype == nstool::Settings::FILE_TYPE_NACP)
+		if (error.isSet())
 		{
-			nstool::NacpProcess obj;
+			output += error.get() + "\n";
+			failed = true;
+		}
+		output += "\n";
 
-			obj.setInputFile(infile_stream);
-			obj.setCliOutputMode(set.opt.cli_output_mode);
-			obj.setVerifyMode(set.opt.verify);
+		return output;
+	});
 
-			obj.process();
+	return failed == false;
+}
+
+// process every file in the directory set.infile.path (and its subdirectories) in parallel without printing their info
+// one tab separated line is printed per file (detected type, result, first warning or the error, path), followed by the number of files of each type, returns false if any file failed
+bool processInputDirectoryScan(const nstool::Settings& set)
+{
+	std::vector<tc::io::Path> path_list;
+	nstool::getLocalFileListRecursive(set.infile.path.get(), path_list);
+
+	// settings shared by every file, each file is processed on a single thread
+	nstool::Settings input_set_base = set;
+	input_set_base.infile.scan_directory = false;
+	input_set_base.fs.extract_options.thread_count = 1;
+	openSharedBaseNcaSession(input_set_base);
+
+	// only the warnings and errors are used from the output of each file, so don't format its info (warnings are printed regardless of these)
+	input_set_base.opt.cli_output_mode = nstool::CliOutputMode();
+	input_set_base.fs.show_fs_tree = false;
+
+	std::vector<nstool::Settings::FileType> filetype_list(path_list.size(), nstool::Settings::FILE_TYPE_ERROR);
+	std::atomic<bool> failed(false);
+
+	fmt::print("#type\tstatus\tdetail\tpath\n");
+	processInputsInOrder(path_list.size(), set.fs.extract_options.thread_count, [&](size_t index) -> std::string {
+		nstool::Settings::FileType filetype;
+		tc::Optional<std::string> error;
+		std::string output = processCapturedInputFile(input_set_base, path_list[index], filetype, error);
+		filetype_list[index] = filetype;
+
+		// processing problems that are not errors (e.g. a failed signature with -y) are printed as warnings
+		size_t warning_pos = output.find("[WARNING]");
+
+		std::string status = "ok", detail = "-";
+		if (error.isSet())
+		{
+			status = "error";
+			detail = error.get();
+			failed = true;
+		}
+		else if (filetype == nstool::Settings::FILE_TYPE_ERROR)
+		{
+			status = "skipped";
 		}
-		else if (set.infile.filetype == nstool::Settings::FILE_TYPE_INI)
+		else if (warning_pos != std::string::npos)
 		{
-			nstool::IniProcess obj;
+			status = "warning";
+			detail = output.substr(warning_pos, output.find('\n', warning_pos) - warning_pos);
+		}
 
-			obj.setInputFile(infile_stream);
-			obj.setCliOutputMode(set.opt.cli_output_mode);
-			obj.setVerifyMode(set.opt.verify);
+		return fmt::format("{:s}\t{:s}\t{:s}\t{:s}\n", nstool::SettingsInitializer::getFileTypeAsString(filetype), status, detail, path_list[index].to_string());
+	});
 
-			if (set.kip.extract_path.isSet())
-				obj.setKipExtractPath(set.kip.extract_path.get());
+	// summary
+	std::map<std::string, size_t> filetype_count;
+	for (auto itr = filetype_list.begin(); itr != filetype_list.end(); itr++)
+	{
+		filetype_count[nstool::SettingsInitializer::getFileTypeAsString(*itr)] += 1;
+	}
+	fmt::print("# {:d} files\n", path_list.size());
+	for (auto itr = filetype_count.begin(); itr != filetype_count.end(); itr++)
+	{
+		fmt::print("# {:s}: {:d}\n", itr->first, itr->second);
+	}
 
-			obj.process();
-		}
-		else if (set.infile.filetype == nstool::Settings::FILE_TYPE_KIP)
+	return failed == false;
+}
+
+// serve requests on the socket set.infile.path, each request is processed like an input of a batch (the keys are only loaded once)
+// with --mmap the input files of recent requests are kept memory mapped, so repeated requests for the same container do not map it again
+void processServerRequests(const nstool::Settings& set)
+{
+	nstool::Settings input_set_base = set;
+	input_set_base.opt.server = false;
+	openSharedBaseNcaSession(input_set_base);
+
+	nstool::ServerProcess obj;
+
+	// inputs are not memory mapped by size here, reading a kept mapping of a file that was truncated since would kill the server with SIGBUS
+	bool mmap_input = set.opt.mmap_input;
+	obj.setSocketPath(set.infile.path.get());
+	obj.setInputFileOpener([mmap_input](const tc::io::Path& path) -> nstool::StreamFactory {
+		return openInputFile(path, mmap_input, std::numeric_limits<int64_t>::max());
+	});
+	obj.setRequestHandler([input_set_base](const nstool::ServerProcess::sRequest& request, const nstool::StreamFactory& infile_factory) -> nstool::ServerProcess::sResponse {
+		nstool::Settings request_set = input_set_base;
+		switch (request.command)
 		{
-			nstool::KipProcess obj;
+		case (nstool::ServerProcess::Command_List):
+			request_set.fs.show_fs_tree = true;
+			break;
+		case (nstool::ServerProcess::Command_Extract):
+			request_set.fs.extract_jobs.push_back({request.virtual_path, request.extract_path.get()});
+			break;
+		case (nstool::ServerProcess::Command_Verify):
+			request_set.opt.verify = true;
+			break;
+		default:
+			break;
+		}
 
-			obj.setInputFile(infile_stream);
-			obj.setCliOutputMode(set.opt.cli_output_mode);
-			obj.setVerifyMode(set.opt.verify);
+		nstool::Settings::FileType filetype;
+		tc::Optional<std::string> error;
 
-			obj.process();
-		}
-		else if (set.infile.filetype == nstool::Settings::FILE_TYPE_ES_CERT)
+		nstool::ServerProcess::sResponse response;
+		response.output = processCapturedInputFile(request_set, request.input_path, filetype, error, infile_factory, &response.records);
+		if (filetype == nstool::Settings::FILE_TYPE_ERROR && error.isNull())
 		{
-			nstool::EsCertProcess obj;
+			error = std::string("[nstool::SettingsInitializer ERROR] Input file type was undetermined.");
+		}
 
-			obj.setInputFile(infile_stream);
-			obj.setKeyCfg(set.opt.keybag);
-			obj.setCliOutputMode(set.opt.cli_output_mode);
-			obj.setVerifyMode(set.opt.verify);
+		// warnings (e.g. failed signature or hash checks when verifying) are printed as "[WARNING] <message>" lines (or with a module name)
+		bool has_warning = false;
+		for (size_t pos = response.output.find("WARNING]"); pos != std::string::npos; pos = response.output.find("WARNING]", pos + 1))
+		{
+			size_t line_begin = response.output.rfind('\n', pos);
+			line_begin = (line_begin == std::string::npos) ? 0 : line_begin + 1;
+			size_t line_end = response.output.find('\n', pos);
+			if (line_end == std::string::npos)
+				line_end = response.output.size();
+
+			response.records.push_back(nstool::OutputCapture::formatRecord({"warning", response.output.substr(line_begin, line_end - line_begin)}));
+			has_warning = true;
+		}
 
-			obj.process();
+		if (error.isSet())
+		{
+			response.output += error.get() + "\n";
+			response.records.push_back(nstool::OutputCapture::formatRecord({"error", error.get()}));
 		}
-		else if (set.infile.filetype == nstool::Settings::FILE_TYPE_ES_TIK)
+		response.status = error.isSet() ? nstool::ServerProcess::Status_Error : (has_warning ? nstool::ServerProcess::Status_Warning : nstool::ServerProcess::Status_Ok);
+		response.filetype = nstool::SettingsInitializer::getFileTypeAsString(filetype);
+
+		return response;
+	});
+
+	obj.process();
+}
+
+int umain(const std::vector<std::string>& args, const std::vector<std::string>& env)
+{
+	try 
+	{
+		nstool::Settings set = nstool::SettingsInitializer(args);
+		
+		// the input of a header scan is a directory or list file of NCAs, rather than a file to process
+		if (set.nca.header_scan)
 		{
-			nstool::EsTikProcess obj;
+			nstool::NcaHeaderScanProcess obj;
 
-			obj.setInputFile(infile_stream);
+			obj.setInputPath(set.infile.path.get());
 			obj.setKeyCfg(set.opt.keybag);
-			//obj.setCertificateChain(user_set.getCertificateChain());
-			obj.setCliOutputMode(set.opt.cli_output_mode);
-			obj.setVerifyMode(set.opt.verify);
+			obj.setThreadCount(set.fs.extract_options.thread_count);
 
 			obj.process();
-		}
-		else if (set.infile.filetype == nstool::Settings::FILE_TYPE_HB_ASSET)
-		{
-			nstool::AssetProcess obj;
 
-			obj.setInputFile(infile_stream);
-			obj.setCliOutputMode(set.opt.cli_output_mode);
-			obj.setVerifyMode(set.opt.verify);
+			return 0;
+		}
 
-			if (set.aset.icon_extract_path.isSet())
-				obj.setIconExtractPath(set.aset.icon_extract_path.get());
-			if (set.aset.nacp_extract_path.isSet())
-				obj.setNacpExtractPath(set.aset.nacp_extract_path.get());
+		if (set.infile.batch_path_list.empty() == false)
+		{
+			return processInputFileBatch(set) ? 0 : 1;
+		}
 
-			obj.setRomfsShowFsTree(set.fs.show_fs_tree);
-			obj.setRomfsExtractJobs(set.fs.extract_jobs);
+		if (set.infile.scan_directory)
+		{
+			return processInputDirectoryScan(set) ? 0 : 1;
+		}
 
-			obj.process();
+		if (set.opt.server)
+		{
+			processServerRequests(set);
+			return 0;
 		}
+
+		processInputFile(set);
 	}
 	catch (tc::Exception& e)
 	{
@@ -6,6 +6,7 @@
 #include <tc/io/IOUtil.h>
 #include <tc/cli.h>
 #include <fmt/core.h>
+#include <functional>
 
 
 namespace nstool {
@@ -29,4 +30,25 @@ struct ExtractJob {
 	tc::io::Path extract_path;
 };
 
+class HashManifest;
+
+struct ExtractOptions
+{
+	size_t thread_count;
+	size_t max_io_size; // upper bound for the size of a single read/write, the actual size is aligned to the source's hash/crypto block size
+	bool sparse_output; // skip writing zero filled blocks, so they become holes in the output file
+	bool resume; // keep a manifest of extracted files in each extract directory, and skip files that still match it
+	std::string input_identity; // identifies the input file in resume manifests (see ExtractManifest::getInputIdentity()), a manifest made for another input is ignored
+	std::shared_ptr<HashManifest> hash_manifest; // when set, the hashes of every extracted file are recorded here
+
+	ExtractOptions() : thread_count(1), max_io_size(0x100000), sparse_output(false), resume(false), input_identity(), hash_manifest()
+	{}
+};
+
+// maps the virtual path of a file (tc::io::Path::to_string()) to the offset of its data in the input file, used to order extraction
+using FileOffsetMap = std::map<std::string, int64_t>;
+
+// opens a new stream over the input file, independent of any other stream it returned (so each can be used from a different thread)
+using StreamFactory = std::function<std::shared_ptr<tc::io::IStream>()>;
+
 }
\ No newline at end of file
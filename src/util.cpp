@@ -1,12 +1,30 @@
 #include "util.h"
+#include "UringFileStream.h"
+#include "StreamCopyPipeline.h"
 
 #include <tc/io/FileStream.h>
+#include <tc/io/LocalFileSystem.h>
 #include <tc/io/SubStream.h>
 #include <tc/io/IOUtil.h>
+#include <tc/NotSupportedException.h>
 
+#include <pietendo/hac/PartitionFsHeader.h>
+#include <pietendo/hac/define/pfs.h>
+#include <pietendo/hac/define/romfs.h>
+
+#include <cstring>
 #include <sstream>
 #include <algorithm>
 #include <iostream>
+#include <atomic>
+
+#ifdef __linux__
+#include <cerrno>
+#include <fcntl.h>
+#include <unistd.h>
+#include <sys/sendfile.h>
+#include <sys/syscall.h>
+#endif
 
 inline bool isNotPrintable(char chr) { return isprint(chr) == false; }
 
@@ -66,51 +84,382 @@ void nstool::processResFile(const std::shared_ptr<tc::io::IStream>& file, std::m
 
 }
 
+void nstool::processListFile(const std::shared_ptr<tc::io::IStream>& file, std::vector<std::string>& list)
+{
+	if (file == nullptr || !file->canRead() || file->length() == 0)
+	{
+		return;
+	}
+
+	std::stringstream in_stream;
+
+	// populate string stream
+	tc::ByteData cache = tc::ByteData(0x1000);
+	file->seek(0, tc::io::SeekOrigin::Begin);
+	for (int64_t pos = 0; pos < file->length();)
+	{
+		size_t bytes_read = file->read(cache.data(), cache.size());
+
+		in_stream << std::string((char*)cache.data(), bytes_read);
+
+		pos += tc::io::IOUtil::castSizeToInt64(bytes_read);
+	}
+
+	processListFile(in_stream, list);
+}
+
+void nstool::processListFile(std::istream& in_stream, std::vector<std::string>& list)
+{
+	std::string line;
+	while (std::getline(in_stream, line))
+	{
+		// strip line ending of files written on windows
+		if (line.empty() == false && line.back() == '\r')
+			line.pop_back();
+
+		// skip empty and comment lines
+		if (line.empty() || line[0] == '#')
+			continue;
+
+		list.push_back(line);
+	}
+}
+
+void nstool::getLocalFileListRecursive(const tc::io::Path& dir_path, std::vector<tc::io::Path>& file_list)
+{
+	tc::io::LocalFileSystem local_fs;
+
+	tc::io::sDirectoryListing dir_listing;
+	local_fs.getDirectoryListing(dir_path, dir_listing);
+
+	// sorted so the order of the list does not depend on the order of the directory entries on disk
+	std::sort(dir_listing.file_list.begin(), dir_listing.file_list.end());
+	std::sort(dir_listing.dir_list.begin(), dir_listing.dir_list.end());
+
+	for (auto itr = dir_listing.file_list.begin(); itr != dir_listing.file_list.end(); itr++)
+	{
+		file_list.push_back(dir_path + *itr);
+	}
+
+	for (auto itr = dir_listing.dir_list.begin(); itr != dir_listing.dir_list.end(); itr++)
+	{
+		// the listing may include the current and parent directory aliases
+		if (*itr == "." || *itr == "..")
+			continue;
+
+		getLocalFileListRecursive(dir_path + *itr, file_list);
+	}
+}
+
+size_t nstool::getIoBlockSize(size_t io_alignment, size_t max_io_size)
+{
+	if (io_alignment == 0)
+	{
+		io_alignment = 1;
+	}
+
+	if (max_io_size < kMinIoSize)
+	{
+		max_io_size = kMinIoSize;
+	}
+
+	if (max_io_size < io_alignment)
+	{
+		return io_alignment;
+	}
+
+	return (max_io_size / io_alignment) * io_alignment;
+}
+
 void nstool::writeSubStreamToFile(const std::shared_ptr<tc::io::IStream>& in_stream, int64_t offset, int64_t length, const tc::io::Path& out_path, tc::ByteData& cache)
 {
-	writeStreamToStream(std::make_shared<tc::io::SubStream>(tc::io::SubStream(in_stream, offset, length)), std::make_shared<tc::io::FileStream>(tc::io::FileStream(out_path, tc::io::FileMode::Create, tc::io::FileAccess::Write)), cache);
+	writeStreamToStream(std::make_shared<tc::io::SubStream>(tc::io::SubStream(in_stream, offset, length)), openOutputFileStream(out_path, length), cache);
 }
 
 void nstool::writeSubStreamToFile(const std::shared_ptr<tc::io::IStream>& in_stream, int64_t offset, int64_t length, const tc::io::Path& out_path, size_t cache_size)
 {
-	writeStreamToStream(std::make_shared<tc::io::SubStream>(tc::io::SubStream(in_stream, offset, length)), std::make_shared<tc::io::FileStream>(tc::io::FileStream(out_path, tc::io::FileMode::Create, tc::io::FileAccess::Write)), cache_size);
+	writeStreamToStream(std::make_shared<tc::io::SubStream>(tc::io::SubStream(in_stream, offset, length)), openOutputFileStream(out_path, length), cache_size);
 }
 
-void nstool::writeStreamToFile(const std::shared_ptr<tc::io::IStream>& in_stream, const tc::io::Path& out_path, tc::ByteData& cache)
+void nstool::writeStreamToFile(const std::shared_ptr<tc::io::IStream>& in_stream, const tc::io::Path& out_path, tc::ByteData& cache, bool sparse, const StreamDataObserver& observer)
 {
-	writeStreamToStream(in_stream, std::make_shared<tc::io::FileStream>(tc::io::FileStream(out_path, tc::io::FileMode::Create, tc::io::FileAccess::Write)), cache);
+	writeStreamToStream(in_stream, openOutputFileStream(out_path, in_stream->length()), cache, sparse, observer);
 }
 
 void nstool::writeStreamToFile(const std::shared_ptr<tc::io::IStream>& in_stream, const tc::io::Path& out_path, size_t cache_size)
 {
-	writeStreamToStream(in_stream, std::make_shared<tc::io::FileStream>(tc::io::FileStream(out_path, tc::io::FileMode::Create, tc::io::FileAccess::Write)), cache_size);
+	writeStreamToStream(in_stream, openOutputFileStream(out_path, in_stream->length()), cache_size);
+}
+
+void nstool::writeStreamToStream(const std::shared_ptr<tc::io::IStream>& in_stream, const std::shared_ptr<tc::io::IStream>& out_stream, tc::ByteData& cache, bool sparse, const StreamDataObserver& observer)
+{
+	StreamCopyPipeline pipeline("nstool::writeStreamToStream()");
+	pipeline.copy(in_stream, out_stream, cache, sparse, observer, "source streeam");
+}
+
+void nstool::writeStreamToStream(const std::shared_ptr<tc::io::IStream>& in_stream, const std::shared_ptr<tc::io::IStream>& out_stream, size_t cache_size)
+{
+	tc::ByteData cache = tc::ByteData(cache_size);
+	writeStreamToStream(in_stream, out_stream, cache);
+}
+
+bool nstool::copyFileRegionToFile(const tc::io::Path& in_path, int64_t offset, int64_t length, const tc::io::Path& out_path)
+{
+#ifdef __linux__
+	int in_fd = open(in_path.to_string().c_str(), O_RDONLY | O_CLOEXEC);
+	if (in_fd < 0)
+	{
+		return false;
+	}
+	int out_fd = open(out_path.to_string().c_str(), O_WRONLY | O_CREAT | O_TRUNC | O_CLOEXEC, 0666);
+	if (out_fd < 0)
+	{
+		close(in_fd);
+		return false;
+	}
+
+	loff_t in_pos = offset;
+	loff_t out_pos = 0;
+	int64_t remaining_data = length;
+
+#ifdef __NR_copy_file_range
+	// copy_file_range() can share extents (reflink) on filesystems that support it, but fails with EXDEV/ENOSYS/EINVAL across filesystems or on older kernels
+	while (remaining_data > 0)
+	{
+		ssize_t copied = syscall(__NR_copy_file_range, in_fd, &in_pos, out_fd, &out_pos, size_t(std::min<int64_t>(remaining_data, 0x40000000)), 0);
+		if (copied < 0 && errno == EINTR)
+			continue;
+		if (copied <= 0)
+			break;
+		remaining_data -= copied;
+	}
+#endif
+
+	// sendfile() continues from where copy_file_range() stopped (out_fd was only written through out_pos, so it is still positioned at 0)
+	if (remaining_data > 0 && lseek(out_fd, out_pos, SEEK_SET) == out_pos)
+	{
+		while (remaining_data > 0)
+		{
+			off_t sendfile_pos = off_t(in_pos);
+			ssize_t copied = sendfile(out_fd, in_fd, &sendfile_pos, size_t(std::min<int64_t>(remaining_data, 0x40000000)));
+			if (copied < 0 && errno == EINTR)
+				continue;
+			if (copied <= 0)
+				break;
+			in_pos += copied;
+			out_pos += copied;
+			remaining_data -= copied;
+		}
+	}
+
+	close(in_fd);
+	bool close_ok = close(out_fd) == 0;
+
+	return remaining_data == 0 && close_ok;
+#else
+	return false;
+#endif
 }
 
-void nstool::writeStreamToStream(const std::shared_ptr<tc::io::IStream>& in_stream, const std::shared_ptr<tc::io::IStream>& out_stream, tc::ByteData& cache)
+std::shared_ptr<tc::io::IStream> nstool::openOutputFileStream(const tc::io::Path& out_path, int64_t expected_size)
 {
-	// iterate thru child files
-	size_t cache_read_len;
-	
-	in_stream->seek(0, tc::io::SeekOrigin::Begin);
-	out_stream->seek(0, tc::io::SeekOrigin::Begin);
-	for (int64_t remaining_data = in_stream->length(); remaining_data > 0;)
+	// set after the first failure to create a ring, so unsupported systems only pay for the attempt once
+	static std::atomic<bool> queued_output_unavailable(false);
+
+	// small files are written in one or two calls, so setting up a ring costs more than it saves
+	if (expected_size >= kQueuedOutputMinSize && queued_output_unavailable == false)
 	{
-		cache_read_len = in_stream->read(cache.data(), cache.size());
-		if (cache_read_len == 0)
+		try
 		{
-			throw tc::io::IOException("nstool::writeStreamToStream()", "Failed to read from source streeam.");
+			return std::make_shared<UringFileStream>(out_path);
 		}
+		catch (const tc::NotSupportedException&)
+		{
+			queued_output_unavailable = true;
+		}
+	}
 
-		out_stream->write(cache.data(), cache_read_len);
+	return std::make_shared<tc::io::FileStream>(tc::io::FileStream(out_path, tc::io::FileMode::Create, tc::io::FileAccess::Write));
+}
 
-		remaining_data -= int64_t(cache_read_len);
+void nstool::readStreamExact(const std::shared_ptr<tc::io::IStream>& stream, int64_t offset, byte_t* ptr, size_t count, const std::string& module_name)
+{
+	stream->seek(offset, tc::io::SeekOrigin::Begin);
+	for (size_t done = 0; done < count;)
+	{
+		size_t read_len = stream->read(ptr + done, count - done);
+		if (read_len == 0)
+		{
+			throw tc::io::IOException(module_name, "Failed to read from base stream.");
+		}
+		done += read_len;
 	}
 }
 
-void nstool::writeStreamToStream(const std::shared_ptr<tc::io::IStream>& in_stream, const std::shared_ptr<tc::io::IStream>& out_stream, size_t cache_size)
+bool nstool::isZeroFilled(const byte_t* data, size_t len)
 {
-	tc::ByteData cache = tc::ByteData(cache_size);
-	writeStreamToStream(in_stream, out_stream, cache);
+	// OR together 64bit words instead of testing each byte, the compiler vectorises this loop
+	static const size_t kWordSize = sizeof(uint64_t);
+
+	size_t word_num = len / kWordSize;
+	uint64_t accumulator = 0;
+	for (size_t i = 0; i < word_num; i++)
+	{
+		uint64_t word;
+		memcpy(&word, data + (i * kWordSize), kWordSize);
+		accumulator |= word;
+	}
+	for (size_t i = word_num * kWordSize; i < len; i++)
+	{
+		accumulator |= data[i];
+	}
+
+	return accumulator == 0;
+}
+
+void nstool::getPartitionFsFileOffsets(const std::shared_ptr<tc::io::IStream>& stream, const tc::io::Path& mount_path, int64_t base_offset, FileOffsetMap& file_offsets)
+{
+	try
+	{
+		// read base header to determine complete header size
+		pie::hac::sPfsHeader hdr;
+		if (stream->length() < tc::io::IOUtil::castSizeToInt64(sizeof(pie::hac::sPfsHeader)))
+		{
+			return;
+		}
+		stream->seek(0, tc::io::SeekOrigin::Begin);
+		stream->read((byte_t*)&hdr, sizeof(pie::hac::sPfsHeader));
+
+		size_t file_entry_size = 0;
+		if (hdr.st_magic.unwrap() == pie::hac::pfs::kPfsStructMagic)
+			file_entry_size = sizeof(pie::hac::sPfsFile);
+		else if (hdr.st_magic.unwrap() == pie::hac::pfs::kHashedPfsStructMagic)
+			file_entry_size = sizeof(pie::hac::sHashedPfsFile);
+		else
+			return;
+
+		int64_t header_size = int64_t(sizeof(pie::hac::sPfsHeader)) + int64_t(hdr.file_num.unwrap()) * int64_t(file_entry_size) + int64_t(hdr.name_table_size.unwrap());
+		if (stream->length() < header_size)
+		{
+			return;
+		}
+
+		// read complete header
+		tc::ByteData scratch = tc::ByteData(tc::io::IOUtil::castInt64ToSize(header_size));
+		stream->seek(0, tc::io::SeekOrigin::Begin);
+		stream->read(scratch.data(), scratch.size());
+
+		pie::hac::PartitionFsHeader pfs;
+		pfs.fromBytes(scratch.data(), scratch.size());
+
+		for (auto itr = pfs.getFileList().begin(); itr != pfs.getFileList().end(); itr++)
+		{
+			file_offsets[(mount_path + itr->name).to_string()] = base_offset + itr->offset;
+		}
+	}
+	catch (tc::Exception&)
+	{
+		// ordering hints are optional
+	}
+}
+
+void nstool::getRomFsFileOffsets(const std::shared_ptr<tc::io::IStream>& stream, const tc::io::Path& mount_path, int64_t base_offset, FileOffsetMap& file_offsets)
+{
+	static const uint32_t kInvalidEntryOffset = 0xffffffff;
+
+	try
+	{
+		pie::hac::sRomfsHeader hdr;
+		if (stream->length() < tc::io::IOUtil::castSizeToInt64(sizeof(pie::hac::sRomfsHeader)))
+		{
+			return;
+		}
+		stream->seek(0, tc::io::SeekOrigin::Begin);
+		stream->read((byte_t*)&hdr, sizeof(pie::hac::sRomfsHeader));
+		if (hdr.header_size.unwrap() != sizeof(pie::hac::sRomfsHeader) || hdr.dir_entry.size.unwrap() == 0 || hdr.file_entry.size.unwrap() == 0)
+		{
+			return;
+		}
+
+		// the tables must lie within the stream, so a corrupt header cannot cause a huge allocation
+		// (sizes and offsets are unsigned 64bit, so each is checked against the length before they are added)
+		uint64_t stream_length = uint64_t(stream->length());
+		if (hdr.dir_entry.offset.unwrap() > stream_length || hdr.dir_entry.size.unwrap() > stream_length - hdr.dir_entry.offset.unwrap()
+			|| hdr.file_entry.offset.unwrap() > stream_length || hdr.file_entry.size.unwrap() > stream_length - hdr.file_entry.offset.unwrap())
+		{
+			return;
+		}
+
+		// read entry tables
+		tc::ByteData dir_entry_table = tc::ByteData(tc::io::IOUtil::castInt64ToSize(hdr.dir_entry.size.unwrap()));
+		stream->seek(hdr.dir_entry.offset.unwrap(), tc::io::SeekOrigin::Begin);
+		stream->read(dir_entry_table.data(), dir_entry_table.size());
+
+		tc::ByteData file_entry_table = tc::ByteData(tc::io::IOUtil::castInt64ToSize(hdr.file_entry.size.unwrap()));
+		stream->seek(hdr.file_entry.offset.unwrap(), tc::io::SeekOrigin::Begin);
+		stream->read(file_entry_table.data(), file_entry_table.size());
+
+		// walk the directory tree from the root directory (entry offset 0), stack holds (dir entry offset, dir path)
+		std::vector<std::pair<uint32_t, tc::io::Path>> dir_stack;
+		dir_stack.push_back(std::make_pair(uint32_t(0), mount_path));
+		size_t visited_dir_num = 0;
+		while (dir_stack.empty() == false)
+		{
+			uint32_t dir_offset = dir_stack.back().first;
+			tc::io::Path dir_path = dir_stack.back().second;
+			dir_stack.pop_back();
+
+			// each directory entry is at least sizeof(sRomfsDirEntry), so more visits than that means the table contains a loop
+			if (size_t(dir_offset) + sizeof(pie::hac::sRomfsDirEntry) > dir_entry_table.size() || ++visited_dir_num > dir_entry_table.size() / sizeof(pie::hac::sRomfsDirEntry))
+			{
+				return;
+			}
+			const pie::hac::sRomfsDirEntry* dir_entry = (const pie::hac::sRomfsDirEntry*)(dir_entry_table.data() + dir_offset);
+
+			// files in this directory
+			size_t visited_file_num = 0;
+			for (uint32_t file_offset = dir_entry->file_offset.unwrap(); file_offset != kInvalidEntryOffset;)
+			{
+				if (size_t(file_offset) + sizeof(pie::hac::sRomfsFileEntry) > file_entry_table.size() || ++visited_file_num > file_entry_table.size() / sizeof(pie::hac::sRomfsFileEntry))
+				{
+					return;
+				}
+				const pie::hac::sRomfsFileEntry* file_entry = (const pie::hac::sRomfsFileEntry*)(file_entry_table.data() + file_offset);
+				if (size_t(file_offset) + sizeof(pie::hac::sRomfsFileEntry) + file_entry->name_size.unwrap() > file_entry_table.size())
+				{
+					return;
+				}
+
+				std::string name = std::string((const char*)(file_entry_table.data() + file_offset + sizeof(pie::hac::sRomfsFileEntry)), file_entry->name_size.unwrap());
+				file_offsets[(dir_path + name).to_string()] = base_offset + int64_t(hdr.data_offset.unwrap()) + int64_t(file_entry->data_offset.unwrap());
+
+				file_offset = file_entry->sibling_offset.unwrap();
+			}
+
+			// child directories
+			for (uint32_t child_offset = dir_entry->child_offset.unwrap(); child_offset != kInvalidEntryOffset;)
+			{
+				if (size_t(child_offset) + sizeof(pie::hac::sRomfsDirEntry) > dir_entry_table.size() || dir_stack.size() > dir_entry_table.size() / sizeof(pie::hac::sRomfsDirEntry))
+				{
+					return;
+				}
+				const pie::hac::sRomfsDirEntry* child_entry = (const pie::hac::sRomfsDirEntry*)(dir_entry_table.data() + child_offset);
+				if (size_t(child_offset) + sizeof(pie::hac::sRomfsDirEntry) + child_entry->name_size.unwrap() > dir_entry_table.size())
+				{
+					return;
+				}
+
+				std::string name = std::string((const char*)(dir_entry_table.data() + child_offset + sizeof(pie::hac::sRomfsDirEntry)), child_entry->name_size.unwrap());
+				dir_stack.push_back(std::make_pair(child_offset, dir_path + name));
+
+				child_offset = child_entry->sibling_offset.unwrap();
+			}
+		}
+	}
+	catch (tc::Exception&)
+	{
+		// ordering hints are optional
+	}
 }
 
 std::string nstool::getTruncatedBytesString(const byte_t* data, size_t len)
@@ -1,18 +1,55 @@
 #pragma once
 #include "types.h"
+#include "StreamCopyPipeline.h"
 
 namespace nstool
 {
 
 void processResFile(const std::shared_ptr<tc::io::IStream>& file, std::map<std::string, std::string>& dict);
 
+// one entry per line, blank lines and lines starting with '#' are skipped
+void processListFile(const std::shared_ptr<tc::io::IStream>& file, std::vector<std::string>& list);
+void processListFile(std::istream& in_stream, std::vector<std::string>& list);
+
+// add the path of every file in the local directory dir_path and its subdirectories to file_list, throws tc::io::DirectoryNotFoundException if dir_path is not a directory
+void getLocalFileListRecursive(const tc::io::Path& dir_path, std::vector<tc::io::Path>& file_list);
+
+// smallest I/O size getIoBlockSize() returns, smaller --iosize values would copy files a few bytes per call
+static const size_t kMinIoSize = 0x1000;
+
+// largest multiple of io_alignment that is not larger than max_io_size (but at least one io_alignment block, and at least kMinIoSize)
+// cache/cache_size of the stream copy functions below should be sized with this, so they honour ExtractOptions::max_io_size
+size_t getIoBlockSize(size_t io_alignment, size_t max_io_size);
+
 void writeSubStreamToFile(const std::shared_ptr<tc::io::IStream>& in_stream, int64_t offset, int64_t length, const tc::io::Path& out_path, tc::ByteData& cache);
-void writeSubStreamToFile(const std::shared_ptr<tc::io::IStream>& in_stream, int64_t offset, int64_t length, const tc::io::Path& out_path, size_t cache_size = 0x10000);
-void writeStreamToFile(const std::shared_ptr<tc::io::IStream>& in_stream, const tc::io::Path& out_path, tc::ByteData& cache);
-void writeStreamToFile(const std::shared_ptr<tc::io::IStream>& in_stream, const tc::io::Path& out_path, size_t cache_size = 0x10000);
-void writeStreamToStream(const std::shared_ptr<tc::io::IStream>& in_stream, const std::shared_ptr<tc::io::IStream>& out_stream, tc::ByteData& cache);
-void writeStreamToStream(const std::shared_ptr<tc::io::IStream>& in_stream, const std::shared_ptr<tc::io::IStream>& out_stream, size_t cache_size = 0x10000);
+void writeSubStreamToFile(const std::shared_ptr<tc::io::IStream>& in_stream, int64_t offset, int64_t length, const tc::io::Path& out_path, size_t cache_size);
+// when sparse is true, all zero kSparseBlockSize blocks are seeked over instead of written, leaving holes in the output file on filesystems that support them
+static const size_t kSparseBlockSize = 0x1000;
+
+// streams larger than cache/cache_size are copied through a StreamCopyPipeline created for the copy, callers copying many files should keep their own pipeline instead
+void writeStreamToFile(const std::shared_ptr<tc::io::IStream>& in_stream, const tc::io::Path& out_path, tc::ByteData& cache, bool sparse = false, const StreamDataObserver& observer = StreamDataObserver());
+void writeStreamToFile(const std::shared_ptr<tc::io::IStream>& in_stream, const tc::io::Path& out_path, size_t cache_size);
+void writeStreamToStream(const std::shared_ptr<tc::io::IStream>& in_stream, const std::shared_ptr<tc::io::IStream>& out_stream, tc::ByteData& cache, bool sparse = false, const StreamDataObserver& observer = StreamDataObserver());
+void writeStreamToStream(const std::shared_ptr<tc::io::IStream>& in_stream, const std::shared_ptr<tc::io::IStream>& out_stream, size_t cache_size);
+
+// copy a region of a local file to a new file inside the kernel (copy_file_range(), which may reflink, then sendfile()), without passing the data through a user space buffer
+// returns false if this is not supported for these files/this platform, in which case the caller should fall back to writeStreamToStream()
+bool copyFileRegionToFile(const tc::io::Path& in_path, int64_t offset, int64_t length, const tc::io::Path& out_path);
+
+// create a new local file for writing, files of at least kQueuedOutputMinSize bytes use UringFileStream (queued writes) where io_uring is available, otherwise tc::io::FileStream is used
+// the caller must flush() the returned stream to observe write errors
+static const int64_t kQueuedOutputMinSize = 0x100000;
+std::shared_ptr<tc::io::IStream> openOutputFileStream(const tc::io::Path& out_path, int64_t expected_size);
+
+// read exactly count bytes of stream at offset, throws tc::io::IOException(module_name, ...) if the stream ends first
+void readStreamExact(const std::shared_ptr<tc::io::IStream>& stream, int64_t offset, byte_t* ptr, size_t count, const std::string& module_name);
+
+bool isZeroFilled(const byte_t* data, size_t len);
 
+// add the data offset of each file in a PartitionFs/RomFs image (mounted at mount_path, located at base_offset in the input file) to file_offsets
+// these only provide ordering hints, so a corrupt image results in missing entries rather than an exception
+void getPartitionFsFileOffsets(const std::shared_ptr<tc::io::IStream>& stream, const tc::io::Path& mount_path, int64_t base_offset, FileOffsetMap& file_offsets);
+void getRomFsFileOffsets(const std::shared_ptr<tc::io::IStream>& stream, const tc::io::Path& mount_path, int64_t base_offset, FileOffsetMap& file_offsets);
 
 std::string getTruncatedBytesString(const byte_t* data, size_t len);
 std::string getTruncatedBytesString(const byte_t* data, size_t len, bool do_not_truncate);